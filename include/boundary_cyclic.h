@@ -25,7 +25,12 @@
 
 #ifdef USEMPI
 #include <mpi.h>
+#include <map>
+#include <memory>
+#include <tuple>
+#include "comm_plan.h"
 #endif
+#include <vector>
 
 class Master;
 template<typename> class Grid;
@@ -43,6 +48,13 @@ class Boundary_cyclic
         void exec(TF* const restrict, Edge=Edge::Both_edges); // Fills the ghost cells in the periodic directions.
         void exec_2d(TF* const restrict); // Fills the ghost cells of one slice in the periodic direction.
 
+        void exec(const std::vector<TF*>&, Edge=Edge::Both_edges); // Fills the ghost cells of multiple fields with one message per neighbour.
+
+        // Fill only the given number of ghost cells in the x- and y-direction closest to the interior.
+        void exec(TF* const restrict, Edge, const int, const int);
+        void exec(const std::vector<TF*>&, Edge, const int, const int);
+        void exec_2d(const std::vector<TF*>&); // Fills the ghost cells of multiple slices with one message per neighbour.
+
         void exec(unsigned int* const restrict, Edge=Edge::Both_edges); // Fills the ghost cells in the periodic directions.
         void exec_2d(unsigned int* const restrict); // Fills the ghost cells of one slice in the periodic direction.
 
@@ -58,14 +70,26 @@ class Boundary_cyclic
         bool mpi_types_allocated;
 
         #ifdef USEMPI
-        MPI_Datatype eastwestedge;     ///< MPI datatype containing the ghostcells at the east-west sides.
-        MPI_Datatype northsouthedge;   ///< MPI datatype containing the ghostcells at the north-south sides.
-        MPI_Datatype eastwestedge2d;   ///< MPI datatype containing the ghostcells for one slice at the east-west sides.
-        MPI_Datatype northsouthedge2d; ///< MPI datatype containing the ghostcells for one slice at the north-south sides.
         MPI_Datatype eastwestedge_uint;     ///< MPI datatype containing the ghostcells at the east-west sides.
         MPI_Datatype northsouthedge_uint;   ///< MPI datatype containing the ghostcells at the north-south sides.
         MPI_Datatype eastwestedge2d_uint;   ///< MPI datatype containing the ghostcells for one slice at the east-west sides.
         MPI_Datatype northsouthedge2d_uint; ///< MPI datatype containing the ghostcells for one slice at the north-south sides.
+
+        // Packed buffers and persistent messages for the exchange of one edge of a set of fields.
+        struct Halo_plan
+        {
+            std::vector<TF> send_1; ///< Packed ghost cells of all fields sent to the east or north neighbour.
+            std::vector<TF> send_2; ///< Packed ghost cells of all fields sent to the west or south neighbour.
+            std::vector<TF> recv_1; ///< Packed ghost cells of all fields received from the west or south neighbour.
+            std::vector<TF> recv_2; ///< Packed ghost cells of all fields received from the east or north neighbour.
+            Comm_plan comm_plan;
+        };
+
+        // Plans are stored per number of fields, number of vertical levels, edge and number of ghost cells.
+        std::map<std::tuple<int, int, Edge, int>, std::unique_ptr<Halo_plan>> halo_plans;
+
+        Halo_plan& get_halo_plan(const int, const int, Edge, const int);
+        void exec_batched(const std::vector<TF*>&, Edge, const int, const int, const int); // Packed exchange of the ghost cells of multiple fields.
         #endif
 };
 #endif
@@ -28,6 +28,23 @@
 
 template<typename> class Diff;
 
+// Inverse of the Ri(z/L) lookup table, which gives z/L without iterations. The core
+// range is tabulated uniformly in Ri, the free convection tail uniformly in log(-Ri).
+struct Obuk_lookup
+{
+    std::vector<float> zL_core;
+    std::vector<float> zL_tail;
+
+    float Ri_min;      // Lowest Ri in the table
+    float Ri_core;     // Ri at the start of the core range
+    float Ri_max;      // Highest Ri in the table
+    float zL_max;      // z/L for Ri beyond Ri_max
+
+    float dRi_core_i;     // Inverse spacing of zL_core in Ri
+    float log_Ri_core;    // log(-Ri_core)
+    float dlog_Ri_tail_i; // Inverse spacing of zL_tail in log(-Ri)
+};
+
 template<typename TF>
 class Boundary_surface : public Boundary<TF>
 {
@@ -90,6 +107,8 @@ class Boundary_surface : public Boundary<TF>
         std::vector<float> zL_sl;
         std::vector<float> f_sl;
 
+        Obuk_lookup obuk_lookup;
+
         #ifdef USECUDA
         float* zL_sl_g;
         float* f_sl_g;
@@ -53,6 +53,12 @@ class Budget_2 : public Budget<TF>
         std::vector<TF> vmodel;
         std::vector<TF> wmodel;
 
+        // Names of the budget terms and their per-level sums, stored as one block of kcells per term.
+        std::vector<std::string> term_names;
+        std::vector<double> term_sums;
+
+        double* get_term_sums(const std::string&);
+
         /*
         void calc_kinetic_energy(double*, double*, const double*, const double*, const double*, const double*, const double*, const double, const double);
 
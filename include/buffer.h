@@ -64,6 +64,9 @@ class Buffer
 
         std::map<std::string, std::vector<TF>> bufferprofs; ///< Map containing the buffer profiles.
 
+        std::vector<TF> sigmaz;  ///< Damping coefficient at cell center.
+        std::vector<TF> sigmazh; ///< Damping coefficient at cell face.
+
         bool swbuffer; ///< Switch for buffer.
         bool swupdate; ///< Switch for enabling runtime updating of buffer profile.
 
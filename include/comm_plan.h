@@ -0,0 +1,66 @@
+/*
+ * MicroHH
+ * Copyright (c) 2011-2020 Chiel van Heerwaarden
+ * Copyright (c) 2011-2020 Thijs Heus
+ * Copyright (c) 2014-2020 Bart van Stratum
+ *
+ * This file is part of MicroHH
+ *
+ * MicroHH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * MicroHH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with MicroHH.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COMM_PLAN_H
+#define COMM_PLAN_H
+
+#ifdef USEMPI
+#include <mpi.h>
+#include <vector>
+
+/**
+ * Persistent point-to-point communication pattern.
+ * The messages are registered once on fixed buffers with MPI_Send_init and MPI_Recv_init
+ * and are restarted on every execution. The number of messages and the amount of data
+ * sent by all plans are kept for diagnostics.
+ */
+class Comm_plan
+{
+    public:
+        Comm_plan();
+        ~Comm_plan();
+
+        Comm_plan(const Comm_plan&) = delete;
+        Comm_plan& operator=(const Comm_plan&) = delete;
+
+        void add_send(const void*, int, MPI_Datatype, int, int, MPI_Comm); // Registers a persistent send.
+        void add_recv(void*, int, MPI_Datatype, int, int, MPI_Comm);       // Registers a persistent receive.
+
+        void start(); // Starts all registered messages.
+        void wait();  // Waits for completion of all registered messages.
+        void exec() { start(); wait(); }
+
+        // Totals over all plans of this process, printed at the end of the run.
+        static double get_total_messages() { return total_messages; }
+        static double get_total_bytes() { return total_bytes; }
+
+    private:
+        std::vector<MPI_Request> requests;
+
+        long n_sends;        // Number of sends per execution of the plan.
+        long bytes_per_exec; // Number of bytes sent per execution of the plan.
+
+        static double total_messages; // Number of messages sent by all plans.
+        static double total_bytes;    // Number of bytes sent by all plans.
+};
+#endif
+#endif
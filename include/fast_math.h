@@ -21,6 +21,13 @@
  */
 
 #ifndef FAST_MATH_H
+#define FAST_MATH_H
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <limits>
 
 // In case the code is compiled with NVCC, add the macros for CUDA
 #ifdef __CUDACC__
@@ -54,5 +61,233 @@ namespace Fast_math
     {
         return a*a*a*a*a*a*a;
     }
+
+    // Transcendental functions. If USEFASTMATH is defined, branch-free polynomial
+    // approximations are used that the compiler can vectorize, otherwise (and in
+    // CUDA code) the calls are forwarded to the standard library. Maximum errors
+    // of the approximations over their valid range, as measured by the program
+    // check_fast_math (main/check_fast_math.cxx):
+    //   fast_exp  : 2 ULP, argument clipped to the finite range.
+    //   fast_log  : 3 ULP, positive normal arguments only.
+    //   fast_pow  : 3*(1 + |y*log(x)|) ULP, x >= 0 only, 0 for x == 0.
+    //   fast_cbrt : 1 ULP.
+    //   fast_erf  : 1.5e-7 (double) and 6e-7 (float) absolute (Abramowitz and Stegun 7.1.26).
+    #if defined(USEFASTMATH) && !defined(__CUDACC__)
+    namespace Fast_math_kernels
+    {
+        // All integer manipulations use 32-bit integers, such that they vectorize without AVX-512.
+        template<typename TF>
+        inline int32_t round_to_int(const TF x)
+        {
+            return static_cast<int32_t>(x + (x > TF(0.) ? TF(0.5) : TF(-0.5)));
+        }
+
+        inline double scale_exp2(const int32_t n)
+        {
+            const int64_t bits = static_cast<int64_t>(n + 1023) << 52;
+            double scale;
+            std::memcpy(&scale, &bits, sizeof(double));
+            return scale;
+        }
+
+        inline float scale_exp2_float(const int32_t n)
+        {
+            const int32_t bits = (n + 127) << 23;
+            float scale;
+            std::memcpy(&scale, &bits, sizeof(float));
+            return scale;
+        }
+
+        // Split x in a mantissa in [sqrt(1/2), sqrt(2)) and a power of two.
+        inline double split_exponent(const double x, double& e)
+        {
+            int64_t bits;
+            std::memcpy(&bits, &x, sizeof(double));
+            bits -= INT64_C(0x3fe6a09e667f3bcd);
+            e = static_cast<double>(static_cast<int32_t>(bits >> 52));
+            bits = (bits & INT64_C(0x000fffffffffffff)) + INT64_C(0x3fe6a09e667f3bcd);
+            double m;
+            std::memcpy(&m, &bits, sizeof(double));
+            return m;
+        }
+
+        inline float split_exponent(const float x, float& e)
+        {
+            int32_t bits;
+            std::memcpy(&bits, &x, sizeof(float));
+            bits -= 0x3f3504f3;
+            e = static_cast<float>(bits >> 23);
+            bits = (bits & 0x007fffff) + 0x3f3504f3;
+            float m;
+            std::memcpy(&m, &bits, sizeof(float));
+            return m;
+        }
+    }
+
+    inline double fast_exp(double x)
+    {
+        x = std::min(std::max(x, -708.), 709.);
+
+        // Reduce to exp(r) * 2^n with |r| <= ln(2)/2, ln(2) is split for an exact product.
+        const int32_t ni = Fast_math_kernels::round_to_int(x*1.4426950408889634);
+        const double n = ni;
+        const double r = (x - n*6.93147180369123816490e-01) - n*1.90821492927058770002e-10;
+
+        // Taylor series up to r^12.
+        double p = 1./479001600.;
+        p = p*r + 1./39916800.;
+        p = p*r + 1./3628800.;
+        p = p*r + 1./362880.;
+        p = p*r + 1./40320.;
+        p = p*r + 1./5040.;
+        p = p*r + 1./720.;
+        p = p*r + 1./120.;
+        p = p*r + 1./24.;
+        p = p*r + 1./6.;
+        p = p*r + 0.5;
+        p = p*r + 1.;
+        p = p*r + 1.;
+
+        return p * Fast_math_kernels::scale_exp2(ni);
+    }
+
+    inline float fast_exp(float x)
+    {
+        x = std::min(std::max(x, -87.f), 88.f);
+
+        const int32_t ni = Fast_math_kernels::round_to_int(x*1.44269504f);
+        const float n = ni;
+        const float r = (x - n*0.693145751953125f) - n*1.428606765330187045e-06f;
+
+        // Taylor series up to r^7.
+        float p = 1.f/5040.f;
+        p = p*r + 1.f/720.f;
+        p = p*r + 1.f/120.f;
+        p = p*r + 1.f/24.f;
+        p = p*r + 1.f/6.f;
+        p = p*r + 0.5f;
+        p = p*r + 1.f;
+        p = p*r + 1.f;
+
+        return p * Fast_math_kernels::scale_exp2_float(ni);
+    }
+
+    inline double fast_log(const double x)
+    {
+        double e;
+        const double m = Fast_math_kernels::split_exponent(x, e);
+
+        // log(m) = 2 atanh(f) with f = (m-1)/(m+1), |f| < 0.172, series up to f^21.
+        const double f = (m - 1.) / (m + 1.);
+        const double s = f*f;
+
+        double p = 1./21.;
+        p = p*s + 1./19.;
+        p = p*s + 1./17.;
+        p = p*s + 1./15.;
+        p = p*s + 1./13.;
+        p = p*s + 1./11.;
+        p = p*s + 1./9.;
+        p = p*s + 1./7.;
+        p = p*s + 1./5.;
+        p = p*s + 1./3.;
+        p = p*s + 1.;
+
+        return e*6.93147180369123816490e-01 + (2.*f*p + e*1.90821492927058770002e-10);
+    }
+
+    inline float fast_log(const float x)
+    {
+        float e;
+        const float m = Fast_math_kernels::split_exponent(x, e);
+
+        const float f = (m - 1.f) / (m + 1.f);
+        const float s = f*f;
+
+        // Series up to f^11.
+        float p = 1.f/11.f;
+        p = p*s + 1.f/9.f;
+        p = p*s + 1.f/7.f;
+        p = p*s + 1.f/5.f;
+        p = p*s + 1.f/3.f;
+        p = p*s + 1.f;
+
+        return e*0.693145751953125f + (2.f*f*p + e*1.428606765330187045e-06f);
+    }
+
+    inline double fast_pow(const double x, const double y)
+    {
+        return double(x > 0.) * fast_exp(y*fast_log(std::max(x, std::numeric_limits<double>::min())));
+    }
+
+    inline float fast_pow(const float x, const float y)
+    {
+        return float(x > 0.f) * fast_exp(y*fast_log(std::max(x, std::numeric_limits<float>::min())));
+    }
+
+    inline double fast_cbrt(const double x)
+    {
+        const double a = std::abs(x);
+
+        // Initial guess from the high word of the bits, followed by four Newton iterations.
+        int64_t bits;
+        std::memcpy(&bits, &a, sizeof(double));
+        const int32_t high = static_cast<int32_t>(bits >> 32) / 3 + 715094163;
+        bits = static_cast<int64_t>(high) << 32;
+        double y;
+        std::memcpy(&y, &bits, sizeof(double));
+
+        for (int n=0; n<4; ++n)
+            y -= (y*y*y - a) / (3.*y*y);
+
+        return (a > 0.) ? std::copysign(y, x) : 0.;
+    }
+
+    inline float fast_cbrt(const float x)
+    {
+        const float a = std::abs(x);
+
+        int32_t bits;
+        std::memcpy(&bits, &a, sizeof(float));
+        bits = bits/3 + 709921077;
+        float y;
+        std::memcpy(&y, &bits, sizeof(float));
+
+        for (int n=0; n<3; ++n)
+            y -= (y*y*y - a) / (3.f*y*y);
+
+        return (a > 0.f) ? std::copysign(y, x) : 0.f;
+    }
+
+    template<typename TF>
+    inline TF fast_erf(const TF x)
+    {
+        const TF a = std::abs(x);
+        const TF t = TF(1.) / (TF(1.) + TF(0.3275911)*a);
+
+        TF p = TF(1.061405429);
+        p = p*t - TF(1.453152027);
+        p = p*t + TF(1.421413741);
+        p = p*t - TF(0.284496736);
+        p = p*t + TF(0.254829592);
+
+        return std::copysign(TF(1.) - p*t*fast_exp(-a*a), x);
+    }
+    #else
+    template<typename TF>
+    CUDA_MACRO inline TF fast_exp(const TF x) { return std::exp(x); }
+
+    template<typename TF>
+    CUDA_MACRO inline TF fast_log(const TF x) { return std::log(x); }
+
+    template<typename TF>
+    CUDA_MACRO inline TF fast_pow(const TF x, const TF y) { return std::pow(x, y); }
+
+    template<typename TF>
+    CUDA_MACRO inline TF fast_cbrt(const TF x) { return std::cbrt(x); }
+
+    template<typename TF>
+    CUDA_MACRO inline TF fast_erf(const TF x) { return std::erf(x); }
+    #endif
 }
 #endif
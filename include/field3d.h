@@ -43,6 +43,8 @@ class Field3d
 
         int init();
 
+        void set_minimum_ghost_cells(const int, const int); // Requests ghost cells for this field only.
+
         // Variables at CPU.
         std::vector<TF> fld;
         std::vector<TF> fld_bot;
@@ -60,6 +62,9 @@ class Field3d
 
         std::array<int,3> loc;
 
+        int igc; // Number of ghost cells in the x-direction that is kept up to date for this field.
+        int jgc; // Number of ghost cells in the y-direction that is kept up to date for this field.
+
         TF visc;
 
         // Device functions and variables
@@ -39,6 +39,20 @@ class Netcdf_handle;
 
 enum class Grid_order { Second, Fourth };
 
+// Spans [i0, i1) of grid points per (j, k) row for which the tendencies are computed.
+// Each row has a single span over the full domain, unless cells are excluded with
+// Grid::set_column_kstart(), for instance those deep inside the immersed boundary.
+struct Row_spans
+{
+    int jcells;
+    std::vector<int> offset; // Index of the first span of row j + k*jcells, size jcells*kcells+1.
+    std::vector<int> i0;     // First i-index of each span.
+    std::vector<int> i1;     // Last i-index+1 of each span.
+
+    int begin(const int j, const int k) const { return offset[j + k*jcells]; }
+    int end  (const int j, const int k) const { return offset[j + k*jcells + 1]; }
+};
+
 template<typename TF>
 struct Grid_data
 {
@@ -60,6 +74,9 @@ struct Grid_data
     int jgc; // Number of ghost cells in the y-direction.
     int kgc; // Number of ghost cells in the z-direction.
 
+    int igc_min; // Number of ghost cells in the x-direction that is required for all fields.
+    int jgc_min; // Number of ghost cells in the y-direction that is required for all fields.
+
     int icells;  // Number of grid cells in the x-direction including ghost cells for one process.
     int jcells;  // Number of grid cells in the y-direction including ghost cells for one process.
     int ijcells; // Number of grid cells in the xy-plane including ghost cells for one process.
@@ -98,6 +115,8 @@ struct Grid_data
     std::vector<TF> yh; // Grid coordinate of cell faces in x-direction.
     std::vector<TF> zh; // Grid coordinate of cell faces in x-direction.
 
+    Row_spans row_spans; // Spans of grid points per row for which the tendencies are computed.
+
     int ithread_block; // Number of grid cells in the x-direction for GPU thread block.
     int jthread_block; // Number of grid cells in the y-direction for GPU thread block.
 
@@ -143,7 +162,13 @@ class Grid
         const Grid_data<TF>& get_grid_data();
         Grid_order get_spatial_order() const { return spatial_order; }
 
-        void set_minimum_ghost_cells(int, int, int);
+        Transpose_type get_transpose_type() const { return transpose_type; }
+        void set_transpose_type(const Transpose_type type) { transpose_type = type; }
+
+        void set_column_kstart(const std::vector<int>&); // Excludes the cells below a per-column start index from the row spans.
+
+        void set_minimum_ghost_cells(int, int, int); // Sets the minimum number of ghost cells for all fields.
+        void reserve_ghost_cells(int, int, int);     // Only increases the number of ghost cells in memory.
 
         // MPI functions
         void init_mpi(); // Creates the MPI data types used in grid operations.
@@ -162,6 +187,7 @@ class Grid
         Transpose<TF> transpose;
 
         Grid_order spatial_order; // Default spatial order of the operators to be used on this grid.
+        Transpose_type transpose_type; // Communication strategy of the transposes.
 
         bool mpitypes;  // Boolean to check whether MPI datatypes are created.
 
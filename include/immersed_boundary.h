@@ -61,6 +61,10 @@ struct Ghost_cells
 
     std::vector<TF> di; // Distance ghost cell to interpolation point
 
+    // Flat 3D indices of the ghost cells and interpolation points (CPU only):
+    std::vector<int> ijk;      // size = number of ghost cells
+    std::vector<int> ip_ijk;   // size = number of ghost cells x n_idw_points
+
     // Points outside IB used for IDW interpolation:
     std::vector<int> ip_i;     // size = number of ghost cells x n_idw_points
     std::vector<int> ip_j;
@@ -133,6 +137,7 @@ class Immersed_boundary
 
         void exec_momentum();
         void exec_scalars();
+        void freeze_skipped_cells(); // Zero the tendencies of the cells skipped with swskipsolid.
 
         void exec_cross(Cross<TF>&, unsigned long);
 
@@ -152,6 +157,8 @@ class Immersed_boundary
         IB_type sw_ib;
 
         int n_idw_points;       // Number of interpolation points in IDW interpolation
+        bool sw_ghost_cache;    // Cache the ghost cells on disk for restarts
+        bool sw_skip_solid;     // Skip the tendencies of cells deep inside the IB
 
         // Boundary conditions for scalars
         Boundary_type sbcbot;
@@ -161,6 +168,7 @@ class Immersed_boundary
         // IB input from DEM
         std::vector<TF> dem;
         std::vector<unsigned int> k_dem;
+        std::vector<int> kstart_col; // First vertical index per column for which tendencies are computed
 
         // All ghost cell properties
         std::map<std::string, Ghost_cells<TF>> ghost;
@@ -170,6 +178,11 @@ class Immersed_boundary
 
         // Cross-sections
         std::vector<std::string> crosslist;
+
+        void init_ghost_cells(
+                const std::string&,
+                const std::vector<TF>&, const std::vector<TF>&, const std::vector<TF>&,
+                Boundary_type);
 };
 
 #endif
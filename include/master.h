@@ -40,6 +40,9 @@ struct MPI_data
     int mpicoordx;
     int mpicoordy;
 
+    int nprocs_rad;  // Number of processes that only solve the radiation for the others.
+    bool rad_server; // This process is a radiation server.
+
     #ifdef USEMPI
     int nnorth;
     int nsouth;
@@ -49,6 +52,10 @@ struct MPI_data
     MPI_Comm commxy;
     MPI_Comm commx;
     MPI_Comm commy;
+
+    bool node_aware; // Processes are ordered per node and transposes within a node use shared memory.
+
+    MPI_Comm commrad; // Intercommunicator between the model and the radiation server processes.
     #endif
 };
 
@@ -115,6 +122,7 @@ class Master
         int reqsn;
 
         int check_error(int);
+        MPI_Comm create_node_ordered_comm(); // Creates a copy of MPI_COMM_WORLD with the processes ordered per node.
         #endif
 };
 #endif
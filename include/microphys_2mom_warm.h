@@ -34,6 +34,7 @@
 
 #include "microphys.h"
 #include "field3d_operators.h"
+#include "fast_math.h"
 
 class Master;
 class Input;
@@ -97,7 +98,11 @@ namespace Micro_2mom_warm_functions
     template<typename TF> CUDA_MACRO
     inline TF calc_rain_diameter(const TF mr)
     {
+        #ifdef USEFASTMATH
+        return Fast_math::fast_cbrt(mr/pirhow<TF>);
+        #else
         return pow(mr/pirhow<TF>, TF(1.)/TF(3.));
+        #endif
     }
 
     // Shape parameter mu_r
@@ -113,7 +118,11 @@ namespace Micro_2mom_warm_functions
     template<typename TF> CUDA_MACRO
     inline TF calc_lambda_r(const TF mur, const TF dr)
     {
+        #ifdef USEFASTMATH
+        return Fast_math::fast_cbrt((mur+3)*(mur+2)*(mur+1)) / dr;
+        #else
         return pow((mur+3)*(mur+2)*(mur+1), TF(1.)/TF(3.)) / dr;
+        #endif
     }
 
     template<typename TF> CUDA_MACRO
@@ -183,6 +192,8 @@ class Microphys_2mom_warm : public Microphys<TF>
 
         bool swmicrobudget;     // Output full microphysics budget terms
         TF cflmax;              // Max CFL number in microphysics sedimentation
+        bool swsedsubcycle;     // Sub-cycle the sedimentation instead of limiting the time step
+        int n_threads;          // Number of OpenMP threads over the XZ slices
 
         std::vector<std::string> crosslist;                  // Cross-sections handled by this class
         std::vector<std::string> available_masks = {"qr"};   // Vector with the masks that fields can provide
@@ -190,6 +201,11 @@ class Microphys_2mom_warm : public Microphys<TF>
         // Surface precipitation statistics
         std::vector<TF> rr_bot;   // 2D surface sedimentation flux (kg m-2 s-1 == mm s-1)
 
+        // Active cell bookkeeping
+        std::vector<int> cloud_cells;   // Indices of cells with cloud water
+        std::vector<int> cloud_offset;  // Start of each level in cloud_cells
+        std::vector<int> rain_count;    // Number of cells with rain per XZ slice
+
         const std::string tend_name = "micro";
         const std::string tend_longname = "Microphysics";
 };
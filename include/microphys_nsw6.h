@@ -77,6 +77,8 @@ class Microphys_nsw6 : public Microphys<TF>
 
         bool swmicrobudget;     // Output full microphysics budget terms
         TF cflmax;              // Max CFL number in microphysics sedimentation
+        int n_threads;          // Number of OpenMP threads in the sedimentation
+        bool swsedsubcycle;     // Sub-cycle the sedimentation instead of limiting the time step
 
         std::vector<std::string> crosslist; // Cross-sections handled by this class
 
@@ -90,5 +92,9 @@ class Microphys_nsw6 : public Microphys<TF>
         std::vector<TF> rr_bot; // Rain rate at the bottom.
         std::vector<TF> rs_bot; // Snow rate at the bottom.
         std::vector<TF> rg_bot; // Graupel rate at the bottom.
+        std::vector<TF> rc_sub; // Surface rate of a sedimentation sub-step.
+
+        std::vector<int> active_cells;  // Indices of cells that contain condensate.
+        std::vector<int> active_offset; // Start of each level in active_cells.
 };
 #endif
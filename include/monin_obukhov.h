@@ -22,6 +22,8 @@
 
 #ifndef MONIN_OBUKHOV_H
 
+#include "fast_math.h"
+
 // In case the code is compiled with NVCC, add the macros for CUDA
 #ifdef __CUDACC__
 #  define CUDA_MACRO __host__ __device__
@@ -38,7 +40,11 @@ namespace Monin_obukhov
     CUDA_MACRO inline TF phim_unstable(const TF zeta)
     {
         // Wilson, 2001 functions, see Wyngaard, page 222.
+        #ifdef USEFASTMATH
+        return TF(1.) / std::sqrt(TF(1.) + TF(3.6)*Fast_math::pow2(Fast_math::fast_cbrt(std::abs(zeta))));
+        #else
         return std::pow(TF(1.) + TF(3.6)*std::pow(std::abs(zeta), TF(2./3.)), TF(-1./2.));
+        #endif
     }
 
     template<typename TF>
@@ -58,7 +64,11 @@ namespace Monin_obukhov
     CUDA_MACRO inline TF phih_unstable(const TF zeta)
     {
         // Wilson, 2001 functions, see Wyngaard, page 222.
+        #ifdef USEFASTMATH
+        return TF(1.) / std::sqrt(TF(1.) + TF(7.9)*Fast_math::pow2(Fast_math::fast_cbrt(std::abs(zeta))));
+        #else
         return std::pow(TF(1.) + TF(7.9)*std::pow(std::abs(zeta), TF(2./3.)), TF(-1./2.));
+        #endif
     }
 
     template<typename TF>
@@ -81,7 +91,7 @@ namespace Monin_obukhov
     CUDA_MACRO inline TF psim_unstable(const TF zeta)
     {
         // Wilson, 2001 functions, see Wyngaard, page 222.
-        return TF(3.)*std::log( ( TF(1.) + TF(1.)/phim_unstable(zeta) ) / TF(2.));
+        return TF(3.)*Fast_math::fast_log( ( TF(1.) + TF(1.)/phim_unstable(zeta) ) / TF(2.));
     }
 
     template<typename TF>
@@ -95,7 +105,7 @@ namespace Monin_obukhov
     CUDA_MACRO inline TF psih_unstable(const TF zeta)
     {
         // Wilson, 2001 functions, see Wyngaard, page 222.
-        return TF(3.) * std::log( ( TF(1.) + TF(1.) / phih_unstable(zeta) ) / TF(2.));
+        return TF(3.) * Fast_math::fast_log( ( TF(1.) + TF(1.) / phih_unstable(zeta) ) / TF(2.));
     }
 
     template<typename TF>
@@ -109,16 +119,16 @@ namespace Monin_obukhov
     CUDA_MACRO inline TF fm(const TF zsl, const TF z0m, const TF L)
     {
         return (L <= TF(0.))
-            ? Constants::kappa<TF> / (std::log(zsl/z0m) - psim_unstable(zsl/L) + psim_unstable(z0m/L))
-            : Constants::kappa<TF> / (std::log(zsl/z0m) - psim_stable  (zsl/L) + psim_stable  (z0m/L));
+            ? Constants::kappa<TF> / (Fast_math::fast_log(zsl/z0m) - psim_unstable(zsl/L) + psim_unstable(z0m/L))
+            : Constants::kappa<TF> / (Fast_math::fast_log(zsl/z0m) - psim_stable  (zsl/L) + psim_stable  (z0m/L));
     }
 
     template<typename TF>
     CUDA_MACRO inline TF fh(const TF zsl, const TF z0h, const TF L)
     {
         return (L <= TF(0.))
-            ? Constants::kappa<TF> / (std::log(zsl/z0h) - psih_unstable(zsl/L) + psih_unstable(z0h/L))
-            : Constants::kappa<TF> / (std::log(zsl/z0h) - psih_stable  (zsl/L) + psih_stable  (z0h/L));
+            ? Constants::kappa<TF> / (Fast_math::fast_log(zsl/z0h) - psih_unstable(zsl/L) + psih_unstable(z0h/L))
+            : Constants::kappa<TF> / (Fast_math::fast_log(zsl/z0h) - psih_stable  (zsl/L) + psih_stable  (z0h/L));
     }
 }
 #endif
@@ -23,6 +23,8 @@
 
 #include <memory>
 #include <vector>
+#include <string>
+#include <stdexcept>
 #include "field3d_operators.h"
 
 class Master;
@@ -71,6 +73,12 @@ class Radiation
 
         virtual void exec_column(Column<TF>&, Thermo<TF>&, Timeloop<TF>&) = 0;
 
+        // Radiation server processes, that solve the radiation for the model processes.
+        virtual void create_server(Input&, Netcdf_handle&)
+        { throw std::runtime_error("Radiation server processes are not supported by this radiation"); }
+        virtual void exec_server()
+        { throw std::runtime_error("Radiation server processes are not supported by this radiation"); }
+
     protected:
         Master& master;
         Grid<TF>& grid;
@@ -21,6 +21,13 @@
 #ifndef RADIATION_RRTMGP_H
 #define RADIATION_RRTMGP_H
 
+#include <map>
+#include <future>
+
+#ifdef USEMPI
+#include <mpi.h>
+#endif
+
 #include "radiation.h"
 #include "field3d_operators.h"
 
@@ -46,7 +53,7 @@ class Radiation_rrtmgp : public Radiation<TF>
 {
 	public:
 		Radiation_rrtmgp(Master&, Grid<TF>&, Fields<TF>&, Input&);
-        virtual ~Radiation_rrtmgp() {}
+        virtual ~Radiation_rrtmgp();
 
 		bool check_field_exists(std::string name)
         { throw std::runtime_error("Not implemented"); }
@@ -67,7 +74,10 @@ class Radiation_rrtmgp : public Radiation<TF>
                 Thermo<TF>&, Timeloop<TF>&,
                 const unsigned long, const int);
 
-        void exec_column(Column<TF>&, Thermo<TF>&, Timeloop<TF>&) {};
+        void exec_column(Column<TF>&, Thermo<TF>&, Timeloop<TF>&);
+
+        void create_server(Input&, Netcdf_handle&);
+        void exec_server();
 
 	private:
 		using Radiation<TF>::swradiation;
@@ -94,20 +104,54 @@ class Radiation_rrtmgp : public Radiation<TF>
                 Input&, Netcdf_handle&, Thermo<TF>&, Stats<TF>&,
                 const Gas_concs<double>&);
 
+        void sample_columns(const unsigned long);
+        void gather_columns(const Array<double,2>&, Array<double,2>&) const;
+        void expand_columns(const Array<double,2>&, Array<double,2>&) const;
+
+        void get_radiation_input(
+                Thermo<TF>&,
+                Array<double,2>&, Array<double,2>&,
+                Array<double,2>&, Array<double,2>&,
+                Array<double,2>&, Array<double,2>&, Array<double,2>&);
+
+        void solve_tendency(
+                std::vector<TF>&, const unsigned long,
+                const Array<double,2>&, const Array<double,2>&,
+                const Array<double,2>&, const Array<double,2>&,
+                const Array<double,2>&, const Array<double,2>&, const Array<double,2>&,
+                const std::vector<TF>&, const std::vector<TF>&,
+                const bool);
+
+        bool async_ready();
+        void finish_async();
+
+        void bcast_reference_columns();
+        #ifdef USEMPI
+        void send_to_server(
+                const unsigned long,
+                const Array<double,2>&, const Array<double,2>&,
+                const Array<double,2>&, const Array<double,2>&,
+                const Array<double,2>&, const Array<double,2>&, const Array<double,2>&,
+                const std::vector<TF>&, const std::vector<TF>&);
+        #endif
+
         void exec_longwave(
-                Thermo<TF>&, Timeloop<TF>&, Stats<TF>&,
+                const unsigned long, const Array<double,2>&, const Array<double,2>&,
                 Array<double,2>&, Array<double,2>&, Array<double,2>&,
                 const Array<double,2>&, const Array<double,2>&,
                 const Array<double,2>&, const Array<double,2>&, const Array<double,2>&,
                 const bool);
 
         void exec_shortwave(
-                Thermo<TF>&, Timeloop<TF>&, Stats<TF>&,
+                const unsigned long, const Array<double,2>&, const Array<double,2>&,
                 Array<double,2>&, Array<double,2>&, Array<double,2>&, Array<double,2>&,
                 const Array<double,2>&, const Array<double,2>&,
                 const Array<double,2>&, const Array<double,2>&, const Array<double,2>&,
                 const bool);
 
+        void update_cache(Thermo<TF>&, Timeloop<TF>&, const unsigned long);
+        std::vector<std::string> get_output_names() const;
+
         // void exec_stats(Stats<TF>&, Thermo<TF>&, Timeloop<TF>&);
         // void exec_cross(Cross<TF>&, const int, Thermo<TF>&, Timeloop<TF>&);
         // void exec_dump(Dump<TF>&, const int, Thermo<TF>&, Timeloop<TF>&) {};
@@ -120,9 +164,53 @@ class Radiation_rrtmgp : public Radiation<TF>
         bool sw_clear_sky_stats;
         double dt_rad;
         unsigned long idt_rad;
+        unsigned long itime_rad_next; // Time of the next radiation call.
+
+        bool sw_limit_dt;    // Switch to limit the time step to the radiation times.
+        bool sw_tend_extrap; // Switch to extrapolate the heating rate between radiation calls.
+
+        // Heating rate and times of the two last radiation calls, used for the extrapolation.
+        std::vector<TF> thlt_rad_prev;
+        double time_rad;
+        double time_rad_prev;
+
+        // Radiation on a helper thread, its heating rate replaces thlt_rad once finished.
+        bool sw_async;
+        std::future<void> rad_future;
+        std::vector<TF> thlt_rad_async;
+        double time_rad_async;
+
+        // Radiation on the server processes, with the same lag as on the helper thread.
+        bool sw_rad_server;
+        bool rad_server_pending;   // A solve has been sent to the server and is not received yet.
+        bool rad_server_connected; // The server waits for a finish message of this process.
+        #ifdef USEMPI
+        unsigned long rad_send_header[3];
+        std::vector<double> rad_send_buffer;
+        std::vector<double> rad_recv_buffer;
+        MPI_Request rad_reqs[3];
+        #endif
+
+        // Coordinates of the subdomain that is solved, for the random column and g-point samples.
+        int solve_coordx;
+        int solve_coordy;
+
+        int n_col_block; // Number of columns that are solved simultaneously per thread.
+        int n_threads;   // Number of threads that solve the column blocks.
+
+        // Monte Carlo spectral and spatial sampling.
+        int n_gpt_sample;       // Number of g-points solved per column, 0 solves all.
+        int sample_tile_size;   // One random column is solved per tile of sample_tile_size^2 columns.
+        unsigned long sample_seed;
+        std::vector<int> col_sample;              // Local indices of the solved columns.
+        std::vector<unsigned long> col_sample_id; // Global indices of the solved columns.
 
         std::vector<std::string> crosslist;
 
+        // Fluxes of the time step rad_cache_itime, shared by the tendency, stats, cross and column output.
+        unsigned long rad_cache_itime;
+        std::map<std::string, Array<double,2>> rad_cache;
+
         // RRTMGP related variables.
         double tsi_scaling; // Total solar irradiance scaling factor.
         double t_sfc;       // Surface absolute temperature in K.
@@ -137,6 +225,15 @@ class Radiation_rrtmgp : public Radiation<TF>
         Array<double,2> sw_flux_dn_dir_inc;
         Array<double,2> sw_flux_dn_dif_inc;
 
+        // Coefficient files of the gas and cloud optics, the reference files are only used to report
+        // the accuracy of a reduced k-distribution on the reference column.
+        std::string coef_lw_file;
+        std::string coef_sw_file;
+        std::string cloud_coef_lw_file;
+        std::string cloud_coef_sw_file;
+        std::string coef_lw_ref_file;
+        std::string coef_sw_ref_file;
+
         // The full solver.
         Gas_concs<double> gas_concs;
         std::unique_ptr<Gas_optics<double>> kdist_lw;
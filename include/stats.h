@@ -83,6 +83,9 @@ struct Mask
 template<typename TF>
 using Mask_map = std::map<std::string, Mask<TF>>;
 
+template<typename TF>
+inline TF in_mask(const unsigned int mask, const unsigned int flag) { return static_cast<TF>( (mask & flag) != 0 ); }
+
 enum class Stats_mask_type {Plus, Min};
 enum class Stats_whitelist_type {White, Black, Default};
 
@@ -101,6 +104,7 @@ class Stats
         bool do_statistics(unsigned long);
         bool do_tendency() {return swtendency; }
         void set_tendency(bool);
+        bool get_tendency() const { return doing_tendency; }
 
         void initialize_masks();
         void finalize_masks();
@@ -145,6 +149,10 @@ class Stats
                 const std::pair<const std::string, Mask<TF>>&,
                 const Field3d<TF>&);
 
+        void set_mask_mean_prof(
+                std::pair<const std::string, Mask<TF>>&,
+                const std::string&, const double* const);
+
         void calc_stats(const std::string&, const Field3d<TF>&, const TF, const TF);
         void calc_stats_2d(const std::string&, const std::vector<TF>&, const TF);
         void calc_covariance(const std::string&, const Field3d<TF>&, const TF, const TF, const int,
@@ -154,6 +162,7 @@ class Stats
         void set_time_series(const std::string&, const TF);
 
         Mask_map<TF>& get_masks() { return masks; }
+        const std::vector<unsigned int>& get_mask_field() const { return mfield; }
 
     private:
         Master& master;
@@ -186,6 +195,8 @@ class Stats
         // Tendency calculations
         std::map<std::string, std::vector<std::string>> tendency_order;
 
+        void calc_moment_stats(std::vector<Mask<TF>*>&, const std::string&, const Field3d<TF>&, const TF, const TF);
+
         void calc_flux_2nd(TF*, const TF* const, const TF* const, const TF, TF* const, const TF* const, TF*, const int*, const unsigned int* const, const unsigned int, const int* const,
                           const int, const int, const int, const int, const int, const int, const int, const int);
         void calc_flux_4th(TF*, const TF* const, const TF* const, TF* const, const TF* const, TF*, const int*, const unsigned int* const, const unsigned int, const int* const,
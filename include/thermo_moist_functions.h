@@ -103,7 +103,11 @@ namespace Thermo_moist_functions
         const TF x = std::max(TF(-100.), T-T0<TF>);
         #endif
 
+        #ifdef USEFASTMATH
+        return TF(611.15)*Fast_math::fast_exp(TF(22.452)*x / (TF(272.55)+x));
+        #else
         return TF(611.15)*std::exp(22.452*x / (272.55+x));
+        #endif
     }
 
     template<typename TF>
@@ -148,7 +152,11 @@ namespace Thermo_moist_functions
     template<typename TF>
     CUDA_MACRO inline TF exner(const TF p)
     {
+        #ifdef USEFASTMATH
+        return Fast_math::fast_pow(p/p0<TF>, Rd<TF>/cp<TF>);
+        #else
         return pow((p/p0<TF>), (Rd<TF>/cp<TF>));
+        #endif
     }
 
     template<typename TF>
@@ -25,13 +25,19 @@
 
 #ifdef USEMPI
 #include <mpi.h>
+#include <memory>
+#include "comm_plan.h"
 #endif
 
+#include <vector>
 #include "defines.h"
 
 class Master;
 template<typename> class Grid;
 
+// Communication strategies for the transposes, Auto selects the fastest one at startup.
+enum class Transpose_type {Datatype, Alltoall, Pairwise, Persistent, Auto};
+
 template<typename TF>
 class Transpose
 {
@@ -57,6 +63,56 @@ class Transpose
         bool mpi_types_allocated;
 
         #ifdef USEMPI
+        struct Transpose_block
+        {
+            MPI_Datatype* type; ///< Derived datatype describing the block.
+            int count;          ///< Number of contiguous chunks in the block.
+            int length;         ///< Number of elements per chunk.
+            int stride;         ///< Distance between the starts of two chunks.
+            int step;           ///< Offset between the blocks of two consecutive processes.
+        };
+
+        struct Transpose_plan
+        {
+            MPI_Comm comm; ///< Communicator over which the transpose is done.
+            int np;        ///< Number of processes in the communicator.
+            int rank;      ///< Rank of this process in the communicator.
+            Transpose_block send;
+            Transpose_block recv;
+            std::unique_ptr<Comm_plan> comm_plan; ///< Persistent messages on the packed buffers.
+            std::vector<TF*> shared; ///< Shared memory buffers of all processes, empty if not on one node.
+            MPI_Win* shared_win;     ///< Shared memory window that holds the buffers.
+        };
+
+        void exec(const Transpose_plan&, TF* const restrict, TF* const restrict);
+        void exec_datatype(const Transpose_plan&, TF* const restrict, TF* const restrict);
+        void exec_alltoall(const Transpose_plan&, TF* const restrict, TF* const restrict);
+        void exec_pairwise(const Transpose_plan&, TF* const restrict, TF* const restrict);
+        void exec_persistent(const Transpose_plan&, TF* const restrict, TF* const restrict);
+        void exec_shared(const Transpose_plan&, TF* const restrict, TF* const restrict);
+
+        void init_persistent(Transpose_plan&); ///< Registers the persistent messages of a plan.
+        bool init_shared(MPI_Comm, MPI_Win&, std::vector<TF*>&); ///< Allocates a shared memory window if the communicator is on one node.
+
+        void autotune(); ///< Times all transpose types and selects the fastest one.
+
+        Transpose_type transpose_type;
+
+        Transpose_plan plan_zx;
+        Transpose_plan plan_xz;
+        Transpose_plan plan_xy;
+        Transpose_plan plan_yx;
+        Transpose_plan plan_yz;
+        Transpose_plan plan_zy;
+
+        bool shared_x; ///< True if the transposes over commx go through shared memory.
+        bool shared_y; ///< True if the transposes over commy go through shared memory.
+        MPI_Win win_x; ///< Shared memory window over commx.
+        MPI_Win win_y; ///< Shared memory window over commy.
+
+        std::vector<TF> sendbuf; ///< Buffer for packed data of the Alltoall, Pairwise and Persistent transposes.
+        std::vector<TF> recvbuf; ///< Buffer for packed data of the Alltoall, Pairwise and Persistent transposes.
+
         MPI_Datatype transposez;  ///< MPI datatype containing base blocks for z-orientation in zx-transpose.
         MPI_Datatype transposez2; ///< MPI datatype containing base blocks for z-orientation in zy-transpose.
         MPI_Datatype transposex;  ///< MPI datatype containing base blocks for x-orientation in zx-transpose.
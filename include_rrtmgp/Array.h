@@ -29,6 +29,8 @@
 #include <vector>
 #include <algorithm>
 #include <iostream>
+#include <utility>
+#include <stdexcept>
 
 template<int N>
 inline std::array<int, N> calc_strides(const std::array<int, N>& dims)
@@ -111,22 +113,33 @@ class Array
         Array(std::vector<T>&& data, const std::array<int, N>& dims) :
             dims(dims),
             ncells(product<N>(dims)),
-            data(data),
+            data(std::move(data)),
             strides(calc_strides<N>(dims)),
             offsets({})
         {} // CvH Do we need to size check data?
 
         // Define the default copy constructor and assignment operator.
-        // Array(const Array<T, N>&) = default;
-        // Array<T,N>& operator=(const Array<T, N>&) = default; // CvH does this one need empty checking?
+        Array(const Array<T, N>&) = default;
+        Array<T,N>& operator=(const Array<T, N>&) = default; // CvH does this one need empty checking?
+
+        // Moving takes over the data and leaves an empty array behind.
+        Array(Array<T, N>&& array) :
+            dims(std::exchange(array.dims, {})),
+            ncells(std::exchange(array.ncells, 0)),
+            data(std::move(array.data)),
+            strides(std::exchange(array.strides, {})),
+            offsets(std::exchange(array.offsets, {}))
+        {}
 
-        // Array(Array<T, N>&& array) :
-        //     dims(std::exchange(array.dims, {})),
-        //     ncells(std::exchange(array.ncells, 0)),
-        //     data(std::move(array.data)),
-        //     strides(std::exchange(array.strides, {})),
-        //     offsets(std::exchange(array.offsets, {}))
-        // {}
+        Array<T,N>& operator=(Array<T, N>&& array)
+        {
+            dims = std::exchange(array.dims, {});
+            ncells = std::exchange(array.ncells, 0);
+            data = std::move(array.data);
+            strides = std::exchange(array.strides, {});
+            offsets = std::exchange(array.offsets, {});
+            return *this;
+        }
 
         inline void set_offsets(const std::array<int, N>& offsets)
         {
@@ -172,7 +185,7 @@ class Array
         inline void operator=(std::vector<T>&& data)
         {
             // CvH check size.
-            this->data = data;
+            this->data = std::move(data);
         }
 
         inline T& operator()(const std::array<int, N>& indices)
@@ -192,6 +205,16 @@ class Array
 
         inline Array<T, N> subset(
                 const std::array<std::pair<int, int>, N> ranges) const
+        {
+            Array<T, N> a_sub;
+            subset_to(ranges, a_sub);
+            return a_sub;
+        }
+
+        // Copy a subset into an existing array, which is only reallocated if its dimensions differ.
+        // Dimensions of size 1 are spread over the range.
+        inline void subset_to(
+                const std::array<std::pair<int, int>, N> ranges, Array<T, N>& a_sub) const
         {
             // Calculate the dimension sizes based on the range.
             std::array<int, N> subdims;
@@ -204,22 +227,35 @@ class Array
                 do_spread[i] = (dims[i] == 1);
             }
 
-            // Create the array and fill it with the subset.
-            Array<T, N> a_sub(subdims);
-            for (int i=0; i<a_sub.ncells; ++i)
+            if (a_sub.dims != subdims)
+                a_sub = Array<T, N>(subdims);
+            else
+                a_sub.offsets = {};
+
+            // The fastest varying dimension is contiguous in memory, copy it in runs.
+            const int n_run = subdims[0];
+            const int n_runs = a_sub.ncells / n_run;
+
+            for (int r=0; r<n_runs; ++r)
             {
                 std::array<int, N> index;
-                int ic = i;
+                int ir = r;
                 for (int n=N-1; n>0; --n)
                 {
-                    index[n] = do_spread[n] ? 1 : ic / a_sub.strides[n] + ranges[n].first;
-                    ic %= a_sub.strides[n];
+                    const int stride_run = a_sub.strides[n] / n_run;
+                    index[n] = do_spread[n] ? 1 : ir / stride_run + ranges[n].first;
+                    ir %= stride_run;
                 }
-                index[0] = do_spread[0] ? 1 : ic + ranges[0].first;
-                a_sub.data[i] = (*this)(index);
-            }
+                index[0] = do_spread[0] ? 1 : ranges[0].first;
 
-            return a_sub;
+                const T* src = data.data() + calc_index<N>(index, strides, offsets);
+                T* dst = a_sub.data.data() + r*n_run;
+
+                if (do_spread[0])
+                    std::fill(dst, dst + n_run, *src);
+                else
+                    std::copy(src, src + n_run, dst);
+            }
         }
 
     private:
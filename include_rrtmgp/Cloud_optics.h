@@ -25,6 +25,8 @@
 #ifndef CLOUD_OPTICS_H
 #define CLOUD_OPTICS_H
 
+#include <vector>
+
 #include "Array.h"
 #include "Optical_props.h"
 
@@ -46,13 +48,15 @@ class Cloud_optics : public Optical_props<TF>
                 const Array<int,2>& liqmsk, const Array<int,2>& icemsk,
                 const Array<TF,2>& clwp, const Array<TF,2>& ciwp,
                 const Array<TF,2>& reliq, const Array<TF,2>& reice,
-                Optical_props_1scl<TF>& optical_props);
+                Optical_props_1scl<TF>& optical_props,
+                std::vector<int>& index, std::vector<TF>& fint);
 
         void cloud_optics(
                 const Array<int,2>& liqmsk, const Array<int,2>& icemsk,
                 const Array<TF,2>& clwp, const Array<TF,2>& ciwp,
                 const Array<TF,2>& reliq, const Array<TF,2>& reice,
-                Optical_props_2str<TF>& optical_props);
+                Optical_props_2str<TF>& optical_props,
+                std::vector<int>& index, std::vector<TF>& fint);
 
     private:
         int liq_nsteps;
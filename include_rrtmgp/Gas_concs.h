@@ -36,6 +36,9 @@ class Gas_concs
         Gas_concs() {}
         Gas_concs(const Gas_concs& gas_concs_ref, const int start, const int size);
 
+        // Fill with a subset of columns of another set, reusing the existing arrays.
+        void set_subset(const Gas_concs& gas_concs_ref, const int start, const int size);
+
         // Insert new gas into the map.
         void set_vmr(const std::string& name, const TF data);
         void set_vmr(const std::string& name, const Array<TF,1>& data);
@@ -47,6 +47,18 @@ class Rte_lw
                 Array<TF,3>& gpt_flux_dn,
                 const int n_gauss_angles);
 
+        // Solve only the g-points in gpt_sel (ncol, nsel) of each column, the fluxes have nsel g-points.
+        static void rte_lw_gpt_subset(
+                const std::unique_ptr<Optical_props_arry<TF>>& optical_props,
+                const int top_at_1,
+                const Source_func_lw<TF>& sources,
+                const Array<TF,2>& sfc_emis,
+                const Array<TF,2>& inc_flux,
+                const Array<int,2>& gpt_sel,
+                Array<TF,3>& gpt_flux_up,
+                Array<TF,3>& gpt_flux_dn,
+                const int n_gauss_angles);
+
         static void expand_and_transpose(
                 const std::unique_ptr<Optical_props_arry<TF>>& ops,
                 const Array<TF,2> arr_in,
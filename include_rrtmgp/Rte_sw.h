@@ -48,6 +48,20 @@ class Rte_sw
                 Array<TF,3>& gpt_flux_dn,
                 Array<TF,3>& gpt_flux_dir);
 
+        // Solve only the g-points in gpt_sel (ncol, nsel) of each column, the fluxes have nsel g-points.
+        static void rte_sw_gpt_subset(
+                const std::unique_ptr<Optical_props_arry<TF>>& optical_props,
+                const int top_at_1,
+                const Array<TF,1>& mu0,
+                const Array<TF,2>& inc_flux_dir,
+                const Array<TF,2>& sfc_alb_dir,
+                const Array<TF,2>& sfc_alb_dif,
+                const Array<TF,2>& inc_flux_dif,
+                const Array<int,2>& gpt_sel,
+                Array<TF,3>& gpt_flux_up,
+                Array<TF,3>& gpt_flux_dn,
+                Array<TF,3>& gpt_flux_dir);
+
         static void expand_and_transpose(
                 const std::unique_ptr<Optical_props_arry<TF>>& ops,
                 const Array<TF,2> arr_in,
@@ -0,0 +1,181 @@
+/*
+ * MicroHH
+ * Copyright (c) 2011-2020 Chiel van Heerwaarden
+ * Copyright (c) 2011-2020 Thijs Heus
+ * Copyright (c) 2014-2020 Bart van Stratum
+ *
+ * This file is part of MicroHH
+ *
+ * MicroHH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * MicroHH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with MicroHH.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Checks the functions of fast_math.h against the standard library over their input range
+// and compares the largest error with the bounds documented in fast_math.h. The reference
+// is evaluated in long double, as the standard library is not correctly rounded for all
+// functions (glibc cbrt is off by up to 3 ULP). Returns 1 if any bound is exceeded.
+
+#include <cstdio>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <algorithm>
+#include "fast_math.h"
+
+namespace
+{
+    constexpr int n_points = 1000000;
+
+    // Error of a in units in the last place of the reference b, which is rounded to TF.
+    template<typename TF>
+    double ulp_error(const TF a, const long double b_ld)
+    {
+        const TF b = static_cast<TF>(b_ld);
+        const TF ulp = std::nextafter(std::abs(b), std::numeric_limits<TF>::infinity()) - std::abs(b);
+        return std::abs(static_cast<double>(a) - static_cast<double>(b)) / ulp;
+    }
+
+    template<typename TF>
+    std::string type_name() { return std::is_same<TF, double>::value ? "double" : "float"; }
+
+    template<typename TF>
+    bool report(const std::string& name, const std::string& unit, const double err, const double bound)
+    {
+        const bool pass = err <= bound;
+        std::printf("%-9s %-6s max error %9.3e, bound %9.3e %-3s %s\n",
+                name.c_str(), type_name<TF>().c_str(), err, bound, unit.c_str(), pass ? "OK" : "FAILED");
+        return pass;
+    }
+
+    // Sample x linearly between x_min and x_max.
+    template<typename TF>
+    TF lin(const int n, const TF x_min, const TF x_max)
+    {
+        return x_min + (x_max - x_min) * static_cast<TF>(n) / (n_points-1);
+    }
+
+    // Sample x logarithmically between 10^e_min and 10^e_max.
+    template<typename TF>
+    TF log10_space(const int n, const TF e_min, const TF e_max)
+    {
+        return std::pow(TF(10.), lin(n, e_min, e_max));
+    }
+
+    template<typename TF>
+    bool check_exp()
+    {
+        const TF x_min = std::is_same<TF, double>::value ? TF(-708.) : TF(-87.);
+        const TF x_max = std::is_same<TF, double>::value ? TF( 709.) : TF( 88.);
+
+        double err = 0.;
+        for (int n=0; n<n_points; ++n)
+        {
+            const TF x = lin(n, x_min, x_max);
+            err = std::max(err, ulp_error(Fast_math::fast_exp(x), std::exp(static_cast<long double>(x))));
+        }
+        return report<TF>("exp", "ULP", err, 2.);
+    }
+
+    template<typename TF>
+    bool check_log()
+    {
+        const TF e_max = std::is_same<TF, double>::value ? TF(307.) : TF(37.);
+
+        double err = 0.;
+        for (int n=0; n<n_points; ++n)
+        {
+            const TF x = log10_space(n, -e_max, e_max);
+            err = std::max(err, ulp_error(Fast_math::fast_log(x), std::log(static_cast<long double>(x))));
+        }
+        return report<TF>("log", "ULP", err, 3.);
+    }
+
+    // The error bound of pow scales with the magnitude of y*log(x), the error is reported
+    // relative to that bound.
+    template<typename TF>
+    bool check_pow()
+    {
+        constexpr int n_y = 61;
+
+        double err = 0.;
+        for (int m=0; m<n_y; ++m)
+        {
+            const TF y = TF(-3.) + TF(6.) * m / (n_y-1);
+            for (int n=0; n<n_points/n_y; ++n)
+            {
+                const TF x = std::pow(TF(10.), TF(-10.) + TF(20.) * n / (n_points/n_y - 1));
+                const double bound = 3.*(1. + std::abs(y*std::log(x)));
+                err = std::max(err, ulp_error(Fast_math::fast_pow(x, y), std::pow(static_cast<long double>(x), static_cast<long double>(y))) / bound);
+            }
+        }
+        return report<TF>("pow", "ULP", err, 1.);
+    }
+
+    template<typename TF>
+    bool check_cbrt()
+    {
+        const TF e_max = std::is_same<TF, double>::value ? TF(300.) : TF(37.);
+
+        double err = 0.;
+        for (int n=0; n<n_points; ++n)
+        {
+            const TF x = log10_space(n, -e_max, e_max);
+            err = std::max(err, ulp_error(Fast_math::fast_cbrt( x), std::cbrt(static_cast<long double>( x))));
+            err = std::max(err, ulp_error(Fast_math::fast_cbrt(-x), std::cbrt(static_cast<long double>(-x))));
+        }
+        if (Fast_math::fast_cbrt(TF(0.)) != TF(0.))
+            err = std::numeric_limits<double>::infinity();
+        return report<TF>("cbrt", "ULP", err, 1.);
+    }
+
+    template<typename TF>
+    bool check_erf()
+    {
+        const double bound = std::is_same<TF, double>::value ? 1.5e-7 : 6e-7;
+
+        double err = 0.;
+        for (int n=0; n<n_points; ++n)
+        {
+            const TF x = lin(n, TF(-6.), TF(6.));
+            err = std::max(err, static_cast<double>(std::abs(Fast_math::fast_erf(x) - std::erf(static_cast<long double>(x)))));
+        }
+        return report<TF>("erf", "", err, bound);
+    }
+
+    template<typename TF>
+    bool check_all()
+    {
+        bool pass = true;
+        pass &= check_exp <TF>();
+        pass &= check_log <TF>();
+        pass &= check_pow <TF>();
+        pass &= check_cbrt<TF>();
+        pass &= check_erf <TF>();
+        return pass;
+    }
+}
+
+int main()
+{
+    #ifndef USEFASTMATH
+    std::printf("Fast math: Disabled, the functions forward to the standard library\n");
+    return 0;
+    #else
+    bool pass = true;
+    pass &= check_all<double>();
+    pass &= check_all<float>();
+
+    return pass ? 0 : 1;
+    #endif
+}
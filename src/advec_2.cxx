@@ -82,8 +82,9 @@ namespace
             const TF* const restrict u, const TF* const restrict v, const TF* const restrict w,
             const TF* const restrict dzi, const TF dx, const TF dy,
             const TF* const restrict rhoref, const TF* const restrict rhorefh,
-            const int istart, const int iend, const int jstart, const int jend, const int kstart, const int kend,
-            const int jj, const int kk)
+            const int jstart, const int jend, const int kstart, const int kend,
+            const int jj, const int kk,
+            const Row_spans& row_spans)
     {
         const int ii = 1;
 
@@ -92,20 +93,21 @@ namespace
 
         for (int k=kstart; k<kend; ++k)
             for (int j=jstart; j<jend; ++j)
-                #pragma ivdep
-                for (int i=istart; i<iend; ++i)
-                {
-                    const int ijk = i + j*jj + k*kk;
-                    ut[ijk] +=
-                             - ( interp2(u[ijk   ], u[ijk+ii]) * interp2(u[ijk   ], u[ijk+ii])
-                               - interp2(u[ijk-ii], u[ijk   ]) * interp2(u[ijk-ii], u[ijk   ]) ) * dxi
-
-                             - ( interp2(v[ijk-ii+jj], v[ijk+jj]) * interp2(u[ijk   ], u[ijk+jj])
-                               - interp2(v[ijk-ii   ], v[ijk   ]) * interp2(u[ijk-jj], u[ijk   ]) ) * dyi
-
-                             - ( rhorefh[k+1] * interp2(w[ijk-ii+kk], w[ijk+kk]) * interp2(u[ijk   ], u[ijk+kk])
-                               - rhorefh[k  ] * interp2(w[ijk-ii   ], w[ijk   ]) * interp2(u[ijk-kk], u[ijk   ]) ) / rhoref[k] * dzi[k];
-                }
+                for (int n=row_spans.begin(j, k); n<row_spans.end(j, k); ++n)
+                    #pragma ivdep
+                    for (int i=row_spans.i0[n]; i<row_spans.i1[n]; ++i)
+                    {
+                        const int ijk = i + j*jj + k*kk;
+                        ut[ijk] +=
+                                 - ( interp2(u[ijk   ], u[ijk+ii]) * interp2(u[ijk   ], u[ijk+ii])
+                                   - interp2(u[ijk-ii], u[ijk   ]) * interp2(u[ijk-ii], u[ijk   ]) ) * dxi
+
+                                 - ( interp2(v[ijk-ii+jj], v[ijk+jj]) * interp2(u[ijk   ], u[ijk+jj])
+                                   - interp2(v[ijk-ii   ], v[ijk   ]) * interp2(u[ijk-jj], u[ijk   ]) ) * dyi
+
+                                 - ( rhorefh[k+1] * interp2(w[ijk-ii+kk], w[ijk+kk]) * interp2(u[ijk   ], u[ijk+kk])
+                                   - rhorefh[k  ] * interp2(w[ijk-ii   ], w[ijk   ]) * interp2(u[ijk-kk], u[ijk   ]) ) / rhoref[k] * dzi[k];
+                    }
     }
 
     template<typename TF>
@@ -113,8 +115,9 @@ namespace
             const TF* const restrict u, const TF* const restrict v, const TF* const restrict w,
             const TF* const restrict dzi, const TF dx, const TF dy,
             const TF* const restrict rhoref, const TF* const restrict rhorefh,
-            const int istart, const int iend, const int jstart, const int jend, const int kstart, const int kend,
-            const int jj, const int kk)
+            const int jstart, const int jend, const int kstart, const int kend,
+            const int jj, const int kk,
+            const Row_spans& row_spans)
     {
         const int ii = 1;
 
@@ -123,20 +126,21 @@ namespace
 
         for (int k=kstart; k<kend; ++k)
             for (int j=jstart; j<jend; ++j)
-                #pragma ivdep
-                for (int i=istart; i<iend; ++i)
-                {
-                    const int ijk = i + j*jj + k*kk;
-                    vt[ijk] +=
-                             - ( interp2(u[ijk+ii-jj], u[ijk+ii]) * interp2(v[ijk   ], v[ijk+ii])
-                               - interp2(u[ijk   -jj], u[ijk   ]) * interp2(v[ijk-ii], v[ijk   ]) ) * dxi
-
-                             - ( interp2(v[ijk   ], v[ijk+jj]) * interp2(v[ijk   ], v[ijk+jj])
-                               - interp2(v[ijk-jj], v[ijk   ]) * interp2(v[ijk-jj], v[ijk   ]) ) * dyi
-
-                             - ( rhorefh[k+1] * interp2(w[ijk-jj+kk], w[ijk+kk]) * interp2(v[ijk   ], v[ijk+kk])
-                               - rhorefh[k  ] * interp2(w[ijk-jj   ], w[ijk   ]) * interp2(v[ijk-kk], v[ijk   ]) ) / rhoref[k] * dzi[k];
-                }
+                for (int n=row_spans.begin(j, k); n<row_spans.end(j, k); ++n)
+                    #pragma ivdep
+                    for (int i=row_spans.i0[n]; i<row_spans.i1[n]; ++i)
+                    {
+                        const int ijk = i + j*jj + k*kk;
+                        vt[ijk] +=
+                                 - ( interp2(u[ijk+ii-jj], u[ijk+ii]) * interp2(v[ijk   ], v[ijk+ii])
+                                   - interp2(u[ijk   -jj], u[ijk   ]) * interp2(v[ijk-ii], v[ijk   ]) ) * dxi
+
+                                 - ( interp2(v[ijk   ], v[ijk+jj]) * interp2(v[ijk   ], v[ijk+jj])
+                                   - interp2(v[ijk-jj], v[ijk   ]) * interp2(v[ijk-jj], v[ijk   ]) ) * dyi
+
+                                 - ( rhorefh[k+1] * interp2(w[ijk-jj+kk], w[ijk+kk]) * interp2(v[ijk   ], v[ijk+kk])
+                                   - rhorefh[k  ] * interp2(w[ijk-jj   ], w[ijk   ]) * interp2(v[ijk-kk], v[ijk   ]) ) / rhoref[k] * dzi[k];
+                    }
     }
 
     template<typename TF>
@@ -144,8 +148,9 @@ namespace
             const TF* const restrict u, const TF* const restrict v, TF* const restrict w,
             const TF* const restrict dzhi, const TF dx, const TF dy,
             const TF* const restrict rhoref, const TF* const restrict rhorefh,
-            const int istart, const int iend, const int jstart, const int jend, const int kstart, const int kend,
-            const int jj, const int kk)
+            const int jstart, const int jend, const int kstart, const int kend,
+            const int jj, const int kk,
+            const Row_spans& row_spans)
     {
         const int ii = 1;
 
@@ -154,20 +159,21 @@ namespace
 
         for (int k=kstart+1; k<kend; ++k)
             for (int j=jstart; j<jend; ++j)
-                #pragma ivdep
-                for (int i=istart; i<iend; ++i)
-                {
-                    const int ijk = i + j*jj + k*kk;
-                    wt[ijk] +=
-                             - ( interp2(u[ijk+ii-kk], u[ijk+ii]) * interp2(w[ijk   ], w[ijk+ii])
-                               - interp2(u[ijk   -kk], u[ijk   ]) * interp2(w[ijk-ii], w[ijk   ]) ) * dxi
-
-                             - ( interp2(v[ijk+jj-kk], v[ijk+jj]) * interp2(w[ijk   ], w[ijk+jj])
-                               - interp2(v[ijk   -kk], v[ijk   ]) * interp2(w[ijk-jj], w[ijk   ]) ) * dyi
-
-                             - ( rhoref[k  ] * interp2(w[ijk   ], w[ijk+kk]) * interp2(w[ijk   ], w[ijk+kk])
-                               - rhoref[k-1] * interp2(w[ijk-kk], w[ijk   ]) * interp2(w[ijk-kk], w[ijk   ]) ) / rhorefh[k] * dzhi[k];
-                }
+                for (int n=row_spans.begin(j, k); n<row_spans.end(j, k); ++n)
+                    #pragma ivdep
+                    for (int i=row_spans.i0[n]; i<row_spans.i1[n]; ++i)
+                    {
+                        const int ijk = i + j*jj + k*kk;
+                        wt[ijk] +=
+                                 - ( interp2(u[ijk+ii-kk], u[ijk+ii]) * interp2(w[ijk   ], w[ijk+ii])
+                                   - interp2(u[ijk   -kk], u[ijk   ]) * interp2(w[ijk-ii], w[ijk   ]) ) * dxi
+
+                                 - ( interp2(v[ijk+jj-kk], v[ijk+jj]) * interp2(w[ijk   ], w[ijk+jj])
+                                   - interp2(v[ijk   -kk], v[ijk   ]) * interp2(w[ijk-jj], w[ijk   ]) ) * dyi
+
+                                 - ( rhoref[k  ] * interp2(w[ijk   ], w[ijk+kk]) * interp2(w[ijk   ], w[ijk+kk])
+                                   - rhoref[k-1] * interp2(w[ijk-kk], w[ijk   ]) * interp2(w[ijk-kk], w[ijk   ]) ) / rhorefh[k] * dzhi[k];
+                    }
     }
 
     template<typename TF>
@@ -175,8 +181,9 @@ namespace
             const TF* const restrict u, const TF* const restrict v, const TF* const restrict w,
             const TF* const restrict dzi, const TF dx, const TF dy,
             const TF* const restrict rhoref, const TF* const restrict rhorefh,
-            const int istart, const int iend, const int jstart, const int jend, const int kstart, const int kend,
-            const int jj, const int kk)
+            const int jstart, const int jend, const int kstart, const int kend,
+            const int jj, const int kk,
+            const Row_spans& row_spans)
     {
         const int ii = 1;
 
@@ -185,20 +192,21 @@ namespace
 
         for (int k=kstart; k<kend; ++k)
             for (int j=jstart; j<jend; ++j)
-                #pragma ivdep
-                for (int i=istart; i<iend; ++i)
-                {
-                    const int ijk = i + j*jj + k*kk;
-                    st[ijk] +=
-                             - ( u[ijk+ii] * interp2(s[ijk   ], s[ijk+ii])
-                               - u[ijk   ] * interp2(s[ijk-ii], s[ijk   ]) ) * dxi
-
-                             - ( v[ijk+jj] * interp2(s[ijk   ], s[ijk+jj])
-                               - v[ijk   ] * interp2(s[ijk-jj], s[ijk   ]) ) * dyi
-
-                             - ( rhorefh[k+1] * w[ijk+kk] * interp2(s[ijk   ], s[ijk+kk])
-                               - rhorefh[k  ] * w[ijk   ] * interp2(s[ijk-kk], s[ijk   ]) ) / rhoref[k] * dzi[k];
-                }
+                for (int n=row_spans.begin(j, k); n<row_spans.end(j, k); ++n)
+                    #pragma ivdep
+                    for (int i=row_spans.i0[n]; i<row_spans.i1[n]; ++i)
+                    {
+                        const int ijk = i + j*jj + k*kk;
+                        st[ijk] +=
+                                 - ( u[ijk+ii] * interp2(s[ijk   ], s[ijk+ii])
+                                   - u[ijk   ] * interp2(s[ijk-ii], s[ijk   ]) ) * dxi
+
+                                 - ( v[ijk+jj] * interp2(s[ijk   ], s[ijk+jj])
+                                   - v[ijk   ] * interp2(s[ijk-jj], s[ijk   ]) ) * dyi
+
+                                 - ( rhorefh[k+1] * w[ijk+kk] * interp2(s[ijk   ], s[ijk+kk])
+                                   - rhorefh[k  ] * w[ijk   ] * interp2(s[ijk-kk], s[ijk   ]) ) / rhoref[k] * dzi[k];
+                    }
     }
 
     template<typename TF>
@@ -302,30 +310,30 @@ void Advec_2<TF>::exec(Stats<TF>& stats)
             fields.mp.at("u")->fld.data(), fields.mp.at("v")->fld.data(), fields.mp.at("w")->fld.data(),
             gd.dzi.data(), gd.dx, gd.dy,
             fields.rhoref.data(), fields.rhorefh.data(),
-            gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
-            gd.icells, gd.ijcells);
+            gd.jstart, gd.jend, gd.kstart, gd.kend,
+            gd.icells, gd.ijcells, gd.row_spans);
 
     advec_v(fields.mt.at("v")->fld.data(),
             fields.mp.at("u")->fld.data(), fields.mp.at("v")->fld.data(), fields.mp.at("w")->fld.data(),
             gd.dzi.data(), gd.dx, gd.dy,
             fields.rhoref.data(), fields.rhorefh.data(),
-            gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
-            gd.icells, gd.ijcells);
+            gd.jstart, gd.jend, gd.kstart, gd.kend,
+            gd.icells, gd.ijcells, gd.row_spans);
 
     advec_w(fields.mt.at("w")->fld.data(),
             fields.mp.at("u")->fld.data(), fields.mp.at("v")->fld.data(), fields.mp.at("w")->fld.data(),
             gd.dzhi.data(), gd.dx, gd.dy,
             fields.rhoref.data(), fields.rhorefh.data(),
-            gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
-            gd.icells, gd.ijcells);
+            gd.jstart, gd.jend, gd.kstart, gd.kend,
+            gd.icells, gd.ijcells, gd.row_spans);
 
     for (auto& it : fields.st)
         advec_s(it.second->fld.data(), fields.sp.at(it.first)->fld.data(),
                 fields.mp.at("u")->fld.data(), fields.mp.at("v")->fld.data(), fields.mp.at("w")->fld.data(),
                 gd.dzi.data(), gd.dx, gd.dy,
                 fields.rhoref.data(), fields.rhorefh.data(),
-                gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
-                gd.icells, gd.ijcells);
+                gd.jstart, gd.jend, gd.kstart, gd.kend,
+                gd.icells, gd.ijcells, gd.row_spans);
 
     stats.calc_tend(*fields.mt.at("u"), tend_name);
     stats.calc_tend(*fields.mt.at("v"), tend_name);
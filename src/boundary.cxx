@@ -23,6 +23,7 @@
 #include <cstdio>
 #include <cmath>
 #include <algorithm>
+#include <map>
 #include "master.h"
 #include "input.h"
 #include "grid.h"
@@ -565,12 +566,17 @@ namespace
 template<typename TF>
 void Boundary<TF>::exec(Thermo<TF>& thermo)
 {
-    boundary_cyclic.exec(fields.mp.at("u")->fld.data());
-    boundary_cyclic.exec(fields.mp.at("v")->fld.data());
-    boundary_cyclic.exec(fields.mp.at("w")->fld.data());
+    // Exchange the ghost cells of all prognostic fields that require the same number of ghost cells at once.
+    std::map<std::pair<int, int>, std::vector<TF*>> cyclic_fields;
+
+    for (auto& it : fields.mp)
+        cyclic_fields[{it.second->igc, it.second->jgc}].push_back(it.second->fld.data());
 
     for (auto& it : fields.sp)
-        boundary_cyclic.exec(it.second->fld.data());
+        cyclic_fields[{it.second->igc, it.second->jgc}].push_back(it.second->fld.data());
+
+    for (auto& it : cyclic_fields)
+        boundary_cyclic.exec(it.second, Edge::Both_edges, it.first.first, it.first.second);
 
     // Update the boundary values.
     update_bcs(thermo);
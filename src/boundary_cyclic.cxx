@@ -20,6 +20,7 @@
  * along with MicroHH.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <memory>
 #include "master.h"
 #include "grid.h"
 #include "boundary_cyclic.h"
@@ -50,6 +51,42 @@ namespace
     template<typename TF> MPI_Datatype mpi_fp_type();
     template<> MPI_Datatype mpi_fp_type<double>() { return MPI_DOUBLE; }
     template<> MPI_Datatype mpi_fp_type<float>() { return MPI_FLOAT; }
+
+    // Copy a block of ilen x jlen x klen cells starting at data into a contiguous buffer.
+    template<typename TF>
+    void pack_edge(
+            TF* const restrict buf, const TF* const restrict data,
+            const int ilen, const int jlen, const int klen,
+            const int jj, const int kk)
+    {
+        for (int k=0; k<klen; ++k)
+            for (int j=0; j<jlen; ++j)
+                #pragma ivdep
+                for (int i=0; i<ilen; ++i)
+                {
+                    const int ijk = i + j*jj + k*kk;
+                    const int n = i + j*ilen + k*ilen*jlen;
+                    buf[n] = data[ijk];
+                }
+    }
+
+    // Copy a contiguous buffer into a block of ilen x jlen x klen cells starting at data.
+    template<typename TF>
+    void unpack_edge(
+            TF* const restrict data, const TF* const restrict buf,
+            const int ilen, const int jlen, const int klen,
+            const int jj, const int kk)
+    {
+        for (int k=0; k<klen; ++k)
+            for (int j=0; j<jlen; ++j)
+                #pragma ivdep
+                for (int i=0; i<ilen; ++i)
+                {
+                    const int ijk = i + j*jj + k*kk;
+                    const int n = i + j*ilen + k*ilen*jlen;
+                    data[ijk] = buf[n];
+                }
+    }
 }
 
 template<typename TF>
@@ -64,8 +101,6 @@ void Boundary_cyclic<TF>::init_mpi()
     datacount  = gd.jcells*gd.kcells;
     datablock  = gd.igc;
     datastride = gd.icells;
-    MPI_Type_vector(datacount, datablock, datastride, mpi_fp_type<TF>(), &eastwestedge);
-    MPI_Type_commit(&eastwestedge);
     MPI_Type_vector(datacount, datablock, datastride, MPI_UNSIGNED, &eastwestedge_uint);
     MPI_Type_commit(&eastwestedge_uint);
 
@@ -73,8 +108,6 @@ void Boundary_cyclic<TF>::init_mpi()
     datacount  = gd.kcells;
     datablock  = gd.icells*gd.jgc;
     datastride = gd.icells*gd.jcells;
-    MPI_Type_vector(datacount, datablock, datastride, mpi_fp_type<TF>(), &northsouthedge);
-    MPI_Type_commit(&northsouthedge);
     MPI_Type_vector(datacount, datablock, datastride, MPI_UNSIGNED, &northsouthedge_uint);
     MPI_Type_commit(&northsouthedge_uint);
 
@@ -82,8 +115,6 @@ void Boundary_cyclic<TF>::init_mpi()
     datacount  = gd.jcells;
     datablock  = gd.igc;
     datastride = gd.icells;
-    MPI_Type_vector(datacount, datablock, datastride, mpi_fp_type<TF>(), &eastwestedge2d);
-    MPI_Type_commit(&eastwestedge2d);
     MPI_Type_vector(datacount, datablock, datastride, MPI_UNSIGNED, &eastwestedge2d_uint);
     MPI_Type_commit(&eastwestedge2d_uint);
 
@@ -91,12 +122,20 @@ void Boundary_cyclic<TF>::init_mpi()
     datacount  = 1;
     datablock  = gd.icells*gd.jgc;
     datastride = gd.icells*gd.jcells;
-    MPI_Type_vector(datacount, datablock, datastride, mpi_fp_type<TF>(), &northsouthedge2d);
-    MPI_Type_commit(&northsouthedge2d);
     MPI_Type_vector(datacount, datablock, datastride, MPI_UNSIGNED, &northsouthedge2d_uint);
     MPI_Type_commit(&northsouthedge2d_uint);
 
     mpi_types_allocated = true;
+
+    // Create the plans for single fields and slices, the most common exchanges.
+    get_halo_plan(1, gd.kcells, Edge::East_west_edge, gd.igc);
+    get_halo_plan(1, 1, Edge::East_west_edge, gd.igc);
+
+    if (gd.jtot > 1)
+    {
+        get_halo_plan(1, gd.kcells, Edge::North_south_edge, gd.jgc);
+        get_halo_plan(1, 1, Edge::North_south_edge, gd.jgc);
+    }
 }
 
 template<typename TF>
@@ -104,133 +143,26 @@ void Boundary_cyclic<TF>::exit_mpi()
 {
     if (mpi_types_allocated)
     {
-        MPI_Type_free(&eastwestedge);
-        MPI_Type_free(&northsouthedge);
+        MPI_Type_free(&eastwestedge_uint);
+        MPI_Type_free(&northsouthedge_uint);
 
-        MPI_Type_free(&eastwestedge2d);
-        MPI_Type_free(&northsouthedge2d);
+        MPI_Type_free(&eastwestedge2d_uint);
+        MPI_Type_free(&northsouthedge2d_uint);
     }
 }
 
 template<typename TF>
-void Boundary_cyclic<TF>::exec(TF* const restrict data, Edge edge)
+void Boundary_cyclic<TF>::exec(TF* const restrict data, Edge edge, const int igc, const int jgc)
 {
     auto& gd = grid.get_grid_data();
-    auto& md = master.get_MPI_data();
-
-    const int ncount = 1;
-
-    if (edge == Edge::East_west_edge || edge == Edge::Both_edges)
-    {
-        // Communicate east-west edges.
-        const int eastout = gd.iend-gd.igc;
-        const int westin  = 0;
-        const int westout = gd.istart;
-        const int eastin  = gd.iend;
-
-        // Send and receive the ghost cells in east-west direction.
-        MPI_Isend(&data[eastout], ncount, eastwestedge, md.neast, 1, md.commxy, master.get_request_ptr());
-        MPI_Irecv(&data[ westin], ncount, eastwestedge, md.nwest, 1, md.commxy, master.get_request_ptr());
-        MPI_Isend(&data[westout], ncount, eastwestedge, md.nwest, 2, md.commxy, master.get_request_ptr());
-        MPI_Irecv(&data[ eastin], ncount, eastwestedge, md.neast, 2, md.commxy, master.get_request_ptr());
-        master.wait_all();
-    }
-
-    if (edge == Edge::North_south_edge || edge == Edge::Both_edges)
-    {
-        // If the run is 3D, perform the cyclic boundary routine for the north-south direction.
-        if (gd.jtot > 1)
-        {
-            // Communicate north-south edges.
-            const int northout = (gd.jend-gd.jgc)*gd.icells;
-            const int southin  = 0;
-            const int southout = gd.jstart*gd.icells;
-            const int northin  = gd.jend  *gd.icells;
-
-            // Send and receive the ghost cells in the north-south direction.
-            MPI_Isend(&data[northout], ncount, northsouthedge, md.nnorth, 1, md.commxy, master.get_request_ptr());
-            MPI_Irecv(&data[ southin], ncount, northsouthedge, md.nsouth, 1, md.commxy, master.get_request_ptr());
-            MPI_Isend(&data[southout], ncount, northsouthedge, md.nsouth, 2, md.commxy, master.get_request_ptr());
-            MPI_Irecv(&data[ northin], ncount, northsouthedge, md.nnorth, 2, md.commxy, master.get_request_ptr());
-            master.wait_all();
-        }
-        // In case of 2D, fill all the ghost cells in the y-direction with the same value.
-        else
-        {
-            const int jj = gd.icells;
-            const int kk = gd.icells*gd.jcells;
-
-            for (int k=gd.kstart; k<gd.kend; ++k)
-                for (int j=0; j<gd.jgc; ++j)
-                    #pragma ivdep
-                    for (int i=0; i<gd.icells; ++i)
-                    {
-                        const int ijkref   = i + gd.jstart*jj   + k*kk;
-                        const int ijknorth = i + j*jj           + k*kk;
-                        const int ijksouth = i + (gd.jend+j)*jj + k*kk;
-                        data[ijknorth] = data[ijkref];
-                        data[ijksouth] = data[ijkref];
-                    }
-        }
-    }
+    exec_batched({data}, edge, gd.kcells, igc, jgc);
 }
 
 template<typename TF>
 void Boundary_cyclic<TF>::exec_2d(TF* const restrict data)
 {
     auto& gd = grid.get_grid_data();
-    auto& md = master.get_MPI_data();
-
-    const int ncount = 1;
-
-    // Communicate east-west edges.
-    const int eastout = gd.iend-gd.igc;
-    const int westin  = 0;
-    const int westout = gd.istart;
-    const int eastin  = gd.iend;
-
-    // Communicate north-south edges.
-    const int northout = (gd.jend-gd.jgc)*gd.icells;
-    const int southin  = 0;
-    const int southout = gd.jstart*gd.icells;
-    const int northin  = gd.jend  *gd.icells;
-
-    // First, send and receive the ghost cells in east-west direction.
-    MPI_Isend(&data[eastout], ncount, eastwestedge2d, md.neast, 1, md.commxy, master.get_request_ptr());
-    MPI_Irecv(&data[ westin], ncount, eastwestedge2d, md.nwest, 1, md.commxy, master.get_request_ptr());
-    MPI_Isend(&data[westout], ncount, eastwestedge2d, md.nwest, 2, md.commxy, master.get_request_ptr());
-    MPI_Irecv(&data[ eastin], ncount, eastwestedge2d, md.neast, 2, md.commxy, master.get_request_ptr());
-    master.wait_all();
-
-    // If the run is 3D, apply the BCs.
-    if (gd.jtot > 1)
-    {
-        // Second, send and receive the ghost cells in the north-south direction.
-        MPI_Isend(&data[northout], ncount, northsouthedge2d, md.nnorth, 1, md.commxy, master.get_request_ptr());
-        MPI_Irecv(&data[ southin], ncount, northsouthedge2d, md.nsouth, 1, md.commxy, master.get_request_ptr());
-        MPI_Isend(&data[southout], ncount, northsouthedge2d, md.nsouth, 2, md.commxy, master.get_request_ptr());
-        MPI_Irecv(&data[ northin], ncount, northsouthedge2d, md.nnorth, 2, md.commxy, master.get_request_ptr());
-        master.wait_all();
-    }
-    // In case of 2D, fill all the ghost cells with the current value.
-    else
-    {
-        // Local copies for fast performance in loop.
-        const int jj = gd.icells;
-        const int jstart = gd.jstart;
-        const int jend = gd.jend;
-
-        for (int j=0; j<gd.jgc; ++j)
-            #pragma ivdep
-            for (int i=0; i<gd.icells; ++i)
-            {
-                const int ijref   = i + jstart*jj;
-                const int ijnorth = i + j*jj;
-                const int ijsouth = i + (jend+j)*jj;
-                data[ijnorth] = data[ijref];
-                data[ijsouth] = data[ijref];
-            }
-    }
+    exec_batched({data}, Edge::Both_edges, 1, gd.igc, gd.jgc);
 }
 
 template<typename TF>
@@ -354,6 +286,133 @@ void Boundary_cyclic<TF>::exec_2d(unsigned int* const restrict data)
     }
 }
 
+template<typename TF>
+void Boundary_cyclic<TF>::exec(const std::vector<TF*>& data, Edge edge, const int igc, const int jgc)
+{
+    auto& gd = grid.get_grid_data();
+    exec_batched(data, edge, gd.kcells, igc, jgc);
+}
+
+template<typename TF>
+void Boundary_cyclic<TF>::exec_2d(const std::vector<TF*>& data)
+{
+    auto& gd = grid.get_grid_data();
+    exec_batched(data, Edge::Both_edges, 1, gd.igc, gd.jgc);
+}
+
+template<typename TF>
+typename Boundary_cyclic<TF>::Halo_plan& Boundary_cyclic<TF>::get_halo_plan(
+        const int nfields, const int kcells, Edge edge, const int ngc)
+{
+    auto key = std::make_tuple(nfields, kcells, edge, ngc);
+    auto it = halo_plans.find(key);
+    if (it != halo_plans.end())
+        return *(it->second);
+
+    auto& gd = grid.get_grid_data();
+    auto& md = master.get_MPI_data();
+
+    const bool east_west = (edge == Edge::East_west_edge);
+    const int buffersize = nfields*kcells*ngc*(east_west ? gd.jcells : gd.icells);
+    const int neighbour_1 = east_west ? md.neast : md.nnorth;
+    const int neighbour_2 = east_west ? md.nwest : md.nsouth;
+
+    // The buffers are never resized, as the persistent messages point into them.
+    std::unique_ptr<Halo_plan> plan = std::make_unique<Halo_plan>();
+    plan->send_1.resize(buffersize);
+    plan->send_2.resize(buffersize);
+    plan->recv_1.resize(buffersize);
+    plan->recv_2.resize(buffersize);
+
+    plan->comm_plan.add_send(plan->send_1.data(), buffersize, mpi_fp_type<TF>(), neighbour_1, 1, md.commxy);
+    plan->comm_plan.add_recv(plan->recv_1.data(), buffersize, mpi_fp_type<TF>(), neighbour_2, 1, md.commxy);
+    plan->comm_plan.add_send(plan->send_2.data(), buffersize, mpi_fp_type<TF>(), neighbour_2, 2, md.commxy);
+    plan->comm_plan.add_recv(plan->recv_2.data(), buffersize, mpi_fp_type<TF>(), neighbour_1, 2, md.commxy);
+
+    return *(halo_plans.emplace(key, std::move(plan)).first->second);
+}
+
+template<typename TF>
+void Boundary_cyclic<TF>::exec_batched(
+        const std::vector<TF*>& data, Edge edge, const int kcells, const int igc, const int jgc)
+{
+    auto& gd = grid.get_grid_data();
+
+    const int jj = gd.icells;
+    const int kk = gd.icells*gd.jcells;
+    const int nfields = data.size();
+
+    auto exchange = [&](
+            Edge plan_edge, const int ngc, const int ilen, const int jlen,
+            const int out_1, const int in_1, const int out_2, const int in_2)
+    {
+        // All ghost cells of all fields in one direction are sent as one message.
+        Halo_plan& plan = get_halo_plan(nfields, kcells, plan_edge, ngc);
+        const int edgesize = ilen*jlen*kcells;
+
+        for (int n=0; n<nfields; ++n)
+        {
+            pack_edge(&plan.send_1[n*edgesize], &data[n][out_1], ilen, jlen, kcells, jj, kk);
+            pack_edge(&plan.send_2[n*edgesize], &data[n][out_2], ilen, jlen, kcells, jj, kk);
+        }
+
+        plan.comm_plan.exec();
+
+        for (int n=0; n<nfields; ++n)
+        {
+            unpack_edge(&data[n][in_1], &plan.recv_1[n*edgesize], ilen, jlen, kcells, jj, kk);
+            unpack_edge(&data[n][in_2], &plan.recv_2[n*edgesize], ilen, jlen, kcells, jj, kk);
+        }
+    };
+
+    // Only the igc and jgc ghost cells closest to the interior are exchanged.
+    if ((edge == Edge::East_west_edge || edge == Edge::Both_edges) && igc > 0)
+    {
+        // Communicate east-west edges.
+        const int eastout = gd.iend-igc;
+        const int westin  = gd.istart-igc;
+        const int westout = gd.istart;
+        const int eastin  = gd.iend;
+
+        exchange(Edge::East_west_edge, igc, igc, gd.jcells, eastout, westin, westout, eastin);
+    }
+
+    if ((edge == Edge::North_south_edge || edge == Edge::Both_edges) && jgc > 0)
+    {
+        // If the run is 3D, perform the cyclic boundary routine for the north-south direction.
+        // The strips include the east-west ghost cells, such that the corners are filled as well.
+        if (gd.jtot > 1)
+        {
+            // Communicate north-south edges.
+            const int northout = (gd.jend-jgc)*gd.icells;
+            const int southin  = (gd.jstart-jgc)*gd.icells;
+            const int southout = gd.jstart*gd.icells;
+            const int northin  = gd.jend  *gd.icells;
+
+            exchange(Edge::North_south_edge, jgc, gd.icells, jgc, northout, southin, southout, northin);
+        }
+        // In case of 2D, fill all the ghost cells in the y-direction with the same value.
+        else
+        {
+            const int kstart = (kcells == 1) ? 0 : gd.kstart;
+            const int kend   = (kcells == 1) ? 1 : gd.kend;
+
+            for (TF* const fld : data)
+                for (int k=kstart; k<kend; ++k)
+                    for (int j=0; j<jgc; ++j)
+                        #pragma ivdep
+                        for (int i=0; i<gd.icells; ++i)
+                        {
+                            const int ijkref   = i + gd.jstart*jj         + k*kk;
+                            const int ijknorth = i + (gd.jstart-jgc+j)*jj + k*kk;
+                            const int ijksouth = i + (gd.jend+j)*jj       + k*kk;
+                            fld[ijknorth] = fld[ijkref];
+                            fld[ijksouth] = fld[ijkref];
+                        }
+        }
+    }
+}
+
 #else
 
 template<typename TF>
@@ -367,30 +426,31 @@ void Boundary_cyclic<TF>::exit_mpi()
 }
 
 template<typename TF>
-void Boundary_cyclic<TF>::exec(TF* restrict data, Edge edge)
+void Boundary_cyclic<TF>::exec(TF* restrict data, Edge edge, const int igc, const int jgc)
 {
     auto& gd = grid.get_grid_data();
 
     const int jj = gd.icells;
     const int kk = gd.icells*gd.jcells;
 
+    // Only the igc and jgc ghost cells closest to the interior are filled.
     if (edge == Edge::East_west_edge || edge == Edge::Both_edges)
     {
         // first, east west boundaries
         for (int k=0; k<gd.kcells; ++k)
             for (int j=0; j<gd.jcells; ++j)
                 #pragma ivdep
-                for (int i=0; i<gd.igc; ++i)
+                for (int i=0; i<igc; ++i)
                 {
-                    const int ijk0 = i          + j*jj + k*kk;
-                    const int ijk1 = gd.iend-gd.igc+i + j*jj + k*kk;
+                    const int ijk0 = gd.istart-igc+i + j*jj + k*kk;
+                    const int ijk1 = gd.iend-igc+i   + j*jj + k*kk;
                     data[ijk0] = data[ijk1];
                 }
 
         for (int k=0; k<gd.kcells; ++k)
             for (int j=0; j<gd.jcells; ++j)
                 #pragma ivdep
-                for (int i=0; i<gd.igc; ++i)
+                for (int i=0; i<igc; ++i)
                 {
                     const int ijk0 = i+gd.iend   + j*jj + k*kk;
                     const int ijk1 = i+gd.istart + j*jj + k*kk;
@@ -405,17 +465,17 @@ void Boundary_cyclic<TF>::exec(TF* restrict data, Edge edge)
         {
             // second, send and receive the ghost cells in the north-south direction
             for (int k=0; k<gd.kcells; ++k)
-                for (int j=0; j<gd.jgc; ++j)
+                for (int j=0; j<jgc; ++j)
                     #pragma ivdep
                     for (int i=0; i<gd.icells; ++i)
                     {
-                        const int ijk0 = i + j                 *jj + k*kk;
-                        const int ijk1 = i + (gd.jend-gd.jgc+j)*jj + k*kk;
+                        const int ijk0 = i + (gd.jstart-jgc+j)*jj + k*kk;
+                        const int ijk1 = i + (gd.jend-jgc+j)  *jj + k*kk;
                         data[ijk0] = data[ijk1];
                     }
 
             for (int k=0; k<gd.kcells; ++k)
-                for (int j=0; j<gd.jgc; ++j)
+                for (int j=0; j<jgc; ++j)
                     #pragma ivdep
                     for (int i=0; i<gd.icells; ++i)
                     {
@@ -428,13 +488,13 @@ void Boundary_cyclic<TF>::exec(TF* restrict data, Edge edge)
         else
         {
             for (int k=gd.kstart; k<gd.kend; ++k)
-                for (int j=0; j<gd.jgc; ++j)
+                for (int j=0; j<jgc; ++j)
                     #pragma ivdep
                     for (int i=0; i<gd.icells; ++i)
                     {
-                        const int ijkref   = i + gd.jstart*jj   + k*kk;
-                        const int ijknorth = i + j*jj           + k*kk;
-                        const int ijksouth = i + (gd.jend+j)*jj + k*kk;
+                        const int ijkref   = i + gd.jstart*jj         + k*kk;
+                        const int ijknorth = i + (gd.jstart-jgc+j)*jj + k*kk;
+                        const int ijksouth = i + (gd.jend+j)*jj       + k*kk;
                         data[ijknorth] = data[ijkref];
                         data[ijksouth] = data[ijkref];
                     }
@@ -645,7 +705,36 @@ void Boundary_cyclic<TF>::exec_2d(unsigned int* restrict data)
             }
     }
 }
+
+template<typename TF>
+void Boundary_cyclic<TF>::exec(const std::vector<TF*>& data, Edge edge, const int igc, const int jgc)
+{
+    // Without MPI there are no messages to combine.
+    for (TF* fld : data)
+        exec(fld, edge, igc, jgc);
+}
+
+template<typename TF>
+void Boundary_cyclic<TF>::exec_2d(const std::vector<TF*>& data)
+{
+    for (TF* fld : data)
+        exec_2d(fld);
+}
 #endif
 
+template<typename TF>
+void Boundary_cyclic<TF>::exec(TF* const restrict data, Edge edge)
+{
+    auto& gd = grid.get_grid_data();
+    exec(data, edge, gd.igc, gd.jgc);
+}
+
+template<typename TF>
+void Boundary_cyclic<TF>::exec(const std::vector<TF*>& data, Edge edge)
+{
+    auto& gd = grid.get_grid_data();
+    exec(data, edge, gd.igc, gd.jgc);
+}
+
 template class Boundary_cyclic<double>;
 template class Boundary_cyclic<float>;
@@ -36,6 +36,7 @@
 #include "master.h"
 #include "cross.h"
 #include "monin_obukhov.h"
+#include "fast_math.h"
 
 namespace
 {
@@ -45,39 +46,54 @@ namespace
     // Size of the lookup table.
     const int nzL = 10000; // Size of the lookup table for MO iterations.
 
-    template<typename TF>
-    TF find_zL(const float* const restrict zL, const float* const restrict f,
-               int& n, const float Ri)
+    // Size of the inverse lookup tables.
+    const int nRi_core = nzL;
+    const int nRi_tail = nzL/5;
+
+    // Interpolate z/L at the first crossing of Ri in the Ri(z/L) table, starting the search at n.
+    float interp_zL(const float* const restrict zL, const float* const restrict f,
+                    int& n, const float Ri)
     {
-        // Determine search direction. All checks are at float accuracy.
-        if ( (f[n]-Ri) > 0.f )
-            while ( (f[n-1]-Ri) > 0.f && n > 0.f) { --n; }
-        else
-            while ( (f[n]-Ri) < 0.f && n < (nzL-1) ) { ++n; }
+        while ( (f[n]-Ri) < 0.f && n < (nzL-1) ) { ++n; }
+
+        return (n == 0 || (f[n]-Ri) < 0.f) ? zL[n] : zL[n-1] + (Ri-f[n-1]) / (f[n]-f[n-1]) * (zL[n]-zL[n-1]);
+    }
 
-        const TF zL0 = (n == 0 || n == nzL-1) ? zL[n] : zL[n-1] + (Ri-f[n-1]) / (f[n]-f[n-1]) * (zL[n]-zL[n-1]);
+    // Look up z/L in the inverse tables. Both ranges are evaluated and selected
+    // afterwards, such that the lookup is free of branches and vectorizes.
+    inline float find_zL(const Obuk_lookup& lut, const float Ri_in)
+    {
+        const float Ri = std::min(std::max(Ri_in, lut.Ri_min), lut.Ri_max);
+
+        // Core range, uniform in Ri.
+        const float xc = (std::max(Ri, lut.Ri_core) - lut.Ri_core) * lut.dRi_core_i;
+        const int nc = std::min(static_cast<int>(xc), nRi_core-2);
+        const float zLc = lut.zL_core[nc] + (xc-nc) * (lut.zL_core[nc+1]-lut.zL_core[nc]);
+
+        // Free convection tail, uniform in log(-Ri).
+        const float xt = (Fast_math::fast_log(std::max(-Ri, -lut.Ri_core)) - lut.log_Ri_core) * lut.dlog_Ri_tail_i;
+        const int nt = std::min(static_cast<int>(xt), nRi_tail-2);
+        const float zLt = lut.zL_tail[nt] + (xt-nt) * (lut.zL_tail[nt+1]-lut.zL_tail[nt]);
 
-        return zL0;
+        return (Ri_in > lut.Ri_max) ? lut.zL_max : (Ri >= lut.Ri_core) ? zLc : zLt;
     }
 
     template<typename TF>
-    TF calc_obuk_noslip_flux(const float* restrict zL, const float* restrict f,
-                             int& n,
+    TF calc_obuk_noslip_flux(const Obuk_lookup& lut,
                              const TF du, const TF bfluxbot, const TF zsl)
     {
         // Calculate the appropriate Richardson number and reduce precision.
-        const float Ri = -Constants::kappa<TF> * bfluxbot * zsl / std::pow(du, 3);
-        return zsl/find_zL<TF>(zL, f, n, Ri);
+        const float Ri = -Constants::kappa<TF> * bfluxbot * zsl / Fast_math::pow3(du);
+        return zsl/find_zL(lut, Ri);
     }
 
     template<typename TF>
-    TF calc_obuk_noslip_dirichlet(const float* restrict zL, const float* restrict f,
-                                  int& n,
+    TF calc_obuk_noslip_dirichlet(const Obuk_lookup& lut,
                                   const TF du, const TF db, const TF zsl)
     {
         // Calculate the appropriate Richardson number and reduce precision.
-        const float Ri = Constants::kappa<TF> * db * zsl / std::pow(du, 2);
-        return zsl/find_zL<TF>(zL, f, n, Ri);
+        const float Ri = Constants::kappa<TF> * db * zsl / Fast_math::pow2(du);
+        return zsl/find_zL(lut, Ri);
     }
 
     template<typename TF>
@@ -126,7 +142,7 @@ namespace
                    TF* restrict u, TF* restrict v, TF* restrict b,
                    TF* restrict ubot , TF* restrict vbot, TF* restrict bbot,
                    TF* restrict dutot, const TF* restrict z,
-                   const float* zL_sl, const float* f_sl, int* nobuk,
+                   const Obuk_lookup& obuk_lookup,
                    const TF z0m, const TF z0h, const TF db_ref,
                    const int istart, const int iend, const int jstart, const int jend, const int kstart,
                    const int icells, const int jcells, const int kk,
@@ -176,7 +192,7 @@ namespace
                 for (int i=0; i<icells; ++i)
                 {
                     const int ij = i + j*jj;
-                    obuk [ij] = calc_obuk_noslip_flux(zL_sl, f_sl, nobuk[ij], dutot[ij], bfluxbot[ij], z[kstart]);
+                    obuk [ij] = calc_obuk_noslip_flux(obuk_lookup, dutot[ij], bfluxbot[ij], z[kstart]);
                     ustar[ij] = dutot[ij] * most::fm(z[kstart], z0m, obuk[ij]);
                 }
         }
@@ -189,7 +205,7 @@ namespace
                     const int ij  = i + j*jj;
                     const int ijk = i + j*jj + kstart*kk;
                     const TF db = b[ijk] - bbot[ij] + db_ref;
-                    obuk [ij] = calc_obuk_noslip_dirichlet(zL_sl, f_sl, nobuk[ij], dutot[ij], db, z[kstart]);
+                    obuk [ij] = calc_obuk_noslip_dirichlet(obuk_lookup, dutot[ij], db, z[kstart]);
                     ustar[ij] = dutot[ij] * most::fm(z[kstart], z0m, obuk[ij]);
                 }
         }
@@ -284,8 +300,7 @@ namespace
                     vfluxbot[ij] = -(v[ijk]-vbot[ij])*static_cast<TF>(0.5)*(ustar[ij-jj]*most::fm(zsl, z0m, obuk[ij-jj]) + ustar[ij]*most::fm(zsl, z0m, obuk[ij]));
                 }
 
-            boundary_cyclic.exec_2d(ufluxbot);
-            boundary_cyclic.exec_2d(vfluxbot);
+            boundary_cyclic.exec_2d({ufluxbot, vfluxbot});
         }
         // the flux is known, calculate the surface value and gradient
         else if (bcbot == Boundary_type::Ustar_type)
@@ -317,8 +332,7 @@ namespace
                     vfluxbot[ij] = -copysign(one, v[ijk]-vbot[ij]) * std::pow(ustaronv4 / (one + uonv2 / v2), static_cast<TF>(0.5));
                 }
 
-            boundary_cyclic.exec_2d(ufluxbot);
-            boundary_cyclic.exec_2d(vfluxbot);
+            boundary_cyclic.exec_2d({ufluxbot, vfluxbot});
 
             // CvH: I think that the problem is not closed, since both the fluxes and the surface values
             // of u and v are unknown. You have to assume a no slip in order to get the fluxes and therefore
@@ -697,6 +711,37 @@ void Boundary_surface<TF>::init_solver()
         for (int n=0; n<nzL; ++n)
             f_sl[n] = zL_sl[n] * std::pow(most::fm(zsl, z0m, zsl/zL_sl[n]), 2) / most::fh(zsl, z0h, zsl/zL_sl[n]);
     }
+    else
+        return;
+
+    // Invert the table, with the core range starting at the first point with constant z/L spacing.
+    auto& lut = obuk_lookup;
+
+    lut.Ri_min  = f_sl[0];
+    lut.Ri_core = f_sl[nzL/10];
+    lut.Ri_max  = *std::max_element(f_sl.begin(), f_sl.end());
+    lut.zL_max  = zL_sl[nzL-1];
+
+    lut.dRi_core_i = (nRi_core-1) / (lut.Ri_max - lut.Ri_core);
+    lut.log_Ri_core = std::log(-lut.Ri_core);
+    lut.dlog_Ri_tail_i = (nRi_tail-1) / (std::log(-lut.Ri_min) - lut.log_Ri_core);
+
+    lut.zL_core.resize(nRi_core);
+    lut.zL_tail.resize(nRi_tail);
+
+    // Both tables are filled in order of increasing Ri, such that the search can continue from the previous point.
+    int n = 0;
+    for (int m=nRi_tail-1; m>=0; --m)
+    {
+        const float Ri = -std::exp(lut.log_Ri_core + m/lut.dlog_Ri_tail_i);
+        lut.zL_tail[m] = interp_zL(zL_sl.data(), f_sl.data(), n, Ri);
+    }
+
+    for (int m=0; m<nRi_core; ++m)
+    {
+        const float Ri = std::min(lut.Ri_core + m/lut.dRi_core_i, lut.Ri_max);
+        lut.zL_core[m] = interp_zL(zL_sl.data(), f_sl.data(), n, Ri);
+    }
 }
 
 #ifndef USECUDA
@@ -732,7 +777,7 @@ void Boundary_surface<TF>::update_bcs(Thermo<TF>& thermo)
                 fields.mp.at("u")->fld.data(), fields.mp.at("v")->fld.data(), buoy->fld.data(),
                 fields.mp.at("u")->fld_bot.data(), fields.mp.at("v")->fld_bot.data(), buoy->fld_bot.data(),
                 tmp->fld.data(), gd.z.data(),
-                zL_sl.data(), f_sl.data(), nobuk.data(),
+                obuk_lookup,
                 z0m, z0h, db_ref,
                 gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart,
                 gd.icells, gd.jcells, gd.ijcells,
@@ -257,10 +257,9 @@ void Boundary_surface_bulk<TF>::update_bcs(Thermo<TF>& thermo)
                     dutot->fld.data(), bulk_cm, zsl,
                     gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.icells, gd.ijcells);
 
-    boundary_cyclic.exec_2d(fields.mp.at("u")->flux_bot.data());
-    boundary_cyclic.exec_2d(fields.mp.at("v")->flux_bot.data());
-    boundary_cyclic.exec_2d(fields.mp.at("u")->grad_bot.data());
-    boundary_cyclic.exec_2d(fields.mp.at("v")->grad_bot.data());
+    std::vector<TF*> cyclic_slices = {
+        fields.mp.at("u")->flux_bot.data(), fields.mp.at("v")->flux_bot.data(),
+        fields.mp.at("u")->grad_bot.data(), fields.mp.at("v")->grad_bot.data()};
 
     // Calculate surface scalar fluxes and gradients
     for (auto& it : fields.sp)
@@ -269,10 +268,13 @@ void Boundary_surface_bulk<TF>::update_bcs(Thermo<TF>& thermo)
                         it.second->fld.data(), it.second->fld_bot.data(),
                         dutot->fld.data(), bulk_cs.at(it.first), zsl,
                         gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.icells, gd.ijcells);
-        boundary_cyclic.exec_2d(it.second->flux_bot.data());
-        boundary_cyclic.exec_2d(it.second->grad_bot.data());
+        cyclic_slices.push_back(it.second->flux_bot.data());
+        cyclic_slices.push_back(it.second->grad_bot.data());
     }
 
+    // Exchange the ghost cells of all surface fluxes and gradients at once.
+    boundary_cyclic.exec_2d(cyclic_slices);
+
     auto b= fields.get_tmp();
     thermo.get_buoyancy_fluxbot(*b, false);
     surface_scaling(ustar.data(), obuk.data(), dutot->fld.data(), b->flux_bot.data(), bulk_cm,
@@ -35,26 +35,30 @@
 namespace
 {
     template<typename TF>
-    void calc_buffer(TF* const restrict at, const TF* const restrict a,
-                     const TF* const restrict abuf, const TF* const restrict z,
-                     const TF zstart, const TF zsize, const TF beta, const TF sigma,
-                     const int istart, const int iend, const int icells, const int jstart, const int jend,
-                     const int ijcells, const int bufferkstart, const int kend)
+    void calc_buffer_coef(TF* const restrict sigmaz, const TF* const restrict z,
+                          const TF zstart, const TF zsize, const TF beta, const TF sigma,
+                          const int bufferkstart, const int kend)
     {
         const TF zsizebuf = zsize - zstart;
 
         for (int k=bufferkstart; k<kend; ++k)
-        {
-            const TF sigmaz = sigma*std::pow((z[k]-zstart)/zsizebuf, beta);
+            sigmaz[k] = sigma*std::pow((z[k]-zstart)/zsizebuf, beta);
+    }
 
+    template<typename TF>
+    void calc_buffer(TF* const restrict at, const TF* const restrict a,
+                     const TF* const restrict abuf, const TF* const restrict sigmaz,
+                     const int istart, const int iend, const int icells, const int jstart, const int jend,
+                     const int ijcells, const int bufferkstart, const int kend)
+    {
+        for (int k=bufferkstart; k<kend; ++k)
             for (int j=jstart; j<jend; ++j)
                 #pragma ivdep
                 for (int i=istart; i<iend; ++i)
                 {
                     const int ijk = i + j*icells + k*ijcells;
-                    at[ijk] -= sigmaz*(a[ijk]-abuf[k]);
+                    at[ijk] -= sigmaz[k]*(a[ijk]-abuf[k]);
                 }
-        }
     }
 
 }
@@ -125,6 +129,12 @@ void Buffer<TF>::create(Input& inputin, Netcdf_handle& input_nc, Stats<TF>& stat
             throw std::runtime_error(msg);
         }
 
+        // The damping coefficients only depend on height, compute them once.
+        sigmaz .resize(gd.kcells);
+        sigmazh.resize(gd.kcells);
+        calc_buffer_coef(sigmaz .data(), gd.z .data(), zstart, gd.zsize, beta, sigma, bufferkstart , gd.kend);
+        calc_buffer_coef(sigmazh.data(), gd.zh.data(), zstart, gd.zsize, beta, sigma, bufferkstarth, gd.kend);
+
         if (!swupdate)
         {
             // Set the buffers according to the initial profiles of the variables.
@@ -170,33 +180,33 @@ void Buffer<TF>::exec(Stats<TF>& stats)
         {
             // Calculate the buffer tendencies.
             calc_buffer(fields.mt.at("u")->fld.data(), fields.mp.at("u")->fld.data(), fields.mp.at("u")->fld_mean.data(),
-                        gd.z.data(), zstart, gd.zsize, beta, sigma, gd.istart, gd.iend, gd.icells, gd.jstart, gd.jend, gd.ijcells, bufferkstart, gd.kend);
+                        sigmaz.data(), gd.istart, gd.iend, gd.icells, gd.jstart, gd.jend, gd.ijcells, bufferkstart, gd.kend);
 
             calc_buffer(fields.mt.at("v")->fld.data(), fields.mp.at("v")->fld.data(), fields.mp.at("v")->fld_mean.data(),
-                        gd.z.data(), zstart, gd.zsize, beta, sigma, gd.istart, gd.iend, gd.icells, gd.jstart, gd.jend, gd.ijcells, bufferkstart, gd.kend);
+                        sigmaz.data(), gd.istart, gd.iend, gd.icells, gd.jstart, gd.jend, gd.ijcells, bufferkstart, gd.kend);
 
             calc_buffer(fields.mt.at("w")->fld.data(), fields.mp.at("w")->fld.data(), fields.mp.at("w")->fld_mean.data(),
-                        gd.zh.data(), zstart, gd.zsize, beta, sigma, gd.istart, gd.iend, gd.icells, gd.jstart, gd.jend, gd.ijcells, bufferkstarth, gd.kend);
+                        sigmazh.data(), gd.istart, gd.iend, gd.icells, gd.jstart, gd.jend, gd.ijcells, bufferkstarth, gd.kend);
 
             for (auto& it : fields.sp)
                 calc_buffer(fields.st.at(it.first)->fld.data(), fields.sp.at(it.first)->fld.data(), fields.sp.at(it.first)->fld_mean.data(),
-                            gd.z.data(), zstart, gd.zsize, beta, sigma, gd.istart, gd.iend, gd.icells, gd.jstart, gd.jend, gd.ijcells, bufferkstart, gd.kend);
+                            sigmaz.data(), gd.istart, gd.iend, gd.icells, gd.jstart, gd.jend, gd.ijcells, bufferkstart, gd.kend);
         }
         else
         {
             // Calculate the buffer tendencies.
             calc_buffer(fields.mt.at("u")->fld.data(), fields.mp.at("u")->fld.data(), bufferprofs.at("u").data(),
-                        gd.z.data(), zstart, gd.zsize, beta, sigma, gd.istart, gd.iend, gd.icells, gd.jstart, gd.jend, gd.ijcells, bufferkstart, gd.kend);
+                        sigmaz.data(), gd.istart, gd.iend, gd.icells, gd.jstart, gd.jend, gd.ijcells, bufferkstart, gd.kend);
 
             calc_buffer(fields.mt.at("v")->fld.data(), fields.mp.at("v")->fld.data(), bufferprofs.at("v").data(),
-                        gd.z.data(), zstart, gd.zsize, beta, sigma, gd.istart, gd.iend, gd.icells, gd.jstart, gd.jend, gd.ijcells, bufferkstart, gd.kend);
+                        sigmaz.data(), gd.istart, gd.iend, gd.icells, gd.jstart, gd.jend, gd.ijcells, bufferkstart, gd.kend);
 
             calc_buffer(fields.mt.at("w")->fld.data(), fields.mp.at("w")->fld.data(), bufferprofs.at("w").data(),
-                        gd.zh.data(), zstart, gd.zsize, beta, sigma, gd.istart, gd.iend, gd.icells, gd.jstart, gd.jend, gd.ijcells, bufferkstarth, gd.kend);
+                        sigmazh.data(), gd.istart, gd.iend, gd.icells, gd.jstart, gd.jend, gd.ijcells, bufferkstarth, gd.kend);
 
             for (auto& it : fields.sp)
                 calc_buffer(fields.st.at(it.first)->fld.data(), fields.sp.at(it.first)->fld.data(), bufferprofs.at(it.first).data(),
-                            gd.z.data(), zstart, gd.zsize, beta, sigma, gd.istart, gd.iend, gd.icells, gd.jstart, gd.jend, gd.ijcells, bufferkstart, gd.kend);
+                            sigmaz.data(), gd.istart, gd.iend, gd.icells, gd.jstart, gd.jend, gd.ijcells, bufferkstart, gd.kend);
         }
         stats.calc_tend(*fields.mt.at("u"), tend_name);
         stats.calc_tend(*fields.mt.at("v"), tend_name);
@@ -0,0 +1,73 @@
+/*
+ * MicroHH
+ * Copyright (c) 2011-2020 Chiel van Heerwaarden
+ * Copyright (c) 2011-2020 Thijs Heus
+ * Copyright (c) 2014-2020 Bart van Stratum
+ *
+ * This file is part of MicroHH
+ *
+ * MicroHH is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * MicroHH is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with MicroHH.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef USEMPI
+#include "comm_plan.h"
+
+double Comm_plan::total_messages = 0.;
+double Comm_plan::total_bytes = 0.;
+
+Comm_plan::Comm_plan() :
+    n_sends(0),
+    bytes_per_exec(0)
+{
+}
+
+Comm_plan::~Comm_plan()
+{
+    for (MPI_Request& request : requests)
+        MPI_Request_free(&request);
+}
+
+void Comm_plan::add_send(
+        const void* data, const int count, MPI_Datatype type,
+        const int dest, const int tag, MPI_Comm comm)
+{
+    requests.emplace_back();
+    MPI_Send_init(data, count, type, dest, tag, comm, &requests.back());
+
+    int type_size;
+    MPI_Type_size(type, &type_size);
+    bytes_per_exec += static_cast<long>(count)*type_size;
+    ++n_sends;
+}
+
+void Comm_plan::add_recv(
+        void* data, const int count, MPI_Datatype type,
+        const int source, const int tag, MPI_Comm comm)
+{
+    requests.emplace_back();
+    MPI_Recv_init(data, count, type, source, tag, comm, &requests.back());
+}
+
+void Comm_plan::start()
+{
+    MPI_Startall(requests.size(), requests.data());
+    total_messages += n_sends;
+    total_bytes += bytes_per_exec;
+}
+
+void Comm_plan::wait()
+{
+    MPI_Waitall(requests.size(), requests.data(), MPI_STATUSES_IGNORE);
+}
+#endif
@@ -37,8 +37,9 @@ namespace
 {
     template<typename TF>
     void diff_c(TF* restrict at, const TF* restrict a, const TF visc,
-                const int istart, const int iend, const int jstart, const int jend, const int kstart, const int kend,
-                const int jj, const int kk, const TF dx, const TF dy, const TF* restrict dzi, const TF* restrict dzhi)
+                const int jstart, const int jend, const int kstart, const int kend,
+                const int jj, const int kk, const TF dx, const TF dy, const TF* restrict dzi, const TF* restrict dzhi,
+                const Row_spans& row_spans)
     {
         const int ii = 1;
         const double dxidxi = 1/(dx*dx);
@@ -46,24 +47,26 @@ namespace
 
         for (int k=kstart; k<kend; k++)
             for (int j=jstart; j<jend; j++)
-                #pragma ivdep
-                for (int i=istart; i<iend; i++)
-                {
-                    const int ijk = i + j*jj + k*kk;
-                    at[ijk] += visc * (
-                            + ( (a[ijk+ii] - a[ijk   ])
-                              - (a[ijk   ] - a[ijk-ii]) ) * dxidxi
-                            + ( (a[ijk+jj] - a[ijk   ])
-                              - (a[ijk   ] - a[ijk-jj]) ) * dyidyi
-                            + ( (a[ijk+kk] - a[ijk   ]) * dzhi[k+1]
-                              - (a[ijk   ] - a[ijk-kk]) * dzhi[k]   ) * dzi[k] );
-                }
+                for (int n=row_spans.begin(j, k); n<row_spans.end(j, k); ++n)
+                    #pragma ivdep
+                    for (int i=row_spans.i0[n]; i<row_spans.i1[n]; ++i)
+                    {
+                        const int ijk = i + j*jj + k*kk;
+                        at[ijk] += visc * (
+                                + ( (a[ijk+ii] - a[ijk   ])
+                                  - (a[ijk   ] - a[ijk-ii]) ) * dxidxi
+                                + ( (a[ijk+jj] - a[ijk   ])
+                                  - (a[ijk   ] - a[ijk-jj]) ) * dyidyi
+                                + ( (a[ijk+kk] - a[ijk   ]) * dzhi[k+1]
+                                  - (a[ijk   ] - a[ijk-kk]) * dzhi[k]   ) * dzi[k] );
+                    }
     }
 
     template<typename TF>
     void diff_w(TF* restrict wt, const TF* restrict w, const TF visc,
-                const int istart, const int iend, const int jstart, const int jend, const int kstart, const int kend,
-                const int jj, const int kk, const TF dx, const TF dy, const TF* restrict dzi, const TF* restrict dzhi)
+                const int jstart, const int jend, const int kstart, const int kend,
+                const int jj, const int kk, const TF dx, const TF dy, const TF* restrict dzi, const TF* restrict dzhi,
+                const Row_spans& row_spans)
     {
         const int ii = 1;
         const double dxidxi = 1/(dx*dx);
@@ -71,18 +74,19 @@ namespace
 
         for (int k=kstart+1; k<kend; k++)
             for (int j=jstart; j<jend; j++)
-                #pragma ivdep
-                for (int i=istart; i<iend; i++)
-                {
-                    const int ijk = i + j*jj + k*kk;
-                    wt[ijk] += visc * (
-                            + ( (w[ijk+ii] - w[ijk   ])
-                              - (w[ijk   ] - w[ijk-ii]) ) * dxidxi
-                            + ( (w[ijk+jj] - w[ijk   ])
-                              - (w[ijk   ] - w[ijk-jj]) ) * dyidyi
-                            + ( (w[ijk+kk] - w[ijk   ]) * dzi[k]
-                              - (w[ijk   ] - w[ijk-kk]) * dzi[k-1] ) * dzhi[k] );
-                }
+                for (int n=row_spans.begin(j, k); n<row_spans.end(j, k); ++n)
+                    #pragma ivdep
+                    for (int i=row_spans.i0[n]; i<row_spans.i1[n]; ++i)
+                    {
+                        const int ijk = i + j*jj + k*kk;
+                        wt[ijk] += visc * (
+                                + ( (w[ijk+ii] - w[ijk   ])
+                                  - (w[ijk   ] - w[ijk-ii]) ) * dxidxi
+                                + ( (w[ijk+jj] - w[ijk   ])
+                                  - (w[ijk   ] - w[ijk-jj]) ) * dyidyi
+                                + ( (w[ijk+kk] - w[ijk   ]) * dzi[k]
+                                  - (w[ijk   ] - w[ijk-kk]) * dzi[k-1] ) * dzhi[k] );
+                    }
     }
 
     template<typename TF>
@@ -164,21 +168,21 @@ void Diff_2<TF>::exec(Stats<TF>& stats)
     auto& gd = grid.get_grid_data();
 
     diff_c<TF>(fields.mt.at("u")->fld.data(), fields.mp.at("u")->fld.data(), fields.visc,
-               gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend, gd.icells, gd.ijcells,
-               gd.dx, gd.dy, gd.dzi.data(), gd.dzhi.data());
+               gd.jstart, gd.jend, gd.kstart, gd.kend, gd.icells, gd.ijcells,
+               gd.dx, gd.dy, gd.dzi.data(), gd.dzhi.data(), gd.row_spans);
 
     diff_c<TF>(fields.mt.at("v")->fld.data(), fields.mp.at("v")->fld.data(), fields.visc,
-               gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend, gd.icells, gd.ijcells,
-               gd.dx, gd.dy, gd.dzi.data(), gd.dzhi.data());
+               gd.jstart, gd.jend, gd.kstart, gd.kend, gd.icells, gd.ijcells,
+               gd.dx, gd.dy, gd.dzi.data(), gd.dzhi.data(), gd.row_spans);
 
     diff_w<TF>(fields.mt.at("w")->fld.data(), fields.mp.at("w")->fld.data(), fields.visc,
-               gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend, gd.icells, gd.ijcells,
-               gd.dx, gd.dy, gd.dzi.data(), gd.dzhi.data());
+               gd.jstart, gd.jend, gd.kstart, gd.kend, gd.icells, gd.ijcells,
+               gd.dx, gd.dy, gd.dzi.data(), gd.dzhi.data(), gd.row_spans);
 
     for (auto& it : fields.st)
         diff_c<TF>(it.second->fld.data(), fields.sp.at(it.first)->fld.data(), fields.sp.at(it.first)->visc,
-                   gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend, gd.icells, gd.ijcells,
-                   gd.dx, gd.dy, gd.dzi.data(), gd.dzhi.data());
+                   gd.jstart, gd.jend, gd.kstart, gd.kend, gd.icells, gd.ijcells,
+                   gd.dx, gd.dy, gd.dzi.data(), gd.dzhi.data(), gd.row_spans);
 
     stats.calc_tend(*fields.mt.at("u"), tend_name);
     stats.calc_tend(*fields.mt.at("v"), tend_name);
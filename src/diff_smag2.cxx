@@ -52,7 +52,8 @@ namespace
                       const TF* restrict z, const TF* restrict dzi, const TF* restrict dzhi,
                       const TF dxi, const TF dyi,
                       const int istart, const int iend, const int jstart, const int jend, const int kstart, const int kend,
-                      const int jj, const int kk)
+                      const int jj, const int kk,
+                      const Row_spans& row_spans)
     {
         const int ii = 1;
         constexpr int k_offset = (surface_model == Surface_model::Disabled) ? 0 : 1;
@@ -108,41 +109,42 @@ namespace
 
         for (int k=kstart+k_offset; k<kend; ++k)
             for (int j=jstart; j<jend; ++j)
-                #pragma ivdep
-                for (int i=istart; i<iend; ++i)
-                {
-                    const int ijk = i + j*jj + k*kk;
-                    strain2[ijk] = TF(2.)*(
-                                   // du/dx + du/dx
-                                   + fm::pow2((u[ijk+ii]-u[ijk])*dxi)
-
-                                   // dv/dy + dv/dy
-                                   + fm::pow2((v[ijk+jj]-v[ijk])*dyi)
-
-                                   // dw/dz + dw/dz
-                                   + fm::pow2((w[ijk+kk]-w[ijk])*dzi[k])
-
-                                   // du/dy + dv/dx
-                                   + TF(0.125)*fm::pow2((u[ijk      ]-u[ijk   -jj])*dyi  + (v[ijk      ]-v[ijk-ii   ])*dxi)
-                                   + TF(0.125)*fm::pow2((u[ijk+ii   ]-u[ijk+ii-jj])*dyi  + (v[ijk+ii   ]-v[ijk      ])*dxi)
-                                   + TF(0.125)*fm::pow2((u[ijk   +jj]-u[ijk      ])*dyi  + (v[ijk   +jj]-v[ijk-ii+jj])*dxi)
-                                   + TF(0.125)*fm::pow2((u[ijk+ii+jj]-u[ijk+ii   ])*dyi  + (v[ijk+ii+jj]-v[ijk   +jj])*dxi)
-
-                                   // du/dz + dw/dx
-                                   + TF(0.125)*fm::pow2((u[ijk      ]-u[ijk   -kk])*dzhi[k  ] + (w[ijk      ]-w[ijk-ii   ])*dxi)
-                                   + TF(0.125)*fm::pow2((u[ijk+ii   ]-u[ijk+ii-kk])*dzhi[k  ] + (w[ijk+ii   ]-w[ijk      ])*dxi)
-                                   + TF(0.125)*fm::pow2((u[ijk   +kk]-u[ijk      ])*dzhi[k+1] + (w[ijk   +kk]-w[ijk-ii+kk])*dxi)
-                                   + TF(0.125)*fm::pow2((u[ijk+ii+kk]-u[ijk+ii   ])*dzhi[k+1] + (w[ijk+ii+kk]-w[ijk   +kk])*dxi)
-
-                                   // dv/dz + dw/dy
-                                   + TF(0.125)*fm::pow2((v[ijk      ]-v[ijk   -kk])*dzhi[k  ] + (w[ijk      ]-w[ijk-jj   ])*dyi)
-                                   + TF(0.125)*fm::pow2((v[ijk+jj   ]-v[ijk+jj-kk])*dzhi[k  ] + (w[ijk+jj   ]-w[ijk      ])*dyi)
-                                   + TF(0.125)*fm::pow2((v[ijk   +kk]-v[ijk      ])*dzhi[k+1] + (w[ijk   +kk]-w[ijk-jj+kk])*dyi)
-                                   + TF(0.125)*fm::pow2((v[ijk+jj+kk]-v[ijk+jj   ])*dzhi[k+1] + (w[ijk+jj+kk]-w[ijk   +kk])*dyi) );
-
-                    // Add a small number to avoid zero divisions.
-                    strain2[ijk] += Constants::dsmall;
-                }
+                for (int n=row_spans.begin(j, k); n<row_spans.end(j, k); ++n)
+                    #pragma ivdep
+                    for (int i=row_spans.i0[n]; i<row_spans.i1[n]; ++i)
+                    {
+                        const int ijk = i + j*jj + k*kk;
+                        strain2[ijk] = TF(2.)*(
+                                       // du/dx + du/dx
+                                       + fm::pow2((u[ijk+ii]-u[ijk])*dxi)
+
+                                       // dv/dy + dv/dy
+                                       + fm::pow2((v[ijk+jj]-v[ijk])*dyi)
+
+                                       // dw/dz + dw/dz
+                                       + fm::pow2((w[ijk+kk]-w[ijk])*dzi[k])
+
+                                       // du/dy + dv/dx
+                                       + TF(0.125)*fm::pow2((u[ijk      ]-u[ijk   -jj])*dyi  + (v[ijk      ]-v[ijk-ii   ])*dxi)
+                                       + TF(0.125)*fm::pow2((u[ijk+ii   ]-u[ijk+ii-jj])*dyi  + (v[ijk+ii   ]-v[ijk      ])*dxi)
+                                       + TF(0.125)*fm::pow2((u[ijk   +jj]-u[ijk      ])*dyi  + (v[ijk   +jj]-v[ijk-ii+jj])*dxi)
+                                       + TF(0.125)*fm::pow2((u[ijk+ii+jj]-u[ijk+ii   ])*dyi  + (v[ijk+ii+jj]-v[ijk   +jj])*dxi)
+
+                                       // du/dz + dw/dx
+                                       + TF(0.125)*fm::pow2((u[ijk      ]-u[ijk   -kk])*dzhi[k  ] + (w[ijk      ]-w[ijk-ii   ])*dxi)
+                                       + TF(0.125)*fm::pow2((u[ijk+ii   ]-u[ijk+ii-kk])*dzhi[k  ] + (w[ijk+ii   ]-w[ijk      ])*dxi)
+                                       + TF(0.125)*fm::pow2((u[ijk   +kk]-u[ijk      ])*dzhi[k+1] + (w[ijk   +kk]-w[ijk-ii+kk])*dxi)
+                                       + TF(0.125)*fm::pow2((u[ijk+ii+kk]-u[ijk+ii   ])*dzhi[k+1] + (w[ijk+ii+kk]-w[ijk   +kk])*dxi)
+
+                                       // dv/dz + dw/dy
+                                       + TF(0.125)*fm::pow2((v[ijk      ]-v[ijk   -kk])*dzhi[k  ] + (w[ijk      ]-w[ijk-jj   ])*dyi)
+                                       + TF(0.125)*fm::pow2((v[ijk+jj   ]-v[ijk+jj-kk])*dzhi[k  ] + (w[ijk+jj   ]-w[ijk      ])*dyi)
+                                       + TF(0.125)*fm::pow2((v[ijk   +kk]-v[ijk      ])*dzhi[k+1] + (w[ijk   +kk]-w[ijk-jj+kk])*dyi)
+                                       + TF(0.125)*fm::pow2((v[ijk+jj+kk]-v[ijk+jj   ])*dzhi[k+1] + (w[ijk+jj+kk]-w[ijk   +kk])*dyi) );
+
+                        // Add a small number to avoid zero divisions.
+                        strain2[ijk] += Constants::dsmall;
+                    }
     }
 
     template <typename TF, Surface_model surface_model>
@@ -151,9 +153,10 @@ namespace
                             TF* restrict ufluxbot, TF* restrict vfluxbot,
                             const TF* restrict z, const TF* restrict dz, const TF* restrict dzhi, const TF z0m,
                             const TF dx, const TF dy, const TF zsize, const TF cs, const TF visc,
-                            const int istart, const int iend, const int jstart, const int jend, const int kstart, const int kend,
+                            const int jstart, const int jend, const int kstart, const int kend,
                             const int icells, const int jcells, const int ijcells,
-                            Boundary_cyclic<TF>& boundary_cyclic)
+                            Boundary_cyclic<TF>& boundary_cyclic,
+                            const Row_spans& row_spans)
     {
         const int jj = icells;
         const int kk = ijcells;
@@ -170,24 +173,25 @@ namespace
                 const TF mlen_smag = cs*std::pow(dx*dy*dz[k], TF(1./3.));
 
                 for (int j=jstart; j<jend; ++j)
-                    #pragma ivdep
-                    for (int i=istart; i<iend; ++i)
-                    {
-                        const int ijk_bot = i + j*jj + kstart*kk;
-                        const int ijk_top = i + j*jj + kend*kk;
-                        const TF u_tau_bot = std::pow(
-                                fm::pow2( visc*(u[ijk_bot] - u[ijk_bot-kk] )*dzhi[kstart] )
-                              + fm::pow2( visc*(v[ijk_bot] - v[ijk_bot-kk] )*dzhi[kstart] ), TF(0.25) );
-                        const TF u_tau_top = std::pow(
-                                fm::pow2( visc*(u[ijk_top] - u[ijk_top-kk] )*dzhi[kend] )
-                              + fm::pow2( visc*(v[ijk_top] - v[ijk_top-kk] )*dzhi[kend] ), TF(0.25) );
-                        const TF fac_bot = TF(1.) - std::exp( -(       z[k] *u_tau_bot) / (A_vandriest*visc) );
-                        const TF fac_top = TF(1.) - std::exp( -((zsize-z[k])*u_tau_top) / (A_vandriest*visc) );
-                        const TF fac = std::min( fac_bot, fac_top );
-
-                        const int ijk = i + j*jj + k*kk;
-                        evisc[ijk] = fm::pow2(fac * mlen_smag) * std::sqrt(evisc[ijk]);
-                    }
+                    for (int n=row_spans.begin(j, k); n<row_spans.end(j, k); ++n)
+                        #pragma ivdep
+                        for (int i=row_spans.i0[n]; i<row_spans.i1[n]; ++i)
+                        {
+                            const int ijk_bot = i + j*jj + kstart*kk;
+                            const int ijk_top = i + j*jj + kend*kk;
+                            const TF u_tau_bot = std::pow(
+                                    fm::pow2( visc*(u[ijk_bot] - u[ijk_bot-kk] )*dzhi[kstart] )
+                                  + fm::pow2( visc*(v[ijk_bot] - v[ijk_bot-kk] )*dzhi[kstart] ), TF(0.25) );
+                            const TF u_tau_top = std::pow(
+                                    fm::pow2( visc*(u[ijk_top] - u[ijk_top-kk] )*dzhi[kend] )
+                                  + fm::pow2( visc*(v[ijk_top] - v[ijk_top-kk] )*dzhi[kend] ), TF(0.25) );
+                            const TF fac_bot = TF(1.) - std::exp( -(       z[k] *u_tau_bot) / (A_vandriest*visc) );
+                            const TF fac_top = TF(1.) - std::exp( -((zsize-z[k])*u_tau_top) / (A_vandriest*visc) );
+                            const TF fac = std::min( fac_bot, fac_top );
+
+                            const int ijk = i + j*jj + k*kk;
+                            evisc[ijk] = fm::pow2(fac * mlen_smag) * std::sqrt(evisc[ijk]);
+                        }
             }
 
             // For a resolved wall the viscosity at the wall is needed. For now, assume that the eddy viscosity
@@ -214,16 +218,18 @@ namespace
                 const TF fac  = fm::pow2(mlen);
 
                 for (int j=jstart; j<jend; ++j)
-                    #pragma ivdep
-                    for (int i=istart; i<iend; ++i)
-                    {
-                        const int ijk = i + j*jj + k*kk;
-                        evisc[ijk] = fac * std::sqrt(evisc[ijk]);
-                    }
+                    for (int n=row_spans.begin(j, k); n<row_spans.end(j, k); ++n)
+                        #pragma ivdep
+                        for (int i=row_spans.i0[n]; i<row_spans.i1[n]; ++i)
+                        {
+                            const int ijk = i + j*jj + k*kk;
+                            evisc[ijk] = fac * std::sqrt(evisc[ijk]);
+                        }
             }
         }
 
-        boundary_cyclic.exec(evisc);
+        // The second-order diffusion stencils need one ghost cell of the eddy viscosity.
+        boundary_cyclic.exec(evisc, Edge::Both_edges, 1, 1);
     }
 
     template<typename TF, Surface_model surface_model>
@@ -236,7 +242,8 @@ namespace
                     const TF z0m, const TF cs, const TF tPr,
                     const int istart, const int iend, const int jstart, const int jend, const int kstart, const int kend,
                     const int icells, const int jcells, const int ijcells,
-                    Boundary_cyclic<TF>& boundary_cyclic)
+                    Boundary_cyclic<TF>& boundary_cyclic,
+                    const Row_spans& row_spans)
     {
         const int jj = icells;
         const int kk = ijcells;
@@ -250,15 +257,16 @@ namespace
                 const TF fac = fm::pow2(mlen);
 
                 for (int j=jstart; j<jend; ++j)
-                    #pragma ivdep
-                    for (int i=istart; i<iend; ++i)
-                    {
-                        const int ijk = i + j*jj + k*kk;
-                        // Add the buoyancy production to the TKE
-                        TF RitPrratio = N2[ijk] / evisc[ijk] / tPr;
-                        RitPrratio = std::min(RitPrratio, TF(1.-Constants::dsmall));
-                        evisc[ijk] = fac * std::sqrt(evisc[ijk]) * std::sqrt(TF(1.)-RitPrratio);
-                    }
+                    for (int n=row_spans.begin(j, k); n<row_spans.end(j, k); ++n)
+                        #pragma ivdep
+                        for (int i=row_spans.i0[n]; i<row_spans.i1[n]; ++i)
+                        {
+                            const int ijk = i + j*jj + k*kk;
+                            // Add the buoyancy production to the TKE
+                            TF RitPrratio = N2[ijk] / evisc[ijk] / tPr;
+                            RitPrratio = std::min(RitPrratio, TF(1.-Constants::dsmall));
+                            evisc[ijk] = fac * std::sqrt(evisc[ijk]) * std::sqrt(TF(1.)-RitPrratio);
+                        }
             }
 
             // For a resolved wall the viscosity at the wall is needed. For now, assume that the eddy viscosity
@@ -309,19 +317,21 @@ namespace
                 const TF fac = fm::pow2(mlen);
 
                 for (int j=jstart; j<jend; ++j)
-                    #pragma ivdep
-                    for (int i=istart; i<iend; ++i)
-                    {
-                        const int ijk = i + j*jj + k*kk;
-                        // Add the buoyancy production to the TKE
-                        TF RitPrratio = N2[ijk] / evisc[ijk] / tPr;
-                        RitPrratio = std::min(RitPrratio, TF(1.-Constants::dsmall));
-                        evisc[ijk] = fac * std::sqrt(evisc[ijk]) * std::sqrt(TF(1.)-RitPrratio);
-                    }
+                    for (int n=row_spans.begin(j, k); n<row_spans.end(j, k); ++n)
+                        #pragma ivdep
+                        for (int i=row_spans.i0[n]; i<row_spans.i1[n]; ++i)
+                        {
+                            const int ijk = i + j*jj + k*kk;
+                            // Add the buoyancy production to the TKE
+                            TF RitPrratio = N2[ijk] / evisc[ijk] / tPr;
+                            RitPrratio = std::min(RitPrratio, TF(1.-Constants::dsmall));
+                            evisc[ijk] = fac * std::sqrt(evisc[ijk]) * std::sqrt(TF(1.)-RitPrratio);
+                        }
             }
         }
 
-        boundary_cyclic.exec(evisc);
+        // The second-order diffusion stencils need one ghost cell of the eddy viscosity.
+        boundary_cyclic.exec(evisc, Edge::Both_edges, 1, 1);
     }
 
     template <typename TF, Surface_model surface_model>
@@ -333,7 +343,8 @@ namespace
                 const TF* restrict rhoref, const TF* restrict rhorefh,
                 const TF visc,
                 const int istart, const int iend, const int jstart, const int jend, const int kstart, const int kend,
-                const int jj, const int kk)
+                const int jj, const int kk,
+                const Row_spans& row_spans)
     {
         constexpr int k_offset = (surface_model == Surface_model::Disabled) ? 0 : 1;
 
@@ -394,27 +405,28 @@ namespace
 
         for (int k=kstart+k_offset; k<kend-k_offset; ++k)
             for (int j=jstart; j<jend; ++j)
-                #pragma ivdep
-                for (int i=istart; i<iend; ++i)
-                {
-                    const int ijk = i + j*jj + k*kk;
-                    const TF evisce = evisc[ijk   ] + visc;
-                    const TF eviscw = evisc[ijk-ii] + visc;
-                    const TF eviscn = TF(0.25)*(evisc[ijk-ii   ] + evisc[ijk   ] + evisc[ijk-ii+jj] + evisc[ijk+jj]) + visc;
-                    const TF eviscs = TF(0.25)*(evisc[ijk-ii-jj] + evisc[ijk-jj] + evisc[ijk-ii   ] + evisc[ijk   ]) + visc;
-                    const TF evisct = TF(0.25)*(evisc[ijk-ii   ] + evisc[ijk   ] + evisc[ijk-ii+kk] + evisc[ijk+kk]) + visc;
-                    const TF eviscb = TF(0.25)*(evisc[ijk-ii-kk] + evisc[ijk-kk] + evisc[ijk-ii   ] + evisc[ijk   ]) + visc;
-                    ut[ijk] +=
-                             // du/dx + du/dx
-                             + ( evisce*(u[ijk+ii]-u[ijk   ])*dxi
-                               - eviscw*(u[ijk   ]-u[ijk-ii])*dxi ) * TF(2.)*dxi
-                             // du/dy + dv/dx
-                             + ( eviscn*((u[ijk+jj]-u[ijk   ])*dyi  + (v[ijk+jj]-v[ijk-ii+jj])*dxi)
-                               - eviscs*((u[ijk   ]-u[ijk-jj])*dyi  + (v[ijk   ]-v[ijk-ii   ])*dxi) ) * dyi
-                             // du/dz + dw/dx
-                             + ( rhorefh[k+1] * evisct*((u[ijk+kk]-u[ijk   ])* dzhi[k+1] + (w[ijk+kk]-w[ijk-ii+kk])*dxi)
-                               - rhorefh[k  ] * eviscb*((u[ijk   ]-u[ijk-kk])* dzhi[k  ] + (w[ijk   ]-w[ijk-ii   ])*dxi) ) / rhoref[k] * dzi[k];
-                }
+                for (int n=row_spans.begin(j, k); n<row_spans.end(j, k); ++n)
+                    #pragma ivdep
+                    for (int i=row_spans.i0[n]; i<row_spans.i1[n]; ++i)
+                    {
+                        const int ijk = i + j*jj + k*kk;
+                        const TF evisce = evisc[ijk   ] + visc;
+                        const TF eviscw = evisc[ijk-ii] + visc;
+                        const TF eviscn = TF(0.25)*(evisc[ijk-ii   ] + evisc[ijk   ] + evisc[ijk-ii+jj] + evisc[ijk+jj]) + visc;
+                        const TF eviscs = TF(0.25)*(evisc[ijk-ii-jj] + evisc[ijk-jj] + evisc[ijk-ii   ] + evisc[ijk   ]) + visc;
+                        const TF evisct = TF(0.25)*(evisc[ijk-ii   ] + evisc[ijk   ] + evisc[ijk-ii+kk] + evisc[ijk+kk]) + visc;
+                        const TF eviscb = TF(0.25)*(evisc[ijk-ii-kk] + evisc[ijk-kk] + evisc[ijk-ii   ] + evisc[ijk   ]) + visc;
+                        ut[ijk] +=
+                                 // du/dx + du/dx
+                                 + ( evisce*(u[ijk+ii]-u[ijk   ])*dxi
+                                   - eviscw*(u[ijk   ]-u[ijk-ii])*dxi ) * TF(2.)*dxi
+                                 // du/dy + dv/dx
+                                 + ( eviscn*((u[ijk+jj]-u[ijk   ])*dyi  + (v[ijk+jj]-v[ijk-ii+jj])*dxi)
+                                   - eviscs*((u[ijk   ]-u[ijk-jj])*dyi  + (v[ijk   ]-v[ijk-ii   ])*dxi) ) * dyi
+                                 // du/dz + dw/dx
+                                 + ( rhorefh[k+1] * evisct*((u[ijk+kk]-u[ijk   ])* dzhi[k+1] + (w[ijk+kk]-w[ijk-ii+kk])*dxi)
+                                   - rhorefh[k  ] * eviscb*((u[ijk   ]-u[ijk-kk])* dzhi[k  ] + (w[ijk   ]-w[ijk-ii   ])*dxi) ) / rhoref[k] * dzi[k];
+                    }
     }
 
     template <typename TF, Surface_model surface_model>
@@ -426,7 +438,8 @@ namespace
                 TF* restrict rhoref, TF* restrict rhorefh,
                 const TF visc,
                 const int istart, const int iend, const int jstart, const int jend, const int kstart, const int kend,
-                const int jj, const int kk)
+                const int jj, const int kk,
+                const Row_spans& row_spans)
 
     {
         constexpr int k_offset = (surface_model == Surface_model::Disabled) ? 0 : 1;
@@ -488,27 +501,28 @@ namespace
 
         for (int k=kstart+k_offset; k<kend-k_offset; ++k)
             for (int j=jstart; j<jend; ++j)
-                #pragma ivdep
-                for (int i=istart; i<iend; ++i)
-                {
-                    const int ijk = i + j*jj + k*kk;
-                    const TF evisce = TF(0.25)*(evisc[ijk   -jj] + evisc[ijk   ] + evisc[ijk+ii-jj] + evisc[ijk+ii]) + visc;
-                    const TF eviscw = TF(0.25)*(evisc[ijk-ii-jj] + evisc[ijk-ii] + evisc[ijk   -jj] + evisc[ijk   ]) + visc;
-                    const TF eviscn = evisc[ijk   ] + visc;
-                    const TF eviscs = evisc[ijk-jj] + visc;
-                    const TF evisct = TF(0.25)*(evisc[ijk   -jj] + evisc[ijk   ] + evisc[ijk+kk-jj] + evisc[ijk+kk]) + visc;
-                    const TF eviscb = TF(0.25)*(evisc[ijk-kk-jj] + evisc[ijk-kk] + evisc[ijk   -jj] + evisc[ijk   ]) + visc;
-                    vt[ijk] +=
-                             // dv/dx + du/dy
-                             + ( evisce*((v[ijk+ii]-v[ijk   ])*dxi + (u[ijk+ii]-u[ijk+ii-jj])*dyi)
-                               - eviscw*((v[ijk   ]-v[ijk-ii])*dxi + (u[ijk   ]-u[ijk   -jj])*dyi) ) * dxi
-                             // dv/dy + dv/dy
-                             + ( eviscn*(v[ijk+jj]-v[ijk   ])*dyi
-                               - eviscs*(v[ijk   ]-v[ijk-jj])*dyi ) * TF(2.)*dyi
-                             // dv/dz + dw/dy
-                             + ( rhorefh[k+1] * evisct*((v[ijk+kk]-v[ijk   ])*dzhi[k+1] + (w[ijk+kk]-w[ijk-jj+kk])*dyi)
-                               - rhorefh[k  ] * eviscb*((v[ijk   ]-v[ijk-kk])*dzhi[k  ] + (w[ijk   ]-w[ijk-jj   ])*dyi) ) / rhoref[k] * dzi[k];
-                }
+                for (int n=row_spans.begin(j, k); n<row_spans.end(j, k); ++n)
+                    #pragma ivdep
+                    for (int i=row_spans.i0[n]; i<row_spans.i1[n]; ++i)
+                    {
+                        const int ijk = i + j*jj + k*kk;
+                        const TF evisce = TF(0.25)*(evisc[ijk   -jj] + evisc[ijk   ] + evisc[ijk+ii-jj] + evisc[ijk+ii]) + visc;
+                        const TF eviscw = TF(0.25)*(evisc[ijk-ii-jj] + evisc[ijk-ii] + evisc[ijk   -jj] + evisc[ijk   ]) + visc;
+                        const TF eviscn = evisc[ijk   ] + visc;
+                        const TF eviscs = evisc[ijk-jj] + visc;
+                        const TF evisct = TF(0.25)*(evisc[ijk   -jj] + evisc[ijk   ] + evisc[ijk+kk-jj] + evisc[ijk+kk]) + visc;
+                        const TF eviscb = TF(0.25)*(evisc[ijk-kk-jj] + evisc[ijk-kk] + evisc[ijk   -jj] + evisc[ijk   ]) + visc;
+                        vt[ijk] +=
+                                 // dv/dx + du/dy
+                                 + ( evisce*((v[ijk+ii]-v[ijk   ])*dxi + (u[ijk+ii]-u[ijk+ii-jj])*dyi)
+                                   - eviscw*((v[ijk   ]-v[ijk-ii])*dxi + (u[ijk   ]-u[ijk   -jj])*dyi) ) * dxi
+                                 // dv/dy + dv/dy
+                                 + ( eviscn*(v[ijk+jj]-v[ijk   ])*dyi
+                                   - eviscs*(v[ijk   ]-v[ijk-jj])*dyi ) * TF(2.)*dyi
+                                 // dv/dz + dw/dy
+                                 + ( rhorefh[k+1] * evisct*((v[ijk+kk]-v[ijk   ])*dzhi[k+1] + (w[ijk+kk]-w[ijk-jj+kk])*dyi)
+                                   - rhorefh[k  ] * eviscb*((v[ijk   ]-v[ijk-kk])*dzhi[k  ] + (w[ijk   ]-w[ijk-jj   ])*dyi) ) / rhoref[k] * dzi[k];
+                    }
     }
 
     template <typename TF>
@@ -518,34 +532,36 @@ namespace
                 const TF* restrict evisc,
                 const TF* restrict rhoref, const TF* restrict rhorefh,
                 const TF visc,
-                const int istart, const int iend, const int jstart, const int jend, const int kstart, const int kend,
-                const int jj, const int kk)
+                const int jstart, const int jend, const int kstart, const int kend,
+                const int jj, const int kk,
+                const Row_spans& row_spans)
     {
         const int ii = 1;
 
         for (int k=kstart+1; k<kend; ++k)
             for (int j=jstart; j<jend; ++j)
-                #pragma ivdep
-                for (int i=istart; i<iend; ++i)
-                {
-                    const int ijk = i + j*jj + k*kk;
-                    const TF evisce = TF(0.25)*(evisc[ijk   -kk] + evisc[ijk   ] + evisc[ijk+ii-kk] + evisc[ijk+ii]) + visc;
-                    const TF eviscw = TF(0.25)*(evisc[ijk-ii-kk] + evisc[ijk-ii] + evisc[ijk   -kk] + evisc[ijk   ]) + visc;
-                    const TF eviscn = TF(0.25)*(evisc[ijk   -kk] + evisc[ijk   ] + evisc[ijk+jj-kk] + evisc[ijk+jj]) + visc;
-                    const TF eviscs = TF(0.25)*(evisc[ijk-jj-kk] + evisc[ijk-jj] + evisc[ijk   -kk] + evisc[ijk   ]) + visc;
-                    const TF evisct = evisc[ijk   ] + visc;
-                    const TF eviscb = evisc[ijk-kk] + visc;
-                    wt[ijk] +=
-                             // dw/dx + du/dz
-                             + ( evisce*((w[ijk+ii]-w[ijk   ])*dxi + (u[ijk+ii]-u[ijk+ii-kk])*dzhi[k])
-                               - eviscw*((w[ijk   ]-w[ijk-ii])*dxi + (u[ijk   ]-u[ijk+  -kk])*dzhi[k]) ) * dxi
-                             // dw/dy + dv/dz
-                             + ( eviscn*((w[ijk+jj]-w[ijk   ])*dyi + (v[ijk+jj]-v[ijk+jj-kk])*dzhi[k])
-                               - eviscs*((w[ijk   ]-w[ijk-jj])*dyi + (v[ijk   ]-v[ijk+  -kk])*dzhi[k]) ) * dyi
-                             // dw/dz + dw/dz
-                             + ( rhoref[k  ] * evisct*(w[ijk+kk]-w[ijk   ])*dzi[k  ]
-                               - rhoref[k-1] * eviscb*(w[ijk   ]-w[ijk-kk])*dzi[k-1] ) / rhorefh[k] * TF(2.)*dzhi[k];
-                }
+                for (int n=row_spans.begin(j, k); n<row_spans.end(j, k); ++n)
+                    #pragma ivdep
+                    for (int i=row_spans.i0[n]; i<row_spans.i1[n]; ++i)
+                    {
+                        const int ijk = i + j*jj + k*kk;
+                        const TF evisce = TF(0.25)*(evisc[ijk   -kk] + evisc[ijk   ] + evisc[ijk+ii-kk] + evisc[ijk+ii]) + visc;
+                        const TF eviscw = TF(0.25)*(evisc[ijk-ii-kk] + evisc[ijk-ii] + evisc[ijk   -kk] + evisc[ijk   ]) + visc;
+                        const TF eviscn = TF(0.25)*(evisc[ijk   -kk] + evisc[ijk   ] + evisc[ijk+jj-kk] + evisc[ijk+jj]) + visc;
+                        const TF eviscs = TF(0.25)*(evisc[ijk-jj-kk] + evisc[ijk-jj] + evisc[ijk   -kk] + evisc[ijk   ]) + visc;
+                        const TF evisct = evisc[ijk   ] + visc;
+                        const TF eviscb = evisc[ijk-kk] + visc;
+                        wt[ijk] +=
+                                 // dw/dx + du/dz
+                                 + ( evisce*((w[ijk+ii]-w[ijk   ])*dxi + (u[ijk+ii]-u[ijk+ii-kk])*dzhi[k])
+                                   - eviscw*((w[ijk   ]-w[ijk-ii])*dxi + (u[ijk   ]-u[ijk+  -kk])*dzhi[k]) ) * dxi
+                                 // dw/dy + dv/dz
+                                 + ( eviscn*((w[ijk+jj]-w[ijk   ])*dyi + (v[ijk+jj]-v[ijk+jj-kk])*dzhi[k])
+                                   - eviscs*((w[ijk   ]-w[ijk-jj])*dyi + (v[ijk   ]-v[ijk+  -kk])*dzhi[k]) ) * dyi
+                                 // dw/dz + dw/dz
+                                 + ( rhoref[k  ] * evisct*(w[ijk+kk]-w[ijk   ])*dzi[k  ]
+                                   - rhoref[k-1] * eviscb*(w[ijk   ]-w[ijk-kk])*dzi[k-1] ) / rhorefh[k] * TF(2.)*dzhi[k];
+                    }
     }
 
     template <typename TF, Surface_model surface_model>
@@ -556,7 +572,8 @@ namespace
                 const TF* restrict rhoref, const TF* restrict rhorefh,
                 const TF tPr, const TF visc,
                 const int istart, const int iend, const int jstart, const int jend, const int kstart, const int kend,
-                const int jj, const int kk)
+                const int jj, const int kk,
+                const Row_spans& row_spans)
     {
         constexpr int k_offset = (surface_model == Surface_model::Disabled) ? 0 : 1;
 
@@ -611,25 +628,26 @@ namespace
 
         for (int k=kstart+k_offset; k<kend-k_offset; ++k)
             for (int j=jstart; j<jend; ++j)
-                #pragma ivdep
-                for (int i=istart; i<iend; ++i)
-                {
-                    const int ijk = i + j*jj + k*kk;
-                    const TF evisce = TF(0.5)*(evisc[ijk   ]+evisc[ijk+ii])/tPr + visc;
-                    const TF eviscw = TF(0.5)*(evisc[ijk-ii]+evisc[ijk   ])/tPr + visc;
-                    const TF eviscn = TF(0.5)*(evisc[ijk   ]+evisc[ijk+jj])/tPr + visc;
-                    const TF eviscs = TF(0.5)*(evisc[ijk-jj]+evisc[ijk   ])/tPr + visc;
-                    const TF evisct = TF(0.5)*(evisc[ijk   ]+evisc[ijk+kk])/tPr + visc;
-                    const TF eviscb = TF(0.5)*(evisc[ijk-kk]+evisc[ijk   ])/tPr + visc;
-
-                    at[ijk] +=
-                             + ( evisce*(a[ijk+ii]-a[ijk   ])
-                               - eviscw*(a[ijk   ]-a[ijk-ii]) ) * dxidxi
-                             + ( eviscn*(a[ijk+jj]-a[ijk   ])
-                               - eviscs*(a[ijk   ]-a[ijk-jj]) ) * dyidyi
-                             + ( rhorefh[k+1] * evisct*(a[ijk+kk]-a[ijk   ])*dzhi[k+1]
-                               - rhorefh[k  ] * eviscb*(a[ijk   ]-a[ijk-kk])*dzhi[k]  ) / rhoref[k] * dzi[k];
-                }
+                for (int n=row_spans.begin(j, k); n<row_spans.end(j, k); ++n)
+                    #pragma ivdep
+                    for (int i=row_spans.i0[n]; i<row_spans.i1[n]; ++i)
+                    {
+                        const int ijk = i + j*jj + k*kk;
+                        const TF evisce = TF(0.5)*(evisc[ijk   ]+evisc[ijk+ii])/tPr + visc;
+                        const TF eviscw = TF(0.5)*(evisc[ijk-ii]+evisc[ijk   ])/tPr + visc;
+                        const TF eviscn = TF(0.5)*(evisc[ijk   ]+evisc[ijk+jj])/tPr + visc;
+                        const TF eviscs = TF(0.5)*(evisc[ijk-jj]+evisc[ijk   ])/tPr + visc;
+                        const TF evisct = TF(0.5)*(evisc[ijk   ]+evisc[ijk+kk])/tPr + visc;
+                        const TF eviscb = TF(0.5)*(evisc[ijk-kk]+evisc[ijk   ])/tPr + visc;
+
+                        at[ijk] +=
+                                 + ( evisce*(a[ijk+ii]-a[ijk   ])
+                                   - eviscw*(a[ijk   ]-a[ijk-ii]) ) * dxidxi
+                                 + ( eviscn*(a[ijk+jj]-a[ijk   ])
+                                   - eviscs*(a[ijk   ]-a[ijk-jj]) ) * dyidyi
+                                 + ( rhorefh[k+1] * evisct*(a[ijk+kk]-a[ijk   ])*dzhi[k+1]
+                                   - rhorefh[k  ] * eviscb*(a[ijk   ]-a[ijk-kk])*dzhi[k]  ) / rhoref[k] * dzi[k];
+                    }
     }
 
     template<typename TF>
@@ -847,7 +865,7 @@ void Diff_smag2<TF>::exec(Stats<TF>& stats)
                 fields.rhoref.data(), fields.rhorefh.data(),
                 fields.visc,
                 gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
-                gd.icells, gd.ijcells);
+                gd.icells, gd.ijcells, gd.row_spans);
 
         diff_v<TF, Surface_model::Enabled>(
                 fields.mt.at("v")->fld.data(),
@@ -858,7 +876,7 @@ void Diff_smag2<TF>::exec(Stats<TF>& stats)
                 fields.rhoref.data(), fields.rhorefh.data(),
                 fields.visc,
                 gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
-                gd.icells, gd.ijcells);
+                gd.icells, gd.ijcells, gd.row_spans);
 
         diff_w<TF>(
                 fields.mt.at("w")->fld.data(),
@@ -867,8 +885,8 @@ void Diff_smag2<TF>::exec(Stats<TF>& stats)
                 fields.sd.at("evisc")->fld.data(),
                 fields.rhoref.data(), fields.rhorefh.data(),
                 fields.visc,
-                gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
-                gd.icells, gd.ijcells);
+                gd.jstart, gd.jend, gd.kstart, gd.kend,
+                gd.icells, gd.ijcells, gd.row_spans);
 
         for (auto it : fields.st)
         {
@@ -880,7 +898,7 @@ void Diff_smag2<TF>::exec(Stats<TF>& stats)
                     fields.rhoref.data(), fields.rhorefh.data(), tPr,
                     fields.sp.at(it.first)->visc,
                     gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
-                    gd.icells, gd.ijcells);
+                    gd.icells, gd.ijcells, gd.row_spans);
         }
     }
     else
@@ -894,7 +912,7 @@ void Diff_smag2<TF>::exec(Stats<TF>& stats)
                 fields.rhoref.data(), fields.rhorefh.data(),
                 fields.visc,
                 gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
-                gd.icells, gd.ijcells);
+                gd.icells, gd.ijcells, gd.row_spans);
 
         diff_v<TF, Surface_model::Disabled>(
                 fields.mt.at("v")->fld.data(),
@@ -905,7 +923,7 @@ void Diff_smag2<TF>::exec(Stats<TF>& stats)
                 fields.rhoref.data(), fields.rhorefh.data(),
                 fields.visc,
                 gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
-                gd.icells, gd.ijcells);
+                gd.icells, gd.ijcells, gd.row_spans);
 
         diff_w<TF>(
                 fields.mt.at("w")->fld.data(),
@@ -914,8 +932,8 @@ void Diff_smag2<TF>::exec(Stats<TF>& stats)
                 fields.sd.at("evisc")->fld.data(),
                 fields.rhoref.data(), fields.rhorefh.data(),
                 fields.visc,
-                gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
-                gd.icells, gd.ijcells);
+                gd.jstart, gd.jend, gd.kstart, gd.kend,
+                gd.icells, gd.ijcells, gd.row_spans);
 
         for (auto it : fields.st)
         {
@@ -927,7 +945,7 @@ void Diff_smag2<TF>::exec(Stats<TF>& stats)
                     fields.rhoref.data(), fields.rhorefh.data(), tPr,
                     fields.sp.at(it.first)->visc,
                     gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
-                    gd.icells, gd.ijcells);
+                    gd.icells, gd.ijcells, gd.row_spans);
         }
     }
 
@@ -952,7 +970,7 @@ void Diff_smag2<TF>::exec_viscosity(Thermo<TF>& thermo)
                 boundary.ustar.data(), boundary.obuk.data(),
                 gd.z.data(), gd.dzi.data(), gd.dzhi.data(), 1./gd.dx, 1./gd.dy,
                 gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
-                gd.icells, gd.ijcells);
+                gd.icells, gd.ijcells, gd.row_spans);
 
     // Calculate strain rate using resolved boundaries.
     else
@@ -963,7 +981,7 @@ void Diff_smag2<TF>::exec_viscosity(Thermo<TF>& thermo)
                 nullptr, nullptr,
                 gd.z.data(), gd.dzi.data(), gd.dzhi.data(), 1./gd.dx, 1./gd.dy,
                 gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
-                gd.icells, gd.ijcells);
+                gd.icells, gd.ijcells, gd.row_spans);
 
     // Start with retrieving the stability information
     if (thermo.get_switch() == "0")
@@ -976,9 +994,9 @@ void Diff_smag2<TF>::exec_viscosity(Thermo<TF>& thermo)
                     fields.mp.at("u")->flux_bot.data(), fields.mp.at("v")->flux_bot.data(),
                     gd.z.data(), gd.dz.data(), gd.dzhi.data(), boundary.z0m,
                     gd.dx, gd.dy, gd.zsize, this->cs, fields.visc,
-                    gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
+                    gd.jstart, gd.jend, gd.kstart, gd.kend,
                     gd.icells, gd.jcells, gd.ijcells,
-                    boundary_cyclic);
+                    boundary_cyclic, gd.row_spans);
 
         // Calculate eddy viscosity assuming resolved walls
         else
@@ -988,9 +1006,9 @@ void Diff_smag2<TF>::exec_viscosity(Thermo<TF>& thermo)
                     fields.mp.at("u")->flux_bot.data(), fields.mp.at("v")->flux_bot.data(),
                     gd.z.data(), gd.dz.data(), gd.dzhi.data(), boundary.z0m,
                     gd.dx, gd.dy, gd.zsize, this->cs, fields.visc,
-                    gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
+                    gd.jstart, gd.jend, gd.kstart, gd.kend,
                     gd.icells, gd.jcells, gd.ijcells,
-                    boundary_cyclic);
+                    boundary_cyclic, gd.row_spans);
     }
     // assume buoyancy calculation is needed
     else
@@ -1013,7 +1031,7 @@ void Diff_smag2<TF>::exec_viscosity(Thermo<TF>& thermo)
                     boundary.z0m, this->cs, this->tPr,
                     gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
                     gd.icells, gd.jcells, gd.ijcells,
-                    boundary_cyclic);
+                    boundary_cyclic, gd.row_spans);
         else
             calc_evisc<TF, Surface_model::Disabled>(
                     fields.sd.at("evisc")->fld.data(),
@@ -1025,7 +1043,7 @@ void Diff_smag2<TF>::exec_viscosity(Thermo<TF>& thermo)
                     boundary.z0m, this->cs, this->tPr,
                     gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
                     gd.icells, gd.jcells, gd.ijcells,
-                    boundary_cyclic);
+                    boundary_cyclic, gd.row_spans);
 
         fields.release_tmp(buoy_tmp);
         fields.release_tmp(tmp);
@@ -23,6 +23,7 @@
 #include <cstdio>
 #include <iostream>
 #include <cmath>
+#include <algorithm>
 #include "master.h"
 #include "grid.h"
 #include "field3d.h"
@@ -42,6 +43,9 @@ Field3d<TF>::Field3d(
     unit     = unitin;
     group    = groupin;
     loc      = locin;
+
+    igc = 0;
+    jgc = 0;
 }
 
 template<typename TF>
@@ -49,11 +53,24 @@ Field3d<TF>::~Field3d()
 {
 }
 
+template<typename TF>
+void Field3d<TF>::set_minimum_ghost_cells(const int igcin, const int jgcin)
+{
+    igc = std::max(igc, igcin);
+    jgc = std::max(jgc, jgcin);
+
+    grid.reserve_ghost_cells(igcin, jgcin, 0);
+}
+
 template<typename TF>
 int Field3d<TF>::init()
 {
     const Grid_data<TF>& gd = grid.get_grid_data();
 
+    // Every field has at least the number of ghost cells that all fields require.
+    igc = std::max(igc, gd.igc_min);
+    jgc = std::max(jgc, gd.jgc_min);
+
     // Calculate the total field memory size
     const long long field_memory_size = (gd.ncells + 6*gd.ijcells + gd.kcells)*sizeof(TF);
 
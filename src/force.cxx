@@ -169,24 +169,12 @@ namespace
 
     template<typename TF>
     void calc_nudging_tendency(
-            TF* const restrict fldtend, const TF* const restrict fldmean,
+            TF* const restrict tend, const TF* const restrict fldmean,
             const TF* const restrict ref, const TF* const restrict factor,
-            const int istart, const int iend, const int jstart, const int jend, const int kstart, const int kend,
-            const int icells, const int ijcells)
+            const int kstart, const int kend)
     {
-        const int jj = icells;
-        const int kk = ijcells;
-
         for (int k=kstart; k<kend; ++k)
-        {
-            const TF tend = -factor[k] * (fldmean[k] - ref[k]);
-            for (int j=jstart; j<jend; ++j)
-                for (int i=istart; i<iend; ++i)
-                {
-                    const int ijk = i + j*jj + k*kk;
-                    fldtend[ijk] += tend;
-                }
-        }
+            tend[k] = -factor[k] * (fldmean[k] - ref[k]);
     }
 
     template<typename TF>
@@ -201,35 +189,17 @@ namespace
 
     template<typename TF>
     void advec_wls_2nd(
-            TF* const restrict st, const TF* const restrict s,
+            TF* const restrict tend, const TF* const restrict s,
             const TF* const restrict wls, const TF* const dzhi,
-            const int istart, const int iend, const int jstart, const int jend, const int kstart, const int kend,
-            const int icells, const int ijcells)
+            const int kstart, const int kend)
     {
-        const int jj = icells;
-        const int kk = ijcells;
-
         // use an upwind differentiation
         for (int k=kstart; k<kend; ++k)
         {
             if (wls[k] > 0.)
-            {
-                for (int j=jstart; j<jend; ++j)
-                    for (int i=istart; i<iend; ++i)
-                    {
-                        const int ijk = i + j*jj + k*kk;
-                        st[ijk] -=  wls[k] * (s[k]-s[k-1])*dzhi[k];
-                    }
-            }
+                tend[k] = -wls[k] * (s[k]-s[k-1])*dzhi[k];
             else
-            {
-                for (int j=jstart; j<jend; ++j)
-                    for (int i=istart; i<iend; ++i)
-                    {
-                        const int ijk = i + j*jj + k*kk;
-                        st[ijk] -=  wls[k] * (s[k+1]-s[k])*dzhi[k+1];
-                    }
-            }
+                tend[k] = -wls[k] * (s[k+1]-s[k])*dzhi[k+1];
         }
     }
 
@@ -528,18 +498,36 @@ void Force<TF>::exec(double dt, Thermo<TF>& thermo, Stats<TF>& stats)
 
     }
 
-    if (swls == Large_scale_tendency_type::Enabled)
+    // The large-scale source, subsidence and nudging tendencies are horizontally uniform. If their statistics
+    // are not needed at this step, their profiles are summed and added to each field in a single pass.
+    const bool sum_profs = !stats.get_tendency();
+    std::map<std::string, std::vector<TF>> tend_profs;
+
+    auto add_tend_prof = [&](const std::string& name, const TF* const prof, const std::string& tend_name)
     {
-        for (auto& it : lslist)
+        if (sum_profs)
+        {
+            auto it = tend_profs.emplace(name, std::vector<TF>(gd.kcells, TF(0.))).first;
+            for (int k=gd.kstart; k<gd.kend; ++k)
+                it->second[k] += prof[k];
+        }
+        else
         {
             calc_large_scale_source<TF>(
-                    fields.at.at(it)->fld.data(), lsprofs.at(it).data(),
+                    fields.at.at(name)->fld.data(), prof,
                     gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
                     gd.icells, gd.ijcells);
 
-            stats.calc_tend(*fields.at.at(it), tend_name_ls);
+            stats.calc_tend(*fields.at.at(name), tend_name);
         }
+    };
+
+    std::vector<TF> tend(gd.kcells);
 
+    if (swls == Large_scale_tendency_type::Enabled)
+    {
+        for (auto& it : lslist)
+            add_tend_prof(it, lsprofs.at(it).data(), tend_name_ls);
     }
 
     if (swwls == Large_scale_subsidence_type::Enabled)
@@ -547,10 +535,9 @@ void Force<TF>::exec(double dt, Thermo<TF>& thermo, Stats<TF>& stats)
         for (auto& it : fields.st)
         {
             advec_wls_2nd<TF>(
-                    fields.st.at(it.first)->fld.data(), fields.sp.at(it.first)->fld_mean.data(), wls.data(), gd.dzhi.data(),
-                    gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
-                    gd.icells, gd.ijcells);
-            stats.calc_tend(*it.second, tend_name_subs);
+                    tend.data(), fields.sp.at(it.first)->fld_mean.data(), wls.data(), gd.dzhi.data(),
+                    gd.kstart, gd.kend);
+            add_tend_prof(it.first, tend.data(), tend_name_subs);
         }
     }
 
@@ -566,14 +553,18 @@ void Force<TF>::exec(double dt, Thermo<TF>& thermo, Stats<TF>& stats)
             }
 
             calc_nudging_tendency<TF>(
-                    fields.at.at(it)->fld.data(), fields.ap.at(it)->fld_mean.data(),
+                    tend.data(), fields.ap.at(it)->fld_mean.data(),
                     nudgeprofs.at(it).data(), nudge_factor.data(),
-                    gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
-                    gd.icells, gd.ijcells);
-
-            stats.calc_tend(*fields.at.at(it), tend_name_nudge);
+                    gd.kstart, gd.kend);
+            add_tend_prof(it, tend.data(), tend_name_nudge);
         }
     }
+
+    for (auto& it : tend_profs)
+        calc_large_scale_source<TF>(
+                fields.at.at(it.first)->fld.data(), it.second.data(),
+                gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
+                gd.icells, gd.ijcells);
 }
 #endif
 
@@ -69,6 +69,24 @@ Grid<TF>::Grid(Master& masterin, Input& input) :
             throw std::runtime_error(msg);
     }
 
+    std::string swtranspose = input.get_item<std::string>("grid", "swtranspose", "", "auto");
+
+    if (swtranspose == "datatype")
+        transpose_type = Transpose_type::Datatype;
+    else if (swtranspose == "alltoall")
+        transpose_type = Transpose_type::Alltoall;
+    else if (swtranspose == "pairwise")
+        transpose_type = Transpose_type::Pairwise;
+    else if (swtranspose == "persistent")
+        transpose_type = Transpose_type::Persistent;
+    else if (swtranspose == "auto")
+        transpose_type = Transpose_type::Auto;
+    else
+    {
+        std::string msg = swtranspose + " is an illegal value for swtranspose";
+        throw std::runtime_error(msg);
+    }
+
     // 2nd order scheme requires only 1 ghost cell
     if (spatial_order == Grid_order::Second)
     {
@@ -83,6 +101,9 @@ Grid<TF>::Grid(Master& masterin, Input& input) :
         gd.jgc = 3;
         gd.kgc = 3;
     }
+
+    gd.igc_min = gd.igc;
+    gd.jgc_min = gd.jgc;
 }
 
 template<typename TF>
@@ -174,11 +195,16 @@ void Grid<TF>::init()
     gd.dzi4 .resize(gd.kmax+2*gd.kgc);
     gd.dzhi4.resize(gd.kmax+2*gd.kgc);
 
+    // All grid points are included in the tendency calculations by default.
+    set_column_kstart(std::vector<int>(gd.ijcells, 0));
+
     // initialize the communication functions
     init_mpi();
 
-    // Initialize the transposes.
-    transpose.init();
+    // Initialize the transposes. The radiation servers do not solve the pressure and their
+    // communicators do not match the npx x npy decomposition of the model.
+    if (!md.rad_server)
+        transpose.init();
 }
 
 /**
@@ -359,6 +385,48 @@ void Grid<TF>::load()
     load_grid();
 }
 
+/**
+ * This function rebuilds the row spans, such that the cells of column (i,j) below
+ * kstart_col[i + j*icells] are skipped by the kernels that loop over the spans.
+ * @param kstart_col First vertical index for which tendencies are needed per column.
+ */
+template<typename TF>
+void Grid<TF>::set_column_kstart(const std::vector<int>& kstart_col)
+{
+    Row_spans& rs = gd.row_spans;
+
+    rs.jcells = gd.jcells;
+    rs.offset.resize(gd.jcells*gd.kcells+1);
+    rs.i0.clear();
+    rs.i1.clear();
+
+    for (int k=0; k<gd.kcells; ++k)
+        for (int j=0; j<gd.jcells; ++j)
+        {
+            rs.offset[j + k*gd.jcells] = rs.i0.size();
+
+            int i = gd.istart;
+            while (i < gd.iend)
+            {
+                // Skip the excluded columns, and find the end of the next span.
+                while (i < gd.iend && k < kstart_col[i + j*gd.icells])
+                    ++i;
+
+                if (i == gd.iend)
+                    break;
+
+                rs.i0.push_back(i);
+
+                while (i < gd.iend && k >= kstart_col[i + j*gd.icells])
+                    ++i;
+
+                rs.i1.push_back(i);
+            }
+        }
+
+    rs.offset[gd.jcells*gd.kcells] = rs.i0.size();
+}
+
 /**
  * This function checks whether the number of ghost cells does not exceed the slice thickness.
  */
@@ -390,6 +458,22 @@ void Grid<TF>::check_ghost_cells()
  */
 template<typename TF>
 void Grid<TF>::set_minimum_ghost_cells(const int igcin, const int jgcin, const int kgcin)
+{
+    gd.igc_min = std::max(gd.igc_min, igcin);
+    gd.jgc_min = std::max(gd.jgc_min, jgcin);
+
+    reserve_ghost_cells(igcin, jgcin, kgcin);
+}
+
+/**
+ * This function increases the number of ghost cells in memory, without
+ * requiring all fields to keep them up to date.
+ * @param igc Ghost cells in the x-direction.
+ * @param jgc Ghost cells in the y-direction.
+ * @param kgc Ghost cells in the z-direction.
+ */
+template<typename TF>
+void Grid<TF>::reserve_ghost_cells(const int igcin, const int jgcin, const int kgcin)
 {
     gd.igc = std::max(gd.igc, igcin);
     gd.jgc = std::max(gd.jgc, jgcin);
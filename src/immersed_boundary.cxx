@@ -23,6 +23,9 @@
 #include <iostream>
 #include <cmath>
 #include <algorithm>
+#include <limits>
+#include <cstdio>
+#include <cstdint>
 
 #include <constants.h>
 #include "master.h"
@@ -103,77 +106,44 @@ namespace
     }
 
 
+    /* Interpolate the DEM once onto all (x, y) locations of the staggered
+     * grid location, including one ghost cell on each side. All ghost cell
+     * and neighbour searches use this table instead of `interp2_dem`. */
     template<typename TF>
-    bool is_ghost_cell(
-            const std::vector<TF>& dem,
-            const std::vector<TF>& x, const std::vector<TF>& y, const std::vector<TF>& z,
+    void calc_dem_table(
+            std::vector<TF>& z_dem, const std::vector<TF>& dem,
+            const std::vector<TF>& x, const std::vector<TF>& y,
             const TF dx, const TF dy,
-            const int i, const int j, const int k,
+            const int istart, const int jstart,
+            const int iend,   const int jend,
             const int icells, const int jcells,
             const int mpi_offset_x, const int mpi_offset_y)
     {
-        const TF zdem = interp2_dem(
-                x[i], y[j], x, y, dem, dx, dy,
-                icells, jcells, mpi_offset_x, mpi_offset_y);
+        z_dem.resize(icells*jcells);
+
+        for (int j=jstart-1; j<jend+1; ++j)
+            for (int i=istart-1; i<iend+1; ++i)
+                z_dem[i + j*icells] = interp2_dem(
+                        x[i], y[j], x, y, dem, dx, dy,
+                        icells, jcells, mpi_offset_x, mpi_offset_y);
+    }
+
+    template<typename TF>
+    bool is_ghost_cell(
+            const std::vector<TF>& z_dem, const std::vector<TF>& z,
+            const int i, const int j, const int k,
+            const int icells)
+    {
+        const int ij = i + j*icells;
 
         // Check if grid point is below IB. If so; check if
         // one of the neighbouring grid points is outside.
-        if (z[k] <= zdem)
+        if (z[k] <= z_dem[ij])
         {
-            // OLD METHOD:
-            //if (z[k+1] > zdem)
-            //    return true;
-
-            //for (int dj = -1; dj <= 1; ++dj)
-            //{
-            //    const TF zdem = interp2_dem(x[i], y[j+dj], x, y, dem, dx, dy,
-            //                                icells, mpi_offset_x, mpi_offset_y);
-            //    if (z[k] > zdem)
-            //        return true;
-            //}
-
-            //for (int di = -1; di <= 1; ++di)
-            //{
-            //    // Interpolate DEM to account for half-level locations x,y
-            //    const TF zdem = interp2_dem(x[i+di], y[j], x, y, dem, dx, dy,
-            //                                icells, mpi_offset_x, mpi_offset_y);
-            //    if (z[k] > zdem)
-            //        return true;
-            //}
-
-            //// NEW METHOD
-            //for (int dj = -1; dj <= 1; ++dj)
-            //{
-            //    // Interpolate DEM to account for half-level locations x,y
-            //    const TF zdem = interp2_dem(
-            //            x[i], y[j+dj], x, y, dem, dx, dy,
-            //            icells, jcells, mpi_offset_x, mpi_offset_y);
-
-            //    for (int dk = -1; dk <= 1; ++dk)
-            //        if (z[k + dk] > zdem)
-            //            return true;
-            //}
-
-            //for (int di = -1; di <= 1; ++di)
-            //{
-            //    // Interpolate DEM to account for half-level locations x,y
-            //    const TF zdem = interp2_dem(
-            //            x[i+di], y[j], x, y, dem, dx, dy,
-            //            icells, jcells, mpi_offset_x, mpi_offset_y);
-
-            //    for (int dk = -1; dk <= 1; ++dk)
-            //        if (z[k + dk] > zdem)
-            //            return true;
-            //}
-
-            // NEW METHOD
             for (int dj = -1; dj <= 1; ++dj)
                 for (int di = -1; di <= 1; ++di)
                 {
-                    // Interpolate DEM to account for half-level locations x,y
-                    const TF zdem = interp2_dem(
-                            x[i+di], y[j+dj], x, y, dem, dx, dy,
-                            icells, jcells, mpi_offset_x, mpi_offset_y);
+                    const TF zdem = z_dem[ij + di + dj*icells];
 
                     for (int dk = -1; dk <= 1; ++dk)
                         if (z[k + dk] > zdem)
@@ -184,6 +154,14 @@ namespace
         return false;
     }
 
+    // Group of wall samples that fall in the same DEM grid cell.
+    template<typename TF>
+    struct Sample_bucket
+    {
+        int i0, i1, j0, j1; // Sample index range [i0, i1) x [j0, j1)
+        TF d_min;           // Lower bound of the distance to the samples
+    };
+
     template<typename TF>
     void find_nearest_location_wall(
             TF& xb, TF& yb, TF& zb,
@@ -193,26 +171,101 @@ namespace
             const int icells, const int jcells,
             const int mpi_offset_x, const int mpi_offset_y)
     {
-        TF d_min = 1e12;
-        TF x_min, y_min, z_min;
+        // The wall is sampled on a (n+1) x (n+1) grid of +/- dx and +/- dy around (x0, y0).
         const int n = 40;
+        const int ns = n+1;
+        const int nb = 6;  // Maximum bucket size in each direction
+
+        TF xs[ns], ys[ns];
+        int is[ns], js[ns];
+
+        for (int ii=0; ii<ns; ++ii)
+        {
+            xs[ii] = x0 + 2 * (ii-n/2) / (double) n * dx;
+            is[ii] = std::min(static_cast<int>((xs[ii] - TF(0.5)*dx) / dx + mpi_offset_x), icells-2);
+        }
 
-        for (int ii = -n/2; ii < n/2+1; ++ii)
-            for (int jj = -n/2; jj < n/2+1; ++jj)
+        for (int jj=0; jj<ns; ++jj)
+        {
+            ys[jj] = y0 + 2 * (jj-n/2) / (double) n * dy;
+            js[jj] = std::min(static_cast<int>((ys[jj] - TF(0.5)*dy) / dy + mpi_offset_y), jcells-2);
+        }
+
+        auto interp = [&](const TF xc, const TF yc)
+        {
+            return interp2_dem(xc, yc, x, y, dem, dx, dy, icells, jcells, mpi_offset_x, mpi_offset_y);
+        };
+
+        // Bucket the samples in blocks within a DEM grid cell. Within a bucket the DEM is bilinear, so
+        // its extremes are at the corners of the bucket, which gives a lower bound of
+        // the distance to all samples in the bucket.
+        std::vector<Sample_bucket<TF>> buckets;
+        buckets.reserve(Fast_math::pow2(ns/nb + 3));
+
+        for (int ib0=0; ib0<ns; )
+        {
+            int ib1 = ib0+1;
+            while (ib1 < ns && ib1-ib0 < nb && is[ib1] == is[ib0])
+                ++ib1;
+
+            for (int jb0=0; jb0<ns; )
             {
-                const TF xc = x0 + 2 * ii / (double) n * dx;
-                const TF yc = y0 + 2 * jj / (double) n * dy;
-                const TF zc = interp2_dem(xc, yc, x, y, dem, dx, dy, icells, jcells, mpi_offset_x, mpi_offset_y);
-                const TF d  = absolute_distance(x0, y0, z0, xc, yc, zc);
+                int jb1 = jb0+1;
+                while (jb1 < ns && jb1-jb0 < nb && js[jb1] == js[jb0])
+                    ++jb1;
+
+                const TF z00 = interp(xs[ib0  ], ys[jb0  ]);
+                const TF z10 = interp(xs[ib1-1], ys[jb0  ]);
+                const TF z01 = interp(xs[ib0  ], ys[jb1-1]);
+                const TF z11 = interp(xs[ib1-1], ys[jb1-1]);
+
+                // Widen the range a little to be safe against rounding inside the bucket.
+                const TF zmin = std::min(std::min(z00, z10), std::min(z01, z11));
+                const TF zmax = std::max(std::max(z00, z10), std::max(z01, z11));
+                const TF zeps = TF(1e-4) * (zmax - zmin) + TF(64)*std::numeric_limits<TF>::epsilon()*std::max(std::abs(zmin), std::abs(zmax));
+
+                const TF ddx = std::max(TF(0), std::max(xs[ib0] - x0, x0 - xs[ib1-1]));
+                const TF ddy = std::max(TF(0), std::max(ys[jb0] - y0, y0 - ys[jb1-1]));
+                const TF ddz = std::max(TF(0), std::max((zmin-zeps) - z0, z0 - (zmax+zeps)));
+
+                buckets.push_back({ib0, ib1, jb0, jb1, std::sqrt(ddx*ddx + ddy*ddy + ddz*ddz)});
+
+                jb0 = jb1;
+            }
 
-                if (d < d_min)
+            ib0 = ib1;
+        }
+
+        std::sort(buckets.begin(), buckets.end(),
+                [](const Sample_bucket<TF>& a, const Sample_bucket<TF>& b) { return a.d_min < b.d_min; });
+
+        // Search the buckets nearest first. Equal distances are resolved to the
+        // first sample in (ii, jj) order, as in a full search over all samples.
+        TF d_min = 1e12;
+        int n_min = ns*ns;
+        TF x_min, y_min, z_min;
+
+        for (auto& b : buckets)
+        {
+            if (b.d_min > d_min)
+                break;
+
+            for (int ii=b.i0; ii<b.i1; ++ii)
+                for (int jj=b.j0; jj<b.j1; ++jj)
                 {
-                    d_min = d;
-                    x_min = xc;
-                    y_min = yc;
-                    z_min = zc;
+                    const TF zc = interp(xs[ii], ys[jj]);
+                    const TF d  = absolute_distance(x0, y0, z0, xs[ii], ys[jj], zc);
+
+                    if (d < d_min || (d == d_min && ii*ns+jj < n_min))
+                    {
+                        d_min = d;
+                        n_min = ii*ns+jj;
+                        x_min = xs[ii];
+                        y_min = ys[jj];
+                        z_min = zc;
+                    }
                 }
-            }
+        }
 
         xb   = x_min;
         yb   = y_min;
@@ -222,16 +275,15 @@ namespace
     template<typename TF>
     void find_interpolation_points(
             std::vector<int>& ip_i, std::vector<int>& ip_j, std::vector<int>& ip_k,
-            std::vector<TF>& ip_d, std::vector<TF>& c_idw, 
+            std::vector<TF>& ip_d, std::vector<Neighbour<TF>>& neighbours,
             const int index, const int n_idw,
-            const std::vector<TF>& x, const std::vector<TF>& y, const std::vector<TF>& z, const std::vector<TF>& dem,
-            const TF d_lim, const TF dx, const TF dy,
+            const std::vector<TF>& x, const std::vector<TF>& y, const std::vector<TF>& z,
+            const std::vector<TF>& z_dem,
             const int i, const int j, const int k,
-            const int kstart, const int icells, const int jcells, const int ijcells,
-            const int mpi_offset_x, const int mpi_offset_y)
+            const int kstart, const int icells)
     {
         // Vectors including all neighbours outside IB
-        std::vector<Neighbour<TF>> neighbours;
+        neighbours.clear();
 
         // Limit vertical stencil near surface
         const int dk0 = std::max(-2, kstart-k);
@@ -241,25 +293,14 @@ namespace
             for (int dj=-1; dj<2; ++dj)
                 for (int di=-1; di<2; ++di)
                 {
-                    const TF zd = interp2_dem(x[i+di], y[j+dj], x, y, dem, dx, dy, icells, jcells, mpi_offset_x, mpi_offset_y);
+                    const TF zd = z_dem[i+di + (j+dj)*icells];
 
                     // Check if grid point is outside IB
                     if (z[k+dk] > zd)
                     {
-                        // Calculate distance to IB
-                        //TF xb, yb, zb;
-                        //find_nearest_location_wall(
-                        //        xb, yb, zb, x, y, dem, x[i+di], y[j+dj], z[k+dk],
-                        //        dx, dy, icells, jcells, mpi_offset_x, mpi_offset_y);
-                        //const TF dist = absolute_distance(xb, yb, zb, x[i+di], y[j+dj], z[k+dk]);
-
-                        //// Exclude if grid point is too close to the IB
-                        //if (dist > d_lim)
-                        //{
-                            const TF distance = absolute_distance(x[i], y[j], z[k], x[i+di], y[j+dj], z[k+dk]);
-                            Neighbour<TF> tmp_neighbour = {i+di, j+dj, k+dk, distance};
-                            neighbours.push_back(tmp_neighbour);
-                        //}
+                        const TF distance = absolute_distance(x[i], y[j], z[k], x[i+di], y[j+dj], z[k+dk]);
+                        Neighbour<TF> tmp_neighbour = {i+di, j+dj, k+dk, distance};
+                        neighbours.push_back(tmp_neighbour);
                     }
                 }
 
@@ -334,19 +375,25 @@ namespace
     void calc_ghost_cells(
             Ghost_cells<TF>& ghost, const std::vector<TF>& dem, 
             const std::vector<TF>& x, const std::vector<TF>& y, const std::vector<TF>& z,
-            Boundary_type bc, const TF dx, const TF dy, const std::vector<TF>& dz, 
+            Boundary_type bc, const TF dx, const TF dy,
             const int n_idw,
             const int istart, const int jstart, const int kstart,
             const int iend,   const int jend,   const int kend,
             const int icells, const int jcells, const int ijcells,
             const int mpi_offset_x, const int mpi_offset_y)
     {
+        // 0. Interpolate the DEM to the (x, y) locations of the grid
+        std::vector<TF> z_dem;
+        calc_dem_table(
+                z_dem, dem, x, y, dx, dy,
+                istart, jstart, iend, jend, icells, jcells,
+                mpi_offset_x, mpi_offset_y);
+
         // 1. Find the IB ghost cells
         for (int k=kstart; k<kend; ++k)
             for (int j=jstart; j<jend; ++j)
                 for (int i=istart; i<iend; ++i)
-                    if (is_ghost_cell(dem, x, y, z, dx, dy, i, j, k,
-                                      icells, jcells, mpi_offset_x, mpi_offset_y))
+                    if (is_ghost_cell(z_dem, z, i, j, k, icells))
                     {
                         ghost.i.push_back(i);
                         ghost.j.push_back(j);
@@ -397,17 +444,14 @@ namespace
         ghost.ip_d .resize(nghost*n_idw);
         ghost.c_idw.resize(nghost*n_idw);
 
+        std::vector<Neighbour<TF>> neighbours;
+
         for (int n=0; n<nghost; ++n)
         {
-            // Exclude interpolation points closer than `d_lim` to IB
-            const TF dist_lim = 0.1 * std::min(std::min(dx, dy), dz[ghost.k[n]]);
-
             find_interpolation_points(
-                    ghost.ip_i, ghost.ip_j, ghost.ip_k, ghost.ip_d, ghost.c_idw,
-                    n, n_idw, x, y, z, dem, dist_lim, dx, dy,
-                    ghost.i[n], ghost.j[n], ghost.k[n], kstart,
-                    icells, jcells, ijcells,
-                    mpi_offset_x, mpi_offset_y);
+                    ghost.ip_i, ghost.ip_j, ghost.ip_k, ghost.ip_d, neighbours,
+                    n, n_idw, x, y, z, z_dem,
+                    ghost.i[n], ghost.j[n], ghost.k[n], kstart, icells);
         }
 
         // 4. Calculate interpolation coefficients
@@ -425,6 +469,128 @@ namespace
         }
     }
 
+    // FNV-1a hash, used to key the ghost cell cache on its input.
+    uint64_t hash_bytes(uint64_t hash, const void* data, const size_t size)
+    {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t n=0; n<size; ++n)
+        {
+            hash ^= bytes[n];
+            hash *= 1099511628211ULL;
+        }
+        return hash;
+    }
+
+    template<typename T>
+    uint64_t hash_vector(uint64_t hash, const std::vector<T>& v)
+    {
+        return hash_bytes(hash, v.data(), v.size()*sizeof(T));
+    }
+
+    template<typename TF>
+    uint64_t calc_ghost_cells_key(
+            const std::vector<TF>& dem,
+            const std::vector<TF>& x, const std::vector<TF>& y, const std::vector<TF>& z,
+            Boundary_type bc, const int n_idw,
+            const int istart, const int jstart, const int kstart,
+            const int iend,   const int jend,   const int kend,
+            const int icells, const int jcells,
+            const int mpi_offset_x, const int mpi_offset_y)
+    {
+        // Bump the version if the ghost cell calculation or file layout changes.
+        const int version = 1;
+        const int settings[] = {
+                version, static_cast<int>(sizeof(TF)), static_cast<int>(bc), n_idw,
+                istart, jstart, kstart, iend, jend, kend,
+                icells, jcells, mpi_offset_x, mpi_offset_y};
+
+        uint64_t hash = 14695981039346656037ULL;
+        hash = hash_bytes(hash, settings, sizeof(settings));
+        hash = hash_vector(hash, dem);
+        hash = hash_vector(hash, x);
+        hash = hash_vector(hash, y);
+        hash = hash_vector(hash, z);
+
+        return hash;
+    }
+
+    template<typename T>
+    bool write_vector(FILE* f, const std::vector<T>& v)
+    {
+        return fwrite(v.data(), sizeof(T), v.size(), f) == v.size();
+    }
+
+    template<typename T>
+    bool read_vector(FILE* f, std::vector<T>& v, const size_t size)
+    {
+        v.resize(size);
+        return fread(v.data(), sizeof(T), size, f) == size;
+    }
+
+    template<typename TF>
+    void save_ghost_cells(const Ghost_cells<TF>& ghost, const std::string& filename, const uint64_t key, const int n_idw)
+    {
+        FILE* f = fopen(filename.c_str(), "wb");
+        if (f == NULL)
+            return;
+
+        bool ok = fwrite(&key, sizeof(uint64_t), 1, f) == 1;
+        ok = ok && fwrite(&ghost.nghost, sizeof(int), 1, f) == 1;
+        ok = ok && fwrite(&n_idw, sizeof(int), 1, f) == 1;
+
+        ok = ok && write_vector(f, ghost.i ) && write_vector(f, ghost.j ) && write_vector(f, ghost.k );
+        ok = ok && write_vector(f, ghost.xb) && write_vector(f, ghost.yb) && write_vector(f, ghost.zb);
+        ok = ok && write_vector(f, ghost.xi) && write_vector(f, ghost.yi) && write_vector(f, ghost.zi);
+        ok = ok && write_vector(f, ghost.di);
+        ok = ok && write_vector(f, ghost.ip_i) && write_vector(f, ghost.ip_j) && write_vector(f, ghost.ip_k);
+        ok = ok && write_vector(f, ghost.ip_d);
+        ok = ok && write_vector(f, ghost.c_idw) && write_vector(f, ghost.c_idw_sum);
+
+        fclose(f);
+
+        // Never leave an incomplete cache behind.
+        if (!ok)
+            std::remove(filename.c_str());
+    }
+
+    template<typename TF>
+    bool load_ghost_cells(Ghost_cells<TF>& ghost, const std::string& filename, const uint64_t key, const int n_idw)
+    {
+        FILE* f = fopen(filename.c_str(), "rb");
+        if (f == NULL)
+            return false;
+
+        uint64_t key_file;
+        int nghost, n_idw_file;
+
+        bool ok = fread(&key_file, sizeof(uint64_t), 1, f) == 1 && key_file == key;
+        ok = ok && fread(&nghost, sizeof(int), 1, f) == 1;
+        ok = ok && fread(&n_idw_file, sizeof(int), 1, f) == 1 && n_idw_file == n_idw;
+
+        if (ok)
+        {
+            const size_t n  = nghost;
+            const size_t ni = nghost*n_idw;
+
+            ok = read_vector(f, ghost.i, n) && read_vector(f, ghost.j, n) && read_vector(f, ghost.k, n);
+            ok = ok && read_vector(f, ghost.xb, n) && read_vector(f, ghost.yb, n) && read_vector(f, ghost.zb, n);
+            ok = ok && read_vector(f, ghost.xi, n) && read_vector(f, ghost.yi, n) && read_vector(f, ghost.zi, n);
+            ok = ok && read_vector(f, ghost.di, n);
+            ok = ok && read_vector(f, ghost.ip_i, ni) && read_vector(f, ghost.ip_j, ni) && read_vector(f, ghost.ip_k, ni);
+            ok = ok && read_vector(f, ghost.ip_d, ni);
+            ok = ok && read_vector(f, ghost.c_idw, ni) && read_vector(f, ghost.c_idw_sum, n);
+        }
+
+        fclose(f);
+
+        if (ok)
+            ghost.nghost = nghost;
+        else
+            ghost = Ghost_cells<TF>();
+
+        return ok;
+    }
+
     void print_statistics(std::vector<int>& ghost_i, std::string name, Master& master)
     {
         int nghost = ghost_i.size();
@@ -437,49 +603,67 @@ namespace
         }
     }
 
+    // Flatten the ghost cell and interpolation point indices into 3D array indices.
+    template<typename TF>
+    void calc_ghost_cell_indices(
+            Ghost_cells<TF>& ghost, const int n_idw,
+            const int icells, const int ijcells)
+    {
+        ghost.ijk.resize(ghost.nghost);
+        ghost.ip_ijk.resize(ghost.nghost*n_idw);
+
+        for (int n=0; n<ghost.nghost; ++n)
+            ghost.ijk[n] = ghost.i[n] + ghost.j[n]*icells + ghost.k[n]*ijcells;
+
+        for (int n=0; n<ghost.nghost*n_idw; ++n)
+            ghost.ip_ijk[n] = ghost.ip_i[n] + ghost.ip_j[n]*icells + ghost.ip_k[n]*ijcells;
+    }
+
+    /* Set the ghost cells of all fields that share the same ghost cells in a single
+     * pass. The interpolation stencil of each ghost cell is read once and applied to
+     * all fields. The ghost cells are ordered by their 3D index (k, j, i). */
     template<typename TF>
     void set_ghost_cells(
-            TF* const restrict fld, const TF* const restrict boundary_value,
+            TF* const* const restrict flds, const TF* const* const restrict boundary_values,
+            const TF* const restrict visc,
             const TF* const restrict c_idw, const TF* const restrict c_idw_sum,
             const TF* const restrict di,
-            const int* const restrict gi, const int* const restrict gj, const int* const restrict gk,
-            const int* const restrict ipi, const int* const restrict ipj, const int* const restrict ipk,
-            Boundary_type bc, const TF visc, const int n_ghostcells, const int n_idw,
-            const int icells, const int ijcells)
+            const int* const restrict ijkg, const int* const restrict ip_ijk,
+            Boundary_type bc, const int n_fields, const int n_ghostcells, const int n_idw)
     {
         const int n_idw_loc = (bc == Boundary_type::Dirichlet_type) ? n_idw-1 : n_idw;
 
         for (int n=0; n<n_ghostcells; ++n)
         {
-            const int ijkg = gi[n] + gj[n]*icells + gk[n]*ijcells;
-
-            // Sum the IDW coefficient times the value at the neighbouring grid points
-            TF vI = TF(0);
-            for (int i=0; i<n_idw_loc; ++i)
-            {
-                const int ii = i + n*n_idw;
-                const int ijki = ipi[ii] + ipj[ii]*icells + ipk[ii]*ijcells;
-                vI += c_idw[ii] * fld[ijki];
-            }
+            const int* const restrict ijki = &ip_ijk[n*n_idw];
+            const TF* const restrict c = &c_idw[n*n_idw];
 
-            // For Dirichlet BCs, add the boundary value
-            if (bc == Boundary_type::Dirichlet_type)
+            for (int f=0; f<n_fields; ++f)
             {
-                const int ii = n_idw-1 + n*n_idw;
-                vI += c_idw[ii] * boundary_value[n];
-            }
-
-            vI /= c_idw_sum[n];
-
-            // Set the ghost cells, depending on the IB boundary conditions
-            if (bc == Boundary_type::Dirichlet_type)
-                fld[ijkg] = 2*boundary_value[n] - vI;       // Image value reflected across IB
-            else if (bc == Boundary_type::Neumann_type)
-                fld[ijkg] = vI - boundary_value[n] * di[n]; // Image value minus gradient times distance
-            else if (bc == Boundary_type::Flux_type)
-            {
-                const TF grad = -boundary_value[n] / visc;
-                fld[ijkg] = vI - grad * di[n];              // Image value minus gradient times distance
+                TF* const restrict fld = flds[f];
+                const TF boundary_value = boundary_values[f][n];
+
+                // Sum the IDW coefficient times the value at the neighbouring grid points
+                TF vI = TF(0);
+                for (int i=0; i<n_idw_loc; ++i)
+                    vI += c[i] * fld[ijki[i]];
+
+                // For Dirichlet BCs, add the boundary value
+                if (bc == Boundary_type::Dirichlet_type)
+                    vI += c[n_idw-1] * boundary_value;
+
+                vI /= c_idw_sum[n];
+
+                // Set the ghost cells, depending on the IB boundary conditions
+                if (bc == Boundary_type::Dirichlet_type)
+                    fld[ijkg[n]] = 2*boundary_value - vI;       // Image value reflected across IB
+                else if (bc == Boundary_type::Neumann_type)
+                    fld[ijkg[n]] = vI - boundary_value * di[n]; // Image value minus gradient times distance
+                else if (bc == Boundary_type::Flux_type)
+                {
+                    const TF grad = -boundary_value / visc[f];
+                    fld[ijkg[n]] = vI - grad * di[n];           // Image value minus gradient times distance
+                }
             }
         }
     }
@@ -537,6 +721,48 @@ namespace
     }
 
 
+    /* Per column, the first vertical index for which tendencies are needed. This
+     * includes all cells outside the IB at the cell center and at the faces, plus
+     * one layer of solid cells, which covers the ghost cells and the cells that
+     * are read by the 2nd order stencils of the cells outside the IB. */
+    void calc_column_kstart(
+            int* const restrict kstart_col,
+            const unsigned int* const restrict k_dem,
+            const int istart, const int iend,
+            const int jstart, const int jend,
+            const int kstart, const int jj)
+    {
+        for (int j=jstart; j<jend; ++j)
+            for (int i=istart; i<iend; ++i)
+            {
+                unsigned int k_min = k_dem[i + j*jj];
+                for (int dj=-1; dj<2; ++dj)
+                    for (int di=-1; di<2; ++di)
+                        k_min = std::min(k_min, k_dem[i+di + (j+dj)*jj]);
+
+                kstart_col[i + j*jj] = std::max(static_cast<int>(k_min)-1, kstart);
+            }
+    }
+
+    /* Zero the tendencies of the cells below the per-column start index, such that the
+     * cells that are skipped by the tendency kernels keep their values. */
+    template<typename TF>
+    void zero_skipped_tendencies(
+            TF* const restrict at,
+            const int* const restrict kstart_col,
+            const int istart, const int iend,
+            const int jstart, const int jend,
+            const int kstart, const int jj, const int kk)
+    {
+        for (int j=jstart; j<jend; ++j)
+            for (int i=istart; i<iend; ++i)
+            {
+                const int ij = i + j*jj;
+                for (int k=kstart; k<kstart_col[ij]; ++k)
+                    at[ij + k*kk] = TF(0.);
+            }
+    }
+
     template<typename TF>
     void calc_fluxes(
             TF* const restrict flux,
@@ -624,6 +850,13 @@ Immersed_boundary<TF>::Immersed_boundary(Master& masterin, Grid<TF>& gridin, Fie
 
         // Read additional settings
         n_idw_points = inputin.get_item<int>("IB", "n_idw_points", "");
+        sw_ghost_cache = inputin.get_item<bool>("IB", "swcache", "", true);
+        sw_skip_solid = inputin.get_item<bool>("IB", "swskipsolid", "", false);
+
+        #ifdef USECUDA
+        if (sw_skip_solid)
+            throw std::runtime_error("swskipsolid is not supported on the GPU");
+        #endif
 
         // Set available masks
         available_masks.insert(available_masks.end(), {"ib"});
@@ -642,35 +875,23 @@ void Immersed_boundary<TF>::exec_momentum()
     if (sw_ib == IB_type::Disabled)
         return;
 
-    auto& gd = grid.get_grid_data();
-
-    set_ghost_cells(
-            fields.mp.at("u")->fld.data(), ghost.at("u").mbot.data(),
-            ghost.at("u").c_idw.data(), ghost.at("u").c_idw_sum.data(), ghost.at("u").di.data(),
-            ghost.at("u").i.data(), ghost.at("u").j.data(), ghost.at("u").k.data(),
-            ghost.at("u").ip_i.data(), ghost.at("u").ip_j.data(), ghost.at("u").ip_k.data(),
-            Boundary_type::Dirichlet_type, fields.visc, ghost.at("u").i.size(), n_idw_points,
-            gd.icells, gd.ijcells);
+    // The staggered velocity components each have their own ghost cells.
+    for (auto& name : {"u", "v", "w"})
+    {
+        Ghost_cells<TF>& g = ghost.at(name);
 
-    set_ghost_cells(
-            fields.mp.at("v")->fld.data(), ghost.at("v").mbot.data(),
-            ghost.at("v").c_idw.data(), ghost.at("v").c_idw_sum.data(), ghost.at("v").di.data(),
-            ghost.at("v").i.data(), ghost.at("v").j.data(), ghost.at("v").k.data(),
-            ghost.at("v").ip_i.data(), ghost.at("v").ip_j.data(), ghost.at("v").ip_k.data(),
-            Boundary_type::Dirichlet_type, fields.visc, ghost.at("v").i.size(), n_idw_points,
-            gd.icells, gd.ijcells);
+        TF* fld = fields.mp.at(name)->fld.data();
+        const TF* mbot = g.mbot.data();
 
-    set_ghost_cells(
-            fields.mp.at("w")->fld.data(), ghost.at("w").mbot.data(),
-            ghost.at("w").c_idw.data(), ghost.at("w").c_idw_sum.data(), ghost.at("w").di.data(),
-            ghost.at("w").i.data(), ghost.at("w").j.data(), ghost.at("w").k.data(),
-            ghost.at("w").ip_i.data(), ghost.at("w").ip_j.data(), ghost.at("w").ip_k.data(),
-            Boundary_type::Dirichlet_type, fields.visc, ghost.at("w").i.size(), n_idw_points,
-            gd.icells, gd.ijcells);
+        set_ghost_cells(
+                &fld, &mbot, &fields.visc,
+                g.c_idw.data(), g.c_idw_sum.data(), g.di.data(),
+                g.ijk.data(), g.ip_ijk.data(),
+                Boundary_type::Dirichlet_type, 1, g.nghost, n_idw_points);
+    }
 
-    boundary_cyclic.exec(fields.mp.at("u")->fld.data());
-    boundary_cyclic.exec(fields.mp.at("v")->fld.data());
-    boundary_cyclic.exec(fields.mp.at("w")->fld.data());
+    boundary_cyclic.exec({
+            fields.mp.at("u")->fld.data(), fields.mp.at("v")->fld.data(), fields.mp.at("w")->fld.data()});
 }
 
 template <typename TF>
@@ -679,23 +900,52 @@ void Immersed_boundary<TF>::exec_scalars()
     if (sw_ib == IB_type::Disabled)
         return;
 
-    auto& gd = grid.get_grid_data();
+    if (fields.sp.size() == 0)
+        return;
+
+    // All scalars share the same ghost cells, update them in one pass.
+    Ghost_cells<TF>& g = ghost.at("s");
+
+    std::vector<TF*> flds;
+    std::vector<const TF*> sbot;
+    std::vector<TF> visc;
 
     for (auto& it : fields.sp)
     {
-        set_ghost_cells(
-                it.second->fld.data(), ghost.at("s").sbot.at(it.first).data(),
-                ghost.at("s").c_idw.data(), ghost.at("s").c_idw_sum.data(), ghost.at("s").di.data(),
-                ghost.at("s").i.data(), ghost.at("s").j.data(), ghost.at("s").k.data(),
-                ghost.at("s").ip_i.data(), ghost.at("s").ip_j.data(), ghost.at("s").ip_k.data(),
-                sbcbot, it.second->visc, ghost.at("s").i.size(), n_idw_points,
-                gd.icells, gd.ijcells);
-
-        boundary_cyclic.exec(it.second->fld.data());
+        flds.push_back(it.second->fld.data());
+        sbot.push_back(g.sbot.at(it.first).data());
+        visc.push_back(it.second->visc);
     }
+
+    set_ghost_cells(
+            flds.data(), sbot.data(), visc.data(),
+            g.c_idw.data(), g.c_idw_sum.data(), g.di.data(),
+            g.ijk.data(), g.ip_ijk.data(),
+            sbcbot, flds.size(), g.nghost, n_idw_points);
+
+    boundary_cyclic.exec(flds);
 }
 #endif
 
+template <typename TF>
+void Immersed_boundary<TF>::freeze_skipped_cells()
+{
+    if (sw_ib == IB_type::Disabled || !sw_skip_solid)
+        return;
+
+    auto& gd = grid.get_grid_data();
+
+    // The skipped cells receive no advection, diffusion and buoyancy, but the other
+    // tendencies and the pressure still act on them. Zero their total tendency to
+    // prevent them from drifting.
+    for (auto& it : fields.at)
+        zero_skipped_tendencies(
+                it.second->fld.data(), kstart_col.data(),
+                gd.istart, gd.iend,
+                gd.jstart, gd.jend,
+                gd.kstart, gd.icells, gd.ijcells);
+}
+
 template <typename TF>
 void Immersed_boundary<TF>::init(Input& inputin, Cross<TF>& cross)
 {
@@ -764,6 +1014,65 @@ void Immersed_boundary<TF>::init(Input& inputin, Cross<TF>& cross)
     field3d_io.init();
 }
 
+template <typename TF>
+void Immersed_boundary<TF>::init_ghost_cells(
+        const std::string& name,
+        const std::vector<TF>& x, const std::vector<TF>& y, const std::vector<TF>& z,
+        Boundary_type bc)
+{
+    auto& gd  = grid.get_grid_data();
+    auto& mpi = master.get_MPI_data();
+
+    // Offsets used in the 2D DEM interpolation
+    const int mpi_offset_x = -mpi.mpicoordx * gd.imax + gd.igc;
+    const int mpi_offset_y = -mpi.mpicoordy * gd.jmax + gd.jgc;
+
+    Ghost_cells<TF>& g = ghost.at(name);
+
+    // Try the ghost cells cached by a previous run with identical DEM, grid and decomposition.
+    uint64_t key = 0;
+    char filename[256];
+    std::sprintf(filename, "ib_ghost_%s.%05d", name.c_str(), master.get_mpiid());
+
+    int nloaded = 0;
+    if (sw_ghost_cache)
+    {
+        key = calc_ghost_cells_key(
+                dem, x, y, z, bc, n_idw_points,
+                gd.istart, gd.jstart, gd.kstart,
+                gd.iend,   gd.jend,   gd.kend,
+                gd.icells, gd.jcells,
+                mpi_offset_x, mpi_offset_y);
+
+        nloaded = load_ghost_cells(g, filename, key, n_idw_points);
+    }
+
+    // All processes report whether they could use the cache.
+    int nloaded_sum = nloaded;
+    master.sum(&nloaded_sum, 1);
+
+    if (nloaded_sum == mpi.nprocs)
+        master.print_message("Loaded ghost cells %s from cache\n", name.c_str());
+    else
+        master.print_message("Calculating ghost cells %s\n", name.c_str());
+
+    if (!nloaded)
+    {
+        calc_ghost_cells(
+                g, dem, x, y, z, bc,
+                gd.dx, gd.dy, n_idw_points,
+                gd.istart, gd.jstart, gd.kstart,
+                gd.iend,   gd.jend,   gd.kend,
+                gd.icells, gd.jcells, gd.ijcells,
+                mpi_offset_x, mpi_offset_y);
+
+        if (sw_ghost_cache)
+            save_ghost_cells(g, filename, key, n_idw_points);
+    }
+
+    calc_ghost_cell_indices(g, n_idw_points, gd.icells, gd.ijcells);
+}
+
 template <typename TF>
 void Immersed_boundary<TF>::create()
 {
@@ -808,35 +1117,9 @@ void Immersed_boundary<TF>::create()
         ghost.emplace("v", Ghost_cells<TF>());
         ghost.emplace("w", Ghost_cells<TF>());
 
-        master.print_message("Calculating ghost cells u\n");
-        calc_ghost_cells(
-                ghost.at("u"), dem, gd.xh, gd.y, gd.z,
-                Boundary_type::Dirichlet_type,
-                gd.dx, gd.dy, gd.dz, n_idw_points,
-                gd.istart, gd.jstart, gd.kstart,
-                gd.iend,   gd.jend,   gd.kend,
-                gd.icells, gd.jcells, gd.ijcells,
-                mpi_offset_x, mpi_offset_y);
-
-        master.print_message("Calculating ghost cells v\n");
-        calc_ghost_cells(
-                ghost.at("v"), dem, gd.x, gd.yh, gd.z,
-                Boundary_type::Dirichlet_type,
-                gd.dx, gd.dy, gd.dz, n_idw_points,
-                gd.istart, gd.jstart, gd.kstart,
-                gd.iend,   gd.jend,   gd.kend,
-                gd.icells, gd.jcells, gd.ijcells,
-                mpi_offset_x, mpi_offset_y);
-
-        master.print_message("Calculating ghost cells w\n");
-        calc_ghost_cells(
-                ghost.at("w"), dem, gd.x, gd.y, gd.zh,
-                Boundary_type::Dirichlet_type,
-                gd.dx, gd.dy, gd.dzh, n_idw_points,
-                gd.istart, gd.jstart, gd.kstart,
-                gd.iend,   gd.jend,   gd.kend,
-                gd.icells, gd.jcells, gd.ijcells,
-                mpi_offset_x, mpi_offset_y);
+        init_ghost_cells("u", gd.xh, gd.y, gd.z, Boundary_type::Dirichlet_type);
+        init_ghost_cells("v", gd.x, gd.yh, gd.z, Boundary_type::Dirichlet_type);
+        init_ghost_cells("w", gd.x, gd.y, gd.zh, Boundary_type::Dirichlet_type);
 
         // Print some statistics (number of ghost cells)
         print_statistics(ghost.at("u").i, std::string("u"), master);
@@ -856,14 +1139,7 @@ void Immersed_boundary<TF>::create()
         {
             ghost.emplace("s", Ghost_cells<TF>());
 
-            master.print_message("Calculating ghost cells s\n");
-            calc_ghost_cells(
-                    ghost.at("s"), dem, gd.x, gd.y, gd.z, sbcbot,
-                    gd.dx, gd.dy, gd.dz, n_idw_points,
-                    gd.istart, gd.jstart, gd.kstart,
-                    gd.iend,   gd.jend,   gd.kend,
-                    gd.icells, gd.jcells, gd.ijcells,
-                    mpi_offset_x, mpi_offset_y);
+            init_ghost_cells("s", gd.x, gd.y, gd.z, sbcbot);
 
             print_statistics(ghost.at("s").i, std::string("s"), master);
 
@@ -916,6 +1192,20 @@ void Immersed_boundary<TF>::create()
                 gd.icells);
 
         boundary_cyclic.exec_2d(k_dem.data());
+
+        // Exclude the cells deep inside the IB from the tendency calculations.
+        if (sw_skip_solid)
+        {
+            kstart_col.resize(gd.ijcells, 0);
+
+            calc_column_kstart(
+                    kstart_col.data(), k_dem.data(),
+                    gd.istart, gd.iend,
+                    gd.jstart, gd.jend,
+                    gd.kstart, gd.icells);
+
+            grid.set_column_kstart(kstart_col);
+        }
     }
 }
 
@@ -44,6 +44,9 @@ Master::~Master()
         MPI_Comm_free(&md.commxy);
         MPI_Comm_free(&md.commx);
         MPI_Comm_free(&md.commy);
+
+        if (md.nprocs_rad > 0)
+            MPI_Comm_free(&md.commrad);
     }
 
     print_message("Finished run on %d processes\n", md.nprocs);
@@ -91,16 +94,56 @@ void Master::init(Input& input)
 
     wall_clock_end = wall_clock_start + 3600.*wall_clock_limit;
 
-    if (md.nprocs != md.npx*md.npy)
+    md.node_aware = input.get_item<bool>("master", "swnodeaware", "", false);
+
+    // The last nprocs_rad processes only solve the radiation, they get their own 2-D grid
+    // communicator and talk to the model processes over an intercommunicator.
+    md.nprocs_rad = input.get_item<int>("master", "nprocs_rad", "", 0);
+    md.rad_server = false;
+
+    int n;
+    MPI_Comm commgroup = MPI_COMM_WORLD;
+
+    if (md.nprocs_rad > 0)
+    {
+        if (md.nprocs_rad >= md.nprocs)
+            throw std::runtime_error("nprocs_rad has to be smaller than the number of processes");
+        if (md.node_aware)
+            throw std::runtime_error("swnodeaware cannot be combined with nprocs_rad");
+
+        const int nprocs_model = md.nprocs - md.nprocs_rad;
+        md.rad_server = md.mpiid >= nprocs_model;
+
+        n = MPI_Comm_split(MPI_COMM_WORLD, md.rad_server, md.mpiid, &commgroup);
+        if (check_error(n))
+            throw std::runtime_error("MPI init error");
+
+        // The leader of each group is its first process, identified by its rank in MPI_COMM_WORLD.
+        const int remote_leader = md.rad_server ? 0 : nprocs_model;
+        n = MPI_Intercomm_create(commgroup, 0, MPI_COMM_WORLD, remote_leader, 0, &md.commrad);
+        if (check_error(n))
+            throw std::runtime_error("MPI init error");
+
+        md.nprocs = md.rad_server ? md.nprocs_rad : nprocs_model;
+    }
+
+    if (!md.rad_server && md.nprocs != md.npx*md.npy)
     {
         std::string msg = "nprocs = " + std::to_string(md.nprocs) + " does not equal npx*npy = " + std::to_string(md.npx) + "*" + std::to_string(md.npy);
         throw std::runtime_error(msg);
     }
 
-    int n;
+    // The servers solve the subdomains of the model processes, so they keep npx and npy
+    // for the grid, but lay out their own processes in a single row.
     int dims    [2] = {md.npy, md.npx};
     int periodic[2] = {true, true};
 
+    if (md.rad_server)
+    {
+        dims[0] = 1;
+        dims[1] = md.nprocs_rad;
+    }
+
     // define the dimensions of the 2-D grid layout
     n = MPI_Dims_create(md.nprocs, 2, dims);
     if (check_error(n))
@@ -112,11 +155,22 @@ void Master::init(Input& input)
     if (check_error(n))
         throw std::runtime_error("MPI init error");
 
+    // In node-aware mode, number the processes node by node, such that the processes
+    // of one commx, which are consecutive in the 2-D grid, share a node where possible.
+    MPI_Comm commworld;
+    if (md.node_aware)
+        commworld = create_node_ordered_comm();
+    else
+        commworld = commgroup;
+
     // for now, do not reorder processes, blizzard gives large performance loss
-    n = MPI_Cart_create(MPI_COMM_WORLD, 2, dims, periodic, false, &md.commxy);
+    n = MPI_Cart_create(commworld, 2, dims, periodic, false, &md.commxy);
     if (check_error(n))
         throw std::runtime_error("MPI init error");
 
+    if (md.node_aware || md.nprocs_rad > 0)
+        MPI_Comm_free(&commworld);
+
     n = MPI_Comm_rank(md.commxy, &md.mpiid);
     if (check_error(n))
         throw std::runtime_error("MPI init error");
@@ -162,6 +216,52 @@ void Master::init(Input& input)
     allocated = true;
 }
 
+MPI_Comm Master::create_node_ordered_comm()
+{
+    // Group the processes that can share memory.
+    MPI_Comm commnode;
+    MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, 0, MPI_INFO_NULL, &commnode);
+
+    int noderank, nodesize;
+    MPI_Comm_rank(commnode, &noderank);
+    MPI_Comm_size(commnode, &nodesize);
+
+    // The first process of each node determines the offset of its node in the new order.
+    MPI_Comm commleaders;
+    MPI_Comm_split(MPI_COMM_WORLD, noderank == 0 ? 0 : MPI_UNDEFINED, md.mpiid, &commleaders);
+
+    int offset = 0;
+    if (noderank == 0)
+    {
+        int leaderrank;
+        MPI_Comm_rank(commleaders, &leaderrank);
+        MPI_Exscan(&nodesize, &offset, 1, MPI_INT, MPI_SUM, commleaders);
+
+        // The result of MPI_Exscan is undefined on the first process.
+        if (leaderrank == 0)
+            offset = 0;
+
+        MPI_Comm_free(&commleaders);
+    }
+
+    MPI_Bcast(&offset, 1, MPI_INT, 0, commnode);
+
+    // Check whether all processes of one commx fit within a node.
+    int nodesize_min = nodesize;
+    MPI_Allreduce(MPI_IN_PLACE, &nodesize_min, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+    MPI_Comm_free(&commnode);
+
+    if (nodesize_min % md.npx != 0 && md.npx % nodesize_min != 0)
+        print_warning("npx = %d does not match the %d processes per node, transposes in x cross nodes\n", md.npx, nodesize_min);
+    else if (md.npx > nodesize_min)
+        print_warning("npx = %d exceeds the %d processes per node, transposes in x cross nodes\n", md.npx, nodesize_min);
+
+    MPI_Comm commworld;
+    MPI_Comm_split(MPI_COMM_WORLD, 0, offset + noderank, &commworld);
+
+    return commworld;
+}
+
 double Master::get_wall_clock_time()
 {
     return MPI_Wtime();
@@ -73,6 +73,10 @@ void Master::init(Input& input)
     md.mpicoordx = 0;
     md.mpicoordy = 0;
 
+    // Radiation server processes require MPI.
+    md.nprocs_rad = 0;
+    md.rad_server = false;
+
     allocated = true;
 }
 
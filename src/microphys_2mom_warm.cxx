@@ -25,6 +25,10 @@
 #include <cmath>
 #include <algorithm>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 #include "master.h"
 #include "grid.h"
 #include "fields.h"
@@ -86,15 +90,48 @@ namespace
 // Microphysics calculated over entire 3D field
 namespace mp3d
 {
+    // Compact the cloudy cells into a list of indices sorted by height, level k spans
+    // [cloud_offset[k-kstart], cloud_offset[k-kstart+1]) of the list. Per XZ slice,
+    // the number of rainy cells is stored in rain_count.
+    template<typename TF>
+    void build_active_cells(std::vector<int>& cloud_cells, std::vector<int>& cloud_offset,
+                            std::vector<int>& rain_count,
+                            const TF* const restrict ql, const TF* const restrict qr,
+                            const int istart, const int jstart, const int kstart,
+                            const int iend,   const int jend,   const int kend,
+                            const int jcells, const int jj, const int kk)
+    {
+        cloud_cells.clear();
+        cloud_offset.resize(kend-kstart+1);
+        rain_count.assign(jcells, 0);
+
+        for (int k=kstart; k<kend; k++)
+        {
+            cloud_offset[k-kstart] = cloud_cells.size();
+
+            for (int j=jstart; j<jend; j++)
+                for (int i=istart; i<iend; i++)
+                {
+                    const int ijk = i + j*jj + k*kk;
+
+                    if(ql[ijk] > ql_min<TF>)
+                        cloud_cells.push_back(ijk);
+
+                    rain_count[j] += (qr[ijk] > qr_min<TF>);
+                }
+        }
+
+        cloud_offset[kend-kstart] = cloud_cells.size();
+    }
+
     // Autoconversion: formation of rain drop by coagulating cloud droplets
     template<typename TF>
     void autoconversion(TF* const restrict qrt, TF* const restrict nrt,
                         TF* const restrict qtt, TF* const restrict thlt,
                         const TF* const restrict qr,  const TF* const restrict ql,
                         const TF* const restrict rho, const TF* const restrict exner, const TF nc,
-                        const int istart, const int jstart, const int kstart,
-                        const int iend,   const int jend,   const int kend,
-                        const int jj, const int kk)
+                        const int* const restrict cloud_cells, const int* const restrict cloud_offset,
+                        const int kstart, const int kend)
     {
         const TF x_star = 2.6e-10;       // SB06, list of symbols, same as UCLA-LES
         const TF k_cc   = 9.44e9;        // UCLA-LES (Long, 1974), 4.44e9 in SB06, p48
@@ -102,26 +139,23 @@ namespace mp3d
         const TF kccxs  = k_cc / (TF(20.) * x_star) * (nu_c+2)*(nu_c+4) / pow(nu_c+1, 2);
 
         for (int k=kstart; k<kend; k++)
-            for (int j=jstart; j<jend; j++)
-                #pragma ivdep
-                for (int i=istart; i<iend; i++)
-                {
-                    const int ijk = i + j*jj + k*kk;
-                    if(ql[ijk] > ql_min<TF>)
-                    {
-                        const TF xc      = rho[k] * ql[ijk] / nc;    // Mean mass of cloud drops [kg]
-                        const TF tau     = TF(1.) - ql[ijk] / (ql[ijk] + qr[ijk] + dsmall);    // SB06, Eq 5
-                        const TF phi_au  = TF(600.) * pow(tau, TF(0.68)) * pow(TF(1.) - pow(tau, TF(0.68)), 3);    // UCLA-LES
-                        //const TF phi_au  = 400. * pow(tau, 0.7) * pow(1. - pow(tau, 0.7), 3);    // SB06, Eq 6
-                        const TF au_tend = rho[k] * kccxs * pow(ql[ijk], 2) * pow(xc, 2) *
-                                               (TF(1.) + phi_au / pow(TF(1.)-tau, 2)); // SB06, eq 4
-
-                        qrt[ijk]  += au_tend;
-                        nrt[ijk]  += au_tend * rho[k] / x_star;
-                        qtt[ijk]  -= au_tend;
-                        thlt[ijk] += Lv<TF> / (cp<TF> * exner[k]) * au_tend;
-                    }
-                }
+            #pragma ivdep
+            for (int n=cloud_offset[k-kstart]; n<cloud_offset[k-kstart+1]; n++)
+            {
+                const int ijk = cloud_cells[n];
+
+                const TF xc      = rho[k] * ql[ijk] / nc;    // Mean mass of cloud drops [kg]
+                const TF tau     = TF(1.) - ql[ijk] / (ql[ijk] + qr[ijk] + dsmall);    // SB06, Eq 5
+                const TF phi_au  = TF(600.) * pow(tau, TF(0.68)) * pow(TF(1.) - pow(tau, TF(0.68)), 3);    // UCLA-LES
+                //const TF phi_au  = 400. * pow(tau, 0.7) * pow(1. - pow(tau, 0.7), 3);    // SB06, Eq 6
+                const TF au_tend = rho[k] * kccxs * pow(ql[ijk], 2) * pow(xc, 2) *
+                                       (TF(1.) + phi_au / pow(TF(1.)-tau, 2)); // SB06, eq 4
+
+                qrt[ijk]  += au_tend;
+                nrt[ijk]  += au_tend * rho[k] / x_star;
+                qtt[ijk]  -= au_tend;
+                thlt[ijk] += Lv<TF> / (cp<TF> * exner[k]) * au_tend;
+            }
     }
 
     // Accreation: growth of raindrops collecting cloud droplets
@@ -129,29 +163,27 @@ namespace mp3d
     void accretion(TF* const restrict qrt, TF* const restrict qtt, TF* const restrict thlt,
                    const TF* const restrict qr,  const TF* const restrict ql,
                    const TF* const restrict rho, const TF* const restrict exner,
-                   const int istart, const int jstart, const int kstart,
-                   const int iend,   const int jend,   const int kend,
-                   const int jj, const int kk)
+                   const int* const restrict cloud_cells, const int* const restrict cloud_offset,
+                   const int kstart, const int kend)
     {
         const TF k_cr  = 5.25; // SB06, p49
 
         for (int k=kstart; k<kend; k++)
-            for (int j=jstart; j<jend; j++)
-                #pragma ivdep
-                for (int i=istart; i<iend; i++)
+            #pragma ivdep
+            for (int n=cloud_offset[k-kstart]; n<cloud_offset[k-kstart+1]; n++)
+            {
+                const int ijk = cloud_cells[n];
+                if(qr[ijk] > qr_min<TF>)
                 {
-                    const int ijk = i + j*jj + k*kk;
-                    if(ql[ijk] > ql_min<TF> && qr[ijk] > qr_min<TF>)
-                    {
-                        const TF tau     = TF(1.) - ql[ijk] / (ql[ijk] + qr[ijk]); // SB06, Eq 5
-                        const TF phi_ac  = pow(tau / (tau + TF(5e-5)), 4); // SB06, Eq 8
-                        const TF ac_tend = k_cr * ql[ijk] *  qr[ijk] * phi_ac * pow(rho_0<TF> / rho[k], TF(0.5)); // SB06, Eq 7
+                    const TF tau     = TF(1.) - ql[ijk] / (ql[ijk] + qr[ijk]); // SB06, Eq 5
+                    const TF phi_ac  = pow(tau / (tau + TF(5e-5)), 4); // SB06, Eq 8
+                    const TF ac_tend = k_cr * ql[ijk] *  qr[ijk] * phi_ac * pow(rho_0<TF> / rho[k], TF(0.5)); // SB06, Eq 7
 
-                        qrt[ijk]  += ac_tend;
-                        qtt[ijk]  -= ac_tend;
-                        thlt[ijk] += Lv<TF> / (cp<TF> * exner[k]) * ac_tend;
-                    }
+                    qrt[ijk]  += ac_tend;
+                    qtt[ijk]  -= ac_tend;
+                    thlt[ijk] += Lv<TF> / (cp<TF> * exner[k]) * ac_tend;
                 }
+            }
     }
 
 
@@ -529,6 +561,154 @@ namespace mp2d
             rr_bot[ij] = -flux_qr[ik];
         }
     }
+
+    // Calculate the maximum sedimentation CFL number of qr in an XZ slice, with the
+    // fall speeds of sedimentation_ss08. Requires mu_r and lambda_r of the slice.
+    template<typename TF>
+    TF calc_max_sedimentation_cfl(TF* const restrict w_qr,
+                                  const TF* const restrict mu_r, const TF* const restrict lambda_r,
+                                  const TF* const restrict qr, const TF* const restrict rho,
+                                  const TF* const restrict dzi, const double dt,
+                                  const int istart, const int iend,
+                                  const int kstart, const int kend,
+                                  const int icells, const int ijcells, const int j)
+    {
+        const TF w_max = 9.65; // 9.65=UCLA, 20=SS08, appendix A
+        const TF a_R = 9.65;   // SB06, p51
+        const TF c_R = 600;    // SB06, p51
+        const TF Dv  = 25.0e-6;
+        const TF b_R = a_R * exp(c_R*Dv); // UCLA-LES
+
+        for (int k=kstart; k<kend; k++)
+        {
+            const TF rho_n = pow(TF(1.2) / rho[k], TF(0.5));
+            #pragma ivdep
+            for (int i=istart; i<iend; i++)
+            {
+                const int ijk = i + j*icells + k*ijcells;
+                const int ik  = i + k*icells;
+
+                if(qr[ijk] > qr_min<TF>)
+                    w_qr[ik] = std::min(w_max, std::max(TF(0.1), rho_n * a_R - b_R * TF(pow(TF(1.) + c_R/lambda_r[ik], TF(-1.)*(mu_r[ik]+TF(4.))))));
+                else
+                    w_qr[ik] = 0.;
+            }
+        }
+
+        for (int i=istart; i<iend; i++)
+        {
+            w_qr[i + (kstart-1)*icells] = w_qr[i + kstart*icells];
+            w_qr[i + (kend    )*icells] = TF(0);
+        }
+
+        TF cfl = 0;
+        for (int k=kstart; k<kend; k++)
+            for (int i=istart; i<iend; i++)
+            {
+                const int ik = i + k*icells;
+                cfl = std::max(cfl, TF(0.25) * (w_qr[ik-icells] + TF(2.)*w_qr[ik] + w_qr[ik+icells]) * dzi[k] * TF(dt));
+            }
+
+        return cfl;
+    }
+
+    // Sedimentation from Stevens and Seifert (2008), sub-cycled such that the CFL number of
+    // each sub-step stays below cfl_max. The slice is advanced over the sub-steps in qr_s and nr_s,
+    // the mean tendency and surface rain rate over the sub-steps are added to qrt, nrt and rr_bot.
+    // Requires rain_mass, rain_diam, mu_r and lambda_r to be prepared for slice j.
+    template<typename TF>
+    void sedimentation_ss08_subcycled(TF* const restrict qrt, TF* const restrict nrt, TF* const restrict rr_bot,
+                                      TF* const restrict w_qr, TF* const restrict w_nr,
+                                      TF* const restrict c_qr, TF* const restrict c_nr,
+                                      TF* const restrict slope_qr, TF* const restrict slope_nr,
+                                      TF* const restrict flux_qr, TF* const restrict flux_nr,
+                                      TF* const restrict rain_mass, TF* const restrict rain_diam,
+                                      TF* const restrict mu_r, TF* const restrict lambda_r,
+                                      TF* const restrict qr_s, TF* const restrict nr_s,
+                                      TF* const restrict qrt_s, TF* const restrict nrt_s,
+                                      TF* const restrict rr_s,
+                                      const TF* const restrict qr, const TF* const restrict nr,
+                                      const TF* const restrict rho, const TF* const restrict rhoh,
+                                      const TF* const restrict dzi,
+                                      const TF* const restrict dz, const double dt, const TF cfl_max,
+                                      const int istart, const int jstart, const int kstart,
+                                      const int iend,   const int jend,   const int kend,
+                                      const int icells, const int kcells, const int ijcells, const int j)
+    {
+        const TF cfl = calc_max_sedimentation_cfl(w_qr, mu_r, lambda_r, qr, rho, dzi, dt,
+                                                  istart, iend, kstart, kend, icells, ijcells, j);
+        const int n_sub = std::max(1, static_cast<int>(std::ceil(cfl / cfl_max)));
+
+        if (n_sub == 1)
+        {
+            sedimentation_ss08(qrt, nrt, rr_bot,
+                               w_qr, w_nr, c_qr, c_nr, slope_qr, slope_nr, flux_qr, flux_nr, mu_r, lambda_r,
+                               qr, nr, rho, rhoh, dzi, dz, dt,
+                               istart, jstart, kstart,
+                               iend,   jend,   kend,
+                               icells, kcells, ijcells, j);
+            return;
+        }
+
+        const double dt_sub = dt / n_sub;
+        const TF f_sub = TF(1) / n_sub;
+
+        // Copy the slice, including the ghost levels which enter the slopes.
+        for (int k=kstart-1; k<kend+1; k++)
+            #pragma ivdep
+            for (int i=istart; i<iend; i++)
+            {
+                const int ijk = i + j*icells + k*ijcells;
+                const int ik  = i + k*icells;
+                qr_s[ik] = qr[ijk];
+                nr_s[ik] = nr[ijk];
+            }
+
+        for (int i=istart; i<iend; i++)
+            rr_bot[i + j*icells] = TF(0);
+
+        // The slice copies are treated as a single-row 3D field, with j=0 and ijcells=icells.
+        for (int n=0; n<n_sub; n++)
+        {
+            if (n > 0)
+                prepare_microphysics_slice(rain_mass, rain_diam, mu_r, lambda_r,
+                                           qr_s, nr_s, rho,
+                                           istart, iend, kstart, kend, icells, icells, 0);
+
+            for (int k=kstart; k<kend; k++)
+                #pragma ivdep
+                for (int i=istart; i<iend; i++)
+                {
+                    const int ik = i + k*icells;
+                    qrt_s[ik] = TF(0);
+                    nrt_s[ik] = TF(0);
+                }
+
+            sedimentation_ss08(qrt_s, nrt_s, rr_s,
+                               w_qr, w_nr, c_qr, c_nr, slope_qr, slope_nr, flux_qr, flux_nr, mu_r, lambda_r,
+                               qr_s, nr_s, rho, rhoh, dzi, dz, dt_sub,
+                               istart, 0, kstart,
+                               iend,   1, kend,
+                               icells, kcells, icells, 0);
+
+            for (int k=kstart; k<kend; k++)
+                #pragma ivdep
+                for (int i=istart; i<iend; i++)
+                {
+                    const int ijk = i + j*icells + k*ijcells;
+                    const int ik  = i + k*icells;
+
+                    qr_s[ik] += qrt_s[ik] * TF(dt_sub);
+                    nr_s[ik] += nrt_s[ik] * TF(dt_sub);
+
+                    qrt[ijk] += f_sub * qrt_s[ik];
+                    nrt[ijk] += f_sub * nrt_s[ik];
+                }
+
+            for (int i=istart; i<iend; i++)
+                rr_bot[i + j*icells] += f_sub * rr_s[i];
+        }
+    }
 }
 
 template<typename TF>
@@ -542,6 +722,10 @@ Microphys_2mom_warm<TF>::Microphys_2mom_warm(Master& masterin, Grid<TF>& gridin,
     swmicrobudget = inputin.get_item<bool>("micro", "swmicrobudget", "", false);
     cflmax        = inputin.get_item<TF>("micro", "cflmax", "", 2.);
     Nc0<TF>       = inputin.get_item<TF>("micro", "Nc0", "", 70e6);
+    n_threads     = inputin.get_item<int>("micro", "n_threads", "", 1);
+    if (n_threads < 1)
+        throw std::runtime_error("n_threads must be at least 1");
+    swsedsubcycle = inputin.get_item<bool>("micro", "swsedsubcycle", "", true);
 
     // Initialize the qr (rain water specific humidity) and nr (droplot number concentration) fields
     const std::string group_name = "thermo";
@@ -642,85 +826,135 @@ void Microphys_2mom_warm<TF>::exec(Thermo<TF>& thermo, const double dt, Stats<TF
     // (1) limit the required number of tmp fields
     // (2) re-use some expensive calculations used in multiple microphysics routines.
     const int ikcells    = gd.icells * gd.kcells;                           // Size of XZ slice
-    const int n_slices   = 12;                                              // Number of XZ slices required
-    const int n_tmp_flds = std::ceil(static_cast<TF>(n_slices)/gd.jcells);  // Number of required tmp fields
+    const int n_slices   = 17;                                              // Number of XZ slices required per thread
+    const int n_tmp_flds = std::ceil(static_cast<TF>(n_slices*n_threads)/gd.jcells);  // Number of required tmp fields
 
     // Load the required number of tmp fields:
     std::vector<std::shared_ptr<Field3d<TF>>> tmp_fields;
     for (int n=0; n<n_tmp_flds; ++n)
         tmp_fields.push_back(fields.get_tmp());
 
-    // Get pointers to slices in tmp fields:
-    int slice_counter = 0;
-
-    TF* w_qr = get_tmp_slice<TF>(tmp_fields, slice_counter, gd.jcells, ikcells);
-    TF* w_nr = get_tmp_slice<TF>(tmp_fields, slice_counter, gd.jcells, ikcells);
-
-    TF* c_qr = get_tmp_slice<TF>(tmp_fields, slice_counter, gd.jcells, ikcells);
-    TF* c_nr = get_tmp_slice<TF>(tmp_fields, slice_counter, gd.jcells, ikcells);
-
-    TF* slope_qr = get_tmp_slice<TF>(tmp_fields, slice_counter, gd.jcells, ikcells);
-    TF* slope_nr = get_tmp_slice<TF>(tmp_fields, slice_counter, gd.jcells, ikcells);
-
-    TF* flux_qr = get_tmp_slice<TF>(tmp_fields, slice_counter, gd.jcells, ikcells);
-    TF* flux_nr = get_tmp_slice<TF>(tmp_fields, slice_counter, gd.jcells, ikcells);
-
-    TF* rain_mass = get_tmp_slice<TF>(tmp_fields, slice_counter, gd.jcells, ikcells);
-    TF* rain_diam = get_tmp_slice<TF>(tmp_fields, slice_counter, gd.jcells, ikcells);
-
-    TF* lambda_r = get_tmp_slice<TF>(tmp_fields, slice_counter, gd.jcells, ikcells);
-    TF* mu_r     = get_tmp_slice<TF>(tmp_fields, slice_counter, gd.jcells, ikcells);
-
     // ---------------------------------
     // Calculate microphysics tendencies
     // ---------------------------------
 
+    // Only cloudy cells contribute to autoconversion and accretion,
+    // and XZ slices without rain are skipped in the slice loop.
+    mp3d::build_active_cells(cloud_cells, cloud_offset, rain_count,
+                             ql->fld.data(), fields.sp.at("qr")->fld.data(),
+                             gd.istart, gd.jstart, gd.kstart,
+                             gd.iend,   gd.jend,   gd.kend,
+                             gd.jcells, gd.icells, gd.ijcells);
+
     // Autoconversion; formation of rain drop by coagulating cloud droplets
     mp3d::autoconversion(fields.st.at("qr")->fld.data(), fields.st.at("nr")->fld.data(), fields.st.at("qt")->fld.data(), fields.st.at("thl")->fld.data(),
                          fields.sp.at("qr")->fld.data(), ql->fld.data(), fields.rhoref.data(), exner.data(), Nc0<TF>,
-                         gd.istart, gd.jstart, gd.kstart,
-                         gd.iend,   gd.jend,   gd.kend,
-                         gd.icells, gd.ijcells);
+                         cloud_cells.data(), cloud_offset.data(),
+                         gd.kstart, gd.kend);
 
     // Accretion; growth of raindrops collecting cloud droplets
     mp3d::accretion(fields.st.at("qr")->fld.data(), fields.st.at("qt")->fld.data(), fields.st.at("thl")->fld.data(),
                     fields.sp.at("qr")->fld.data(), ql->fld.data(), fields.rhoref.data(), exner.data(),
-                    gd.istart, gd.jstart, gd.kstart,
-                    gd.iend,   gd.jend,   gd.kend,
-                    gd.icells, gd.ijcells);
-
-    // Rest of the microphysics is handled per XZ slice
-    for (int j=gd.jstart; j<gd.jend; ++j)
+                    cloud_cells.data(), cloud_offset.data(),
+                    gd.kstart, gd.kend);
+
+    TF* qrt  = fields.st.at("qr")->fld.data();
+    TF* nrt  = fields.st.at("nr")->fld.data();
+    TF* qtt  = fields.st.at("qt")->fld.data();
+    TF* thlt = fields.st.at("thl")->fld.data();
+
+    const TF* qr  = fields.sp.at("qr")->fld.data();
+    const TF* nr  = fields.sp.at("nr")->fld.data();
+    const TF* qt  = fields.sp.at("qt")->fld.data();
+    const TF* thl = fields.sp.at("thl")->fld.data();
+
+    // Rest of the microphysics is handled per XZ slice. Slices only write to their own
+    // j-row of the tendencies, so they are distributed over threads with private scratch.
+    #pragma omp parallel num_threads(n_threads)
     {
-        // Prepare the XZ slices which are used in all routines
-        mp2d::prepare_microphysics_slice(rain_mass, rain_diam, mu_r, lambda_r,
-                                         fields.sp.at("qr")->fld.data(), fields.sp.at("nr")->fld.data(), fields.rhoref.data(),
-                                         gd.istart, gd.iend, gd.kstart, gd.kend, gd.icells, gd.ijcells, j);
+        #ifdef _OPENMP
+        int slice_counter = omp_get_thread_num() * n_slices;
+        #else
+        int slice_counter = 0;
+        #endif
 
-        // Evaporation; evaporation of rain drops in unsaturated environment
-        mp2d::evaporation(fields.st.at("qr")->fld.data(), fields.st.at("nr")->fld.data(),  fields.st.at("qt")->fld.data(), fields.st.at("thl")->fld.data(),
-                          fields.sp.at("qr")->fld.data(), fields.sp.at("nr")->fld.data(),  ql->fld.data(),
-                          fields.sp.at("qt")->fld.data(), fields.sp.at("thl")->fld.data(), fields.rhoref.data(), exner.data(), p.data(),
-                          rain_mass, rain_diam,
-                          gd.istart, gd.jstart, gd.kstart,
-                          gd.iend,   gd.jend,   gd.kend,
-                          gd.icells, gd.ijcells, j);
+        // Get pointers to this thread's slices in tmp fields:
+        TF* w_qr = get_tmp_slice<TF>(tmp_fields, slice_counter, gd.jcells, ikcells);
+        TF* w_nr = get_tmp_slice<TF>(tmp_fields, slice_counter, gd.jcells, ikcells);
 
-        // Self collection and breakup; growth of raindrops by mutual (rain-rain) coagulation, and breakup by collisions
-        mp2d::selfcollection_breakup(fields.st.at("nr")->fld.data(), fields.sp.at("qr")->fld.data(), fields.sp.at("nr")->fld.data(), fields.rhoref.data(),
-                                     rain_mass, rain_diam, lambda_r,
-                                     gd.istart, gd.jstart, gd.kstart,
-                                     gd.iend,   gd.jend,   gd.kend,
-                                     gd.icells, gd.ijcells, j);
+        TF* c_qr = get_tmp_slice<TF>(tmp_fields, slice_counter, gd.jcells, ikcells);
+        TF* c_nr = get_tmp_slice<TF>(tmp_fields, slice_counter, gd.jcells, ikcells);
 
-        // Sedimentation; sub-grid sedimentation of rain
-        mp2d::sedimentation_ss08(fields.st.at("qr")->fld.data(), fields.st.at("nr")->fld.data(), rr_bot.data(),
-                                 w_qr, w_nr, c_qr, c_nr, slope_qr, slope_nr, flux_qr, flux_nr, mu_r, lambda_r,
-                                 fields.sp.at("qr")->fld.data(), fields.sp.at("nr")->fld.data(),
-                                 fields.rhoref.data(), fields.rhorefh.data(), gd.dzi.data(), gd.dz.data(), dt,
-                                 gd.istart, gd.jstart, gd.kstart,
-                                 gd.iend,   gd.jend,   gd.kend,
-                                 gd.icells, gd.kcells, gd.ijcells, j);
+        TF* slope_qr = get_tmp_slice<TF>(tmp_fields, slice_counter, gd.jcells, ikcells);
+        TF* slope_nr = get_tmp_slice<TF>(tmp_fields, slice_counter, gd.jcells, ikcells);
+
+        TF* flux_qr = get_tmp_slice<TF>(tmp_fields, slice_counter, gd.jcells, ikcells);
+        TF* flux_nr = get_tmp_slice<TF>(tmp_fields, slice_counter, gd.jcells, ikcells);
+
+        TF* rain_mass = get_tmp_slice<TF>(tmp_fields, slice_counter, gd.jcells, ikcells);
+        TF* rain_diam = get_tmp_slice<TF>(tmp_fields, slice_counter, gd.jcells, ikcells);
+
+        TF* lambda_r = get_tmp_slice<TF>(tmp_fields, slice_counter, gd.jcells, ikcells);
+        TF* mu_r     = get_tmp_slice<TF>(tmp_fields, slice_counter, gd.jcells, ikcells);
+
+        // Scratch for the sub-cycled sedimentation
+        TF* qr_s  = get_tmp_slice<TF>(tmp_fields, slice_counter, gd.jcells, ikcells);
+        TF* nr_s  = get_tmp_slice<TF>(tmp_fields, slice_counter, gd.jcells, ikcells);
+        TF* qrt_s = get_tmp_slice<TF>(tmp_fields, slice_counter, gd.jcells, ikcells);
+        TF* nrt_s = get_tmp_slice<TF>(tmp_fields, slice_counter, gd.jcells, ikcells);
+        TF* rr_s  = get_tmp_slice<TF>(tmp_fields, slice_counter, gd.jcells, ikcells);
+
+        #pragma omp for schedule(dynamic)
+        for (int j=gd.jstart; j<gd.jend; ++j)
+        {
+            // Without rain all slice processes vanish, including the surface rain rate.
+            if (rain_count[j] == 0)
+            {
+                std::fill(rr_bot.begin() + gd.istart + j*gd.icells, rr_bot.begin() + gd.iend + j*gd.icells, TF(0.));
+                continue;
+            }
+
+            // Prepare the XZ slices which are used in all routines
+            mp2d::prepare_microphysics_slice(rain_mass, rain_diam, mu_r, lambda_r,
+                                             qr, nr, fields.rhoref.data(),
+                                             gd.istart, gd.iend, gd.kstart, gd.kend, gd.icells, gd.ijcells, j);
+
+            // Evaporation; evaporation of rain drops in unsaturated environment
+            mp2d::evaporation(qrt, nrt, qtt, thlt,
+                              qr, nr, ql->fld.data(),
+                              qt, thl, fields.rhoref.data(), exner.data(), p.data(),
+                              rain_mass, rain_diam,
+                              gd.istart, gd.jstart, gd.kstart,
+                              gd.iend,   gd.jend,   gd.kend,
+                              gd.icells, gd.ijcells, j);
+
+            // Self collection and breakup; growth of raindrops by mutual (rain-rain) coagulation, and breakup by collisions
+            mp2d::selfcollection_breakup(nrt, qr, nr, fields.rhoref.data(),
+                                         rain_mass, rain_diam, lambda_r,
+                                         gd.istart, gd.jstart, gd.kstart,
+                                         gd.iend,   gd.jend,   gd.kend,
+                                         gd.icells, gd.ijcells, j);
+
+            // Sedimentation; sub-grid sedimentation of rain
+            if (swsedsubcycle)
+                mp2d::sedimentation_ss08_subcycled(qrt, nrt, rr_bot.data(),
+                                                   w_qr, w_nr, c_qr, c_nr, slope_qr, slope_nr, flux_qr, flux_nr,
+                                                   rain_mass, rain_diam, mu_r, lambda_r,
+                                                   qr_s, nr_s, qrt_s, nrt_s, rr_s,
+                                                   qr, nr,
+                                                   fields.rhoref.data(), fields.rhorefh.data(), gd.dzi.data(), gd.dz.data(), dt, cflmax,
+                                                   gd.istart, gd.jstart, gd.kstart,
+                                                   gd.iend,   gd.jend,   gd.kend,
+                                                   gd.icells, gd.kcells, gd.ijcells, j);
+            else
+                mp2d::sedimentation_ss08(qrt, nrt, rr_bot.data(),
+                                         w_qr, w_nr, c_qr, c_nr, slope_qr, slope_nr, flux_qr, flux_nr, mu_r, lambda_r,
+                                         qr, nr,
+                                         fields.rhoref.data(), fields.rhorefh.data(), gd.dzi.data(), gd.dz.data(), dt,
+                                         gd.istart, gd.jstart, gd.kstart,
+                                         gd.iend,   gd.jend,   gd.kend,
+                                         gd.icells, gd.kcells, gd.ijcells, j);
+        }
     }
 
     // Release all local tmp fields in use
@@ -765,7 +999,7 @@ void Microphys_2mom_warm<TF>::exec_stats(Stats<TF>& stats, Thermo<TF>& thermo, c
         // (1) limit the required number of tmp fields
         // (2) re-use some expensive calculations used in multiple microphysics routines.
         const int ikcells    = gd.icells * gd.kcells;                           // Size of XZ slice
-        const int n_slices   = 12;                                              // Number of XZ slices required
+        const int n_slices   = 17;                                              // Number of XZ slices required
         const int n_tmp_flds = std::ceil(static_cast<TF>(n_slices)/gd.jcells);  // Number of required tmp fields
 
         // Load the required number of tmp fields:
@@ -794,6 +1028,12 @@ void Microphys_2mom_warm<TF>::exec_stats(Stats<TF>& stats, Thermo<TF>& thermo, c
         TF* lambda_r = get_tmp_slice<TF>(tmp_fields, slice_counter, gd.jcells, ikcells);
         TF* mu_r     = get_tmp_slice<TF>(tmp_fields, slice_counter, gd.jcells, ikcells);
 
+        TF* qr_s  = get_tmp_slice<TF>(tmp_fields, slice_counter, gd.jcells, ikcells);
+        TF* nr_s  = get_tmp_slice<TF>(tmp_fields, slice_counter, gd.jcells, ikcells);
+        TF* qrt_s = get_tmp_slice<TF>(tmp_fields, slice_counter, gd.jcells, ikcells);
+        TF* nrt_s = get_tmp_slice<TF>(tmp_fields, slice_counter, gd.jcells, ikcells);
+        TF* rr_s  = get_tmp_slice<TF>(tmp_fields, slice_counter, gd.jcells, ikcells);
+
         // Get 4 tmp fields for all tendencies (qrt, nrt, thlt, qtt) :-(
         auto qrt  = fields.get_tmp();
         auto nrt  = fields.get_tmp();
@@ -812,11 +1052,16 @@ void Microphys_2mom_warm<TF>::exec_stats(Stats<TF>& stats, Thermo<TF>& thermo, c
         zero_field(thlt->fld.data(), gd.ncells);
         zero_field(qtt->fld.data(),  gd.ncells);
 
+        mp3d::build_active_cells(cloud_cells, cloud_offset, rain_count,
+                                 ql->fld.data(), fields.sp.at("qr")->fld.data(),
+                                 gd.istart, gd.jstart, gd.kstart,
+                                 gd.iend,   gd.jend,   gd.kend,
+                                 gd.jcells, gd.icells, gd.ijcells);
+
         mp3d::autoconversion(qrt->fld.data(), nrt->fld.data(), qtt->fld.data(), thlt->fld.data(),
                              fields.sp.at("qr")->fld.data(), ql->fld.data(), fields.rhoref.data(), exner.data(), Nc0<TF>,
-                             gd.istart, gd.jstart, gd.kstart,
-                             gd.iend,   gd.jend,   gd.kend,
-                             gd.icells, gd.ijcells);
+                             cloud_cells.data(), cloud_offset.data(),
+                             gd.kstart, gd.kend);
 
         stats.calc_stats("auto_qrt" , *qrt , no_offset, no_threshold);
         stats.calc_stats("auto_nrt" , *nrt , no_offset, no_threshold);
@@ -831,9 +1076,8 @@ void Microphys_2mom_warm<TF>::exec_stats(Stats<TF>& stats, Thermo<TF>& thermo, c
 
         mp3d::accretion(qrt->fld.data(), qtt->fld.data(), thlt->fld.data(),
                         fields.sp.at("qr")->fld.data(), ql->fld.data(), fields.rhoref.data(), exner.data(),
-                        gd.istart, gd.jstart, gd.kstart,
-                        gd.iend,   gd.jend,   gd.kend,
-                        gd.icells, gd.ijcells);
+                        cloud_cells.data(), cloud_offset.data(),
+                        gd.kstart, gd.kend);
 
         stats.calc_stats("accr_qrt" , *qrt , no_offset, no_threshold);
         stats.calc_stats("accr_thlt", *thlt, no_offset, no_threshold);
@@ -897,13 +1141,24 @@ void Microphys_2mom_warm<TF>::exec_stats(Stats<TF>& stats, Thermo<TF>& thermo, c
                                              fields.sp.at("qr")->fld.data(), fields.sp.at("nr")->fld.data(), fields.rhoref.data(),
                                              gd.istart, gd.iend, gd.kstart, gd.kend, gd.icells, gd.ijcells, j);
 
-            mp2d::sedimentation_ss08(qrt->fld.data(), nrt->fld.data(), rr_bot.data(),
-                                     w_qr, w_nr, c_qr, c_nr, slope_qr, slope_nr, flux_qr, flux_nr, mu_r, lambda_r,
-                                     fields.sp.at("qr")->fld.data(), fields.sp.at("nr")->fld.data(),
-                                     fields.rhoref.data(), fields.rhorefh.data(), gd.dzi.data(), gd.dz.data(), dt,
-                                     gd.istart, gd.jstart, gd.kstart,
-                                     gd.iend,   gd.jend,   gd.kend,
-                                     gd.icells, gd.kcells, gd.ijcells, j);
+            if (swsedsubcycle)
+                mp2d::sedimentation_ss08_subcycled(qrt->fld.data(), nrt->fld.data(), rr_bot.data(),
+                                                   w_qr, w_nr, c_qr, c_nr, slope_qr, slope_nr, flux_qr, flux_nr,
+                                                   rain_mass, rain_diam, mu_r, lambda_r,
+                                                   qr_s, nr_s, qrt_s, nrt_s, rr_s,
+                                                   fields.sp.at("qr")->fld.data(), fields.sp.at("nr")->fld.data(),
+                                                   fields.rhoref.data(), fields.rhorefh.data(), gd.dzi.data(), gd.dz.data(), dt, cflmax,
+                                                   gd.istart, gd.jstart, gd.kstart,
+                                                   gd.iend,   gd.jend,   gd.kend,
+                                                   gd.icells, gd.kcells, gd.ijcells, j);
+            else
+                mp2d::sedimentation_ss08(qrt->fld.data(), nrt->fld.data(), rr_bot.data(),
+                                         w_qr, w_nr, c_qr, c_nr, slope_qr, slope_nr, flux_qr, flux_nr, mu_r, lambda_r,
+                                         fields.sp.at("qr")->fld.data(), fields.sp.at("nr")->fld.data(),
+                                         fields.rhoref.data(), fields.rhorefh.data(), gd.dzi.data(), gd.dz.data(), dt,
+                                         gd.istart, gd.jstart, gd.kstart,
+                                         gd.iend,   gd.jend,   gd.kend,
+                                         gd.icells, gd.kcells, gd.ijcells, j);
         }
 
         stats.calc_stats("sed_qrt" , *qrt , no_offset, no_threshold);
@@ -938,6 +1193,10 @@ void Microphys_2mom_warm<TF>::exec_cross(Cross<TF>& cross, unsigned long iotime)
 template<typename TF>
 unsigned long Microphys_2mom_warm<TF>::get_time_limit(unsigned long idt, const double dt)
 {
+    // With sub-cycled sedimentation the fall speed does not limit the model time step.
+    if (swsedsubcycle)
+        return Constants::ulhuge;
+
     auto& gd = grid.get_grid_data();
 
     // Calculate the maximum sedimentation CFL number
@@ -21,6 +21,7 @@
  */
 
 #include <iostream>
+#include <algorithm>
 #include <cmath>
 #include <vector>
 
@@ -119,7 +120,51 @@ namespace
     using namespace Fast_math;
     using Micro_2mom_warm_functions::minmod;
 
-    // Compute all microphysical tendencies.
+    // Compact all cells that contain condensate into a list of indices sorted by height.
+    // Level k spans [active_offset[k-kstart], active_offset[k-kstart+1]) of the list.
+    // The number of active rain, snow and graupel cells is returned in n_precip.
+    template<typename TF>
+    void build_active_cells(
+            std::vector<int>& active, std::vector<int>& active_offset, int* const restrict n_precip,
+            const TF* const restrict ql, const TF* const restrict qi,
+            const TF* const restrict qr, const TF* const restrict qs, const TF* const restrict qg,
+            const int istart, const int jstart, const int kstart,
+            const int iend, const int jend, const int kend,
+            const int jj, const int kk)
+    {
+        active.clear();
+        active_offset.resize(kend-kstart+1);
+
+        n_precip[0] = 0;
+        n_precip[1] = 0;
+        n_precip[2] = 0;
+
+        for (int k=kstart; k<kend; ++k)
+        {
+            active_offset[k-kstart] = active.size();
+
+            for (int j=jstart; j<jend; ++j)
+                for (int i=istart; i<iend; ++i)
+                {
+                    const int ijk = i + j*jj + k*kk;
+
+                    const bool has_rain    = (qr[ijk] > qr_min<TF>);
+                    const bool has_snow    = (qs[ijk] > qs_min<TF>);
+                    const bool has_graupel = (qg[ijk] > qg_min<TF>);
+
+                    n_precip[0] += has_rain;
+                    n_precip[1] += has_snow;
+                    n_precip[2] += has_graupel;
+
+                    if (ql[ijk] > ql_min<TF> || qi[ijk] > qi_min<TF> || has_rain || has_snow || has_graupel)
+                        active.push_back(ijk);
+                }
+        }
+
+        active_offset[kend-kstart] = active.size();
+    }
+
+    // Compute all microphysical tendencies over the active cells.
     template<typename TF>
     void conversion(
             TF* const restrict qrt, TF* const restrict qst, TF* const restrict qgt,
@@ -130,15 +175,18 @@ namespace
             const TF* const restrict rho, const TF* const restrict exner, const TF* const restrict p,
             const TF* const restrict dzi, const TF* const restrict dzhi,
             const TF N_d, const TF dt,
-            const int istart, const int jstart, const int kstart,
-            const int iend, const int jend, const int kend,
-            const int jj, const int kk)
+            const int* const restrict active, const int* const restrict active_offset,
+            const int kstart, const int kend)
     {
         // Tomita Eq. 51. N_d is converted from SI units (m-3 instead of cm-3).
         const TF D_d = TF(0.146) - TF(5.964e-2)*std::log((N_d*TF(1.e-6)) / TF(2.e3));
 
         for (int k=kstart; k<kend; ++k)
         {
+            // Skip levels without any condensate.
+            if (active_offset[k-kstart] == active_offset[k-kstart+1])
+                continue;
+
             const TF rho0_rho_sqrt = std::sqrt(rho[kstart]/rho[k]);
 
             // Part of Tomita Eq. 29
@@ -183,468 +231,467 @@ namespace
                 / TF(4.)
                 * rho0_rho_sqrt;
 
-            for (int j=jstart; j<jend; ++j)
-                #pragma ivdep
-                for (int i=istart; i<iend; ++i)
-                {
-                    const int ijk = i + j*jj + k*kk;
-
-                    // Compute the T out of the known values of ql and qi, this saves memory and sat_adjust.
-                    const TF T = exner[k]*thl[ijk] + Lv<TF>/cp<TF>*ql[ijk] + Ls<TF>/cp<TF>*qi[ijk];
-                    const TF qv = qt[ijk] - ql[ijk] - qi[ijk];
-
-                    // Flag the sign of the absolute temperature.
-                    const TF T_pos = TF(T >= T0<TF>);
-                    const TF T_neg = TF(1.) - T_pos;
-
-                    // Check which species are present.
-                    const bool has_vapor   = (qv      > qv_min<TF>);
-                    const bool has_liq     = (ql[ijk] > ql_min<TF>);
-                    const bool has_ice     = (qi[ijk] > qi_min<TF>);
-                    const bool has_rain    = (qr[ijk] > qr_min<TF>);
-                    const bool has_snow    = (qs[ijk] > qs_min<TF>);
-                    const bool has_graupel = (qg[ijk] > qg_min<TF>);
+            const int n_start = active_offset[k-kstart];
+            const int n_end   = active_offset[k-kstart+1];
 
-                    if (! (has_liq || has_ice || has_rain || has_snow || has_graupel) )
-                        continue;
-
-                    // Tomita Eq. 27
-                    const TF lambda_r = std::pow(
-                            a_r<TF> * N_0r<TF> * std::tgamma(b_r<TF> + TF(1.))
-                            / (rho[k] * (qr[ijk] + q_tiny<TF>)),
-                            TF(1.) / (b_r<TF> + TF(1.)) );
-
-                    const TF lambda_s = std::pow(
-                            a_s<TF> * N_0s<TF> * std::tgamma(b_s<TF> + TF(1.))
-                            / (rho[k] * (qs[ijk] + q_tiny<TF>)),
-                            TF(1.) / (b_s<TF> + TF(1.)) );
-
-                    const TF lambda_g = std::pow(
-                            a_g<TF> * N_0g<TF> * std::tgamma(b_g<TF> + TF(1.))
-                            / (rho[k] * (qg[ijk] + q_tiny<TF>)),
-                            TF(1.) / (b_g<TF> + TF(1.)) );
-
-                    // Tomita Eq. 28
-                    const TF V_Tr = !(has_rain) ? TF(0.) :
-                        c_r<TF> * rho0_rho_sqrt
-                        * std::tgamma(b_r<TF> + d_r<TF> + TF(1.)) / std::tgamma(b_r<TF> + TF(1.))
-                        * std::pow(lambda_r, -d_r<TF>);
-
-                    const TF V_Ts = !(has_snow) ? TF(0.) :
-                        c_s<TF> * rho0_rho_sqrt
-                        * std::tgamma(b_s<TF> + d_s<TF> + TF(1.)) / std::tgamma(b_s<TF> + TF(1.))
-                        * std::pow(lambda_s, -d_s<TF>);
-
-                    const TF V_Tg = !(has_graupel) ? TF(0.) :
-                        c_g<TF> * rho0_rho_sqrt
-                        * std::tgamma(b_g<TF> + d_g<TF> + TF(1.)) / std::tgamma(b_g<TF> + TF(1.))
-                        * std::pow(lambda_g, -d_g<TF>);
-
-                    // ACCRETION
-                    // Tomita Eq. 29
-                    const TF P_iacr = !(has_rain && has_ice) ? TF(0.) :
-                        fac_iacr / std::pow(lambda_r, TF(6.) + d_r<TF>) * qi[ijk];
-
-                    // Tomita Eq. 30
-                    const TF delta_1 = TF(qr[ijk] >= TF(1.e-4));
-
-                    // Tomita Eq. 31
-                    TF P_iacr_s = (TF(1.) - delta_1) * P_iacr;
-                    TF P_iacr_g = delta_1 * P_iacr;
-
-                    // Tomita Eq. 32
-                    const TF P_raci = !(has_rain && has_ice) ? TF(0.) :
-                        fac_raci / std::pow(lambda_r, TF(3.) + d_r<TF>) * qi[ijk];
-
-                    // Tomita Eq. 33
-                    TF P_raci_s = (TF(1.) - delta_1) * P_raci;
-                    TF P_raci_g = delta_1 * P_raci;
-
-                    // Tomita Eq. 34, 35
-                    TF P_racw = !(has_liq && has_rain) ? TF(0.) :
-                        fac_racw / std::pow(lambda_r, TF(3.) + d_r<TF>) * ql[ijk];
-                    TF P_sacw = !(has_liq && has_snow) ? TF(0.) :
-                        fac_sacw / std::pow(lambda_s, TF(3.) + d_s<TF>) * ql[ijk];
-
-                    // Tomita Eq. 39
-                    const TF E_si = std::exp(gamma_sacr<TF> * (T - T0<TF>));
-
-                    // Tomita Eq. 36 - 38
-                    TF P_saci = !(has_snow && has_ice) ? TF(0.) :
-                        fac_saci * E_si / std::pow(lambda_s, TF(3.) + d_s<TF>) * qi[ijk];
-                    TF P_gacw = !(has_graupel && has_liq) ? TF(0.) :
-                        fac_gacw / std::pow(lambda_g, TF(3.) + d_g<TF>) * ql[ijk];
-                    TF P_gaci = !(has_graupel && has_ice) ? TF(0.) :
-                        fac_gaci / std::pow(lambda_g, TF(3.) + d_g<TF>) * qi[ijk];
-
-                    // Accretion of falling hydrometeors.
-                    // Tomita Eq. 42
-                    const TF delta_2 = TF(1.) - TF( (qr[ijk] >= TF(1.e-4)) || (qs[ijk] >= TF(1.e-4)) );
-
-                    // Tomita Eq. 41
-                    TF P_racs = !(has_rain && has_snow) ? TF(0.) :
-                        (TF(1.) - delta_2)
-                        * pi<TF> * a_s<TF> * std::abs(V_Tr - V_Ts) * E_sr<TF> * N_0s<TF> * N_0r<TF> / (TF(4.)*rho[k])
-                        * (          std::tgamma(b_s<TF> + TF(3.)) * std::tgamma(TF(1.)) / ( std::pow(lambda_s, b_s<TF> + TF(3.)) * lambda_r )
-                          + TF(2.) * std::tgamma(b_s<TF> + TF(2.)) * std::tgamma(TF(2.)) / ( std::pow(lambda_s, b_s<TF> + TF(2.)) * pow2(lambda_r) )
-                          +          std::tgamma(b_s<TF> + TF(1.)) * std::tgamma(TF(3.)) / ( std::pow(lambda_s, b_s<TF> + TF(1.)) * pow3(lambda_r) ) );
-
-                    // Tomita Eq. 44
-                    const TF P_sacr = !(has_snow && has_rain) ? TF(0.) :
-                          pi<TF> * a_r<TF> * std::abs(V_Ts - V_Tr) * E_sr<TF> * N_0r<TF> * N_0s<TF> / (TF(4.)*rho[k])
-                        * (          std::tgamma(b_r<TF> + TF(1.)) * std::tgamma(TF(3.)) / ( std::pow(lambda_r, b_r<TF> + TF(1.)) * pow3(lambda_s) )
-                          + TF(2.) * std::tgamma(b_r<TF> + TF(2.)) * std::tgamma(TF(2.)) / ( std::pow(lambda_r, b_r<TF> + TF(2.)) * pow2(lambda_s) )
-                          +          std::tgamma(b_r<TF> + TF(3.)) * std::tgamma(TF(1.)) / ( std::pow(lambda_r, b_r<TF> + TF(3.)) * lambda_s ) );
-
-                    // Tomita Eq. 43
-                    TF P_sacr_g = (TF(1.) - delta_2) * P_sacr;
-                    TF P_sacr_s = delta_2 * P_sacr;
-
-                    // Tomita Eq. 49
-                    const TF E_gs = std::min( TF(1.), std::exp(gamma_gacs<TF> * (T - T0<TF>)) );
-
-                    // Tomita Eq. 47
-                    TF P_gacr = !(has_graupel && has_rain) ? TF(0.) :
-                          pi<TF> * a_r<TF> * std::abs(V_Tg - V_Tr) * E_gr<TF> * N_0g<TF> * N_0r<TF> / (TF(4.)*rho[k])
-                        * (          std::tgamma(b_r<TF> + TF(1.)) * std::tgamma(TF(3.)) / ( std::pow(lambda_r, b_r<TF> + TF(1.)) * pow3(lambda_g) )
-                          + TF(2.) * std::tgamma(b_r<TF> + TF(2.)) * std::tgamma(TF(2.)) / ( std::pow(lambda_r, b_r<TF> + TF(2.)) * pow2(lambda_g) )
-                          +          std::tgamma(b_r<TF> + TF(3.)) * std::tgamma(TF(1.)) / ( std::pow(lambda_r, b_r<TF> + TF(3.)) * lambda_g ) );
-
-                    // Tomita Eq. 48
-                    TF P_gacs = !(has_graupel && has_snow) ? TF(0.) :
-                          pi<TF> * a_s<TF> * std::abs(V_Tg - V_Ts) * E_gs * N_0g<TF> * N_0s<TF> / (TF(4.)*rho[k])
-                        * (          std::tgamma(b_s<TF> + TF(1.)) * std::tgamma(TF(3.)) / ( std::pow(lambda_s, b_s<TF> + TF(1.)) * pow3(lambda_g) )
-                          + TF(2.) * std::tgamma(b_s<TF> + TF(2.)) * std::tgamma(TF(2.)) / ( std::pow(lambda_s, b_s<TF> + TF(2.)) * pow2(lambda_g) )
-                          +          std::tgamma(b_s<TF> + TF(3.)) * std::tgamma(TF(1.)) / ( std::pow(lambda_s, b_s<TF> + TF(3.)) * lambda_g ) );
-
-                    // AUTOCONVERSION.
-                    constexpr TF q_icrt = TF(0.);
-                    constexpr TF q_scrt = TF(6.e-4);
-
-                    // Tomita Eq. 53
-                    const TF beta_1 = std::min( beta_saut<TF>, beta_saut<TF>*std::exp(gamma_saut<TF> * (T - T0<TF>)) );
-
-                    // Tomita Eq. 54
-                    const TF beta_2 = std::min( beta_gaut<TF>, beta_gaut<TF>*std::exp(gamma_gaut<TF> * (T - T0<TF>)) );
-
-                    // Tomita Eq. 50. Our N_d is SI units, so conversion is applied.
-                    TF P_raut = !(has_liq) ? TF(0.) :
-                        TF(16.7)/rho[k] * pow2(rho[k]*ql[ijk]) / (TF(5.) + TF(3.66e-2) * TF(1.e-6)*N_d / (D_d*rho[k]*ql[ijk]));
-
-                    // // Kharoutdinov and Kogan autoconversion.
-                    // TF P_raut = (has_liq) ?
-                    //     TF(1350.)
-                    //     * std::pow(ql[ijk], TF(2.47))
-                    //     * std::pow(N_d * TF(1.e-6), TF(-1.79))
-                    //     : TF(0.);
-
-                    // Seifert and Beheng autoconversion.
-                    // const TF x_star = TF(2.6e-10); // SB06, list of symbols, same as UCLA-LES
-                    // const TF k_cc = TF(9.44e9); // UCLA-LES (Long, 1974), 4.44e9 in SB06, p48
-                    // const TF nu_c = TF(1.); // SB06, Table 1., same as UCLA-LES
-                    // const TF kccxs = k_cc / (TF(20.) * x_star) * (nu_c+2)*(nu_c+4) / pow2(nu_c+1);
-                    // const TF xc  = rho[k] * ql[ijk] / N_d; // Mean mass of cloud drops [kg]
-                    // const TF tau = TF(1.) - ql[ijk] / (ql[ijk] + qr[ijk] + dsmall); // SB06, Eq 5
-                    // const TF phi_au = TF(600.) * std::pow(tau, TF(0.68)) * pow3(TF(1.) - pow(tau, TF(0.68))); // UCLA-LES
-
-                    // TF P_raut = rho[k] * kccxs * pow(ql[ijk], 2) * pow(xc, 2) * (TF(1.) + phi_au / pow2(TF(1.)-tau)); // SB06, eq 4
-
-                    // Tomita Eq. 52
-                    TF P_saut = !(has_ice) ? TF(0.) :
-                        std::max(beta_1*(qi[ijk] - q_icrt), TF(0.));
-
-                    // Tomita Eq. 54
-                    TF P_gaut = !(has_snow) ? TF(0.) :
-                        std::max(beta_2*(qs[ijk] - q_scrt), TF(0.));
-
-                    // PHASE CHANGES.
-                    // Tomita Eq. 57
-                    const TF G_w = TF(1.) / (
-                        Lv<TF> / (K_a<TF> * T) * (Lv<TF> / (Rv<TF> * T) - TF(1.))
-                        + Rv<TF>*T / (K_d<TF> * esat_liq(T)) );
-
-                    // Tomita Eq. 62
-                    const TF G_i = TF(1.) / (
-                        Ls<TF> / (K_a<TF> * T) * (Ls<TF> / (Rv<TF> * T) - TF(1.))
-                        + Rv<TF>*T / (K_d<TF> * esat_ice(T)) );
-
-                    const TF S_w = (qt[ijk] - ql[ijk] - qi[ijk]) / qsat_liq(p[k], T);
-                    const TF S_i = (qt[ijk] - ql[ijk] - qi[ijk]) / qsat_ice(p[k], T);
-
-                    // Tomita Eq. 63
-                    const TF delta_3 = TF(S_i <= TF(1.)); // Subsaturated, then delta_3 = 1.
-
-                    // Tomita Eq. 59
-                    TF P_revp = !(has_rain) ? TF(0.) :
-                        - TF(2.)*pi<TF> * N_0r<TF> * (std::min(S_w, TF(1.)) - TF(1.)) * G_w / rho[k]
-                        * ( f_1r<TF> * std::tgamma(TF(2.)) / pow2(lambda_r)
-                          + f_2r<TF> * std::sqrt(c_r<TF> * rho0_rho_sqrt / nu<TF>)
-                          * std::tgamma( TF(0.5) * (TF(5.) + d_r<TF>) )
-                          / std::pow(lambda_r, TF(0.5) * (TF(5.) + d_r<TF>)) );
-
-                    // Tomita Eq. 60. Negative for sublimation, positive for deposition.
-                    const TF P_sdep_ssub = 
-                        TF(2.)*pi<TF> * N_0s<TF> * (S_i - TF(1.)) * G_i / rho[k]
-                        * ( f_1s<TF> * std::tgamma(TF(2.)) / pow2(lambda_s)
-                          + f_2s<TF> * std::sqrt(c_s<TF> * rho0_rho_sqrt / nu<TF>)
-                          * std::tgamma( TF(0.5) * (TF(5.) + d_s<TF>) )
-                          / std::pow(lambda_s, TF(0.5) * (TF(5.) + d_s<TF>)) );
-
-                    // Tomita Eq. 51
-                    const TF P_gdep_gsub = 
-                        TF(2.)*pi<TF> * N_0g<TF> * (S_i - TF(1.)) * G_i / rho[k]
-                        * ( f_1g<TF> * std::tgamma(TF(2.)) / pow2(lambda_g)
-                          + f_2g<TF> * std::sqrt(c_g<TF> * rho0_rho_sqrt / nu<TF>)
-                          * std::tgamma( TF(0.5) * (TF(5.) + d_g<TF>) )
-                          / std::pow(lambda_g, TF(0.5) * (TF(5.) + d_g<TF>)) );
-
-                    // Tomita Eq. 64
-                    TF P_sdep = !(has_vapor) ? TF(0.) :
-                        (TF(1.) - delta_3) * P_sdep_ssub;
-                    TF P_gdep = !(has_vapor) ? TF(0.) :
-                        (TF(1.) - delta_3) * P_gdep_gsub;
-
-                    // Tomita Eq. 65
-                    // CvH: I swapped the sign with respect to Tomita, the term should be positive.
-                    TF P_ssub = !(has_snow) ? TF(0.) :
-                        - delta_3 * P_sdep_ssub;
-                    TF P_gsub = !(has_graupel) ? TF(0.) :
-                        - delta_3 * P_gdep_gsub;
-
-                    // Freezing and melting
-                    // Tomita Eq. 67, 68 combined.
-                    TF P_smlt = !(has_snow) ? TF(0.) :
-                        TF(2.)*pi<TF> * K_a<TF> * (T - T0<TF>) * N_0s<TF> / (rho[k]*Lf<TF>)
-                        * ( f_1s<TF> * std::tgamma(TF(2.)) / pow2(lambda_s)
-                          + f_2s<TF> * std::sqrt(c_s<TF> * rho0_rho_sqrt / nu<TF>)
-                          * std::tgamma( TF(0.5) * (TF(5.) + d_s<TF>) )
-                          / std::pow(lambda_s, TF(0.5) * (TF(5.) + d_s<TF>)) )
-                        + C_l<TF> * (T - T0<TF>) / Lf<TF> * (P_sacw + P_sacr);
-
-                    // Tomita Eq. 69
-                    TF P_gmlt = !(has_graupel) ? TF(0.) :
-                        TF(2.)*pi<TF> * K_a<TF> * (T - T0<TF>) * N_0g<TF> / (rho[k]*Lf<TF>)
-                        * ( f_1g<TF> * std::tgamma(TF(2.)) / pow2(lambda_g)
-                          + f_2g<TF> * std::sqrt(c_g<TF> * rho0_rho_sqrt / nu<TF>)
-                          * std::tgamma( TF(0.5) * (TF(5.) + d_g<TF>) )
-                          / std::pow(lambda_g, TF(0.5) * (TF(5.) + d_g<TF>)) )
-                        + C_l<TF> * (T - T0<TF>) / Lf<TF> * (P_gacw + P_gacr);
-
-                    // Tomita Eq. 70
-                    constexpr TF A_prime = TF(0.66);
-                    constexpr TF B_prime = TF(100.);
-
-                    TF P_gfrz = !(has_rain) ? TF(0.) :
-                        TF(20.) * pi_2<TF> * B_prime * N_0r<TF> * rho_w<TF> / rho[k]
-                        * (std::exp(A_prime * (T0<TF> - T)) - TF(1.)) / pow7(lambda_r);
-
-                    // COMPUTE THE TENDENCIES.
-                    // Limit the production terms to avoid instability.
-                    auto limit_tend = [&](TF& tend, const TF tend_limit)
-                    {
-                        tend = std::max(TF(0.), std::min(tend, tend_limit));
-                    };
-
-                    const TF dqv_dt_max = qv      / dt;
-                    const TF dqi_dt_max = qi[ijk] / dt;
-                    const TF dql_dt_max = ql[ijk] / dt;
-                    const TF dqr_dt_max = qr[ijk] / dt;
-                    const TF dqs_dt_max = qs[ijk] / dt;
-                    const TF dqg_dt_max = qg[ijk] / dt;
-
-                    // Limit on the availability of the source.
-                    // Limit accretion terms.
-                    limit_tend(P_iacr_s, dqr_dt_max);
-                    limit_tend(P_iacr_g, dqr_dt_max);
-                    limit_tend(P_raci_s, dqi_dt_max);
-                    limit_tend(P_raci_g, dqi_dt_max);
-                    limit_tend(P_racw  , dql_dt_max);
-                    limit_tend(P_sacw  , dql_dt_max);
-                    limit_tend(P_saci  , dqi_dt_max);
-                    limit_tend(P_gacw  , dql_dt_max);
-                    limit_tend(P_gaci  , dqi_dt_max);
-                    limit_tend(P_racs  , dqs_dt_max);
-                    limit_tend(P_sacr_s, dqr_dt_max);
-                    limit_tend(P_sacr_g, dqr_dt_max);
-                    limit_tend(P_gacr  , dqr_dt_max);
-                    limit_tend(P_gacs  , dqs_dt_max);
-
-                    // Limit autoconversion terms.
-                    limit_tend(P_raut, dql_dt_max);
-                    limit_tend(P_saut, dqi_dt_max);
-                    limit_tend(P_gaut, dqs_dt_max);
-
-                    // Limit phase changes.
-                    limit_tend(P_revp, dqr_dt_max);
-                    limit_tend(P_sdep, dqv_dt_max);
-                    limit_tend(P_ssub, dqs_dt_max);
-                    limit_tend(P_gdep, dqv_dt_max);
-                    limit_tend(P_gsub, dqg_dt_max);
-                    limit_tend(P_smlt, dqs_dt_max);
-                    limit_tend(P_gmlt, dqg_dt_max);
-                    limit_tend(P_gfrz, dqr_dt_max);
-
-                    // P_iacr_s = 0;
-                    // P_iacr_g = 0;
-                    // P_raci_s = 0;
-                    // P_raci_g = 0;
-                    // P_racw   = 0;
-                    // P_sacw   = 0;
-                    // P_saci   = 0;
-                    // P_gacw   = 0;
-                    // P_gaci   = 0;
-                    // P_racs   = 0;
-                    // P_sacr_s = 0;
-                    // P_sacr_g = 0;
-                    // P_gacr   = 0;
-                    // P_gacs   = 0;
-
-                    // P_raut = 0;
-                    // P_saut = 0;
-                    // P_gaut = 0;
-
-                    // P_revp = 0;
-                    // P_sdep = 0;
-                    // P_ssub = 0;
-                    // P_gdep = 0;
-                    // P_gsub = 0;
-                    // P_smlt = 0;
-                    // P_gmlt = 0;
-                    // P_gfrz = 0;
-
-                    TF vapor_to_snow = P_sdep;
-                    TF vapor_to_graupel = P_gdep;
-
-                    TF cloud_to_rain = P_racw + P_sacw * T_pos + P_raut;
-                    TF cloud_to_graupel = P_gacw;
-                    TF cloud_to_snow = P_sacw * T_neg;
-
-                    TF rain_to_vapor = P_revp;
-                    TF rain_to_graupel = P_gacr + P_iacr_g + P_sacr_g * T_neg + P_gfrz * T_neg;
-                    TF rain_to_snow = P_sacr_s * T_neg + P_iacr_s;
-
-                    TF ice_to_snow = P_raci_s + P_saci + P_saut;
-                    TF ice_to_graupel = P_raci_g + P_gaci;
-
-                    TF snow_to_graupel = P_gacs + P_racs + P_gaut;
-                    TF snow_to_rain = P_smlt;
-                    TF snow_to_vapor = P_ssub;
-
-                    TF graupel_to_rain = P_gmlt * T_pos;
-                    TF graupel_to_vapor = P_gsub;
-
-                    const TF dqv_dt =
-                        - vapor_to_snow - vapor_to_graupel;
-
-                    const TF dql_dt =
-                        - cloud_to_rain - cloud_to_graupel - cloud_to_snow;
-
-                    const TF dqi_dt =
-                        - ice_to_snow - ice_to_graupel;
-
-                    const TF dqr_dt =
-                        + cloud_to_rain + snow_to_rain + graupel_to_rain
-                        - rain_to_vapor - rain_to_graupel - rain_to_snow;
-
-                    const TF dqs_dt =
-                        + cloud_to_snow + ice_to_snow + vapor_to_snow
-                        - snow_to_graupel - snow_to_vapor - snow_to_rain;
-
-                    const TF dqg_dt =
-                        + cloud_to_graupel + rain_to_graupel + ice_to_graupel
-                        + vapor_to_graupel + snow_to_graupel
-                        - graupel_to_rain - graupel_to_vapor;
-
-                    // Limit the production terms to avoid instability.
-                    auto limit_factor = [](const TF tend, const TF tend_limit)
-                    {
-                        return (tend < TF(0.)) ? std::min(-tend_limit/tend, TF(1.)) : TF(1.);
-                    };
-
-                    const TF dqv_dt_fac = limit_factor(dqv_dt, dqv_dt_max);
-                    const TF dql_dt_fac = limit_factor(dql_dt, dql_dt_max);
-                    const TF dqi_dt_fac = limit_factor(dqi_dt, dqi_dt_max);
-                    const TF dqr_dt_fac = limit_factor(dqr_dt, dqr_dt_max);
-                    const TF dqs_dt_fac = limit_factor(dqs_dt, dqs_dt_max);
-                    const TF dqg_dt_fac = limit_factor(dqg_dt, dqg_dt_max);
-
-                    vapor_to_snow    *= dqv_dt_fac * dqs_dt_fac;
-                    vapor_to_graupel *= dqv_dt_fac * dqg_dt_fac;
-
-                    cloud_to_rain    *= dql_dt_fac * dqr_dt_fac;
-                    cloud_to_graupel *= dql_dt_fac * dqg_dt_fac;
-                    cloud_to_snow    *= dql_dt_fac * dqs_dt_fac;
-
-                    rain_to_vapor    *= dqr_dt_fac * dqv_dt_fac;
-                    rain_to_graupel  *= dqr_dt_fac * dqg_dt_fac;
-                    rain_to_snow     *= dqr_dt_fac * dqs_dt_fac;
-
-                    ice_to_snow      *= dqi_dt_fac * dqs_dt_fac;
-                    ice_to_graupel   *= dqi_dt_fac * dqg_dt_fac;
-
-                    snow_to_graupel  *= dqs_dt_fac * dqg_dt_fac;
-                    snow_to_vapor    *= dqs_dt_fac * dqv_dt_fac;
-                    snow_to_rain     *= dqs_dt_fac * dqr_dt_fac;
-
-                    graupel_to_rain  *= dqg_dt_fac * dqr_dt_fac;
-                    graupel_to_vapor *= dqg_dt_fac * dqv_dt_fac;
-
-                    // Loss from cloud.
-                    qtt[ijk] -= cloud_to_rain;
-                    qrt[ijk] += cloud_to_rain;
-                    thlt[ijk] += Lv<TF> / (cp<TF> * exner[k]) * cloud_to_rain;
-
-                    qtt[ijk] -= cloud_to_graupel;
-                    qgt[ijk] += cloud_to_graupel;
-                    thlt[ijk] += Ls<TF> / (cp<TF> * exner[k]) * cloud_to_graupel;
-
-                    qtt[ijk] -= cloud_to_snow;
-                    qst[ijk] += cloud_to_snow;
-                    thlt[ijk] += Ls<TF> / (cp<TF> * exner[k]) * cloud_to_snow;
-
-                    // Loss from rain.
-                    qrt[ijk] -= rain_to_vapor;
-                    qtt[ijk] += rain_to_vapor;
-                    thlt[ijk] -= Lv<TF> / (cp<TF> * exner[k]) * rain_to_vapor;
-
-                    qrt[ijk] -= rain_to_graupel;
-                    qgt[ijk] += rain_to_graupel;
-                    thlt[ijk] += Lf<TF> / (cp<TF> * exner[k]) * rain_to_graupel;
-
-                    qrt[ijk] -= rain_to_snow;
-                    qst[ijk] += rain_to_snow;
-                    thlt[ijk] += Lf<TF> / (cp<TF> * exner[k]) * rain_to_snow;
-
-                    // Loss from ice.
-                    qtt[ijk] -= ice_to_snow;
-                    qst[ijk] += ice_to_snow;
-                    thlt[ijk] += Ls<TF> / (cp<TF> * exner[k]) * ice_to_snow;
-
-                    qtt[ijk] -= ice_to_graupel;
-                    qgt[ijk] += ice_to_graupel;
-                    thlt[ijk] += Ls<TF> / (cp<TF> * exner[k]) * ice_to_graupel;
-
-                    // Loss from snow.
-                    qst[ijk] -= snow_to_graupel;
-                    qgt[ijk] += snow_to_graupel;
-
-                    qst[ijk] -= snow_to_vapor;
-                    qtt[ijk] += snow_to_vapor;
-                    thlt[ijk] -= Ls<TF> / (cp<TF> * exner[k]) * snow_to_vapor;
-
-                    qst[ijk] -= snow_to_rain;
-                    qrt[ijk] += snow_to_rain;
-                    thlt[ijk] -= Lf<TF> / (cp<TF> * exner[k]) * snow_to_rain;
-
-                    // Loss from graupel.
-                    qgt[ijk] -= graupel_to_rain;
-                    qrt[ijk] += graupel_to_rain;
-                    thlt[ijk] -= Lf<TF> / (cp<TF> * exner[k]) * graupel_to_rain;
-
-                    qgt[ijk] -= graupel_to_vapor;
-                    qtt[ijk] += graupel_to_vapor;
-                    thlt[ijk] -= Ls<TF> / (cp<TF> * exner[k]) * graupel_to_vapor;
-                }
+            #pragma ivdep
+            for (int n=n_start; n<n_end; ++n)
+            {
+                const int ijk = active[n];
+
+                // Compute the T out of the known values of ql and qi, this saves memory and sat_adjust.
+                const TF T = exner[k]*thl[ijk] + Lv<TF>/cp<TF>*ql[ijk] + Ls<TF>/cp<TF>*qi[ijk];
+                const TF qv = qt[ijk] - ql[ijk] - qi[ijk];
+
+                // Flag the sign of the absolute temperature.
+                const TF T_pos = TF(T >= T0<TF>);
+                const TF T_neg = TF(1.) - T_pos;
+
+                // Check which species are present.
+                const bool has_vapor   = (qv      > qv_min<TF>);
+                const bool has_liq     = (ql[ijk] > ql_min<TF>);
+                const bool has_ice     = (qi[ijk] > qi_min<TF>);
+                const bool has_rain    = (qr[ijk] > qr_min<TF>);
+                const bool has_snow    = (qs[ijk] > qs_min<TF>);
+                const bool has_graupel = (qg[ijk] > qg_min<TF>);
+
+                // Tomita Eq. 27
+                const TF lambda_r = fast_pow(
+                        a_r<TF> * N_0r<TF> * std::tgamma(b_r<TF> + TF(1.))
+                        / (rho[k] * (qr[ijk] + q_tiny<TF>)),
+                        TF(1.) / (b_r<TF> + TF(1.)) );
+
+                const TF lambda_s = fast_pow(
+                        a_s<TF> * N_0s<TF> * std::tgamma(b_s<TF> + TF(1.))
+                        / (rho[k] * (qs[ijk] + q_tiny<TF>)),
+                        TF(1.) / (b_s<TF> + TF(1.)) );
+
+                const TF lambda_g = fast_pow(
+                        a_g<TF> * N_0g<TF> * std::tgamma(b_g<TF> + TF(1.))
+                        / (rho[k] * (qg[ijk] + q_tiny<TF>)),
+                        TF(1.) / (b_g<TF> + TF(1.)) );
+
+                // Tomita Eq. 28
+                const TF V_Tr = !(has_rain) ? TF(0.) :
+                    c_r<TF> * rho0_rho_sqrt
+                    * std::tgamma(b_r<TF> + d_r<TF> + TF(1.)) / std::tgamma(b_r<TF> + TF(1.))
+                    * fast_pow(lambda_r, -d_r<TF>);
+
+                const TF V_Ts = !(has_snow) ? TF(0.) :
+                    c_s<TF> * rho0_rho_sqrt
+                    * std::tgamma(b_s<TF> + d_s<TF> + TF(1.)) / std::tgamma(b_s<TF> + TF(1.))
+                    * fast_pow(lambda_s, -d_s<TF>);
+
+                const TF V_Tg = !(has_graupel) ? TF(0.) :
+                    c_g<TF> * rho0_rho_sqrt
+                    * std::tgamma(b_g<TF> + d_g<TF> + TF(1.)) / std::tgamma(b_g<TF> + TF(1.))
+                    * fast_pow(lambda_g, -d_g<TF>);
+
+                // ACCRETION
+                // Tomita Eq. 29
+                const TF P_iacr = !(has_rain && has_ice) ? TF(0.) :
+                    fac_iacr / fast_pow(lambda_r, TF(6.) + d_r<TF>) * qi[ijk];
+
+                // Tomita Eq. 30
+                const TF delta_1 = TF(qr[ijk] >= TF(1.e-4));
+
+                // Tomita Eq. 31
+                TF P_iacr_s = (TF(1.) - delta_1) * P_iacr;
+                TF P_iacr_g = delta_1 * P_iacr;
+
+                // Tomita Eq. 32
+                const TF P_raci = !(has_rain && has_ice) ? TF(0.) :
+                    fac_raci / fast_pow(lambda_r, TF(3.) + d_r<TF>) * qi[ijk];
+
+                // Tomita Eq. 33
+                TF P_raci_s = (TF(1.) - delta_1) * P_raci;
+                TF P_raci_g = delta_1 * P_raci;
+
+                // Tomita Eq. 34, 35
+                TF P_racw = !(has_liq && has_rain) ? TF(0.) :
+                    fac_racw / fast_pow(lambda_r, TF(3.) + d_r<TF>) * ql[ijk];
+                TF P_sacw = !(has_liq && has_snow) ? TF(0.) :
+                    fac_sacw / fast_pow(lambda_s, TF(3.) + d_s<TF>) * ql[ijk];
+
+                // Tomita Eq. 39
+                const TF E_si = std::exp(gamma_sacr<TF> * (T - T0<TF>));
+
+                // Tomita Eq. 36 - 38
+                TF P_saci = !(has_snow && has_ice) ? TF(0.) :
+                    fac_saci * E_si / fast_pow(lambda_s, TF(3.) + d_s<TF>) * qi[ijk];
+                TF P_gacw = !(has_graupel && has_liq) ? TF(0.) :
+                    fac_gacw / fast_pow(lambda_g, TF(3.) + d_g<TF>) * ql[ijk];
+                TF P_gaci = !(has_graupel && has_ice) ? TF(0.) :
+                    fac_gaci / fast_pow(lambda_g, TF(3.) + d_g<TF>) * qi[ijk];
+
+                // Accretion of falling hydrometeors.
+                // Tomita Eq. 42
+                const TF delta_2 = TF(1.) - TF( (qr[ijk] >= TF(1.e-4)) || (qs[ijk] >= TF(1.e-4)) );
+
+                // Tomita Eq. 41
+                TF P_racs = !(has_rain && has_snow) ? TF(0.) :
+                    (TF(1.) - delta_2)
+                    * pi<TF> * a_s<TF> * std::abs(V_Tr - V_Ts) * E_sr<TF> * N_0s<TF> * N_0r<TF> / (TF(4.)*rho[k])
+                    * (          std::tgamma(b_s<TF> + TF(3.)) * std::tgamma(TF(1.)) / ( fast_pow(lambda_s, b_s<TF> + TF(3.)) * lambda_r )
+                      + TF(2.) * std::tgamma(b_s<TF> + TF(2.)) * std::tgamma(TF(2.)) / ( fast_pow(lambda_s, b_s<TF> + TF(2.)) * pow2(lambda_r) )
+                      +          std::tgamma(b_s<TF> + TF(1.)) * std::tgamma(TF(3.)) / ( fast_pow(lambda_s, b_s<TF> + TF(1.)) * pow3(lambda_r) ) );
+
+                // Tomita Eq. 44
+                const TF P_sacr = !(has_snow && has_rain) ? TF(0.) :
+                      pi<TF> * a_r<TF> * std::abs(V_Ts - V_Tr) * E_sr<TF> * N_0r<TF> * N_0s<TF> / (TF(4.)*rho[k])
+                    * (          std::tgamma(b_r<TF> + TF(1.)) * std::tgamma(TF(3.)) / ( fast_pow(lambda_r, b_r<TF> + TF(1.)) * pow3(lambda_s) )
+                      + TF(2.) * std::tgamma(b_r<TF> + TF(2.)) * std::tgamma(TF(2.)) / ( fast_pow(lambda_r, b_r<TF> + TF(2.)) * pow2(lambda_s) )
+                      +          std::tgamma(b_r<TF> + TF(3.)) * std::tgamma(TF(1.)) / ( fast_pow(lambda_r, b_r<TF> + TF(3.)) * lambda_s ) );
+
+                // Tomita Eq. 43
+                TF P_sacr_g = (TF(1.) - delta_2) * P_sacr;
+                TF P_sacr_s = delta_2 * P_sacr;
+
+                // Tomita Eq. 49
+                const TF E_gs = std::min( TF(1.), std::exp(gamma_gacs<TF> * (T - T0<TF>)) );
+
+                // Tomita Eq. 47
+                TF P_gacr = !(has_graupel && has_rain) ? TF(0.) :
+                      pi<TF> * a_r<TF> * std::abs(V_Tg - V_Tr) * E_gr<TF> * N_0g<TF> * N_0r<TF> / (TF(4.)*rho[k])
+                    * (          std::tgamma(b_r<TF> + TF(1.)) * std::tgamma(TF(3.)) / ( fast_pow(lambda_r, b_r<TF> + TF(1.)) * pow3(lambda_g) )
+                      + TF(2.) * std::tgamma(b_r<TF> + TF(2.)) * std::tgamma(TF(2.)) / ( fast_pow(lambda_r, b_r<TF> + TF(2.)) * pow2(lambda_g) )
+                      +          std::tgamma(b_r<TF> + TF(3.)) * std::tgamma(TF(1.)) / ( fast_pow(lambda_r, b_r<TF> + TF(3.)) * lambda_g ) );
+
+                // Tomita Eq. 48
+                TF P_gacs = !(has_graupel && has_snow) ? TF(0.) :
+                      pi<TF> * a_s<TF> * std::abs(V_Tg - V_Ts) * E_gs * N_0g<TF> * N_0s<TF> / (TF(4.)*rho[k])
+                    * (          std::tgamma(b_s<TF> + TF(1.)) * std::tgamma(TF(3.)) / ( fast_pow(lambda_s, b_s<TF> + TF(1.)) * pow3(lambda_g) )
+                      + TF(2.) * std::tgamma(b_s<TF> + TF(2.)) * std::tgamma(TF(2.)) / ( fast_pow(lambda_s, b_s<TF> + TF(2.)) * pow2(lambda_g) )
+                      +          std::tgamma(b_s<TF> + TF(3.)) * std::tgamma(TF(1.)) / ( fast_pow(lambda_s, b_s<TF> + TF(3.)) * lambda_g ) );
+
+                // AUTOCONVERSION.
+                constexpr TF q_icrt = TF(0.);
+                constexpr TF q_scrt = TF(6.e-4);
+
+                // Tomita Eq. 53
+                const TF beta_1 = std::min( beta_saut<TF>, beta_saut<TF>*std::exp(gamma_saut<TF> * (T - T0<TF>)) );
+
+                // Tomita Eq. 54
+                const TF beta_2 = std::min( beta_gaut<TF>, beta_gaut<TF>*std::exp(gamma_gaut<TF> * (T - T0<TF>)) );
+
+                // Tomita Eq. 50. Our N_d is SI units, so conversion is applied.
+                TF P_raut = !(has_liq) ? TF(0.) :
+                    TF(16.7)/rho[k] * pow2(rho[k]*ql[ijk]) / (TF(5.) + TF(3.66e-2) * TF(1.e-6)*N_d / (D_d*rho[k]*ql[ijk]));
+
+                // // Kharoutdinov and Kogan autoconversion.
+                // TF P_raut = (has_liq) ?
+                //     TF(1350.)
+                //     * std::pow(ql[ijk], TF(2.47))
+                //     * std::pow(N_d * TF(1.e-6), TF(-1.79))
+                //     : TF(0.);
+
+                // Seifert and Beheng autoconversion.
+                // const TF x_star = TF(2.6e-10); // SB06, list of symbols, same as UCLA-LES
+                // const TF k_cc = TF(9.44e9); // UCLA-LES (Long, 1974), 4.44e9 in SB06, p48
+                // const TF nu_c = TF(1.); // SB06, Table 1., same as UCLA-LES
+                // const TF kccxs = k_cc / (TF(20.) * x_star) * (nu_c+2)*(nu_c+4) / pow2(nu_c+1);
+                // const TF xc  = rho[k] * ql[ijk] / N_d; // Mean mass of cloud drops [kg]
+                // const TF tau = TF(1.) - ql[ijk] / (ql[ijk] + qr[ijk] + dsmall); // SB06, Eq 5
+                // const TF phi_au = TF(600.) * std::pow(tau, TF(0.68)) * pow3(TF(1.) - pow(tau, TF(0.68))); // UCLA-LES
+
+                // TF P_raut = rho[k] * kccxs * pow(ql[ijk], 2) * pow(xc, 2) * (TF(1.) + phi_au / pow2(TF(1.)-tau)); // SB06, eq 4
+
+                // Tomita Eq. 52
+                TF P_saut = !(has_ice) ? TF(0.) :
+                    std::max(beta_1*(qi[ijk] - q_icrt), TF(0.));
+
+                // Tomita Eq. 54
+                TF P_gaut = !(has_snow) ? TF(0.) :
+                    std::max(beta_2*(qs[ijk] - q_scrt), TF(0.));
+
+                // PHASE CHANGES.
+                // Tomita Eq. 57
+                const TF G_w = TF(1.) / (
+                    Lv<TF> / (K_a<TF> * T) * (Lv<TF> / (Rv<TF> * T) - TF(1.))
+                    + Rv<TF>*T / (K_d<TF> * esat_liq(T)) );
+
+                // Tomita Eq. 62
+                const TF G_i = TF(1.) / (
+                    Ls<TF> / (K_a<TF> * T) * (Ls<TF> / (Rv<TF> * T) - TF(1.))
+                    + Rv<TF>*T / (K_d<TF> * esat_ice(T)) );
+
+                const TF S_w = (qt[ijk] - ql[ijk] - qi[ijk]) / qsat_liq(p[k], T);
+                const TF S_i = (qt[ijk] - ql[ijk] - qi[ijk]) / qsat_ice(p[k], T);
+
+                // Tomita Eq. 63
+                const TF delta_3 = TF(S_i <= TF(1.)); // Subsaturated, then delta_3 = 1.
+
+                // Tomita Eq. 59
+                TF P_revp = !(has_rain) ? TF(0.) :
+                    - TF(2.)*pi<TF> * N_0r<TF> * (std::min(S_w, TF(1.)) - TF(1.)) * G_w / rho[k]
+                    * ( f_1r<TF> * std::tgamma(TF(2.)) / pow2(lambda_r)
+                      + f_2r<TF> * std::sqrt(c_r<TF> * rho0_rho_sqrt / nu<TF>)
+                      * std::tgamma( TF(0.5) * (TF(5.) + d_r<TF>) )
+                      / fast_pow(lambda_r, TF(0.5) * (TF(5.) + d_r<TF>)) );
+
+                // Tomita Eq. 60. Negative for sublimation, positive for deposition.
+                const TF P_sdep_ssub = 
+                    TF(2.)*pi<TF> * N_0s<TF> * (S_i - TF(1.)) * G_i / rho[k]
+                    * ( f_1s<TF> * std::tgamma(TF(2.)) / pow2(lambda_s)
+                      + f_2s<TF> * std::sqrt(c_s<TF> * rho0_rho_sqrt / nu<TF>)
+                      * std::tgamma( TF(0.5) * (TF(5.) + d_s<TF>) )
+                      / fast_pow(lambda_s, TF(0.5) * (TF(5.) + d_s<TF>)) );
+
+                // Tomita Eq. 51
+                const TF P_gdep_gsub = 
+                    TF(2.)*pi<TF> * N_0g<TF> * (S_i - TF(1.)) * G_i / rho[k]
+                    * ( f_1g<TF> * std::tgamma(TF(2.)) / pow2(lambda_g)
+                      + f_2g<TF> * std::sqrt(c_g<TF> * rho0_rho_sqrt / nu<TF>)
+                      * std::tgamma( TF(0.5) * (TF(5.) + d_g<TF>) )
+                      / fast_pow(lambda_g, TF(0.5) * (TF(5.) + d_g<TF>)) );
+
+                // Tomita Eq. 64
+                TF P_sdep = !(has_vapor) ? TF(0.) :
+                    (TF(1.) - delta_3) * P_sdep_ssub;
+                TF P_gdep = !(has_vapor) ? TF(0.) :
+                    (TF(1.) - delta_3) * P_gdep_gsub;
+
+                // Tomita Eq. 65
+                // CvH: I swapped the sign with respect to Tomita, the term should be positive.
+                TF P_ssub = !(has_snow) ? TF(0.) :
+                    - delta_3 * P_sdep_ssub;
+                TF P_gsub = !(has_graupel) ? TF(0.) :
+                    - delta_3 * P_gdep_gsub;
+
+                // Freezing and melting
+                // Tomita Eq. 67, 68 combined.
+                TF P_smlt = !(has_snow) ? TF(0.) :
+                    TF(2.)*pi<TF> * K_a<TF> * (T - T0<TF>) * N_0s<TF> / (rho[k]*Lf<TF>)
+                    * ( f_1s<TF> * std::tgamma(TF(2.)) / pow2(lambda_s)
+                      + f_2s<TF> * std::sqrt(c_s<TF> * rho0_rho_sqrt / nu<TF>)
+                      * std::tgamma( TF(0.5) * (TF(5.) + d_s<TF>) )
+                      / fast_pow(lambda_s, TF(0.5) * (TF(5.) + d_s<TF>)) )
+                    + C_l<TF> * (T - T0<TF>) / Lf<TF> * (P_sacw + P_sacr);
+
+                // Tomita Eq. 69
+                TF P_gmlt = !(has_graupel) ? TF(0.) :
+                    TF(2.)*pi<TF> * K_a<TF> * (T - T0<TF>) * N_0g<TF> / (rho[k]*Lf<TF>)
+                    * ( f_1g<TF> * std::tgamma(TF(2.)) / pow2(lambda_g)
+                      + f_2g<TF> * std::sqrt(c_g<TF> * rho0_rho_sqrt / nu<TF>)
+                      * std::tgamma( TF(0.5) * (TF(5.) + d_g<TF>) )
+                      / fast_pow(lambda_g, TF(0.5) * (TF(5.) + d_g<TF>)) )
+                    + C_l<TF> * (T - T0<TF>) / Lf<TF> * (P_gacw + P_gacr);
+
+                // Tomita Eq. 70
+                constexpr TF A_prime = TF(0.66);
+                constexpr TF B_prime = TF(100.);
+
+                TF P_gfrz = !(has_rain) ? TF(0.) :
+                    TF(20.) * pi_2<TF> * B_prime * N_0r<TF> * rho_w<TF> / rho[k]
+                    * (std::exp(A_prime * (T0<TF> - T)) - TF(1.)) / pow7(lambda_r);
+
+                // COMPUTE THE TENDENCIES.
+                // Limit the production terms to avoid instability.
+                auto limit_tend = [&](TF& tend, const TF tend_limit)
+                {
+                    tend = std::max(TF(0.), std::min(tend, tend_limit));
+                };
+
+                const TF dqv_dt_max = qv      / dt;
+                const TF dqi_dt_max = qi[ijk] / dt;
+                const TF dql_dt_max = ql[ijk] / dt;
+                const TF dqr_dt_max = qr[ijk] / dt;
+                const TF dqs_dt_max = qs[ijk] / dt;
+                const TF dqg_dt_max = qg[ijk] / dt;
+
+                // Limit on the availability of the source.
+                // Limit accretion terms.
+                limit_tend(P_iacr_s, dqr_dt_max);
+                limit_tend(P_iacr_g, dqr_dt_max);
+                limit_tend(P_raci_s, dqi_dt_max);
+                limit_tend(P_raci_g, dqi_dt_max);
+                limit_tend(P_racw  , dql_dt_max);
+                limit_tend(P_sacw  , dql_dt_max);
+                limit_tend(P_saci  , dqi_dt_max);
+                limit_tend(P_gacw  , dql_dt_max);
+                limit_tend(P_gaci  , dqi_dt_max);
+                limit_tend(P_racs  , dqs_dt_max);
+                limit_tend(P_sacr_s, dqr_dt_max);
+                limit_tend(P_sacr_g, dqr_dt_max);
+                limit_tend(P_gacr  , dqr_dt_max);
+                limit_tend(P_gacs  , dqs_dt_max);
+
+                // Limit autoconversion terms.
+                limit_tend(P_raut, dql_dt_max);
+                limit_tend(P_saut, dqi_dt_max);
+                limit_tend(P_gaut, dqs_dt_max);
+
+                // Limit phase changes.
+                limit_tend(P_revp, dqr_dt_max);
+                limit_tend(P_sdep, dqv_dt_max);
+                limit_tend(P_ssub, dqs_dt_max);
+                limit_tend(P_gdep, dqv_dt_max);
+                limit_tend(P_gsub, dqg_dt_max);
+                limit_tend(P_smlt, dqs_dt_max);
+                limit_tend(P_gmlt, dqg_dt_max);
+                limit_tend(P_gfrz, dqr_dt_max);
+
+                // P_iacr_s = 0;
+                // P_iacr_g = 0;
+                // P_raci_s = 0;
+                // P_raci_g = 0;
+                // P_racw   = 0;
+                // P_sacw   = 0;
+                // P_saci   = 0;
+                // P_gacw   = 0;
+                // P_gaci   = 0;
+                // P_racs   = 0;
+                // P_sacr_s = 0;
+                // P_sacr_g = 0;
+                // P_gacr   = 0;
+                // P_gacs   = 0;
+
+                // P_raut = 0;
+                // P_saut = 0;
+                // P_gaut = 0;
+
+                // P_revp = 0;
+                // P_sdep = 0;
+                // P_ssub = 0;
+                // P_gdep = 0;
+                // P_gsub = 0;
+                // P_smlt = 0;
+                // P_gmlt = 0;
+                // P_gfrz = 0;
+
+                TF vapor_to_snow = P_sdep;
+                TF vapor_to_graupel = P_gdep;
+
+                TF cloud_to_rain = P_racw + P_sacw * T_pos + P_raut;
+                TF cloud_to_graupel = P_gacw;
+                TF cloud_to_snow = P_sacw * T_neg;
+
+                TF rain_to_vapor = P_revp;
+                TF rain_to_graupel = P_gacr + P_iacr_g + P_sacr_g * T_neg + P_gfrz * T_neg;
+                TF rain_to_snow = P_sacr_s * T_neg + P_iacr_s;
+
+                TF ice_to_snow = P_raci_s + P_saci + P_saut;
+                TF ice_to_graupel = P_raci_g + P_gaci;
+
+                TF snow_to_graupel = P_gacs + P_racs + P_gaut;
+                TF snow_to_rain = P_smlt;
+                TF snow_to_vapor = P_ssub;
+
+                TF graupel_to_rain = P_gmlt * T_pos;
+                TF graupel_to_vapor = P_gsub;
+
+                const TF dqv_dt =
+                    - vapor_to_snow - vapor_to_graupel;
+
+                const TF dql_dt =
+                    - cloud_to_rain - cloud_to_graupel - cloud_to_snow;
+
+                const TF dqi_dt =
+                    - ice_to_snow - ice_to_graupel;
+
+                const TF dqr_dt =
+                    + cloud_to_rain + snow_to_rain + graupel_to_rain
+                    - rain_to_vapor - rain_to_graupel - rain_to_snow;
+
+                const TF dqs_dt =
+                    + cloud_to_snow + ice_to_snow + vapor_to_snow
+                    - snow_to_graupel - snow_to_vapor - snow_to_rain;
+
+                const TF dqg_dt =
+                    + cloud_to_graupel + rain_to_graupel + ice_to_graupel
+                    + vapor_to_graupel + snow_to_graupel
+                    - graupel_to_rain - graupel_to_vapor;
+
+                // Limit the production terms to avoid instability.
+                auto limit_factor = [](const TF tend, const TF tend_limit)
+                {
+                    return (tend < TF(0.)) ? std::min(-tend_limit/tend, TF(1.)) : TF(1.);
+                };
+
+                const TF dqv_dt_fac = limit_factor(dqv_dt, dqv_dt_max);
+                const TF dql_dt_fac = limit_factor(dql_dt, dql_dt_max);
+                const TF dqi_dt_fac = limit_factor(dqi_dt, dqi_dt_max);
+                const TF dqr_dt_fac = limit_factor(dqr_dt, dqr_dt_max);
+                const TF dqs_dt_fac = limit_factor(dqs_dt, dqs_dt_max);
+                const TF dqg_dt_fac = limit_factor(dqg_dt, dqg_dt_max);
+
+                vapor_to_snow    *= dqv_dt_fac * dqs_dt_fac;
+                vapor_to_graupel *= dqv_dt_fac * dqg_dt_fac;
+
+                cloud_to_rain    *= dql_dt_fac * dqr_dt_fac;
+                cloud_to_graupel *= dql_dt_fac * dqg_dt_fac;
+                cloud_to_snow    *= dql_dt_fac * dqs_dt_fac;
+
+                rain_to_vapor    *= dqr_dt_fac * dqv_dt_fac;
+                rain_to_graupel  *= dqr_dt_fac * dqg_dt_fac;
+                rain_to_snow     *= dqr_dt_fac * dqs_dt_fac;
+
+                ice_to_snow      *= dqi_dt_fac * dqs_dt_fac;
+                ice_to_graupel   *= dqi_dt_fac * dqg_dt_fac;
+
+                snow_to_graupel  *= dqs_dt_fac * dqg_dt_fac;
+                snow_to_vapor    *= dqs_dt_fac * dqv_dt_fac;
+                snow_to_rain     *= dqs_dt_fac * dqr_dt_fac;
+
+                graupel_to_rain  *= dqg_dt_fac * dqr_dt_fac;
+                graupel_to_vapor *= dqg_dt_fac * dqv_dt_fac;
+
+                // Loss from cloud.
+                qtt[ijk] -= cloud_to_rain;
+                qrt[ijk] += cloud_to_rain;
+                thlt[ijk] += Lv<TF> / (cp<TF> * exner[k]) * cloud_to_rain;
+
+                qtt[ijk] -= cloud_to_graupel;
+                qgt[ijk] += cloud_to_graupel;
+                thlt[ijk] += Ls<TF> / (cp<TF> * exner[k]) * cloud_to_graupel;
+
+                qtt[ijk] -= cloud_to_snow;
+                qst[ijk] += cloud_to_snow;
+                thlt[ijk] += Ls<TF> / (cp<TF> * exner[k]) * cloud_to_snow;
+
+                // Loss from rain.
+                qrt[ijk] -= rain_to_vapor;
+                qtt[ijk] += rain_to_vapor;
+                thlt[ijk] -= Lv<TF> / (cp<TF> * exner[k]) * rain_to_vapor;
+
+                qrt[ijk] -= rain_to_graupel;
+                qgt[ijk] += rain_to_graupel;
+                thlt[ijk] += Lf<TF> / (cp<TF> * exner[k]) * rain_to_graupel;
+
+                qrt[ijk] -= rain_to_snow;
+                qst[ijk] += rain_to_snow;
+                thlt[ijk] += Lf<TF> / (cp<TF> * exner[k]) * rain_to_snow;
+
+                // Loss from ice.
+                qtt[ijk] -= ice_to_snow;
+                qst[ijk] += ice_to_snow;
+                thlt[ijk] += Ls<TF> / (cp<TF> * exner[k]) * ice_to_snow;
+
+                qtt[ijk] -= ice_to_graupel;
+                qgt[ijk] += ice_to_graupel;
+                thlt[ijk] += Ls<TF> / (cp<TF> * exner[k]) * ice_to_graupel;
+
+                // Loss from snow.
+                qst[ijk] -= snow_to_graupel;
+                qgt[ijk] += snow_to_graupel;
+
+                qst[ijk] -= snow_to_vapor;
+                qtt[ijk] += snow_to_vapor;
+                thlt[ijk] -= Ls<TF> / (cp<TF> * exner[k]) * snow_to_vapor;
+
+                qst[ijk] -= snow_to_rain;
+                qrt[ijk] += snow_to_rain;
+                thlt[ijk] -= Lf<TF> / (cp<TF> * exner[k]) * snow_to_rain;
+
+                // Loss from graupel.
+                qgt[ijk] -= graupel_to_rain;
+                qrt[ijk] += graupel_to_rain;
+                thlt[ijk] -= Lf<TF> / (cp<TF> * exner[k]) * graupel_to_rain;
+
+                qgt[ijk] -= graupel_to_vapor;
+                qtt[ijk] += graupel_to_vapor;
+                thlt[ijk] -= Ls<TF> / (cp<TF> * exner[k]) * graupel_to_vapor;
+            }
         }
     }
 
@@ -695,12 +742,13 @@ namespace
             const TF qc_min,
             const int istart, const int jstart, const int kstart,
             const int iend, const int jend, const int kend,
-            const int jj, const int kk)
+            const int jj, const int kk, const int n_threads)
     {
         constexpr TF V_Tmin = TF(0.1);
         constexpr TF V_Tmax = TF(10.);
 
         // 1. Calculate sedimentation velocity at cell center
+        #pragma omp parallel for num_threads(n_threads)
         for (int k=kstart; k<kend; ++k)
         {
             const TF rho0_rho_sqrt = std::sqrt(rho[kstart]/rho[k]);
@@ -744,6 +792,7 @@ namespace
             }
 
         // 2. Calculate CFL number using interpolated sedimentation velocity
+        #pragma omp parallel for num_threads(n_threads)
         for (int k=kstart; k<kend; ++k)
             for (int j=jstart; j<jend; ++j)
                 #pragma ivdep
@@ -754,6 +803,7 @@ namespace
                 }
 
         // 3. Calculate slopes
+        #pragma omp parallel for num_threads(n_threads)
         for (int k=kstart; k<kend; ++k)
             for (int j=jstart; j<jend; ++j)
                 #pragma ivdep
@@ -772,8 +822,10 @@ namespace
                 flux_qc[ijk] = TF(0.);
             }
 
-        for (int k=kend-1; k>kstart-1; --k)
-            for (int j=jstart; j<jend; ++j)
+        // The flux at each level depends on the one above, so columns are independent but levels are not.
+        #pragma omp parallel for num_threads(n_threads)
+        for (int j=jstart; j<jend; ++j)
+            for (int k=kend-1; k>kstart-1; --k)
                 #pragma ivdep
                 for (int i=istart; i<iend; ++i)
                 {
@@ -801,6 +853,7 @@ namespace
                 }
 
         // Calculate tendency
+        #pragma omp parallel for num_threads(n_threads)
         for (int k=kstart; k<kend; ++k)
             for (int j=jstart; j<jend; ++j)
                 #pragma ivdep
@@ -898,6 +951,95 @@ namespace
 
         return cfl_max;
     }
+
+    // Sedimentation from Stevens and Seifert (2008), sub-cycled such that the CFL number of each
+    // sub-step stays below cfl_max. The field is advanced over the sub-steps in qc_s, and the mean
+    // tendency and surface flux over the sub-steps are added to qct and rc_bot.
+    template<typename TF>
+    void sedimentation_ss08_subcycled(
+            TF* const restrict qct, TF* const restrict rc_bot,
+            TF* const restrict w_qc, TF* const restrict c_qc,
+            TF* const restrict slope_qc, TF* const restrict flux_qc,
+            TF* const restrict qc_s, TF* const restrict qct_s, TF* const restrict rc_s,
+            const TF* const restrict qc,
+            const TF* const restrict rho,
+            const TF* const restrict dzi, const TF* const restrict dz,
+            const double dt, const double cfl_max,
+            const TF a_c, const TF b_c, const TF c_c, const TF d_c, const TF N_0c,
+            const TF qc_min,
+            const int istart, const int jstart, const int kstart,
+            const int iend, const int jend, const int kend,
+            const int jj, const int kk, const int n_threads)
+    {
+        const double cfl = calc_cfl_ss08(
+                w_qc, qc, rho, dzi, dz, dt,
+                a_c, b_c, c_c, d_c, N_0c, qc_min,
+                istart, jstart, kstart, iend, jend, kend, jj, kk);
+
+        const int n_sub = std::max(1, static_cast<int>(std::ceil(cfl / cfl_max)));
+
+        if (n_sub == 1)
+        {
+            sedimentation_ss08(
+                    qct, rc_bot, w_qc, c_qc, slope_qc, flux_qc,
+                    qc, rho, dzi, dz, dt,
+                    a_c, b_c, c_c, d_c, N_0c, qc_min,
+                    istart, jstart, kstart, iend, jend, kend, jj, kk, n_threads);
+            return;
+        }
+
+        const double dt_sub = dt / n_sub;
+        const TF f_sub = TF(1.) / n_sub;
+
+        // Copy the field, including the ghost levels which enter the slopes.
+        #pragma omp parallel for num_threads(n_threads)
+        for (int k=kstart-1; k<kend+1; ++k)
+            for (int j=jstart; j<jend; ++j)
+                #pragma ivdep
+                for (int i=istart; i<iend; ++i)
+                {
+                    const int ijk = i + j*jj + k*kk;
+                    qc_s[ijk] = qc[ijk];
+                }
+
+        for (int j=jstart; j<jend; ++j)
+            for (int i=istart; i<iend; ++i)
+                rc_bot[i + j*jj] = TF(0.);
+
+        for (int n=0; n<n_sub; ++n)
+        {
+            #pragma omp parallel for num_threads(n_threads)
+            for (int k=kstart; k<kend; ++k)
+                for (int j=jstart; j<jend; ++j)
+                    #pragma ivdep
+                    for (int i=istart; i<iend; ++i)
+                    {
+                        const int ijk = i + j*jj + k*kk;
+                        qct_s[ijk] = TF(0.);
+                    }
+
+            sedimentation_ss08(
+                    qct_s, rc_s, w_qc, c_qc, slope_qc, flux_qc,
+                    qc_s, rho, dzi, dz, dt_sub,
+                    a_c, b_c, c_c, d_c, N_0c, qc_min,
+                    istart, jstart, kstart, iend, jend, kend, jj, kk, n_threads);
+
+            #pragma omp parallel for num_threads(n_threads)
+            for (int k=kstart; k<kend; ++k)
+                for (int j=jstart; j<jend; ++j)
+                    #pragma ivdep
+                    for (int i=istart; i<iend; ++i)
+                    {
+                        const int ijk = i + j*jj + k*kk;
+                        qc_s[ijk] += qct_s[ijk] * TF(dt_sub);
+                        qct[ijk] += f_sub * qct_s[ijk];
+                    }
+
+            for (int j=jstart; j<jend; ++j)
+                for (int i=istart; i<iend; ++i)
+                    rc_bot[i + j*jj] += f_sub * rc_s[i + j*jj];
+        }
+    }
 }
 
 template<typename TF>
@@ -910,6 +1052,10 @@ Microphys_nsw6<TF>::Microphys_nsw6(Master& masterin, Grid<TF>& gridin, Fields<TF
     // Read microphysics switches and settings
     // swmicrobudget = inputin.get_item<bool>("micro", "swmicrobudget", "", false);
     cfl_max = inputin.get_item<TF>("micro", "cflmax", "", 1.2);
+    n_threads = inputin.get_item<int>("micro", "n_threads", "", 1);
+    if (n_threads < 1)
+        throw std::runtime_error("n_threads must be at least 1");
+    swsedsubcycle = inputin.get_item<bool>("micro", "swsedsubcycle", "", true);
 
     N_d = inputin.get_item<TF>("micro", "Nd", "", 100.e6); // CvH: 50 cm-3 do we need conversion, or do we stick with Tomita?
 
@@ -939,6 +1085,7 @@ void Microphys_nsw6<TF>::init()
     rr_bot.resize(gd.ijcells);
     rs_bot.resize(gd.ijcells);
     rg_bot.resize(gd.ijcells);
+    rc_sub.resize(gd.ijcells);
 }
 
 template<typename TF>
@@ -985,6 +1132,16 @@ void Microphys_nsw6<TF>::exec(Thermo<TF>& thermo, const double dt, Stats<TF>& st
     const std::vector<TF>& p = thermo.get_p_vector();
     const std::vector<TF>& exner = thermo.get_exner_vector();
 
+    // Only cells with condensate contribute to the conversion terms.
+    int n_precip[3];
+    build_active_cells(
+            active_cells, active_offset, n_precip,
+            ql->fld.data(), qi->fld.data(),
+            fields.sp.at("qr")->fld.data(), fields.sp.at("qs")->fld.data(), fields.sp.at("qg")->fld.data(),
+            gd.istart, gd.jstart, gd.kstart,
+            gd.iend, gd.jend, gd.kend,
+            gd.icells, gd.ijcells);
+
     conversion(
             fields.st.at("qr")->fld.data(), fields.st.at("qs")->fld.data(), fields.st.at("qg")->fld.data(),
             fields.st.at("qt")->fld.data(), fields.st.at("thl")->fld.data(),
@@ -994,9 +1151,8 @@ void Microphys_nsw6<TF>::exec(Thermo<TF>& thermo, const double dt, Stats<TF>& st
             fields.rhoref.data(), exner.data(), p.data(),
             gd.dzi.data(), gd.dzhi.data(),
             this->N_d, TF(dt),
-            gd.istart, gd.jstart, gd.kstart,
-            gd.iend, gd.jend, gd.kend,
-            gd.icells, gd.ijcells);
+            active_cells.data(), active_offset.data(),
+            gd.kstart, gd.kend);
 
     fields.release_tmp(ql);
     fields.release_tmp(qi);
@@ -1005,56 +1161,114 @@ void Microphys_nsw6<TF>::exec(Thermo<TF>& thermo, const double dt, Stats<TF>& st
     auto tmp2 = fields.get_tmp();
     auto tmp3 = fields.get_tmp();
     auto tmp4 = fields.get_tmp();
-
-    // Falling rain.
-    sedimentation_ss08(
-            fields.st.at("qr")->fld.data(), rr_bot.data(),
-            tmp1->fld.data(), tmp2->fld.data(),
-            tmp3->fld.data(), tmp4->fld.data(),
-            fields.sp.at("qr")->fld.data(),
-            fields.rhoref.data(),
-            gd.dzi.data(), gd.dz.data(),
-            dt,
-            a_r<TF>, b_r<TF>, c_r<TF>, d_r<TF>, N_0r<TF>,
-            qr_min<TF>,
-            gd.istart, gd.jstart, gd.kstart,
-            gd.iend, gd.jend, gd.kend,
-            gd.icells, gd.ijcells);
-
-    // Falling snow.
-    sedimentation_ss08(
-            fields.st.at("qs")->fld.data(), rs_bot.data(),
-            tmp1->fld.data(), tmp2->fld.data(),
-            tmp3->fld.data(), tmp4->fld.data(),
-            fields.sp.at("qs")->fld.data(),
-            fields.rhoref.data(),
-            gd.dzi.data(), gd.dz.data(),
-            dt,
-            a_s<TF>, b_s<TF>, c_s<TF>, d_s<TF>, N_0s<TF>,
-            qs_min<TF>,
-            gd.istart, gd.jstart, gd.kstart,
-            gd.iend, gd.jend, gd.kend,
-            gd.icells, gd.ijcells);
-
-    // Falling graupel.
-    sedimentation_ss08(
-            fields.st.at("qg")->fld.data(), rg_bot.data(),
-            tmp1->fld.data(), tmp2->fld.data(),
-            tmp3->fld.data(), tmp4->fld.data(),
-            fields.sp.at("qg")->fld.data(),
-            fields.rhoref.data(),
-            gd.dzi.data(), gd.dz.data(),
-            dt,
-            a_g<TF>, b_g<TF>, c_g<TF>, d_g<TF>, N_0g<TF>,
-            qg_min<TF>,
-            gd.istart, gd.jstart, gd.kstart,
-            gd.iend, gd.jend, gd.kend,
-            gd.icells, gd.ijcells);
+    auto tmp5 = fields.get_tmp();
+    auto tmp6 = fields.get_tmp();
+
+    // Falling rain, without any rain the fluxes are zero.
+    if (n_precip[0] == 0)
+        std::fill(rr_bot.begin(), rr_bot.end(), TF(0.));
+    else if (swsedsubcycle)
+        sedimentation_ss08_subcycled(
+                fields.st.at("qr")->fld.data(), rr_bot.data(),
+                tmp1->fld.data(), tmp2->fld.data(),
+                tmp3->fld.data(), tmp4->fld.data(),
+                tmp5->fld.data(), tmp6->fld.data(), rc_sub.data(),
+                fields.sp.at("qr")->fld.data(),
+                fields.rhoref.data(),
+                gd.dzi.data(), gd.dz.data(),
+                dt, cfl_max,
+                a_r<TF>, b_r<TF>, c_r<TF>, d_r<TF>, N_0r<TF>,
+                qr_min<TF>,
+                gd.istart, gd.jstart, gd.kstart,
+                gd.iend, gd.jend, gd.kend,
+                gd.icells, gd.ijcells, n_threads);
+    else
+        sedimentation_ss08(
+                fields.st.at("qr")->fld.data(), rr_bot.data(),
+                tmp1->fld.data(), tmp2->fld.data(),
+                tmp3->fld.data(), tmp4->fld.data(),
+                fields.sp.at("qr")->fld.data(),
+                fields.rhoref.data(),
+                gd.dzi.data(), gd.dz.data(),
+                dt,
+                a_r<TF>, b_r<TF>, c_r<TF>, d_r<TF>, N_0r<TF>,
+                qr_min<TF>,
+                gd.istart, gd.jstart, gd.kstart,
+                gd.iend, gd.jend, gd.kend,
+                gd.icells, gd.ijcells, n_threads);
+
+    // Falling snow, without any snow the fluxes are zero.
+    if (n_precip[1] == 0)
+        std::fill(rs_bot.begin(), rs_bot.end(), TF(0.));
+    else if (swsedsubcycle)
+        sedimentation_ss08_subcycled(
+                fields.st.at("qs")->fld.data(), rs_bot.data(),
+                tmp1->fld.data(), tmp2->fld.data(),
+                tmp3->fld.data(), tmp4->fld.data(),
+                tmp5->fld.data(), tmp6->fld.data(), rc_sub.data(),
+                fields.sp.at("qs")->fld.data(),
+                fields.rhoref.data(),
+                gd.dzi.data(), gd.dz.data(),
+                dt, cfl_max,
+                a_s<TF>, b_s<TF>, c_s<TF>, d_s<TF>, N_0s<TF>,
+                qs_min<TF>,
+                gd.istart, gd.jstart, gd.kstart,
+                gd.iend, gd.jend, gd.kend,
+                gd.icells, gd.ijcells, n_threads);
+    else
+        sedimentation_ss08(
+                fields.st.at("qs")->fld.data(), rs_bot.data(),
+                tmp1->fld.data(), tmp2->fld.data(),
+                tmp3->fld.data(), tmp4->fld.data(),
+                fields.sp.at("qs")->fld.data(),
+                fields.rhoref.data(),
+                gd.dzi.data(), gd.dz.data(),
+                dt,
+                a_s<TF>, b_s<TF>, c_s<TF>, d_s<TF>, N_0s<TF>,
+                qs_min<TF>,
+                gd.istart, gd.jstart, gd.kstart,
+                gd.iend, gd.jend, gd.kend,
+                gd.icells, gd.ijcells, n_threads);
+
+    // Falling graupel, without any graupel the fluxes are zero.
+    if (n_precip[2] == 0)
+        std::fill(rg_bot.begin(), rg_bot.end(), TF(0.));
+    else if (swsedsubcycle)
+        sedimentation_ss08_subcycled(
+                fields.st.at("qg")->fld.data(), rg_bot.data(),
+                tmp1->fld.data(), tmp2->fld.data(),
+                tmp3->fld.data(), tmp4->fld.data(),
+                tmp5->fld.data(), tmp6->fld.data(), rc_sub.data(),
+                fields.sp.at("qg")->fld.data(),
+                fields.rhoref.data(),
+                gd.dzi.data(), gd.dz.data(),
+                dt, cfl_max,
+                a_g<TF>, b_g<TF>, c_g<TF>, d_g<TF>, N_0g<TF>,
+                qg_min<TF>,
+                gd.istart, gd.jstart, gd.kstart,
+                gd.iend, gd.jend, gd.kend,
+                gd.icells, gd.ijcells, n_threads);
+    else
+        sedimentation_ss08(
+                fields.st.at("qg")->fld.data(), rg_bot.data(),
+                tmp1->fld.data(), tmp2->fld.data(),
+                tmp3->fld.data(), tmp4->fld.data(),
+                fields.sp.at("qg")->fld.data(),
+                fields.rhoref.data(),
+                gd.dzi.data(), gd.dz.data(),
+                dt,
+                a_g<TF>, b_g<TF>, c_g<TF>, d_g<TF>, N_0g<TF>,
+                qg_min<TF>,
+                gd.istart, gd.jstart, gd.kstart,
+                gd.iend, gd.jend, gd.kend,
+                gd.icells, gd.ijcells, n_threads);
 
     fields.release_tmp(tmp1);
     fields.release_tmp(tmp2);
     fields.release_tmp(tmp3);
     fields.release_tmp(tmp4);
+    fields.release_tmp(tmp5);
+    fields.release_tmp(tmp6);
 
     stats.calc_tend(*fields.st.at("thl"), tend_name);
     stats.calc_tend(*fields.st.at("qt" ), tend_name);
@@ -1097,6 +1311,10 @@ void Microphys_nsw6<TF>::exec_cross(Cross<TF>& cross, unsigned long iotime)
 template<typename TF>
 unsigned long Microphys_nsw6<TF>::get_time_limit(unsigned long idt, const double dt)
 {
+    // With sub-cycled sedimentation the fall speeds do not limit the model time step.
+    if (swsedsubcycle)
+        return Constants::ulhuge;
+
     auto& gd = grid.get_grid_data();
 
     auto tmp = fields.get_tmp();
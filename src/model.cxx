@@ -53,6 +53,10 @@
 #include "dump.h"
 #include "model.h"
 
+#ifdef USEMPI
+#include "comm_plan.h"
+#endif
+
 #ifdef USECUDA
 #include <cuda_runtime_api.h>
 #endif
@@ -107,6 +111,11 @@ Model<TF>::Model(Master& masterin, int argc, char *argv[]) :
     process_command_line_options(sim_mode, sim_name, argc, argv, master);
 
     input = std::make_shared<Input>(master, sim_name + ".ini");
+
+    // Set up the processes before the first file is opened, as the radiation server
+    // processes read their input over their own communicator.
+    master.init(*input);
+
     input_nc = std::make_shared<Netcdf_file>(master, sim_name + "_input.nc", Netcdf_mode::Read);
 
     try
@@ -168,7 +177,16 @@ Model<TF>::~Model()
 template<typename TF>
 void Model<TF>::init()
 {
-    master.init(*input);
+    // The radiation server processes only need the grid and the radiation.
+    if (master.get_MPI_data().rad_server)
+    {
+        if (radiation->get_switch() != "rrtmgp")
+            throw std::runtime_error("Radiation server processes require rrtmgp radiation");
+
+        grid->init();
+        radiation->init(*timeloop);
+        return;
+    }
 
     grid->init();
     fields->init(*input, *dump, *cross, sim_mode);
@@ -196,6 +214,18 @@ void Model<TF>::init()
 template<typename TF>
 void Model<TF>::load_or_save()
 {
+    if (master.get_MPI_data().rad_server)
+    {
+        if (sim_mode != Sim_mode::Init)
+        {
+            grid->load();
+            radiation->create_server(*input, *input_nc);
+        }
+
+        input.reset();
+        return;
+    }
+
     if (sim_mode == Sim_mode::Init)
     {
         // Initialize the allocated fields and save the data.
@@ -291,6 +321,13 @@ void Model<TF>::exec()
     if (sim_mode == Sim_mode::Init)
         return;
 
+    // The radiation server processes serve the model processes until these are finished.
+    if (master.get_MPI_data().rad_server)
+    {
+        radiation->exec_server();
+        return;
+    }
+
     #ifdef USECUDA
     prepare_gpu();
     #endif
@@ -380,6 +417,9 @@ void Model<TF>::exec()
                 // Apply the limiter as the last tendency.
                 limiter->exec(timeloop->get_sub_time_step(), *stats);
 
+                // Keep the cells that are skipped inside the immersed boundary at their values.
+                ib->freeze_skipped_cells();
+
                 // Calculate the total tendency statistics, if necessary
                 for (auto& it: fields->at)
                     stats->calc_tend(*it.second, "total");
@@ -495,6 +535,13 @@ void Model<TF>::exec()
 
     clear_gpu();
     #endif
+
+    #ifdef USEMPI
+    // Report the traffic of the persistent halo exchanges and transposes of all processes.
+    double comm_totals[2] = {Comm_plan::get_total_messages(), Comm_plan::get_total_bytes()};
+    master.sum(comm_totals, 2);
+    master.print_message("Persistent communication: %.0f messages, %.3f GB\n", comm_totals[0], comm_totals[1]*1.e-9);
+    #endif
 }
 
 #ifdef USECUDA
@@ -541,10 +588,7 @@ void Model<TF>::calculate_statistics(int iteration, double time, unsigned long i
     // Do the statistics.
     if (stats->do_statistics(itime))
     {
-        // Calculate statistics
-        if (!stats->do_tendency())
-            calc_masks();
-
+        // The masks of this step have been computed in setup_stats().
         fields   ->exec_stats(*stats);
         thermo   ->exec_stats(*stats);
         microphys->exec_stats(*stats, *thermo, dt);
@@ -602,33 +646,11 @@ void Model<TF>::setup_stats()
         }
         #endif
 
-        // Prepare all the masks.
-        const std::vector<std::string>& mask_list = stats->get_mask_list();
+        // Prepare all the masks once, they are shared by the tendency and state statistics.
+        calc_masks();
 
-        stats->initialize_masks();
-        for (auto& mask_name : mask_list)
-        {
-            // Get the mask from one of the mask providing classes
-            if (fields->has_mask(mask_name))
-                fields->get_mask(*stats, mask_name);
-            else if (thermo->has_mask(mask_name))
-                thermo->get_mask(*stats, mask_name);
-            else if (microphys->has_mask(mask_name))
-                microphys->get_mask(*stats, mask_name);
-            else if (decay->has_mask(mask_name))
-                decay->get_mask(*stats, mask_name);
-            else if (ib->has_mask(mask_name))
-                ib->get_mask(*stats, mask_name);
-            else
-            {
-                std::string error_message = "Can not calculate mask for \"" + mask_name + "\"";
-                throw std::runtime_error(error_message);
-            }
-        }
-        stats->finalize_masks();
         if (stats->do_tendency())
         {
-            calc_masks();
             cpu_up_to_date = false;
             stats->set_tendency(true);
         }
@@ -176,9 +176,9 @@ void Pres_2<TF>::input(TF* const restrict p,
     const int jgc = gd.jgc;
     const int kgc = gd.kgc;
 
-    // set the cyclic boundary conditions for the tendencies
-    boundary_cyclic.exec(ut, Edge::East_west_edge  );
-    boundary_cyclic.exec(vt, Edge::North_south_edge);
+    // set the cyclic boundary conditions for the tendencies, the divergence needs one ghost cell
+    boundary_cyclic.exec(ut, Edge::East_west_edge  , 1, 1);
+    boundary_cyclic.exec(vt, Edge::North_south_edge, 1, 1);
 
     // write pressure as a 3d array without ghost cells
     for (int k=0; k<gd.kmax; ++k)
@@ -357,8 +357,8 @@ void Pres_2<TF>::solve(TF* const restrict p, TF* const restrict work3d, TF* cons
             p[ijk-kkp] = p[ijk];
         }
 
-    // set the cyclic boundary conditions
-    boundary_cyclic.exec(p);
+    // set the cyclic boundary conditions, the pressure gradient needs one ghost cell
+    boundary_cyclic.exec(p, Edge::Both_edges, 1, 1);
 }
 
 template<typename TF>
@@ -281,10 +281,10 @@ void Pres_4<TF>::input(
 
     const int kmax = gd.kmax;
 
-    // Set the cyclic boundary conditions for the tendencies.
-    boundary_cyclic.exec(ut, Edge::East_west_edge);
+    // Set the cyclic boundary conditions for the tendencies, the divergence needs two ghost cells.
+    boundary_cyclic.exec(ut, Edge::East_west_edge, 2, 2);
     if (dim3)
-        boundary_cyclic.exec(vt, Edge::North_south_edge);
+        boundary_cyclic.exec(vt, Edge::North_south_edge, 2, 2);
 
     // Set the bc.
     for (int j=0; j<gd.jmax; j++)
@@ -524,8 +524,8 @@ void Pres_4<TF>::solve(
             p[ijk+kkp2] = p[ijk-kkp1];
         }
 
-    // Set the cyclic boundary conditions.
-    boundary_cyclic.exec(p);
+    // Set the cyclic boundary conditions, the pressure gradient needs two ghost cells.
+    boundary_cyclic.exec(p, Edge::Both_edges, 2, 2);
 }
 
 template<typename TF>
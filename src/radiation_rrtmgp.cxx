@@ -22,6 +22,9 @@
 #include <numeric>
 #include <string>
 #include <cmath>
+#include <limits>
+#include <cstdint>
+#include <chrono>
 
 #include "radiation_rrtmgp.h"
 #include "master.h"
@@ -32,6 +35,7 @@
 #include "netcdf_interface.h"
 #include "stats.h"
 #include "cross.h"
+#include "column.h"
 #include "constants.h"
 #include "timeloop.h"
 
@@ -396,6 +400,23 @@ namespace
                 }
     }
 
+    template<typename TF>
+    void add_tendency_extrap(
+            TF* restrict thlt, const TF* restrict thlt_rad, const TF* restrict thlt_rad_prev,
+            const TF fac,
+            const int istart, const int iend, const int jstart, const int jend, const int kstart, const int kend,
+            const int jj, const int kk)
+    {
+        for (int k=kstart; k<kend; ++k)
+            for (int j=jstart; j<jend; ++j)
+                #pragma ivdep
+                for (int i=istart; i<iend; ++i)
+                {
+                    const int ijk = i + j*jj + k*kk;
+                    thlt[ijk] += thlt_rad[ijk] + fac*(thlt_rad[ijk] - thlt_rad_prev[ijk]);
+                }
+    }
+
     template<typename TF>
     void solve_longwave_column(
             std::unique_ptr<Optical_props_arry<TF>>& optical_props,
@@ -572,6 +593,292 @@ namespace
                 flux_net   ({icol, ilev}) = fluxes->get_flux_net   ()({icol, ilev});
             }
     }
+
+    // Counter-based random number in [0,1). It only depends on its keys, so the result does not
+    // depend on the domain decomposition, the threading or the order of evaluation.
+    inline double random_uniform(
+            const unsigned long seed, const unsigned long itime,
+            const unsigned long id, const unsigned long counter)
+    {
+        auto splitmix64 = [](uint64_t z)
+        {
+            z += 0x9e3779b97f4a7c15ULL;
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+            return z ^ (z >> 31);
+        };
+
+        uint64_t x = splitmix64(seed);
+        x = splitmix64(x ^ itime);
+        x = splitmix64(x ^ id);
+        x = splitmix64(x ^ counter);
+
+        return std::ldexp(static_cast<double>(x >> 11), -53);
+    }
+
+    // Stream numbers to draw independent random numbers for the same column.
+    constexpr unsigned long stream_col = 0;
+    constexpr unsigned long stream_lw  = 1;
+    constexpr unsigned long stream_sw  = 2;
+
+    // Select for each column a random subset of g-points without replacement.
+    void select_gpoints(
+            Array<int,2>& gpt_sel, const unsigned long* const col_id,
+            const int n_gpt, const unsigned long seed, const unsigned long itime, const unsigned long stream)
+    {
+        const int n_col = gpt_sel.dim(1);
+        const int n_sel = gpt_sel.dim(2);
+
+        std::vector<int> gpts(n_gpt);
+
+        for (int icol=1; icol<=n_col; ++icol)
+        {
+            std::iota(gpts.begin(), gpts.end(), 1);
+
+            // Partial Fisher-Yates shuffle.
+            for (int isel=0; isel<n_sel; ++isel)
+            {
+                const double r = random_uniform(seed, itime, col_id[icol-1], (stream << 32) + isel);
+                const int iswap = std::min(isel + static_cast<int>(r*(n_gpt-isel)), n_gpt-1);
+                std::swap(gpts[isel], gpts[iswap]);
+                gpt_sel({icol, isel+1}) = gpts[isel];
+            }
+        }
+    }
+
+    // Report the cost and the accuracy of a k-distribution relative to a reference k-distribution.
+    void print_flux_error(
+            Master& master, const std::string& name, const int n_gpt, const int n_gpt_ref,
+            const Array<double,2>& flux_up, const Array<double,2>& flux_dn,
+            const Array<double,2>& flux_up_ref, const Array<double,2>& flux_dn_ref)
+    {
+        double err_up = 0.;
+        double err_dn = 0.;
+        for (int i=0; i<flux_up.size(); ++i)
+        {
+            err_up = std::max(err_up, std::abs(flux_up.v()[i] - flux_up_ref.v()[i]));
+            err_dn = std::max(err_dn, std::abs(flux_dn.v()[i] - flux_dn_ref.v()[i]));
+        }
+
+        master.print_message(
+                "Radiation %s: %d g-points, cost %.3f of reference (%d g-points), max flux error up %.3f, dn %.3f W m-2\n",
+                name.c_str(), n_gpt, static_cast<double>(n_gpt)/n_gpt_ref, n_gpt_ref, err_up, err_dn);
+    }
+
+    // Check that the g-point sampling is unbiased. The mean of the sampled fluxes over a fixed sequence
+    // of draws has to match the fluxes of the full solve within a few standard errors.
+    template<typename F>
+    void check_gpt_sampling(
+            Master& master, const std::string& name, const int n_gpt_solve, const int n_gpt,
+            const Array<double,2>& flux_up_ref, const Array<double,2>& flux_dn_ref,
+            F&& solve_sample)
+    {
+        constexpr int n_draw = 1000;
+
+        const int n = flux_up_ref.size();
+        std::vector<double> up_sum(n, 0.), up_sum2(n, 0.);
+        std::vector<double> dn_sum(n, 0.), dn_sum2(n, 0.);
+
+        Array<double,2> flux_up({flux_up_ref.dim(1), flux_up_ref.dim(2)});
+        Array<double,2> flux_dn({flux_dn_ref.dim(1), flux_dn_ref.dim(2)});
+
+        for (int idraw=0; idraw<n_draw; ++idraw)
+        {
+            solve_sample(idraw, flux_up, flux_dn);
+
+            for (int i=0; i<n; ++i)
+            {
+                up_sum [i] += flux_up.v()[i];
+                up_sum2[i] += flux_up.v()[i]*flux_up.v()[i];
+                dn_sum [i] += flux_dn.v()[i];
+                dn_sum2[i] += flux_dn.v()[i]*flux_dn.v()[i];
+            }
+        }
+
+        double err_up = 0.;
+        double err_dn = 0.;
+        bool is_biased = false;
+
+        auto check = [&](const double sum, const double sum2, const double ref, double& err)
+        {
+            const double mean = sum / n_draw;
+            const double std_err = std::sqrt(std::max(sum2/n_draw - mean*mean, 0.) / (n_draw-1));
+            const double err_abs = std::abs(mean - ref);
+
+            err = std::max(err, err_abs);
+            if (err_abs > 5.*std_err + 1.e-6)
+                is_biased = true;
+        };
+
+        for (int i=0; i<n; ++i)
+        {
+            check(up_sum[i], up_sum2[i], flux_up_ref.v()[i], err_up);
+            check(dn_sum[i], dn_sum2[i], flux_dn_ref.v()[i], err_dn);
+        }
+
+        master.print_message(
+                "Radiation %s: mean of %d draws of %d out of %d g-points, max flux error up %.3f, dn %.3f W m-2\n",
+                name.c_str(), n_draw, n_gpt_solve, n_gpt, err_up, err_dn);
+
+        if (is_biased)
+            master.print_warning(
+                    "Radiation %s: sampled fluxes deviate more than five standard errors from the full solve\n",
+                    name.c_str());
+    }
+
+    // Compute the cloud masks and the effective radii of liquid and ice of a block of columns.
+    template<typename TF>
+    void calc_cloud_props(
+            Array<int,2>& cld_mask_liq, Array<int,2>& cld_mask_ice,
+            Array<double,2>& rel, Array<double,2>& rei,
+            const Array<double,2>& clwp, const Array<double,2>& ciwp,
+            const std::vector<TF>& dz, const int kstart)
+    {
+        const int n_col = clwp.dim(1);
+        const int n_lay = clwp.dim(2);
+
+        constexpr double mask_min_value = 1e-12; // DALES uses 1e-20.
+
+        const double sig_g = 1.34;
+        const double fac = std::exp(std::log(sig_g)*std::log(sig_g)) * 1e6; // Conversion to micron included.
+
+        // CvH: Numbers according to RCEMIP.
+        const double Nc0 = 100.e6;
+        const double Ni0 = 1.e5;
+
+        const double four_third_pi_Nc0_rho_w = (4./3.)*M_PI*Nc0*Constants::rho_w<double>;
+        const double four_third_pi_Ni0_rho_i = (4./3.)*M_PI*Ni0*Constants::rho_i<double>;
+
+        for (int ilay=1; ilay<=n_lay; ++ilay)
+        {
+            const double layer_thickness = dz[ilay + kstart - 1];
+            const double fac_liq = 1. / (layer_thickness*four_third_pi_Nc0_rho_w);
+            const double fac_ice = 1. / (layer_thickness*four_third_pi_Ni0_rho_i);
+            const int offset = (ilay-1)*n_col;
+
+            #pragma ivdep
+            for (int icol=0; icol<n_col; ++icol)
+            {
+                const int n = icol + offset;
+                const int mask_liq = clwp.v()[n] > mask_min_value;
+                const int mask_ice = ciwp.v()[n] > mask_min_value;
+                cld_mask_liq.v()[n] = mask_liq;
+                cld_mask_ice.v()[n] = mask_ice;
+
+                // Parametrization according to Martin et al., 1994 JAS. Fac multiplication taken from DALES.
+                // CvH: Potentially better using moments from microphysics.
+                const double rel_value = mask_liq ? fac * std::cbrt(clwp.v()[n]*fac_liq) : 0.;
+
+                // Calculate the effective radius of ice from the mass and the number concentration.
+                const double rei_value = mask_ice ? 1.e6 * std::cbrt(ciwp.v()[n]*fac_ice) : 0.;
+
+                // Limit the values between 2.5 and 60 for liquid and 2.5 and 200 for ice.
+                rel.v()[n] = std::max(2.5, std::min(rel_value, 60.));
+                rei.v()[n] = std::max(2.5, std::min(rei_value, 200.));
+            }
+        }
+    }
+
+    // Work objects of one thread for solving a block of longwave columns.
+    struct Longwave_work
+    {
+        Longwave_work(
+                const int n_col, const int n_lay, const int n_lev, const int n_gpt_solve,
+                const Gas_optics<double>& kdist, const Cloud_optics<double>& cloud) :
+            optical_props(std::make_unique<Optical_props_1scl<double>>(n_col, n_lay, kdist)),
+            cloud_optical_props(std::make_unique<Optical_props_1scl<double>>(n_col, n_lay, cloud)),
+            sources(n_col, n_lay, kdist),
+            fluxes(std::make_unique<Fluxes_broadband<double>>(n_col, n_lev)),
+            gpt_flux_up({n_col, n_lev, n_gpt_solve}),
+            gpt_flux_dn({n_col, n_lev, n_gpt_solve}),
+            gpt_sel({n_col, n_gpt_solve}),
+            cld_mask_liq({n_col, n_lay}),
+            cld_mask_ice({n_col, n_lay}),
+            rel({n_col, n_lay}),
+            rei({n_col, n_lay}),
+            cloud_index(n_col*n_lay),
+            cloud_fint(n_col*n_lay)
+        {}
+
+        std::unique_ptr<Optical_props_arry<double>> optical_props;
+        std::unique_ptr<Optical_props_1scl<double>> cloud_optical_props;
+        Source_func_lw<double> sources;
+        std::unique_ptr<Fluxes_broadband<double>> fluxes;
+        Array<double,3> gpt_flux_up;
+        Array<double,3> gpt_flux_dn;
+        Array<int,2> gpt_sel;
+
+        // Subsets of the input, refilled for every block.
+        Gas_concs<double> gas_concs;
+        Array<double,2> p_lay;
+        Array<double,2> p_lev;
+        Array<double,2> t_lay;
+        Array<double,1> t_sfc;
+        Array<double,2> t_lev;
+        Array<double,2> col_dry;
+        Array<double,2> clwp;
+        Array<double,2> ciwp;
+        Array<int,2> cld_mask_liq;
+        Array<int,2> cld_mask_ice;
+        Array<double,2> rel;
+        Array<double,2> rei;
+        std::vector<int> cloud_index;
+        std::vector<double> cloud_fint;
+        Array<double,2> emis_sfc;
+        Array<double,2> lw_flux_dn_inc;
+    };
+
+    // Work objects of one thread for solving a block of shortwave columns.
+    struct Shortwave_work
+    {
+        Shortwave_work(
+                const int n_col, const int n_lay, const int n_lev, const int n_gpt, const int n_gpt_solve,
+                const Gas_optics<double>& kdist, const Cloud_optics<double>& cloud) :
+            optical_props(std::make_unique<Optical_props_2str<double>>(n_col, n_lay, kdist)),
+            cloud_optical_props(std::make_unique<Optical_props_2str<double>>(n_col, n_lay, cloud)),
+            fluxes(std::make_unique<Fluxes_broadband<double>>(n_col, n_lev)),
+            toa_src_dummy({n_col, n_gpt}),
+            gpt_flux_up({n_col, n_lev, n_gpt_solve}),
+            gpt_flux_dn({n_col, n_lev, n_gpt_solve}),
+            gpt_flux_dn_dir({n_col, n_lev, n_gpt_solve}),
+            gpt_sel({n_col, n_gpt_solve}),
+            cld_mask_liq({n_col, n_lay}),
+            cld_mask_ice({n_col, n_lay}),
+            rel({n_col, n_lay}),
+            rei({n_col, n_lay}),
+            cloud_index(n_col*n_lay),
+            cloud_fint(n_col*n_lay)
+        {}
+
+        std::unique_ptr<Optical_props_arry<double>> optical_props;
+        std::unique_ptr<Optical_props_2str<double>> cloud_optical_props;
+        std::unique_ptr<Fluxes_broadband<double>> fluxes;
+        Array<double,2> toa_src_dummy;
+        Array<double,3> gpt_flux_up;
+        Array<double,3> gpt_flux_dn;
+        Array<double,3> gpt_flux_dn_dir;
+        Array<int,2> gpt_sel;
+
+        // Subsets of the input, refilled for every block.
+        Gas_concs<double> gas_concs;
+        Array<double,2> p_lay;
+        Array<double,2> p_lev;
+        Array<double,2> t_lay;
+        Array<double,2> col_dry;
+        Array<double,2> clwp;
+        Array<double,2> ciwp;
+        Array<int,2> cld_mask_liq;
+        Array<int,2> cld_mask_ice;
+        Array<double,2> rel;
+        Array<double,2> rei;
+        std::vector<int> cloud_index;
+        std::vector<double> cloud_fint;
+        Array<double,1> mu0;
+        Array<double,2> toa_src;
+        Array<double,2> sfc_alb_dir;
+        Array<double,2> sfc_alb_dif;
+        Array<double,2> sw_flux_dn_dif_inc;
+    };
 }
 
 template<typename TF>
@@ -588,6 +895,47 @@ Radiation_rrtmgp<TF>::Radiation_rrtmgp(
 
     dt_rad = inputin.get_item<double>("radiation", "dt_rad", "");
 
+    // Limit the time step such that radiation is solved exactly every dt_rad, otherwise at the first step after.
+    sw_limit_dt = inputin.get_item<bool>("radiation", "swlimitdt", "", true);
+
+    // Linearly extrapolate the heating rate of the two last radiation calls in between calls.
+    sw_tend_extrap = inputin.get_item<bool>("radiation", "swtendextrap", "", false);
+    rad_cache_itime = std::numeric_limits<unsigned long>::max();
+
+    // Solve the radiation on a helper thread, the heating rate lags by at most one radiation call.
+    sw_async = inputin.get_item<bool>("radiation", "swasync", "", false);
+
+    // Solve the radiation on the radiation server processes, with the same lag as the helper thread.
+    sw_rad_server = masterin.get_MPI_data().nprocs_rad > 0;
+    rad_server_pending = false;
+    rad_server_connected = false;
+
+    // Number of columns that are solved simultaneously, the blocks are distributed over the threads.
+    n_col_block = inputin.get_item<int>("radiation", "n_col_block", "", 4);
+    if (n_col_block < 1)
+        throw std::runtime_error("n_col_block must be at least 1");
+
+    // Monte Carlo sampling of g-points per column and of one column per tile of columns.
+    n_gpt_sample = inputin.get_item<int>("radiation", "n_gpt_sample", "", 0);
+    sample_tile_size = inputin.get_item<int>("radiation", "sample_tile_size", "", 1);
+    sample_seed = inputin.get_item<int>("radiation", "sample_seed", "", 0);
+
+    if (n_gpt_sample < 0 || sample_tile_size < 1)
+        throw std::runtime_error("n_gpt_sample must be non-negative and sample_tile_size positive");
+
+    // The time loop restricts the model to one thread, the radiation sets its own number of threads.
+    n_threads = inputin.get_item<int>("radiation", "n_threads", "", 1);
+    if (n_threads < 1)
+        throw std::runtime_error("n_threads must be at least 1");
+
+    // The k-distribution and cloud optics tables, a reduced g-point set lowers the cost of the solver.
+    coef_lw_file = inputin.get_item<std::string>("radiation", "coef_lw_file", "", "coefficients_lw.nc");
+    coef_sw_file = inputin.get_item<std::string>("radiation", "coef_sw_file", "", "coefficients_sw.nc");
+    cloud_coef_lw_file = inputin.get_item<std::string>("radiation", "cloud_coef_lw_file", "", "cloud_coefficients_lw.nc");
+    cloud_coef_sw_file = inputin.get_item<std::string>("radiation", "cloud_coef_sw_file", "", "cloud_coefficients_sw.nc");
+    coef_lw_ref_file = inputin.get_item<std::string>("radiation", "coef_lw_ref_file", "", "");
+    coef_sw_ref_file = inputin.get_item<std::string>("radiation", "coef_sw_ref_file", "", "");
+
 	t_sfc       = inputin.get_item<double>("radiation", "t_sfc"      , "");
     emis_sfc    = inputin.get_item<double>("radiation", "emis_sfc"   , "");
     sfc_alb_dir = inputin.get_item<double>("radiation", "sfc_alb_dir", "");
@@ -609,13 +957,39 @@ void Radiation_rrtmgp<TF>::init(Timeloop<TF>& timeloop)
     idt_rad = static_cast<unsigned long>(timeloop.get_ifactor() * dt_rad + 0.5);
 
     // Check if restarttime is dividable by dt_rad
-    if (timeloop.get_isavetime() % idt_rad != 0)
+    if (sw_limit_dt && (timeloop.get_isavetime() % idt_rad != 0))
         throw std::runtime_error("Restart \"savetime\" is not an (integer) multiple of \"dt_rad\"");
+
+    // The tiles for the column sampling may not cross the subdomain boundaries.
+    auto& gd = grid.get_grid_data();
+    if ((gd.imax % sample_tile_size != 0) || (gd.jmax % sample_tile_size != 0))
+        throw std::runtime_error("imax and jmax must be multiples of sample_tile_size");
+
+    // The heating rate is not part of the restart files, solve the radiation at the first step.
+    itime_rad_next = 0;
+
+    // Negative times flag that no heating rate is available yet.
+    time_rad = -1.;
+    time_rad_prev = -1.;
+
+    if (sw_tend_extrap)
+        thlt_rad_prev.resize(gd.ncells);
+
+    if (sw_async || sw_rad_server)
+        thlt_rad_async.resize(gd.ncells);
+
+    // The coordinates of the solved subdomain, the servers take them from the model process.
+    auto& md = master.get_MPI_data();
+    solve_coordx = md.mpicoordx;
+    solve_coordy = md.mpicoordy;
 }
 
 template<typename TF>
 unsigned long Radiation_rrtmgp<TF>::get_time_limit(unsigned long itime)
 {
+    if (!sw_limit_dt)
+        return Constants::ulhuge;
+
     unsigned long idtlim = idt_rad - itime % idt_rad;
     return idtlim;
 }
@@ -642,6 +1016,12 @@ void Radiation_rrtmgp<TF>::create(
     // Solve the reference column to compute upper boundary conditions.
     create_column(input, input_nc, thermo, stats);
 
+    // The servers need the top boundary conditions of the reference column as well.
+    if (sw_rad_server)
+    {
+        bcast_reference_columns();
+        rad_server_connected = true;
+    }
 
     if (stats.get_switch() && sw_shortwave)
     {
@@ -679,6 +1059,13 @@ void Radiation_rrtmgp<TF>::create(
     }
 
     crosslist = cross.get_enabled_variables(allowed_crossvars_radiation);
+
+    // Add the fluxes to the columns.
+    if (column.get_switch())
+    {
+        for (const std::string& name : get_output_names())
+            column.add_prof(name, "Radiative flux", "W m-2", "zh");
+    }
 }
 
 template<typename TF>
@@ -780,6 +1167,81 @@ void Radiation_rrtmgp<TF>::create_column_longwave(
             t_sfc, emis_sfc,
             n_lay);
 
+    // Check the g-point sampling on the reference column, with the same seed as the model.
+    if (n_gpt_sample > 0 && n_gpt_sample < n_gpt)
+    {
+        const int top_at_1 = p_lay({1, 1}) < p_lay({1, n_lay});
+        const double gpt_fac = static_cast<double>(n_gpt) / n_gpt_sample;
+        const unsigned long col_id = 0;
+
+        std::unique_ptr<Fluxes_broadband<double>> fluxes =
+                std::make_unique<Fluxes_broadband<double>>(n_col, n_lev);
+
+        Array<int,2> gpt_sel({n_col, n_gpt_sample});
+        Array<double,3> gpt_flux_up({n_col, n_lev, n_gpt_sample});
+        Array<double,3> gpt_flux_dn({n_col, n_lev, n_gpt_sample});
+
+        auto solve_sample = [&](const int idraw, Array<double,2>& flux_up, Array<double,2>& flux_dn)
+        {
+            select_gpoints(gpt_sel, &col_id, n_gpt, sample_seed, idraw, stream_lw);
+
+            Rte_lw<double>::rte_lw_gpt_subset(
+                    optical_props_lw,
+                    top_at_1,
+                    *sources_lw,
+                    emis_sfc,
+                    Array<double,2>(),
+                    gpt_sel,
+                    gpt_flux_up, gpt_flux_dn,
+                    1);
+
+            fluxes->reduce(gpt_flux_up, gpt_flux_dn, optical_props_lw, top_at_1);
+
+            for (int ilev=1; ilev<=n_lev; ++ilev)
+            {
+                flux_up({1, ilev}) = gpt_fac * fluxes->get_flux_up()({1, ilev});
+                flux_dn({1, ilev}) = gpt_fac * fluxes->get_flux_dn()({1, ilev});
+            }
+        };
+
+        check_gpt_sampling(master, "longwave", n_gpt_sample, n_gpt, lw_flux_up, lw_flux_dn, solve_sample);
+    }
+
+    // Compare the fluxes with those of the reference k-distribution.
+    if (!coef_lw_ref_file.empty())
+    {
+        std::unique_ptr<Gas_optics<double>> kdist_lw_ref = std::make_unique<Gas_optics<double>>(
+                load_and_init_gas_optics(master, gas_concs, coef_lw_ref_file));
+
+        std::unique_ptr<Source_func_lw<double>> sources_lw_ref =
+                std::make_unique<Source_func_lw<double>>(n_col, n_lay, *kdist_lw_ref);
+
+        std::unique_ptr<Optical_props_arry<double>> optical_props_lw_ref =
+                std::make_unique<Optical_props_1scl<double>>(n_col, n_lay, *kdist_lw_ref);
+
+        Array<double,2> lw_flux_up_ref ({n_col, n_lev});
+        Array<double,2> lw_flux_dn_ref ({n_col, n_lev});
+        Array<double,2> lw_flux_net_ref({n_col, n_lev});
+        Array<double,2> lw_flux_dn_inc_ref({n_col, kdist_lw_ref->get_ngpt()});
+
+        solve_longwave_column<double>(
+                optical_props_lw_ref,
+                lw_flux_up_ref, lw_flux_dn_ref, lw_flux_net_ref,
+                lw_flux_dn_inc_ref, thermo.get_ph_vector()[gd.kend],
+                gas_concs,
+                kdist_lw_ref,
+                sources_lw_ref,
+                col_dry,
+                p_lay, p_lev,
+                t_lay, t_lev,
+                t_sfc, emis_sfc,
+                n_lay);
+
+        print_flux_error(
+                master, "longwave", n_gpt, kdist_lw_ref->get_ngpt(),
+                lw_flux_up, lw_flux_dn, lw_flux_up_ref, lw_flux_dn_ref);
+    }
+
     // Save the reference profile fluxes in the stats.
     if (stats.get_switch())
     {
@@ -865,6 +1327,100 @@ void Radiation_rrtmgp<TF>::create_column_shortwave(
             tsi_scaling,
             n_lay);
 
+    // Check the g-point sampling on the reference column, with the same seed as the model.
+    if (n_gpt_sample > 0 && n_gpt_sample < n_gpt)
+    {
+        const int top_at_1 = p_lay({1, 1}) < p_lay({1, n_lay});
+        const double gpt_fac = static_cast<double>(n_gpt) / n_gpt_sample;
+        const unsigned long col_id = 0;
+
+        // Recompute the top of atmosphere source, the column solver does not return it.
+        Array<double,2> toa_src({n_col, n_gpt});
+        kdist_sw->gas_optics(
+                p_lay,
+                p_lev,
+                t_lay,
+                gas_concs,
+                optical_props_sw,
+                toa_src,
+                col_dry);
+
+        if (tsi_scaling >= 0)
+            for (int igpt=1; igpt<=n_gpt; ++igpt)
+                toa_src({1, igpt}) *= tsi_scaling;
+
+        std::unique_ptr<Fluxes_broadband<double>> fluxes =
+                std::make_unique<Fluxes_broadband<double>>(n_col, n_lev);
+
+        Array<int,2> gpt_sel({n_col, n_gpt_sample});
+        Array<double,3> gpt_flux_up    ({n_col, n_lev, n_gpt_sample});
+        Array<double,3> gpt_flux_dn    ({n_col, n_lev, n_gpt_sample});
+        Array<double,3> gpt_flux_dn_dir({n_col, n_lev, n_gpt_sample});
+
+        auto solve_sample = [&](const int idraw, Array<double,2>& flux_up, Array<double,2>& flux_dn)
+        {
+            select_gpoints(gpt_sel, &col_id, n_gpt, sample_seed, idraw, stream_sw);
+
+            Rte_sw<double>::rte_sw_gpt_subset(
+                    optical_props_sw,
+                    top_at_1,
+                    mu0,
+                    toa_src,
+                    sfc_alb_dir,
+                    sfc_alb_dif,
+                    Array<double,2>(),
+                    gpt_sel,
+                    gpt_flux_up,
+                    gpt_flux_dn,
+                    gpt_flux_dn_dir);
+
+            fluxes->reduce(gpt_flux_up, gpt_flux_dn, gpt_flux_dn_dir, optical_props_sw, top_at_1);
+
+            for (int ilev=1; ilev<=n_lev; ++ilev)
+            {
+                flux_up({1, ilev}) = gpt_fac * fluxes->get_flux_up()({1, ilev});
+                flux_dn({1, ilev}) = gpt_fac * fluxes->get_flux_dn()({1, ilev});
+            }
+        };
+
+        check_gpt_sampling(master, "shortwave", n_gpt_sample, n_gpt, sw_flux_up, sw_flux_dn, solve_sample);
+    }
+
+    // Compare the fluxes with those of the reference k-distribution.
+    if (!coef_sw_ref_file.empty())
+    {
+        std::unique_ptr<Gas_optics<double>> kdist_sw_ref = std::make_unique<Gas_optics<double>>(
+                load_and_init_gas_optics(master, gas_concs, coef_sw_ref_file));
+
+        std::unique_ptr<Optical_props_arry<double>> optical_props_sw_ref =
+                std::make_unique<Optical_props_2str<double>>(n_col, n_lay, *kdist_sw_ref);
+
+        Array<double,2> sw_flux_up_ref    ({n_col, n_lev});
+        Array<double,2> sw_flux_dn_ref    ({n_col, n_lev});
+        Array<double,2> sw_flux_dn_dir_ref({n_col, n_lev});
+        Array<double,2> sw_flux_net_ref   ({n_col, n_lev});
+        Array<double,2> sw_flux_dn_dir_inc_ref({n_col, kdist_sw_ref->get_ngpt()});
+        Array<double,2> sw_flux_dn_dif_inc_ref({n_col, kdist_sw_ref->get_ngpt()});
+
+        solve_shortwave_column<double>(
+                optical_props_sw_ref,
+                sw_flux_up_ref, sw_flux_dn_ref, sw_flux_dn_dir_ref, sw_flux_net_ref,
+                sw_flux_dn_dir_inc_ref, sw_flux_dn_dif_inc_ref, thermo.get_ph_vector()[gd.kend],
+                gas_concs,
+                *kdist_sw_ref,
+                col_dry,
+                p_lay, p_lev,
+                t_lay, t_lev,
+                mu0,
+                sfc_alb_dir, sfc_alb_dif,
+                tsi_scaling,
+                n_lay);
+
+        print_flux_error(
+                master, "shortwave", n_gpt, kdist_sw_ref->get_ngpt(),
+                sw_flux_up, sw_flux_dn, sw_flux_up_ref, sw_flux_dn_ref);
+    }
+
     // Save the reference profile fluxes in the stats.
     if (stats.get_switch())
     {
@@ -913,10 +1469,10 @@ void Radiation_rrtmgp<TF>::create_solver_longwave(
 
     // Set up the gas optics classes for long and shortwave.
     kdist_lw = std::make_unique<Gas_optics<double>>(
-            load_and_init_gas_optics(master, gas_concs, "coefficients_lw.nc"));
+            load_and_init_gas_optics(master, gas_concs, coef_lw_file));
 
     cloud_lw = std::make_unique<Cloud_optics<double>>(
-            load_and_init_cloud_optics(master, "cloud_coefficients_lw.nc"));
+            load_and_init_cloud_optics(master, cloud_coef_lw_file));
 
     // Set up the statistics.
     if (stats.get_switch())
@@ -941,10 +1497,10 @@ void Radiation_rrtmgp<TF>::create_solver_shortwave(
 
     // Set up the gas optics classes for long and shortwave.
     kdist_sw = std::make_unique<Gas_optics<double>>(
-            load_and_init_gas_optics(master, gas_concs, "coefficients_sw.nc"));
+            load_and_init_gas_optics(master, gas_concs, coef_sw_file));
 
     cloud_sw = std::make_unique<Cloud_optics<double>>(
-            load_and_init_cloud_optics(master, "cloud_coefficients_sw.nc"));
+            load_and_init_cloud_optics(master, cloud_coef_sw_file));
 
     // Set up the statistics.
     if (stats.get_switch())
@@ -962,150 +1518,13 @@ void Radiation_rrtmgp<TF>::create_solver_shortwave(
     }
 }
 
-#ifndef USECUDA
-template<typename TF>
-void Radiation_rrtmgp<TF>::exec(
-        Thermo<TF>& thermo, const double time, Timeloop<TF>& timeloop, Stats<TF>& stats)
-{
-    auto& gd = grid.get_grid_data();
-
-    const bool do_radiation = ((timeloop.get_itime() % idt_rad == 0) && !timeloop.in_substep()) ;
-
-    if (do_radiation)
-    {
-        // Set the tendency to zero.
-        std::fill(fields.sd.at("thlt_rad")->fld.begin(), fields.sd.at("thlt_rad")->fld.end(), TF(0.));
-
-        auto t_lay = fields.get_tmp();
-        auto t_lev = fields.get_tmp();
-        auto h2o   = fields.get_tmp(); // This is the volume mixing ratio, not the specific humidity of vapor.
-        auto clwp  = fields.get_tmp();
-        auto ciwp  = fields.get_tmp();
-
-        // Set the input to the radiation on a 3D grid without ghost cells.
-        thermo.get_radiation_fields(*t_lay, *t_lev, *h2o, *clwp, *ciwp);
-
-        // Initialize arrays in double precision, cast when needed.
-        const int nmaxh = gd.imax*gd.jmax*(gd.ktot+1);
-
-        Array<double,2> t_lay_a(
-                std::vector<double>(t_lay->fld.begin(), t_lay->fld.begin() + gd.nmax), {gd.imax*gd.jmax, gd.ktot});
-        Array<double,2> t_lev_a(
-                std::vector<double>(t_lev->fld.begin(), t_lev->fld.begin() + nmaxh), {gd.imax*gd.jmax, gd.ktot+1});
-        Array<double,2> h2o_a(
-                std::vector<double>(h2o->fld.begin(), h2o->fld.begin() + gd.nmax), {gd.imax*gd.jmax, gd.ktot});
-        Array<double,2> clwp_a(
-                std::vector<double>(clwp->fld.begin(), clwp->fld.begin() + gd.nmax), {gd.imax*gd.jmax, gd.ktot});
-        Array<double,2> ciwp_a(
-                std::vector<double>(ciwp->fld.begin(), ciwp->fld.begin() + gd.nmax), {gd.imax*gd.jmax, gd.ktot});
-
-        Array<double,2> flux_up ({gd.imax*gd.jmax, gd.ktot+1});
-        Array<double,2> flux_dn ({gd.imax*gd.jmax, gd.ktot+1});
-        Array<double,2> flux_net({gd.imax*gd.jmax, gd.ktot+1});
-
-        const bool compute_clouds = true;
-
-        if (sw_longwave)
-        {
-            exec_longwave(
-                    thermo, timeloop, stats,
-                    flux_up, flux_dn, flux_net,
-                    t_lay_a, t_lev_a, h2o_a, clwp_a, ciwp_a,
-                    compute_clouds);
-
-            calc_tendency(
-                    fields.sd.at("thlt_rad")->fld.data(),
-                    flux_up.ptr(), flux_dn.ptr(),
-                    fields.rhoref.data(), thermo.get_exner_vector().data(),
-                    gd.dz.data(),
-                    gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
-                    gd.igc, gd.jgc, gd.kgc,
-                    gd.icells, gd.ijcells,
-                    gd.imax, gd.imax*gd.jmax);
-        }
-
-        if (sw_shortwave)
-        {
-            Array<double,2> flux_dn_dir({gd.imax*gd.jmax, gd.ktot+1});
-
-            exec_shortwave(
-                    thermo, timeloop, stats,
-                    flux_up, flux_dn, flux_dn_dir, flux_net,
-                    t_lay_a, t_lev_a, h2o_a, clwp_a, ciwp_a,
-                    compute_clouds);
-
-            calc_tendency(
-                    fields.sd.at("thlt_rad")->fld.data(),
-                    flux_up.ptr(), flux_dn.ptr(),
-                    fields.rhoref.data(), thermo.get_exner_vector().data(),
-                    gd.dz.data(),
-                    gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
-                    gd.igc, gd.jgc, gd.kgc,
-                    gd.icells, gd.ijcells,
-                    gd.imax, gd.imax*gd.jmax);
-        }
-
-        fields.release_tmp(t_lay);
-        fields.release_tmp(t_lev);
-        fields.release_tmp(h2o);
-        fields.release_tmp(clwp);
-        fields.release_tmp(ciwp);
-    }
-
-    // Always add the tendency.
-    add_tendency(
-            fields.st.at("thl")->fld.data(),
-            fields.sd.at("thlt_rad")->fld.data(),
-            gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
-            gd.icells, gd.ijcells);
-
-    stats.calc_tend(*fields.st.at("thl"), tend_name);
-}
-#endif
-
-namespace
-{
-    template<typename TF>
-    void add_ghost_cells(
-            TF* restrict out, const double* restrict in,
-            const int istart, const int iend,
-            const int jstart, const int jend,
-            const int kstart, const int kend_field,
-            const int igc, const int jgc, const int kgc,
-            const int jj, const int kk,
-            const int jj_nogc, const int kk_nogc)
-    {
-        // Value of kend_field is either kend or kend+1.
-        #pragma omp parallel for
-        for (int k=kstart; k<kend_field; ++k)
-            for (int j=jstart; j<jend; ++j)
-                #pragma ivdep
-                for (int i=istart; i<iend; ++i)
-                {
-                    const int ijk = i + j*jj + k*kk;
-                    const int ijk_nogc = (i-igc) + (j-jgc)*jj_nogc + (k-kgc)*kk_nogc;
-                    out[ijk] = in[ijk_nogc];
-                }
-    }
-}
-
 template<typename TF>
-void Radiation_rrtmgp<TF>::exec_all_stats(
-        Stats<TF>& stats, Cross<TF>& cross, Dump<TF>& dump,
-        Thermo<TF>& thermo, Timeloop<TF>& timeloop,
-        const unsigned long itime, const int iotime)
+void Radiation_rrtmgp<TF>::get_radiation_input(
+        Thermo<TF>& thermo,
+        Array<double,2>& p_lay, Array<double,2>& p_lev,
+        Array<double,2>& t_lay_a, Array<double,2>& t_lev_a,
+        Array<double,2>& h2o_a, Array<double,2>& clwp_a, Array<double,2>& ciwp_a)
 {
-    const bool do_stats = stats.do_statistics(itime);
-    const bool do_cross = cross.do_cross(itime);
-
-    // Return in case of no stats or cross section.
-    if ( !(do_stats || do_cross) )
-        return;
-
-    const TF no_offset = 0.;
-    const TF no_threshold = 0.;
-
-    // CvH: lots of code repetition with exec()
     auto& gd = grid.get_grid_data();
 
     auto t_lay = fields.get_tmp();
@@ -1120,15 +1539,20 @@ void Radiation_rrtmgp<TF>::exec_all_stats(
     // Initialize arrays in double precision, cast when needed.
     const int nmaxh = gd.imax*gd.jmax*(gd.ktot+1);
 
-    Array<double,2> t_lay_a(
+    p_lay = Array<double,2>(
+            std::vector<double>(thermo.get_p_vector ().begin() + gd.kstart, thermo.get_p_vector ().begin() + gd.kend    ), {1, gd.ktot});
+    p_lev = Array<double,2>(
+            std::vector<double>(thermo.get_ph_vector().begin() + gd.kstart, thermo.get_ph_vector().begin() + gd.kend + 1), {1, gd.ktot+1});
+
+    t_lay_a = Array<double,2>(
             std::vector<double>(t_lay->fld.begin(), t_lay->fld.begin() + gd.nmax), {gd.imax*gd.jmax, gd.ktot});
-    Array<double,2> t_lev_a(
+    t_lev_a = Array<double,2>(
             std::vector<double>(t_lev->fld.begin(), t_lev->fld.begin() + nmaxh), {gd.imax*gd.jmax, gd.ktot+1});
-    Array<double,2> h2o_a(
+    h2o_a = Array<double,2>(
             std::vector<double>(h2o->fld.begin(), h2o->fld.begin() + gd.nmax), {gd.imax*gd.jmax, gd.ktot});
-    Array<double,2> clwp_a(
+    clwp_a = Array<double,2>(
             std::vector<double>(clwp->fld.begin(), clwp->fld.begin() + gd.nmax), {gd.imax*gd.jmax, gd.ktot});
-    Array<double,2> ciwp_a(
+    ciwp_a = Array<double,2>(
             std::vector<double>(ciwp->fld.begin(), ciwp->fld.begin() + gd.nmax), {gd.imax*gd.jmax, gd.ktot});
 
     fields.release_tmp(t_lay);
@@ -1136,66 +1560,53 @@ void Radiation_rrtmgp<TF>::exec_all_stats(
     fields.release_tmp(h2o);
     fields.release_tmp(clwp);
     fields.release_tmp(ciwp);
+}
+
+// Solve the fluxes and the heating rate from a copy of the input. This function does not touch the
+// fields, such that it can run on a helper thread while the model advances.
+template<typename TF>
+void Radiation_rrtmgp<TF>::solve_tendency(
+        std::vector<TF>& thlt_rad, const unsigned long itime,
+        const Array<double,2>& p_lay, const Array<double,2>& p_lev,
+        const Array<double,2>& t_lay_a, const Array<double,2>& t_lev_a,
+        const Array<double,2>& h2o_a, const Array<double,2>& clwp_a, const Array<double,2>& ciwp_a,
+        const std::vector<TF>& rhoref, const std::vector<TF>& exner,
+        const bool store_fluxes)
+{
+    auto& gd = grid.get_grid_data();
+
+    // Set the tendency to zero.
+    std::fill(thlt_rad.begin(), thlt_rad.end(), TF(0.));
 
     Array<double,2> flux_up ({gd.imax*gd.jmax, gd.ktot+1});
     Array<double,2> flux_dn ({gd.imax*gd.jmax, gd.ktot+1});
     Array<double,2> flux_net({gd.imax*gd.jmax, gd.ktot+1});
 
-    auto tmp = fields.get_tmp();
-    tmp->loc = gd.wloc;
-
     const bool compute_clouds = true;
 
-    // Use a lambda function to avoid code repetition.
-    auto save_stats_and_cross = [&](
-            const Array<double,2>& array, const std::string& name, const std::array<int,3>& loc)
-    {
-        if (do_stats || do_cross)
-        {
-            // Make sure that the top boundary is taken into account in case of fluxes.
-            const int kend = gd.kstart + array.dim(2);
-            add_ghost_cells(
-                    tmp->fld.data(), array.ptr(),
-                    gd.istart, gd.iend,
-                    gd.jstart, gd.jend,
-                    gd.kstart, kend,
-                    gd.igc, gd.jgc, gd.kgc,
-                    gd.icells, gd.ijcells,
-                    gd.imax, gd.imax*gd.jmax);
-        }
-
-        if (do_stats)
-            stats.calc_stats(name, *tmp, no_offset, no_threshold);
-
-        if (do_cross)
-        {
-            if (std::find(crosslist.begin(), crosslist.end(), name) != crosslist.end())
-                cross.cross_simple(tmp->fld.data(), name, iotime, loc);
-        }
-    };
-
     if (sw_longwave)
     {
         exec_longwave(
-                thermo, timeloop, stats,
+                itime, p_lay, p_lev,
                 flux_up, flux_dn, flux_net,
                 t_lay_a, t_lev_a, h2o_a, clwp_a, ciwp_a,
                 compute_clouds);
 
-        save_stats_and_cross(flux_up, "lw_flux_up", gd.wloc);
-        save_stats_and_cross(flux_dn, "lw_flux_dn", gd.wloc);
-
-        if (sw_clear_sky_stats)
+        if (store_fluxes)
         {
-            exec_longwave(
-                    thermo, timeloop, stats,
-                    flux_up, flux_dn, flux_net,
-                    t_lay_a, t_lev_a, h2o_a, clwp_a, ciwp_a,
-                    !compute_clouds);
-
-            save_stats_and_cross(flux_up, "lw_flux_up_clear", gd.wloc);
-            save_stats_and_cross(flux_dn, "lw_flux_dn_clear", gd.wloc);
+            rad_cache["lw_flux_up"] = flux_up;
+            rad_cache["lw_flux_dn"] = flux_dn;
         }
+
+        calc_tendency(
+                thlt_rad.data(),
+                flux_up.ptr(), flux_dn.ptr(),
+                rhoref.data(), exner.data(),
+                gd.dz.data(),
+                gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
+                gd.igc, gd.jgc, gd.kgc,
+                gd.icells, gd.ijcells,
+                gd.imax, gd.imax*gd.jmax);
     }
 
     if (sw_shortwave)
@@ -1203,50 +1614,524 @@ void Radiation_rrtmgp<TF>::exec_all_stats(
         Array<double,2> flux_dn_dir({gd.imax*gd.jmax, gd.ktot+1});
 
         exec_shortwave(
-                thermo, timeloop, stats,
+                itime, p_lay, p_lev,
                 flux_up, flux_dn, flux_dn_dir, flux_net,
                 t_lay_a, t_lev_a, h2o_a, clwp_a, ciwp_a,
                 compute_clouds);
 
-        save_stats_and_cross(flux_up,     "sw_flux_up"    , gd.wloc);
-        save_stats_and_cross(flux_dn,     "sw_flux_dn"    , gd.wloc);
-        save_stats_and_cross(flux_dn_dir, "sw_flux_dn_dir", gd.wloc);
-
-        if (sw_clear_sky_stats)
+        if (store_fluxes)
         {
-            exec_shortwave(
-                    thermo, timeloop, stats,
-                    flux_up, flux_dn, flux_dn_dir, flux_net,
-                    t_lay_a, t_lev_a, h2o_a, clwp_a, ciwp_a,
-                    !compute_clouds);
-
-            save_stats_and_cross(flux_up,     "sw_flux_up_clear"    , gd.wloc);
-            save_stats_and_cross(flux_dn,     "sw_flux_dn_clear"    , gd.wloc);
-            save_stats_and_cross(flux_dn_dir, "sw_flux_dn_dir_clear", gd.wloc);
+            rad_cache["sw_flux_up"]     = flux_up;
+            rad_cache["sw_flux_dn"]     = flux_dn;
+            rad_cache["sw_flux_dn_dir"] = std::move(flux_dn_dir);
         }
 
+        calc_tendency(
+                thlt_rad.data(),
+                flux_up.ptr(), flux_dn.ptr(),
+                rhoref.data(), exner.data(),
+                gd.dz.data(),
+                gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
+                gd.igc, gd.jgc, gd.kgc,
+                gd.icells, gd.ijcells,
+                gd.imax, gd.imax*gd.jmax);
+    }
+}
+
+// Check whether the radiation on the helper thread or on the server process has finished on all
+// processes, such that all processes switch to the new heating rate at the same time step.
+template<typename TF>
+bool Radiation_rrtmgp<TF>::async_ready()
+{
+    int n_busy = 0;
+
+    if (rad_future.valid())
+        n_busy = rad_future.wait_for(std::chrono::seconds(0)) != std::future_status::ready;
+    #ifdef USEMPI
+    else if (rad_server_pending)
+    {
+        int flag;
+        MPI_Testall(3, rad_reqs, &flag, MPI_STATUSES_IGNORE);
+        n_busy = !flag;
+    }
+    #endif
+    else
+        return false;
+
+    master.sum(&n_busy, 1);
+    return n_busy == 0;
+}
+
+// Wait for the radiation on the helper thread or on the server process and make its heating rate the active one.
+template<typename TF>
+void Radiation_rrtmgp<TF>::finish_async()
+{
+    if (rad_future.valid())
+    {
+        // Rethrows the exceptions of the helper thread.
+        rad_future.get();
+    }
+    #ifdef USEMPI
+    else if (rad_server_pending)
+    {
+        MPI_Waitall(3, rad_reqs, MPI_STATUSES_IGNORE);
+        rad_server_pending = false;
+
+        // The server returns the heating rate without ghost cells.
+        auto& gd = grid.get_grid_data();
+        const int jj_nogc = gd.imax;
+        const int kk_nogc = gd.imax*gd.jmax;
+
+        for (int k=gd.kstart; k<gd.kend; ++k)
+            for (int j=gd.jstart; j<gd.jend; ++j)
+                #pragma ivdep
+                for (int i=gd.istart; i<gd.iend; ++i)
+                {
+                    const int ijk = i + j*gd.icells + k*gd.ijcells;
+                    const int ijk_nogc = (i-gd.igc) + (j-gd.jgc)*jj_nogc + (k-gd.kgc)*kk_nogc;
+                    thlt_rad_async[ijk] = rad_recv_buffer[ijk_nogc];
+                }
+    }
+    #endif
+    else
+        return;
+
+    std::vector<TF>& thlt_rad = fields.sd.at("thlt_rad")->fld;
+
+    if (sw_tend_extrap)
+    {
+        thlt_rad_prev = thlt_rad;
+        time_rad_prev = time_rad;
+    }
+
+    time_rad = time_rad_async;
+    std::swap(thlt_rad, thlt_rad_async);
+}
+
+#ifndef USECUDA
+template<typename TF>
+void Radiation_rrtmgp<TF>::exec(
+        Thermo<TF>& thermo, const double time, Timeloop<TF>& timeloop, Stats<TF>& stats)
+{
+    auto& gd = grid.get_grid_data();
+
+    const unsigned long itime = timeloop.get_itime();
+    const bool do_radiation = ((itime >= itime_rad_next) && !timeloop.in_substep()) ;
+
+    if (do_radiation)
+    {
+        itime_rad_next = (itime / idt_rad + 1) * idt_rad;
+
+        Array<double,2> p_lay, p_lev, t_lay_a, t_lev_a, h2o_a, clwp_a, ciwp_a;
+        get_radiation_input(thermo, p_lay, p_lev, t_lay_a, t_lev_a, h2o_a, clwp_a, ciwp_a);
+
+        if (sw_rad_server)
+        {
+            // The previous call has to be finished at the latest now.
+            const bool has_tendency = rad_server_pending || (time_rad >= 0.);
+            finish_async();
+
+            // Send the input to the server process, the heating rate is applied once received.
+            time_rad_async = time;
+            #ifdef USEMPI
+            send_to_server(
+                    itime, p_lay, p_lev, t_lay_a, t_lev_a, h2o_a, clwp_a, ciwp_a,
+                    fields.rhoref, thermo.get_exner_vector());
+            #endif
+
+            // Without a previous heating rate, the first call is awaited.
+            if (!has_tendency)
+                finish_async();
+        }
+        else if (sw_async)
+        {
+            // The previous call has to be finished at the latest now.
+            const bool has_tendency = rad_future.valid() || (time_rad >= 0.);
+            finish_async();
+
+            // Solve on a helper thread from a copy of the input, the heating rate is applied once ready.
+            time_rad_async = time;
+            rad_future = std::async(
+                    std::launch::async,
+                    [this, itime,
+                     p_lay = std::move(p_lay), p_lev = std::move(p_lev),
+                     t_lay_a = std::move(t_lay_a), t_lev_a = std::move(t_lev_a),
+                     h2o_a = std::move(h2o_a), clwp_a = std::move(clwp_a), ciwp_a = std::move(ciwp_a),
+                     rhoref = fields.rhoref, exner = thermo.get_exner_vector()]()
+                    {
+                        solve_tendency(
+                                thlt_rad_async, itime,
+                                p_lay, p_lev, t_lay_a, t_lev_a, h2o_a, clwp_a, ciwp_a,
+                                rhoref, exner, false);
+                    });
+
+            // Without a previous heating rate, the first call is awaited.
+            if (!has_tendency)
+                finish_async();
+        }
+        else
+        {
+            // Keep the previous heating rate for the extrapolation.
+            if (sw_tend_extrap)
+            {
+                thlt_rad_prev = fields.sd.at("thlt_rad")->fld;
+                time_rad_prev = time_rad;
+                time_rad = time;
+            }
+
+            // The fluxes of this step are kept for the statistics, cross sections and columns.
+            rad_cache.clear();
+            rad_cache_itime = itime;
+
+            solve_tendency(
+                    fields.sd.at("thlt_rad")->fld, itime,
+                    p_lay, p_lev, t_lay_a, t_lev_a, h2o_a, clwp_a, ciwp_a,
+                    fields.rhoref, thermo.get_exner_vector(), true);
+        }
+    }
+    // Apply a finished heating rate before the next radiation call. The readiness is agreed upon by
+    // all processes, as the heating rate has to be switched at the same step everywhere.
+    else if ((sw_async || sw_rad_server) && !timeloop.in_substep() && async_ready())
+        finish_async();
+
+    // Always add the tendency, extrapolated in time once two radiation calls are available.
+    if (sw_tend_extrap && (time_rad_prev >= 0.) && (time > time_rad))
+    {
+        const TF fac = (time - time_rad) / (time_rad - time_rad_prev);
+
+        add_tendency_extrap(
+                fields.st.at("thl")->fld.data(),
+                fields.sd.at("thlt_rad")->fld.data(),
+                thlt_rad_prev.data(),
+                fac,
+                gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
+                gd.icells, gd.ijcells);
+    }
+    else
+        add_tendency(
+                fields.st.at("thl")->fld.data(),
+                fields.sd.at("thlt_rad")->fld.data(),
+                gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
+                gd.icells, gd.ijcells);
+
+    stats.calc_tend(*fields.st.at("thl"), tend_name);
+}
+#endif
+
+namespace
+{
+    template<typename TF>
+    void add_ghost_cells(
+            TF* restrict out, const double* restrict in,
+            const int istart, const int iend,
+            const int jstart, const int jend,
+            const int kstart, const int kend_field,
+            const int igc, const int jgc, const int kgc,
+            const int jj, const int kk,
+            const int jj_nogc, const int kk_nogc)
+    {
+        // Value of kend_field is either kend or kend+1.
+        #pragma omp parallel for
+        for (int k=kstart; k<kend_field; ++k)
+            for (int j=jstart; j<jend; ++j)
+                #pragma ivdep
+                for (int i=istart; i<iend; ++i)
+                {
+                    const int ijk = i + j*jj + k*kk;
+                    const int ijk_nogc = (i-igc) + (j-jgc)*jj_nogc + (k-kgc)*kk_nogc;
+                    out[ijk] = in[ijk_nogc];
+                }
+    }
+}
+
+template<typename TF>
+void Radiation_rrtmgp<TF>::update_cache(
+        Thermo<TF>& thermo, Timeloop<TF>& timeloop, const unsigned long itime)
+{
+    // Results of another time step are outdated.
+    if (rad_cache_itime != itime)
+    {
+        rad_cache.clear();
+        rad_cache_itime = itime;
+    }
+
+    // Only solve what the tendency calculation of this time step did not provide.
+    const bool do_lw       = sw_longwave  && (rad_cache.count("lw_flux_up") == 0);
+    const bool do_lw_clear = sw_longwave  && sw_clear_sky_stats && (rad_cache.count("lw_flux_up_clear") == 0);
+    const bool do_sw       = sw_shortwave && (rad_cache.count("sw_flux_up") == 0);
+    const bool do_sw_clear = sw_shortwave && sw_clear_sky_stats && (rad_cache.count("sw_flux_up_clear") == 0);
+
+    if ( !(do_lw || do_lw_clear || do_sw || do_sw_clear) )
+        return;
+
+    // The helper thread shares the gas concentrations and column samples of the solver.
+    if (sw_async)
+        finish_async();
+
+    auto& gd = grid.get_grid_data();
+
+    Array<double,2> p_lay, p_lev, t_lay_a, t_lev_a, h2o_a, clwp_a, ciwp_a;
+    get_radiation_input(thermo, p_lay, p_lev, t_lay_a, t_lev_a, h2o_a, clwp_a, ciwp_a);
+
+    const bool compute_clouds = true;
+
+    auto solve_longwave = [&](const bool clouds, const std::string& postfix)
+    {
+        Array<double,2> flux_up ({gd.imax*gd.jmax, gd.ktot+1});
+        Array<double,2> flux_dn ({gd.imax*gd.jmax, gd.ktot+1});
+        Array<double,2> flux_net({gd.imax*gd.jmax, gd.ktot+1});
+
+        exec_longwave(
+                itime, p_lay, p_lev,
+                flux_up, flux_dn, flux_net,
+                t_lay_a, t_lev_a, h2o_a, clwp_a, ciwp_a,
+                clouds);
+
+        rad_cache["lw_flux_up" + postfix] = std::move(flux_up);
+        rad_cache["lw_flux_dn" + postfix] = std::move(flux_dn);
+    };
+
+    auto solve_shortwave = [&](const bool clouds, const std::string& postfix)
+    {
+        Array<double,2> flux_up    ({gd.imax*gd.jmax, gd.ktot+1});
+        Array<double,2> flux_dn    ({gd.imax*gd.jmax, gd.ktot+1});
+        Array<double,2> flux_dn_dir({gd.imax*gd.jmax, gd.ktot+1});
+        Array<double,2> flux_net   ({gd.imax*gd.jmax, gd.ktot+1});
+
+        exec_shortwave(
+                itime, p_lay, p_lev,
+                flux_up, flux_dn, flux_dn_dir, flux_net,
+                t_lay_a, t_lev_a, h2o_a, clwp_a, ciwp_a,
+                clouds);
+
+        rad_cache["sw_flux_up"     + postfix] = std::move(flux_up);
+        rad_cache["sw_flux_dn"     + postfix] = std::move(flux_dn);
+        rad_cache["sw_flux_dn_dir" + postfix] = std::move(flux_dn_dir);
+    };
+
+    if (do_lw)
+        solve_longwave(compute_clouds, "");
+    if (do_lw_clear)
+        solve_longwave(!compute_clouds, "_clear");
+    if (do_sw)
+        solve_shortwave(compute_clouds, "");
+    if (do_sw_clear)
+        solve_shortwave(!compute_clouds, "_clear");
+}
+
+template<typename TF>
+std::vector<std::string> Radiation_rrtmgp<TF>::get_output_names() const
+{
+    std::vector<std::string> names;
+
+    if (sw_longwave)
+    {
+        names.insert(names.end(), {"lw_flux_up", "lw_flux_dn"});
+        if (sw_clear_sky_stats)
+            names.insert(names.end(), {"lw_flux_up_clear", "lw_flux_dn_clear"});
+    }
+
+    if (sw_shortwave)
+    {
+        names.insert(names.end(), {"sw_flux_up", "sw_flux_dn", "sw_flux_dn_dir"});
+        if (sw_clear_sky_stats)
+            names.insert(names.end(), {"sw_flux_up_clear", "sw_flux_dn_clear", "sw_flux_dn_dir_clear"});
+    }
+
+    return names;
+}
+
+template<typename TF>
+void Radiation_rrtmgp<TF>::exec_all_stats(
+        Stats<TF>& stats, Cross<TF>& cross, Dump<TF>& dump,
+        Thermo<TF>& thermo, Timeloop<TF>& timeloop,
+        const unsigned long itime, const int iotime)
+{
+    const bool do_stats = stats.do_statistics(itime);
+    const bool do_cross = cross.do_cross(itime);
+
+    // Return in case of no stats or cross section.
+    if ( !(do_stats || do_cross) )
+        return;
+
+    const TF no_offset = 0.;
+    const TF no_threshold = 0.;
+
+    auto& gd = grid.get_grid_data();
+
+    // Reuse the fluxes of the tendency calculation, if radiation was solved at this time step.
+    update_cache(thermo, timeloop, itime);
+
+    auto tmp = fields.get_tmp();
+    tmp->loc = gd.wloc;
+
+    for (const std::string& name : get_output_names())
+    {
+        const Array<double,2>& array = rad_cache.at(name);
+
+        // Make sure that the top boundary is taken into account in case of fluxes.
+        const int kend = gd.kstart + array.dim(2);
+        add_ghost_cells(
+                tmp->fld.data(), array.ptr(),
+                gd.istart, gd.iend,
+                gd.jstart, gd.jend,
+                gd.kstart, kend,
+                gd.igc, gd.jgc, gd.kgc,
+                gd.icells, gd.ijcells,
+                gd.imax, gd.imax*gd.jmax);
+
+        if (do_stats)
+            stats.calc_stats(name, *tmp, no_offset, no_threshold);
+
+        if (do_cross)
+        {
+            if (std::find(crosslist.begin(), crosslist.end(), name) != crosslist.end())
+                cross.cross_simple(tmp->fld.data(), name, iotime, gd.wloc);
+        }
+    }
+
+    if (sw_shortwave)
         stats.set_time_series("sza", std::acos(mu0));
+
+    fields.release_tmp(tmp);
+}
+
+template<typename TF>
+void Radiation_rrtmgp<TF>::exec_column(Column<TF>& column, Thermo<TF>& thermo, Timeloop<TF>& timeloop)
+{
+    const TF no_offset = 0.;
+
+    auto& gd = grid.get_grid_data();
+
+    update_cache(thermo, timeloop, timeloop.get_itime());
+
+    auto tmp = fields.get_tmp();
+
+    for (const std::string& name : get_output_names())
+    {
+        const Array<double,2>& array = rad_cache.at(name);
+
+        const int kend = gd.kstart + array.dim(2);
+        add_ghost_cells(
+                tmp->fld.data(), array.ptr(),
+                gd.istart, gd.iend,
+                gd.jstart, gd.jend,
+                gd.kstart, kend,
+                gd.igc, gd.jgc, gd.kgc,
+                gd.icells, gd.ijcells,
+                gd.imax, gd.imax*gd.jmax);
+
+        column.calc_column(name, tmp->fld.data(), no_offset);
     }
 
     fields.release_tmp(tmp);
 }
 
+template<typename TF>
+void Radiation_rrtmgp<TF>::sample_columns(const unsigned long itime)
+{
+    auto& gd = grid.get_grid_data();
+
+    const int ts = sample_tile_size;
+    const int itiles = gd.imax / ts;
+    const int jtiles = gd.jmax / ts;
+
+    col_sample.clear();
+    col_sample_id.clear();
+
+    // Pick one random column per tile of ts x ts columns, or all columns without sampling.
+    for (int tj=0; tj<jtiles; ++tj)
+        for (int ti=0; ti<itiles; ++ti)
+        {
+            const unsigned long tile_id =
+                (solve_coordx*itiles + ti) + static_cast<unsigned long>(solve_coordy*jtiles + tj) * (gd.itot/ts);
+
+            const int n = (ts > 1) ?
+                std::min(static_cast<int>(random_uniform(sample_seed, itime, tile_id, stream_col) * ts*ts), ts*ts-1) : 0;
+
+            const int i = ti*ts + n%ts;
+            const int j = tj*ts + n/ts;
+
+            col_sample.push_back(i + j*gd.imax);
+            col_sample_id.push_back(
+                    (solve_coordx*gd.imax + i) + static_cast<unsigned long>(solve_coordy*gd.jmax + j) * gd.itot);
+        }
+}
+
+template<typename TF>
+void Radiation_rrtmgp<TF>::gather_columns(const Array<double,2>& in, Array<double,2>& out) const
+{
+    const int n_col = col_sample.size();
+    const int n_z = in.dim(2);
+
+    out.set_dims({n_col, n_z});
+    for (int k=1; k<=n_z; ++k)
+        for (int n=1; n<=n_col; ++n)
+            out({n, k}) = in({col_sample[n-1]+1, k});
+}
+
+template<typename TF>
+void Radiation_rrtmgp<TF>::expand_columns(const Array<double,2>& in, Array<double,2>& out) const
+{
+    auto& gd = grid.get_grid_data();
+
+    const int ts = sample_tile_size;
+    const int itiles = gd.imax / ts;
+    const int n_z = in.dim(2);
+
+    // Every column of a tile gets the fluxes of the column that was solved in that tile.
+    for (int k=1; k<=n_z; ++k)
+        for (int j=0; j<gd.jmax; ++j)
+            for (int i=0; i<gd.imax; ++i)
+            {
+                const int n = (i/ts) + (j/ts)*itiles;
+                out({i + j*gd.imax + 1, k}) = in({n+1, k});
+            }
+}
+
 template<typename TF>
 void Radiation_rrtmgp<TF>::exec_longwave(
-        Thermo<TF>& thermo, Timeloop<TF>& timeloop, Stats<TF>& stats,
-        Array<double,2>& flux_up, Array<double,2>& flux_dn, Array<double,2>& flux_net,
-        const Array<double,2>& t_lay, const Array<double,2>& t_lev,
-        const Array<double,2>& h2o, const Array<double,2>& clwp, const Array<double,2>& ciwp,
+        const unsigned long itime, const Array<double,2>& p_lay, const Array<double,2>& p_lev,
+        Array<double,2>& flux_up_out, Array<double,2>& flux_dn_out, Array<double,2>& flux_net_out,
+        const Array<double,2>& t_lay_in, const Array<double,2>& t_lev_in,
+        const Array<double,2>& h2o_in, const Array<double,2>& clwp_in, const Array<double,2>& ciwp_in,
         const bool compute_clouds)
 {
-    // How many profiles are solved simultaneously?
-    constexpr int n_col_block = 4;
-
     auto& gd = grid.get_grid_data();
 
     const int n_lay = gd.ktot;
     const int n_lev = gd.ktot+1;
-    const int n_col = gd.imax*gd.jmax;
+
+    // Solve only the sampled columns, the others are reconstructed afterwards.
+    sample_columns(itime);
+    const bool do_col_sample = sample_tile_size > 1;
+    const int n_col = col_sample.size();
+
+    Array<double,2> t_lay_s, t_lev_s, h2o_s, clwp_s, ciwp_s;
+    Array<double,2> flux_up_s, flux_dn_s, flux_net_s;
+
+    if (do_col_sample)
+    {
+        gather_columns(t_lay_in, t_lay_s);
+        gather_columns(t_lev_in, t_lev_s);
+        gather_columns(h2o_in, h2o_s);
+        gather_columns(clwp_in, clwp_s);
+        gather_columns(ciwp_in, ciwp_s);
+
+        flux_up_s .set_dims({n_col, n_lev});
+        flux_dn_s .set_dims({n_col, n_lev});
+        flux_net_s.set_dims({n_col, n_lev});
+    }
+
+    const Array<double,2>& t_lay = do_col_sample ? t_lay_s : t_lay_in;
+    const Array<double,2>& t_lev = do_col_sample ? t_lev_s : t_lev_in;
+    const Array<double,2>& h2o   = do_col_sample ? h2o_s   : h2o_in;
+    const Array<double,2>& clwp  = do_col_sample ? clwp_s  : clwp_in;
+    const Array<double,2>& ciwp  = do_col_sample ? ciwp_s  : ciwp_in;
+
+    Array<double,2>& flux_up  = do_col_sample ? flux_up_s  : flux_up_out;
+    Array<double,2>& flux_dn  = do_col_sample ? flux_dn_s  : flux_dn_out;
+    Array<double,2>& flux_net = do_col_sample ? flux_net_s : flux_net_out;
 
     const int n_blocks = n_col / n_col_block;
     const int n_col_block_left = n_col % n_col_block;
@@ -1255,31 +2140,17 @@ void Radiation_rrtmgp<TF>::exec_longwave(
     const int n_bnd = kdist_lw->get_nband();
     const int n_gpt = kdist_lw->get_ngpt();
 
+    // Solve a random subset of g-points per column, the sum over the subset is scaled to stay unbiased.
+    const int n_gpt_solve = (n_gpt_sample > 0) ? std::min(n_gpt_sample, n_gpt) : n_gpt;
+    const double gpt_fac = static_cast<double>(n_gpt) / n_gpt_solve;
+
     // Set the number of angles to 1.
     const int n_ang = 1;
 
     // Check the dimension ordering. The top is not at 1 in MicroHH, but the surface is.
     const int top_at_1 = 0;
 
-    // Define the pointers for the subsetting.
-    std::unique_ptr<Optical_props_arry<double>> optical_props_subset =
-            std::make_unique<Optical_props_1scl<double>>(n_col_block, n_lay, *kdist_lw);
-    std::unique_ptr<Source_func_lw<double>> sources_subset =
-            std::make_unique<Source_func_lw<double>>(n_col_block, n_lay, *kdist_lw);
-    std::unique_ptr<Optical_props_1scl<double>> cloud_optical_props_subset =
-            std::make_unique<Optical_props_1scl<double>>(n_col_block, n_lay, *cloud_lw);
-
-    std::unique_ptr<Optical_props_arry<double>> optical_props_left =
-            std::make_unique<Optical_props_1scl<double>>(n_col_block_left, n_lay, *kdist_lw);
-    std::unique_ptr<Source_func_lw<double>> sources_left =
-            std::make_unique<Source_func_lw<double>>(n_col_block_left, n_lay, *kdist_lw);
-    std::unique_ptr<Optical_props_1scl<double>> cloud_optical_props_left =
-            std::make_unique<Optical_props_1scl<double>>(n_col_block_left, n_lay, *cloud_lw);
-
     // Define the arrays that contain the subsets.
-    Array<double,2> p_lay(std::vector<double>(thermo.get_p_vector ().begin() + gd.kstart, thermo.get_p_vector ().begin() + gd.kend    ), {1, n_lay});
-    Array<double,2> p_lev(std::vector<double>(thermo.get_ph_vector().begin() + gd.kstart, thermo.get_ph_vector().begin() + gd.kend + 1), {1, n_lev});
-
     Array<double,1> t_sfc(std::vector<double>(1, this->t_sfc), {1});
     Array<double,2> emis_sfc(std::vector<double>(n_bnd, this->emis_sfc), {n_bnd, 1});
 
@@ -1290,83 +2161,47 @@ void Radiation_rrtmgp<TF>::exec_longwave(
     // Lambda function for solving optical properties subset.
     auto call_kernels = [&](
             const int col_s_in, const int col_e_in,
-            std::unique_ptr<Optical_props_arry<double>>& optical_props_subset_in,
-            std::unique_ptr<Optical_props_1scl<double>>& cloud_optical_props_in,
-            Source_func_lw<double>& sources_subset_in,
+            Longwave_work& work,
             const Array<double,2>& emis_sfc_subset_in,
-            const Array<double,2>& lw_flux_dn_inc_subset_in,
-            std::unique_ptr<Fluxes_broadband<double>>& fluxes)
+            const Array<double,2>& lw_flux_dn_inc_subset_in)
     {
+        std::unique_ptr<Optical_props_arry<double>>& optical_props_subset_in = work.optical_props;
+        Source_func_lw<double>& sources_subset_in = work.sources;
+        std::unique_ptr<Fluxes_broadband<double>>& fluxes = work.fluxes;
+
         const int n_col_in = col_e_in - col_s_in + 1;
-        Gas_concs<double> gas_concs_subset(gas_concs, col_s_in, n_col_in);
+        work.gas_concs.set_subset(gas_concs, col_s_in, n_col_in);
+
+        p_lay  .subset_to({{ {col_s_in, col_e_in}, {1, n_lay} }}, work.p_lay);
+        p_lev  .subset_to({{ {col_s_in, col_e_in}, {1, n_lev} }}, work.p_lev);
+        t_lay  .subset_to({{ {col_s_in, col_e_in}, {1, n_lay} }}, work.t_lay);
+        t_sfc  .subset_to({{ {col_s_in, col_e_in} }}, work.t_sfc);
+        col_dry.subset_to({{ {col_s_in, col_e_in}, {1, n_lay} }}, work.col_dry);
+        t_lev  .subset_to({{ {col_s_in, col_e_in}, {1, n_lev} }}, work.t_lev);
 
         kdist_lw->gas_optics(
-                p_lay.subset({{ {col_s_in, col_e_in}, {1, n_lay} }}),
-                p_lev.subset({{ {col_s_in, col_e_in}, {1, n_lev} }}),
-                t_lay.subset({{ {col_s_in, col_e_in}, {1, n_lay} }}),
-                t_sfc.subset({{ {col_s_in, col_e_in} }}),
-                gas_concs_subset,
+                work.p_lay,
+                work.p_lev,
+                work.t_lay,
+                work.t_sfc,
+                work.gas_concs,
                 optical_props_subset_in,
                 sources_subset_in,
-                col_dry.subset({{ {col_s_in, col_e_in}, {1, n_lay} }}),
-                t_lev  .subset({{ {col_s_in, col_e_in}, {1, n_lev} }}) );
+                work.col_dry,
+                work.t_lev);
 
         // 2. Solve the cloud optical properties.
         if (compute_clouds)
         {
-            Array<double,2> clwp_subset(clwp.subset({{ {col_s_in, col_e_in}, {1, n_lay} }}));
-            Array<double,2> ciwp_subset(ciwp.subset({{ {col_s_in, col_e_in}, {1, n_lay} }}));
-
-            // Set the masks.
-            constexpr double mask_min_value = 1e-12; // DALES uses 1e-20.
-
-            Array<int,2> cld_mask_liq({n_col_in, n_lay});
-            for (int i=0; i<cld_mask_liq.size(); ++i)
-                cld_mask_liq.v()[i] = clwp_subset.v()[i] > mask_min_value;
-
-            Array<int,2> cld_mask_ice({n_col_in, n_lay});
-            for (int i=0; i<cld_mask_ice.size(); ++i)
-                cld_mask_ice.v()[i] = ciwp_subset.v()[i] > mask_min_value;
-
-            // Compute the effective droplet radius.
-            Array<double,2> rel({n_col_in, n_lay});
-            Array<double,2> rei({n_col_in, n_lay});
-
-            const double sig_g = 1.34;
-            const double fac = std::exp(std::log(sig_g)*std::log(sig_g)) * 1e6; // Conversion to micron included.
+            Array<double,2>& clwp_subset = work.clwp;
+            Array<double,2>& ciwp_subset = work.ciwp;
+            clwp.subset_to({{ {col_s_in, col_e_in}, {1, n_lay} }}, clwp_subset);
+            ciwp.subset_to({{ {col_s_in, col_e_in}, {1, n_lay} }}, ciwp_subset);
 
-            // CvH: Numbers according to RCEMIP.
-            const double Nc0 = 100.e6;
-            const double Ni0 = 1.e5;
-
-            const double four_third_pi_Nc0_rho_w = (4./3.)*M_PI*Nc0*Constants::rho_w<double>;
-            const double four_third_pi_Ni0_rho_i = (4./3.)*M_PI*Ni0*Constants::rho_i<double>;
-
-            for (int ilay=1; ilay<=n_lay; ++ilay)
-            {
-                // const double layer_mass = (p_lev({1, ilay}) - p_lev({1, ilay+1})) / Constants::grav<double>;
-                const double layer_thickness = gd.dz[ilay + gd.kstart - 1];
-
-                for (int icol=1; icol<=n_col_in; ++icol)
-                {
-                    // Parametrization according to Martin et al., 1994 JAS. Fac multiplication taken from DALES.
-                    // CvH: Potentially better using moments from microphysics.
-                    double rel_value = cld_mask_liq({icol, ilay}) * fac *
-                        std::pow((clwp_subset({icol, ilay})/layer_thickness) / four_third_pi_Nc0_rho_w, (1./3.));
-
-                    // Limit the values between 2.5 and 60.
-                    rel_value = std::max(2.5, std::min(rel_value, 60.));
-                    rel({icol, ilay}) = rel_value;
-
-                    // Calculate the effective radius of ice from the mass and the number concentration.
-                    double rei_value = cld_mask_ice({icol, ilay}) * 1.e6 *
-                        std::pow((ciwp_subset({icol, ilay})/layer_thickness) / four_third_pi_Ni0_rho_i, (1./3.));
-
-                    // Limit the values between 2.5 and 200.
-                    rei_value = std::max(2.5, std::min(rei_value, 200.));
-                    rei({icol, ilay}) = rei_value;
-                }
-            }
+            // Set the masks and compute the effective radii.
+            calc_cloud_props(
+                    work.cld_mask_liq, work.cld_mask_ice, work.rel, work.rei,
+                    clwp_subset, ciwp_subset, gd.dz, gd.kstart);
 
             // Convert to g/m2.
             for (int i=0; i<clwp_subset.size(); ++i)
@@ -1376,28 +2211,44 @@ void Radiation_rrtmgp<TF>::exec_longwave(
                 ciwp_subset.v()[i] *= 1e3;
 
             cloud_lw->cloud_optics(
-                    cld_mask_liq, cld_mask_ice,
+                    work.cld_mask_liq, work.cld_mask_ice,
                     clwp_subset, ciwp_subset,
-                    rel, rei,
-                    *cloud_optical_props_in);
+                    work.rel, work.rei,
+                    *work.cloud_optical_props,
+                    work.cloud_index, work.cloud_fint);
 
             // Add the cloud optical props to the gas optical properties.
             add_to(
                     dynamic_cast<Optical_props_1scl<double>&>(*optical_props_subset_in),
-                    dynamic_cast<Optical_props_1scl<double>&>(*cloud_optical_props_in));
+                    *work.cloud_optical_props);
         }
 
-        Array<double,3> gpt_flux_up({n_col_in, n_lev, n_gpt});
-        Array<double,3> gpt_flux_dn({n_col_in, n_lev, n_gpt});
+        Array<double,3>& gpt_flux_up = work.gpt_flux_up;
+        Array<double,3>& gpt_flux_dn = work.gpt_flux_dn;
 
-        Rte_lw<double>::rte_lw(
-                optical_props_subset_in,
-                top_at_1,
-                sources_subset_in,
-                emis_sfc_subset_in,
-                lw_flux_dn_inc_subset_in,
-                gpt_flux_up, gpt_flux_dn,
-                n_ang);
+        if (n_gpt_solve < n_gpt)
+        {
+            select_gpoints(work.gpt_sel, &col_sample_id[col_s_in-1], n_gpt, sample_seed, itime, stream_lw);
+
+            Rte_lw<double>::rte_lw_gpt_subset(
+                    optical_props_subset_in,
+                    top_at_1,
+                    sources_subset_in,
+                    emis_sfc_subset_in,
+                    lw_flux_dn_inc_subset_in,
+                    work.gpt_sel,
+                    gpt_flux_up, gpt_flux_dn,
+                    n_ang);
+        }
+        else
+            Rte_lw<double>::rte_lw(
+                    optical_props_subset_in,
+                    top_at_1,
+                    sources_subset_in,
+                    emis_sfc_subset_in,
+                    lw_flux_dn_inc_subset_in,
+                    gpt_flux_up, gpt_flux_dn,
+                    n_ang);
 
         fluxes->reduce(gpt_flux_up, gpt_flux_dn, optical_props_subset_in, top_at_1);
 
@@ -1405,69 +2256,94 @@ void Radiation_rrtmgp<TF>::exec_longwave(
         for (int ilev=1; ilev<=n_lev; ++ilev)
             for (int icol=1; icol<=n_col_in; ++icol)
             {
-                flux_up ({icol+col_s_in-1, ilev}) = fluxes->get_flux_up ()({icol, ilev});
-                flux_dn ({icol+col_s_in-1, ilev}) = fluxes->get_flux_dn ()({icol, ilev});
-                flux_net({icol+col_s_in-1, ilev}) = fluxes->get_flux_net()({icol, ilev});
+                flux_up ({icol+col_s_in-1, ilev}) = gpt_fac * fluxes->get_flux_up ()({icol, ilev});
+                flux_dn ({icol+col_s_in-1, ilev}) = gpt_fac * fluxes->get_flux_dn ()({icol, ilev});
+                flux_net({icol+col_s_in-1, ilev}) = gpt_fac * fluxes->get_flux_net()({icol, ilev});
             }
     };
 
-    for (int b=1; b<=n_blocks; ++b)
+    // Solve the blocks of columns in parallel, each thread creates its work objects once.
+    const int n_blocks_total = n_blocks + (n_col_block_left > 0 ? 1 : 0);
+
+    #pragma omp parallel num_threads(n_threads)
     {
-        const int col_s = (b-1) * n_col_block + 1;
-        const int col_e =  b    * n_col_block;
-
-        Array<double,2> emis_sfc_subset = emis_sfc.subset({{ {1, n_bnd}, {col_s, col_e} }});
-        Array<double,2> lw_flux_dn_inc_subset = lw_flux_dn_inc.subset({{ {col_s, col_e}, {1, n_gpt} }});
-        std::unique_ptr<Fluxes_broadband<double>> fluxes_subset =
-                std::make_unique<Fluxes_broadband<double>>(n_col_block, n_lev);
-
-        call_kernels(
-                col_s, col_e,
-                optical_props_subset,
-                cloud_optical_props_subset,
-                *sources_subset,
-                emis_sfc_subset,
-                lw_flux_dn_inc_subset,
-                fluxes_subset);
+        std::unique_ptr<Longwave_work> work_block;
+        std::unique_ptr<Longwave_work> work_left;
+
+        #pragma omp for schedule(dynamic)
+        for (int b=1; b<=n_blocks_total; ++b)
+        {
+            const int col_s = (b-1) * n_col_block + 1;
+            const int col_e = std::min(b * n_col_block, n_col);
+
+            std::unique_ptr<Longwave_work>& work = (b <= n_blocks) ? work_block : work_left;
+            if (!work)
+                work = std::make_unique<Longwave_work>(
+                        col_e-col_s+1, n_lay, n_lev, n_gpt_solve, *kdist_lw, *cloud_lw);
+
+            emis_sfc.subset_to({{ {1, n_bnd}, {col_s, col_e} }}, work->emis_sfc);
+            lw_flux_dn_inc.subset_to({{ {col_s, col_e}, {1, n_gpt} }}, work->lw_flux_dn_inc);
+
+            call_kernels(
+                    col_s, col_e,
+                    *work,
+                    work->emis_sfc,
+                    work->lw_flux_dn_inc);
+        }
     }
 
-    if (n_col_block_left > 0)
+    if (do_col_sample)
     {
-        const int col_s = n_col - n_col_block_left + 1;
-        const int col_e = n_col;
-
-        Array<double,2> emis_sfc_left = emis_sfc.subset({{ {1, n_bnd}, {col_s, col_e} }});
-        Array<double,2> lw_flux_dn_inc_left = lw_flux_dn_inc.subset({{ {col_s, col_e}, {1, n_gpt} }});
-        std::unique_ptr<Fluxes_broadband<double>> fluxes_left =
-                std::make_unique<Fluxes_broadband<double>>(n_col_block_left, n_lev);
-
-        call_kernels(
-                col_s, col_e,
-                optical_props_left,
-                cloud_optical_props_left,
-                *sources_left,
-                emis_sfc_left,
-                lw_flux_dn_inc_left,
-                fluxes_left);
+        expand_columns(flux_up, flux_up_out);
+        expand_columns(flux_dn, flux_dn_out);
+        expand_columns(flux_net, flux_net_out);
     }
 }
 
 template<typename TF>
 void Radiation_rrtmgp<TF>::exec_shortwave(
-        Thermo<TF>& thermo, Timeloop<TF>& timeloop, Stats<TF>& stats,
-        Array<double,2>& flux_up, Array<double,2>& flux_dn, Array<double,2>& flux_dn_dir, Array<double,2>& flux_net,
-        const Array<double,2>& t_lay, const Array<double,2>& t_lev,
-        const Array<double,2>& h2o, const Array<double,2>& clwp, const Array<double,2>& ciwp,
+        const unsigned long itime, const Array<double,2>& p_lay, const Array<double,2>& p_lev,
+        Array<double,2>& flux_up_out, Array<double,2>& flux_dn_out,
+        Array<double,2>& flux_dn_dir_out, Array<double,2>& flux_net_out,
+        const Array<double,2>& t_lay_in, const Array<double,2>& t_lev_in,
+        const Array<double,2>& h2o_in, const Array<double,2>& clwp_in, const Array<double,2>& ciwp_in,
         const bool compute_clouds)
 {
-    // How many profiles are solved simultaneously?
-    constexpr int n_col_block = 4;
-
     auto& gd = grid.get_grid_data();
 
     const int n_lay = gd.ktot;
     const int n_lev = gd.ktot+1;
-    const int n_col = gd.imax*gd.jmax;
+
+    // Solve only the sampled columns, the others are reconstructed afterwards.
+    sample_columns(itime);
+    const bool do_col_sample = sample_tile_size > 1;
+    const int n_col = col_sample.size();
+
+    Array<double,2> t_lay_s, h2o_s, clwp_s, ciwp_s;
+    Array<double,2> flux_up_s, flux_dn_s, flux_dn_dir_s, flux_net_s;
+
+    if (do_col_sample)
+    {
+        gather_columns(t_lay_in, t_lay_s);
+        gather_columns(h2o_in, h2o_s);
+        gather_columns(clwp_in, clwp_s);
+        gather_columns(ciwp_in, ciwp_s);
+
+        flux_up_s    .set_dims({n_col, n_lev});
+        flux_dn_s    .set_dims({n_col, n_lev});
+        flux_dn_dir_s.set_dims({n_col, n_lev});
+        flux_net_s   .set_dims({n_col, n_lev});
+    }
+
+    const Array<double,2>& t_lay = do_col_sample ? t_lay_s : t_lay_in;
+    const Array<double,2>& h2o   = do_col_sample ? h2o_s   : h2o_in;
+    const Array<double,2>& clwp  = do_col_sample ? clwp_s  : clwp_in;
+    const Array<double,2>& ciwp  = do_col_sample ? ciwp_s  : ciwp_in;
+
+    Array<double,2>& flux_up     = do_col_sample ? flux_up_s     : flux_up_out;
+    Array<double,2>& flux_dn     = do_col_sample ? flux_dn_s     : flux_dn_out;
+    Array<double,2>& flux_dn_dir = do_col_sample ? flux_dn_dir_s : flux_dn_dir_out;
+    Array<double,2>& flux_net    = do_col_sample ? flux_net_s    : flux_net_out;
 
     const int n_blocks = n_col / n_col_block;
     const int n_col_block_left = n_col % n_col_block;
@@ -1476,24 +2352,14 @@ void Radiation_rrtmgp<TF>::exec_shortwave(
     const int n_bnd = kdist_sw->get_nband();
     const int n_gpt = kdist_sw->get_ngpt();
 
+    // Solve a random subset of g-points per column, the sum over the subset is scaled to stay unbiased.
+    const int n_gpt_solve = (n_gpt_sample > 0) ? std::min(n_gpt_sample, n_gpt) : n_gpt;
+    const double gpt_fac = static_cast<double>(n_gpt) / n_gpt_solve;
+
     // Check the dimension ordering. The top is not at 1 in MicroHH, but the surface is.
     const int top_at_1 = 0;
 
-    // Define the pointers for the subsetting.
-    std::unique_ptr<Optical_props_arry<double>> optical_props_subset =
-            std::make_unique<Optical_props_2str<double>>(n_col_block, n_lay, *kdist_sw);
-    std::unique_ptr<Optical_props_2str<double>> cloud_optical_props_subset =
-            std::make_unique<Optical_props_2str<double>>(n_col_block, n_lay, *cloud_sw);
-
-    std::unique_ptr<Optical_props_arry<double>> optical_props_left =
-            std::make_unique<Optical_props_2str<double>>(n_col_block_left, n_lay, *kdist_sw);
-    std::unique_ptr<Optical_props_2str<double>> cloud_optical_props_left =
-            std::make_unique<Optical_props_2str<double>>(n_col_block_left, n_lay, *cloud_sw);
-
     // Define the arrays that contain the subsets.
-    Array<double,2> p_lay(std::vector<double>(thermo.get_p_vector ().begin() + gd.kstart, thermo.get_p_vector ().begin() + gd.kend    ), {1, n_lay});
-    Array<double,2> p_lev(std::vector<double>(thermo.get_ph_vector().begin() + gd.kstart, thermo.get_ph_vector().begin() + gd.kend + 1), {1, n_lev});
-
     // Create the boundary conditions
     Array<double,1> mu0(std::vector<double>(1, this->mu0), {1});
     Array<double,2> sfc_alb_dir(std::vector<double>(n_bnd, this->sfc_alb_dir), {n_bnd, 1});
@@ -1509,86 +2375,48 @@ void Radiation_rrtmgp<TF>::exec_shortwave(
     // Lambda function for solving optical properties subset.
     auto call_kernels = [&](
             const int col_s_in, const int col_e_in,
-            std::unique_ptr<Optical_props_arry<double>>& optical_props_subset_in,
-            std::unique_ptr<Optical_props_2str<double>>& cloud_optical_props_in,
+            Shortwave_work& work,
             const Array<double,1>& mu0_subset_in,
             const Array<double,2>& toa_src_subset_in,
             const Array<double,2>& sfc_alb_dir_subset_in,
             const Array<double,2>& sfc_alb_dif_subset_in,
-            const Array<double,2>& sw_flux_dn_dif_inc_subset_in,
-            std::unique_ptr<Fluxes_broadband<double>>& fluxes)
+            const Array<double,2>& sw_flux_dn_dif_inc_subset_in)
     {
+        std::unique_ptr<Optical_props_arry<double>>& optical_props_subset_in = work.optical_props;
+        std::unique_ptr<Fluxes_broadband<double>>& fluxes = work.fluxes;
+
         const int n_col_in = col_e_in - col_s_in + 1;
 
-        Gas_concs<double> gas_concs_subset(gas_concs, col_s_in, n_col_in);
-        Array<double,2> toa_src_dummy({n_col_in, n_gpt});
+        work.gas_concs.set_subset(gas_concs, col_s_in, n_col_in);
+        Array<double,2>& toa_src_dummy = work.toa_src_dummy;
+
+        p_lay  .subset_to({{ {col_s_in, col_e_in}, {1, n_lay} }}, work.p_lay);
+        p_lev  .subset_to({{ {col_s_in, col_e_in}, {1, n_lev} }}, work.p_lev);
+        t_lay  .subset_to({{ {col_s_in, col_e_in}, {1, n_lay} }}, work.t_lay);
+        col_dry.subset_to({{ {col_s_in, col_e_in}, {1, n_lay} }}, work.col_dry);
 
         // 1. Solve the gas optical properties.
         kdist_sw->gas_optics(
-                p_lay.subset({{ {col_s_in, col_e_in}, {1, n_lay} }}),
-                p_lev.subset({{ {col_s_in, col_e_in}, {1, n_lev} }}),
-                t_lay.subset({{ {col_s_in, col_e_in}, {1, n_lay} }}),
-                gas_concs_subset,
+                work.p_lay,
+                work.p_lev,
+                work.t_lay,
+                work.gas_concs,
                 optical_props_subset_in,
                 toa_src_dummy,
-                col_dry.subset({{ {col_s_in, col_e_in}, {1, n_lay} }}) );
+                work.col_dry);
 
         // 2. Solve the cloud optical properties.
         if (compute_clouds)
         {
-            Array<double,2> clwp_subset(clwp.subset({{ {col_s_in, col_e_in}, {1, n_lay} }}));
-            Array<double,2> ciwp_subset(ciwp.subset({{ {col_s_in, col_e_in}, {1, n_lay} }}));
-
-            // Set the masks.
-            constexpr double mask_min_value = 1e-12; // DALES uses 1e-20.
-
-            Array<int,2> cld_mask_liq({n_col_in, n_lay});
-            for (int i=0; i<cld_mask_liq.size(); ++i)
-                cld_mask_liq.v()[i] = clwp_subset.v()[i] > mask_min_value;
-
-            Array<int,2> cld_mask_ice({n_col_in, n_lay});
-            for (int i=0; i<cld_mask_ice.size(); ++i)
-                cld_mask_ice.v()[i] = ciwp_subset.v()[i] > mask_min_value;
-
-            // Compute the effective droplet radius.
-            Array<double,2> rel({n_col_in, n_lay});
-            Array<double,2> rei({n_col_in, n_lay});
-
-            const double sig_g = 1.34;
-            const double fac = std::exp(std::log(sig_g)*std::log(sig_g)) * 1e6; // Conversion to micron included.
-
-            // CvH: Numbers according to RCEMIP.
-            const double Nc0 = 100.e6;
-            const double Ni0 = 1.e5;
-
-            const double four_third_pi_Nc0_rho_w = (4./3.)*M_PI*Nc0*Constants::rho_w<double>;
-            const double four_third_pi_Ni0_rho_i = (4./3.)*M_PI*Ni0*Constants::rho_i<double>;
-
-            for (int ilay=1; ilay<=n_lay; ++ilay)
-            {
-                // const double layer_mass = (p_lev({1, ilay}) - p_lev({1, ilay+1})) / Constants::grav<double>;
-                const double layer_thickness = gd.dz[ilay + gd.kstart - 1];
+            Array<double,2>& clwp_subset = work.clwp;
+            Array<double,2>& ciwp_subset = work.ciwp;
+            clwp.subset_to({{ {col_s_in, col_e_in}, {1, n_lay} }}, clwp_subset);
+            ciwp.subset_to({{ {col_s_in, col_e_in}, {1, n_lay} }}, ciwp_subset);
 
-                for (int icol=1; icol<=n_col_in; ++icol)
-                {
-                    // Parametrization according to Martin et al., 1994 JAS. Fac multiplication taken from DALES.
-                    // CvH: Potentially better using moments from microphysics.
-                    double rel_value = cld_mask_liq({icol, ilay}) * fac *
-                        std::pow((clwp_subset({icol, ilay})/layer_thickness) / four_third_pi_Nc0_rho_w, (1./3.));
-
-                    // Limit the values between 2.5 and 60.
-                    rel_value = std::max(2.5, std::min(rel_value, 60.));
-                    rel({icol, ilay}) = rel_value;
-
-                    // Calculate the effective radius of ice from the mass and the number concentration.
-                    double rei_value = cld_mask_ice({icol, ilay}) * 1.e6 *
-                        std::pow((ciwp_subset({icol, ilay})/layer_thickness) / four_third_pi_Ni0_rho_i, (1./3.));
-
-                    // Limit the values between 2.5 and 200.
-                    rei_value = std::max(2.5, std::min(rei_value, 200.));
-                    rei({icol, ilay}) = rei_value;
-                }
-            }
+            // Set the masks and compute the effective radii.
+            calc_cloud_props(
+                    work.cld_mask_liq, work.cld_mask_ice, work.rel, work.rei,
+                    clwp_subset, ciwp_subset, gd.dz, gd.kstart);
 
             // Convert to g/m2.
             for (int i=0; i<clwp_subset.size(); ++i)
@@ -1598,33 +2426,52 @@ void Radiation_rrtmgp<TF>::exec_shortwave(
                 ciwp_subset.v()[i] *= 1e3;
 
             cloud_sw->cloud_optics(
-                    cld_mask_liq, cld_mask_ice,
+                    work.cld_mask_liq, work.cld_mask_ice,
                     clwp_subset, ciwp_subset,
-                    rel, rei,
-                    *cloud_optical_props_in);
+                    work.rel, work.rei,
+                    *work.cloud_optical_props,
+                    work.cloud_index, work.cloud_fint);
 
             // Add the cloud optical props to the gas optical properties.
             add_to(
                     dynamic_cast<Optical_props_2str<double>&>(*optical_props_subset_in),
-                    dynamic_cast<Optical_props_2str<double>&>(*cloud_optical_props_in));
+                    *work.cloud_optical_props);
         }
 
         // 3. Solve the fluxes.
-        Array<double,3> gpt_flux_up    ({n_col_in, n_lev, n_gpt});
-        Array<double,3> gpt_flux_dn    ({n_col_in, n_lev, n_gpt});
-        Array<double,3> gpt_flux_dn_dir({n_col_in, n_lev, n_gpt});
+        Array<double,3>& gpt_flux_up     = work.gpt_flux_up;
+        Array<double,3>& gpt_flux_dn     = work.gpt_flux_dn;
+        Array<double,3>& gpt_flux_dn_dir = work.gpt_flux_dn_dir;
 
-        Rte_sw<double>::rte_sw(
-                optical_props_subset_in,
-                top_at_1,
-                mu0_subset_in,
-                toa_src_subset_in,
-                sfc_alb_dir_subset_in,
-                sfc_alb_dif_subset_in,
-                sw_flux_dn_dif_inc_subset_in,
-                gpt_flux_up,
-                gpt_flux_dn,
-                gpt_flux_dn_dir);
+        if (n_gpt_solve < n_gpt)
+        {
+            select_gpoints(work.gpt_sel, &col_sample_id[col_s_in-1], n_gpt, sample_seed, itime, stream_sw);
+
+            Rte_sw<double>::rte_sw_gpt_subset(
+                    optical_props_subset_in,
+                    top_at_1,
+                    mu0_subset_in,
+                    toa_src_subset_in,
+                    sfc_alb_dir_subset_in,
+                    sfc_alb_dif_subset_in,
+                    sw_flux_dn_dif_inc_subset_in,
+                    work.gpt_sel,
+                    gpt_flux_up,
+                    gpt_flux_dn,
+                    gpt_flux_dn_dir);
+        }
+        else
+            Rte_sw<double>::rte_sw(
+                    optical_props_subset_in,
+                    top_at_1,
+                    mu0_subset_in,
+                    toa_src_subset_in,
+                    sfc_alb_dir_subset_in,
+                    sfc_alb_dif_subset_in,
+                    sw_flux_dn_dif_inc_subset_in,
+                    gpt_flux_up,
+                    gpt_flux_dn,
+                    gpt_flux_dn_dir);
 
         // 4. Reduce the fluxes to the needed information.
         fluxes->reduce(
@@ -1635,64 +2482,281 @@ void Radiation_rrtmgp<TF>::exec_shortwave(
         for (int ilev=1; ilev<=n_lev; ++ilev)
             for (int icol=1; icol<=n_col_in; ++icol)
             {
-                flux_up    ({icol+col_s_in-1, ilev}) = fluxes->get_flux_up    ()({icol, ilev});
-                flux_dn    ({icol+col_s_in-1, ilev}) = fluxes->get_flux_dn    ()({icol, ilev});
-                flux_dn_dir({icol+col_s_in-1, ilev}) = fluxes->get_flux_dn_dir()({icol, ilev});
-                flux_net   ({icol+col_s_in-1, ilev}) = fluxes->get_flux_net   ()({icol, ilev});
+                flux_up    ({icol+col_s_in-1, ilev}) = gpt_fac * fluxes->get_flux_up    ()({icol, ilev});
+                flux_dn    ({icol+col_s_in-1, ilev}) = gpt_fac * fluxes->get_flux_dn    ()({icol, ilev});
+                flux_dn_dir({icol+col_s_in-1, ilev}) = gpt_fac * fluxes->get_flux_dn_dir()({icol, ilev});
+                flux_net   ({icol+col_s_in-1, ilev}) = gpt_fac * fluxes->get_flux_net   ()({icol, ilev});
             }
     };
 
-    for (int b=1; b<=n_blocks; ++b)
+    // Solve the blocks of columns in parallel, each thread creates its work objects once.
+    const int n_blocks_total = n_blocks + (n_col_block_left > 0 ? 1 : 0);
+
+    #pragma omp parallel num_threads(n_threads)
+    {
+        std::unique_ptr<Shortwave_work> work_block;
+        std::unique_ptr<Shortwave_work> work_left;
+
+        #pragma omp for schedule(dynamic)
+        for (int b=1; b<=n_blocks_total; ++b)
+        {
+            const int col_s = (b-1) * n_col_block + 1;
+            const int col_e = std::min(b * n_col_block, n_col);
+
+            std::unique_ptr<Shortwave_work>& work = (b <= n_blocks) ? work_block : work_left;
+            if (!work)
+                work = std::make_unique<Shortwave_work>(
+                        col_e-col_s+1, n_lay, n_lev, n_gpt, n_gpt_solve, *kdist_sw, *cloud_sw);
+
+            mu0.subset_to({{ {col_s, col_e} }}, work->mu0);
+            sw_flux_dn_dir_inc.subset_to({{ {col_s, col_e}, {1, n_gpt} }}, work->toa_src);
+            sfc_alb_dir.subset_to({{ {1, n_bnd}, {col_s, col_e} }}, work->sfc_alb_dir);
+            sfc_alb_dif.subset_to({{ {1, n_bnd}, {col_s, col_e} }}, work->sfc_alb_dif);
+            sw_flux_dn_dif_inc.subset_to({{ {col_s, col_e}, {1, n_gpt} }}, work->sw_flux_dn_dif_inc);
+
+            call_kernels(
+                    col_s, col_e,
+                    *work,
+                    work->mu0,
+                    work->toa_src,
+                    work->sfc_alb_dir,
+                    work->sfc_alb_dif,
+                    work->sw_flux_dn_dif_inc);
+        }
+    }
+
+    if (do_col_sample)
+    {
+        expand_columns(flux_up, flux_up_out);
+        expand_columns(flux_dn, flux_dn_out);
+        expand_columns(flux_dn_dir, flux_dn_dir_out);
+        expand_columns(flux_net, flux_net_out);
+    }
+}
+
+namespace
+{
+    // Message tags of the communication with the radiation server processes.
+    constexpr int tag_rad_header = 1;
+    constexpr int tag_rad_input  = 2;
+    constexpr int tag_rad_output = 3;
+
+    // A header with this time step signals the server that the model process has finished.
+    constexpr unsigned long itime_rad_finished = std::numeric_limits<unsigned long>::max();
+}
+
+template<typename TF>
+Radiation_rrtmgp<TF>::~Radiation_rrtmgp()
+{
+    // The helper thread may still use the solver.
+    if (rad_future.valid())
+        rad_future.wait();
+
+    #ifdef USEMPI
+    // Receive the pending heating rate and release the server process.
+    if (rad_server_connected)
+    {
+        auto& md = master.get_MPI_data();
+
+        if (rad_server_pending)
+            MPI_Waitall(3, rad_reqs, MPI_STATUSES_IGNORE);
+
+        unsigned long header[3] = {itime_rad_finished, 0, 0};
+        MPI_Send(header, 3, MPI_UNSIGNED_LONG, md.mpiid % md.nprocs_rad, tag_rad_header, md.commrad);
+    }
+    #endif
+}
+
+// Send the boundary conditions of the reference column from the first model process to the servers.
+template<typename TF>
+void Radiation_rrtmgp<TF>::bcast_reference_columns()
+{
+    #ifdef USEMPI
+    auto& md = master.get_MPI_data();
+
+    const int root = md.rad_server ? 0 : ( (md.mpiid == 0) ? MPI_ROOT : MPI_PROC_NULL );
+
+    if (sw_longwave)
+        MPI_Bcast(lw_flux_dn_inc.ptr(), lw_flux_dn_inc.size(), MPI_DOUBLE, root, md.commrad);
+
+    if (sw_shortwave)
+    {
+        MPI_Bcast(sw_flux_dn_dir_inc.ptr(), sw_flux_dn_dir_inc.size(), MPI_DOUBLE, root, md.commrad);
+        MPI_Bcast(sw_flux_dn_dif_inc.ptr(), sw_flux_dn_dif_inc.size(), MPI_DOUBLE, root, md.commrad);
+    }
+    #endif
+}
+
+template<typename TF>
+void Radiation_rrtmgp<TF>::create_server(Input& input, Netcdf_handle& input_nc)
+{
+    // Load the same gas concentrations and optics as the model processes.
+    Netcdf_handle& rad_input_nc = input_nc.get_group("init");
+    load_gas_concs<double>(gas_concs, rad_input_nc, "z");
+
+    if (sw_longwave)
     {
-        const int col_s = (b-1) * n_col_block + 1;
-        const int col_e =  b    * n_col_block;
-
-        Array<double,1> mu0_subset = mu0.subset({{ {col_s, col_e} }});
-        Array<double,2> toa_src_subset = sw_flux_dn_dir_inc.subset({{ {col_s, col_e}, {1, n_gpt} }});
-        Array<double,2> sfc_alb_dir_subset = sfc_alb_dir.subset({{ {1, n_bnd}, {col_s, col_e} }});
-        Array<double,2> sfc_alb_dif_subset = sfc_alb_dif.subset({{ {1, n_bnd}, {col_s, col_e} }});
-        Array<double,2> sw_flux_dn_dif_inc_subset = sw_flux_dn_dif_inc.subset({{ {col_s, col_e}, {1, n_gpt} }});
-
-        std::unique_ptr<Fluxes_broadband<double>> fluxes_subset =
-                std::make_unique<Fluxes_broadband<double>>(n_col_block, n_lev);
-
-        call_kernels(
-                col_s, col_e,
-                optical_props_subset,
-                cloud_optical_props_subset,
-                mu0_subset,
-                toa_src_subset,
-                sfc_alb_dir_subset,
-                sfc_alb_dif_subset,
-                sw_flux_dn_dif_inc_subset,
-                fluxes_subset);
+        kdist_lw = std::make_unique<Gas_optics<double>>(
+                load_and_init_gas_optics(master, gas_concs, coef_lw_file));
+        cloud_lw = std::make_unique<Cloud_optics<double>>(
+                load_and_init_cloud_optics(master, cloud_coef_lw_file));
+
+        lw_flux_dn_inc.set_dims({1, kdist_lw->get_ngpt()});
+    }
+
+    if (sw_shortwave)
+    {
+        kdist_sw = std::make_unique<Gas_optics<double>>(
+                load_and_init_gas_optics(master, gas_concs, coef_sw_file));
+        cloud_sw = std::make_unique<Cloud_optics<double>>(
+                load_and_init_cloud_optics(master, cloud_coef_sw_file));
+
+        sw_flux_dn_dir_inc.set_dims({1, kdist_sw->get_ngpt()});
+        sw_flux_dn_dif_inc.set_dims({1, kdist_sw->get_ngpt()});
     }
 
-    if (n_col_block_left > 0)
+    bcast_reference_columns();
+}
+
+#ifdef USEMPI
+// Pack the input of all columns of this process in one message for the server process, the density
+// and the exner function are sent without ghost cells as the servers might have a different number.
+template<typename TF>
+void Radiation_rrtmgp<TF>::send_to_server(
+        const unsigned long itime,
+        const Array<double,2>& p_lay, const Array<double,2>& p_lev,
+        const Array<double,2>& t_lay_a, const Array<double,2>& t_lev_a,
+        const Array<double,2>& h2o_a, const Array<double,2>& clwp_a, const Array<double,2>& ciwp_a,
+        const std::vector<TF>& rhoref, const std::vector<TF>& exner)
+{
+    auto& gd = grid.get_grid_data();
+    auto& md = master.get_MPI_data();
+
+    rad_send_buffer.clear();
+
+    auto pack = [&](const Array<double,2>& a)
+    {
+        rad_send_buffer.insert(rad_send_buffer.end(), a.v().begin(), a.v().end());
+    };
+
+    pack(p_lay);
+    pack(p_lev);
+    rad_send_buffer.insert(rad_send_buffer.end(), rhoref.begin() + gd.kstart, rhoref.begin() + gd.kend);
+    rad_send_buffer.insert(rad_send_buffer.end(), exner .begin() + gd.kstart, exner .begin() + gd.kend);
+    pack(t_lay_a);
+    pack(t_lev_a);
+    pack(h2o_a);
+    pack(clwp_a);
+    pack(ciwp_a);
+
+    rad_send_header[0] = itime;
+    rad_send_header[1] = md.mpicoordx;
+    rad_send_header[2] = md.mpicoordy;
+
+    rad_recv_buffer.resize(gd.nmax);
+
+    const int server = md.mpiid % md.nprocs_rad;
+
+    MPI_Isend(rad_send_header, 3, MPI_UNSIGNED_LONG, server, tag_rad_header, md.commrad, &rad_reqs[0]);
+    MPI_Isend(rad_send_buffer.data(), rad_send_buffer.size(), MPI_DOUBLE, server, tag_rad_input, md.commrad, &rad_reqs[1]);
+    MPI_Irecv(rad_recv_buffer.data(), gd.nmax, MPI_DOUBLE, server, tag_rad_output, md.commrad, &rad_reqs[2]);
+
+    rad_server_pending = true;
+}
+#endif
+
+// Serve the model processes with mpiid % nprocs_rad equal to the mpiid of this server, until all have finished.
+template<typename TF>
+void Radiation_rrtmgp<TF>::exec_server()
+{
+    #ifdef USEMPI
+    auto& gd = grid.get_grid_data();
+    auto& md = master.get_MPI_data();
+
+    int nprocs_model;
+    MPI_Comm_remote_size(md.commrad, &nprocs_model);
+
+    int n_clients = 0;
+    for (int n=0; n<nprocs_model; ++n)
+        if (n % md.nprocs_rad == md.mpiid)
+            ++n_clients;
+
+    const int n_col = gd.imax*gd.jmax;
+    const int n_lay = gd.ktot;
+    const int n_lev = gd.ktot+1;
+    const int n_buffer = n_lay + n_lev + 2*n_lay + 4*n_col*n_lay + n_col*n_lev;
+
+    std::vector<double> buffer(n_buffer);
+    std::vector<double> result(gd.nmax);
+    std::vector<TF> thlt_rad(gd.ncells);
+    std::vector<TF> rhoref(gd.kcells);
+    std::vector<TF> exner(gd.kcells);
+
+    while (n_clients > 0)
     {
-        const int col_s = n_col - n_col_block_left + 1;
-        const int col_e = n_col;
-
-        Array<double,1> mu0_left = mu0.subset({{ {col_s, col_e} }});
-        Array<double,2> toa_src_left = sw_flux_dn_dir_inc.subset({{ {col_s, col_e}, {1, n_gpt} }});
-        Array<double,2> sfc_alb_dir_left = sfc_alb_dir.subset({{ {1, n_bnd}, {col_s, col_e} }});
-        Array<double,2> sfc_alb_dif_left = sfc_alb_dif.subset({{ {1, n_bnd}, {col_s, col_e} }});
-        Array<double,2> sw_flux_dn_dif_inc_left = sw_flux_dn_dif_inc.subset({{ {col_s, col_e}, {1, n_gpt} }});
-
-        std::unique_ptr<Fluxes_broadband<double>> fluxes_left =
-                std::make_unique<Fluxes_broadband<double>>(n_col_block_left, n_lev);
-
-        call_kernels(
-                col_s, col_e,
-                optical_props_left,
-                cloud_optical_props_left,
-                mu0_left,
-                toa_src_left,
-                sfc_alb_dir_left,
-                sfc_alb_dif_left,
-                sw_flux_dn_dif_inc_left,
-                fluxes_left);
+        unsigned long header[3];
+        MPI_Status status;
+        MPI_Recv(header, 3, MPI_UNSIGNED_LONG, MPI_ANY_SOURCE, tag_rad_header, md.commrad, &status);
+
+        if (header[0] == itime_rad_finished)
+        {
+            --n_clients;
+            continue;
+        }
+
+        const int client = status.MPI_SOURCE;
+        MPI_Recv(buffer.data(), n_buffer, MPI_DOUBLE, client, tag_rad_input, md.commrad, MPI_STATUS_IGNORE);
+
+        // Unpack the input in the order of send_to_server.
+        const double* ptr = buffer.data();
+        auto unpack = [&](const int n)
+        {
+            std::vector<double> v(ptr, ptr+n);
+            ptr += n;
+            return v;
+        };
+
+        Array<double,2> p_lay(unpack(n_lay), {1, n_lay});
+        Array<double,2> p_lev(unpack(n_lev), {1, n_lev});
+
+        std::copy(ptr, ptr+n_lay, rhoref.begin() + gd.kstart);
+        ptr += n_lay;
+        std::copy(ptr, ptr+n_lay, exner.begin() + gd.kstart);
+        ptr += n_lay;
+
+        Array<double,2> t_lay_a(unpack(n_col*n_lay), {n_col, n_lay});
+        Array<double,2> t_lev_a(unpack(n_col*n_lev), {n_col, n_lev});
+        Array<double,2> h2o_a  (unpack(n_col*n_lay), {n_col, n_lay});
+        Array<double,2> clwp_a (unpack(n_col*n_lay), {n_col, n_lay});
+        Array<double,2> ciwp_a (unpack(n_col*n_lay), {n_col, n_lay});
+
+        // Take the random column and g-point samples of the subdomain of the model process.
+        solve_coordx = header[1];
+        solve_coordy = header[2];
+
+        solve_tendency(
+                thlt_rad, header[0],
+                p_lay, p_lev, t_lay_a, t_lev_a, h2o_a, clwp_a, ciwp_a,
+                rhoref, exner, false);
+
+        // Return the heating rate without ghost cells.
+        const int jj_nogc = gd.imax;
+        const int kk_nogc = gd.imax*gd.jmax;
+
+        for (int k=gd.kstart; k<gd.kend; ++k)
+            for (int j=gd.jstart; j<gd.jend; ++j)
+                #pragma ivdep
+                for (int i=gd.istart; i<gd.iend; ++i)
+                {
+                    const int ijk = i + j*gd.icells + k*gd.ijcells;
+                    const int ijk_nogc = (i-gd.igc) + (j-gd.jgc)*jj_nogc + (k-gd.kgc)*kk_nogc;
+                    result[ijk_nogc] = thlt_rad[ijk];
+                }
+
+        MPI_Send(result.data(), gd.nmax, MPI_DOUBLE, client, tag_rad_output, md.commrad);
     }
+    #endif
 }
+
 template class Radiation_rrtmgp<double>;
 template class Radiation_rrtmgp<float>;
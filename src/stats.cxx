@@ -60,9 +60,6 @@ namespace
             return (value > threshold);
     }
 
-    template<typename TF>
-    TF in_mask(const unsigned int mask, const unsigned int flag) { return static_cast<TF>( (mask & flag) != 0 ); }
-
     template<typename TF>
     void set_flag(unsigned int& flag, const int*& restrict nmask, const Mask<TF>& m, const int loc)
     {
@@ -216,11 +213,11 @@ namespace
         }
     }
 
-    // Calculate the number of points contained in the mask.
-    template<typename TF>
+    // Calculate the number of points contained in all masks in a single pass over the mask field.
     void calc_nmask(
-            int* restrict nmask_full, int* restrict nmask_half, int& nmask_bottom,
-            const unsigned int* const mfield, const unsigned int* const mfield_bot, const unsigned int flag, const unsigned int flagh,
+            int* const restrict nmask_full, int* const restrict nmask_half,
+            const unsigned int* const restrict mfield,
+            const unsigned int* const restrict flags, const unsigned int* const restrict flagsh, const int nmasks,
             const int istart, const int iend, const int jstart, const int jend,
             const int kstart, const int kend,
             const int icells, const int ijcells, const int kcells)
@@ -228,30 +225,25 @@ namespace
         #pragma omp parallel for
         for (int k=kstart; k<kend; ++k)
         {
-            nmask_full[k] = 0;
-            nmask_half[k] = 0;
+            // All masks are counted while the level is in cache.
+            for (int n=0; n<nmasks; ++n)
+            {
+                int nfull = 0;
+                int nhalf = 0;
 
-            #pragma omp parallel for reduction (+:nmask_full[k], nmask_half[k]) collapse(2)
-            for (int j=jstart; j<jend; ++j)
-                for (int i=istart; i<iend; ++i)
-                {
-                    const int ijk = i + j*icells + k*ijcells;
-                    nmask_full[k] += in_mask<int>(mfield[ijk], flag );
-                    nmask_half[k] += in_mask<int>(mfield[ijk], flagh);
-                }
-        }
+                for (int j=jstart; j<jend; ++j)
+                    #pragma ivdep
+                    for (int i=istart; i<iend; ++i)
+                    {
+                        const int ijk = i + j*icells + k*ijcells;
+                        nfull += in_mask<int>(mfield[ijk], flags [n]);
+                        nhalf += in_mask<int>(mfield[ijk], flagsh[n]);
+                    }
 
-        nmask_bottom     = 0;
-        // nmask_half[kend] = 0;
-        #pragma omp parallel for reduction (+:nmask_bottom, nmask_half[kend]) collapse(2)
-        for (int j=jstart; j<jend; ++j)
-            for (int i=istart; i<iend; ++i)
-            {
-                const int ij  = i + j*icells;
-                const int ijk = i + j*icells + kend*ijcells;
-                nmask_bottom += in_mask<int>(mfield_bot[ij], flag);
-                // nmask_half[kend] += in_mask<int>(mfield[ijk], flagh);
+                nmask_full[n*kcells + k] = nfull;
+                nmask_half[n*kcells + k] = nhalf;
             }
+        }
     }
 
     template<typename TF>
@@ -298,32 +290,99 @@ namespace
         out = tmp / (itot*jtot);
     }
 
+    // Sums accumulated per mask and level by calc_moment_sums, stored slot by slot over all masks.
+    enum Moment_sum { Sum_plain=0, Sum_frac, Sum_count, Sum_pow1, Sum_pow2, Sum_pow3, Sum_pow4, N_moment_sums };
+
     template<typename TF>
-    void calc_moment(
-            TF* const restrict prof, const TF* const restrict fld, const TF* const restrict fld_mean, const TF offset,
-            const unsigned int* const mask, const unsigned int flag, const int* const nmask, const int power,
+    void calc_moment_sums(
+            double* const restrict sums, double* const restrict shift,
+            const TF* const restrict fld, const TF offset, const TF threshold,
+            const unsigned int* const restrict mask, const unsigned int* const restrict flags,
+            const int* const restrict nmask, const int nmasks,
             const int istart, const int iend, const int jstart, const int jend, const int kstart, const int kend,
-            const int icells, const int ijcells)
+            const int icells, const int ijcells, const int kcells)
     {
         #pragma omp parallel for
         for (int k=kstart; k<kend+1; ++k)
         {
-            if (nmask[k])
+            // Power sums are taken around a value of the level itself to keep them well conditioned.
+            const double c = fld[istart + jstart*icells + k*ijcells];
+            shift[k] = c;
+
+            // All masks are processed while the level is in cache.
+            for (int n=0; n<nmasks; ++n)
             {
-                double tmp = 0.;
+                // Levels without masked points are skipped, which is most of them for sparse masks.
+                if (nmask[n*kcells + k] == 0)
+                    continue;
+
+                double sum = 0.;
+                double frac = 0.;
+                double count = 0.;
+                double pow1 = 0.;
+                double pow2 = 0.;
+                double pow3 = 0.;
+                double pow4 = 0.;
+
                 for (int j=jstart; j<jend; ++j)
                     #pragma ivdep
                     for (int i=istart; i<iend; ++i)
                     {
                         const int ijk  = i + j*icells + k*ijcells;
-                        tmp += in_mask<double>(mask[ijk], flag)*std::pow(fld[ijk] - fld_mean[k] + offset, power);
+                        const double w = in_mask<double>(mask[ijk], flags[n]);
+                        const double a = fld[ijk] - c;
+                        const double a2 = a*a;
+
+                        sum   += w * fld[ijk];
+                        frac  += w * ((fld[ijk] + offset) > threshold);
+                        count += w;
+                        pow1  += w * a;
+                        pow2  += w * a2;
+                        pow3  += w * a2*a;
+                        pow4  += w * a2*a2;
                     }
 
-                prof[k] = tmp / nmask[k];
+                const int nk = n*kcells + k;
+                const int ns = nmasks*kcells;
+                sums[nk + Sum_plain*ns] = sum;
+                sums[nk + Sum_frac *ns] = frac;
+                sums[nk + Sum_count*ns] = count;
+                sums[nk + Sum_pow1 *ns] = pow1;
+                sums[nk + Sum_pow2 *ns] = pow2;
+                sums[nk + Sum_pow3 *ns] = pow3;
+                sums[nk + Sum_pow4 *ns] = pow4;
             }
         }
     }
 
+    // Transform the local power sums around the shift into sums of the 2nd to 4th power of the
+    // deviations from the global mean, which can be summed over all processes.
+    void calc_central_sums(
+            double* const restrict central, const double* const restrict sums,
+            const double* const restrict shift, const double* const restrict mean,
+            const int nmasks, const int kstart, const int kend, const int kcells)
+    {
+        const int ns = nmasks*kcells;
+
+        for (int n=0; n<nmasks; ++n)
+            for (int k=kstart; k<kend+1; ++k)
+            {
+                const int nk = n*kcells + k;
+                const double d  = shift[k] - mean[nk];
+                const double d2 = d*d;
+
+                const double count = sums[nk + Sum_count*ns];
+                const double pow1  = sums[nk + Sum_pow1 *ns];
+                const double pow2  = sums[nk + Sum_pow2 *ns];
+                const double pow3  = sums[nk + Sum_pow3 *ns];
+                const double pow4  = sums[nk + Sum_pow4 *ns];
+
+                central[nk       ] = pow2 + 2.*d*pow1 + d2*count;
+                central[nk +   ns] = pow3 + 3.*d*pow2 + 3.*d2*pow1 + d2*d*count;
+                central[nk + 2*ns] = pow4 + 4.*d*pow3 + 6.*d2*pow2 + 4.*d2*d*pow1 + d2*d2*count;
+            }
+    }
+
     template<typename TF>
     void calc_cov(
             TF* const restrict prof, const TF* const restrict fld1, const TF* const restrict fld1_mean, const TF offset1, const int pow1,
@@ -364,31 +423,6 @@ namespace
     }
 
 
-    template<typename TF>
-    void calc_frac(
-            TF* const restrict prof, const TF* const restrict fld, const TF offset, const TF threshold,
-            const unsigned int* const mask, const unsigned int flag, const int* const nmask,
-            const int istart, const int iend, const int jstart, const int jend, const int kstart, const int kend,
-            const int icells, const int ijcells)
-    {
-        #pragma omp parallel for
-        for (int k=kstart; k<kend+1; ++k)
-        {
-            if (nmask[k])
-            {
-                double tmp = 0.;
-                for (int j=jstart; j<jend; ++j)
-                    #pragma ivdep
-                    for (int i=istart; i<iend; ++i)
-                    {
-                        const int ijk  = i + j*icells + k*ijcells;
-                        tmp += in_mask<double>(mask[ijk], flag)*((fld[ijk] + offset) > threshold);
-                    }
-                prof[k] = tmp / nmask[k];
-            }
-        }
-    }
-
     template<typename TF>
     std::pair<TF, int> calc_path(
             const TF* const restrict data, const TF* const restrict dz, const TF* const restrict rho,
@@ -1110,18 +1144,34 @@ void Stats<TF>::finalize_masks()
     boundary_cyclic.exec(mfield.data());
     boundary_cyclic.exec_2d(mfield_bot.data());
 
+    const int nmasks = masks.size();
+    const int ns = nmasks*gd.kcells;
+
+    std::vector<unsigned int> flags;
+    std::vector<unsigned int> flagsh;
     for (auto& it : masks)
     {
-        // CvH: compute the nmask over the entire depth. Masks need to provide the proper count for
-        // the ghost cells in order to be able to calculate mean profile in ghost cells (needed for budgets).
-        calc_nmask<TF>(
-                it.second.nmask.data(), it.second.nmaskh.data(), it.second.nmask_bot,
-                mfield.data(), mfield_bot.data(), it.second.flag, it.second.flagh,
-                gd.istart, gd.iend, gd.jstart, gd.jend, 0, gd.kcells,
-                gd.icells, gd.ijcells, gd.kcells);
+        flags .push_back(it.second.flag );
+        flagsh.push_back(it.second.flagh);
+    }
+
+    // CvH: compute the nmask over the entire depth. Masks need to provide the proper count for
+    // the ghost cells in order to be able to calculate mean profile in ghost cells (needed for budgets).
+    std::vector<int> nmask_all(2*ns);
+    calc_nmask(
+            nmask_all.data(), nmask_all.data() + ns,
+            mfield.data(), flags.data(), flagsh.data(), nmasks,
+            gd.istart, gd.iend, gd.jstart, gd.jend, 0, gd.kcells,
+            gd.icells, gd.ijcells, gd.kcells);
 
-        master.sum(it.second.nmask.data() , gd.kcells);
-        master.sum(it.second.nmaskh.data(), gd.kcells);
+    master.sum(nmask_all.data(), 2*ns);
+
+    int n = 0;
+    for (auto& it : masks)
+    {
+        std::copy(nmask_all.begin() + n*gd.kcells, nmask_all.begin() + (n+1)*gd.kcells, it.second.nmask.begin());
+        std::copy(nmask_all.begin() + ns + n*gd.kcells, nmask_all.begin() + ns + (n+1)*gd.kcells, it.second.nmaskh.begin());
+        ++n;
 
         it.second.nmask_bot = it.second.nmaskh[gd.kstart];
 
@@ -1223,47 +1273,139 @@ void Stats<TF>::calc_mask_mean_profile(
 }
 
 template<typename TF>
-void Stats<TF>::calc_mask_stats(
+void Stats<TF>::set_mask_mean_prof(
         std::pair<const std::string, Mask<TF>>& m,
+        const std::string& varname, const double* const sum)
+{
+    // Set the mean profile from the masked sums per level, which are already summed over all processes.
+    if (std::find(varlist.begin(), varlist.end(), varname) == varlist.end())
+        return;
+
+    auto& gd = grid.get_grid_data();
+
+    Prof_var<TF>& prof = m.second.profs.at(varname);
+    const int* const nmask = (prof.level == Level_type::Full) ? m.second.nmask.data() : m.second.nmaskh.data();
+
+    for (int k=gd.kstart; k<gd.kend+1; ++k)
+    {
+        if (nmask[k])
+            prof.data[k] = sum[k] / nmask[k];
+    }
+
+    set_fillvalue_prof(prof.data.data(), nmask, gd.kstart, gd.kcells);
+}
+
+template<typename TF>
+void Stats<TF>::calc_moment_stats(
+        std::vector<Mask<TF>*>& mask_list,
         const std::string& varname, const Field3d<TF>& fld, const TF offset, const TF threshold)
 {
+    // Compute the mean, the 2nd to 4th moment and the fraction above the threshold for all masks
+    // in a single traversal of the field.
     auto& gd = grid.get_grid_data();
 
+    auto has_var = [&](const std::string& name)
+    {
+        return std::find(varlist.begin(), varlist.end(), name) != varlist.end();
+    };
+
+    const bool do_mean = has_var(varname);
+    const bool do_frac = has_var(varname + "_frac");
+    bool do_moments = false;
+    for (int power=2; power<=4; ++power)
+        do_moments |= has_var(varname + "_" + std::to_string(power));
+
+    if (!do_mean && !do_frac && !do_moments)
+        return;
+
+    const int nmasks = mask_list.size();
+    const int ns = nmasks*gd.kcells;
+
     unsigned int flag;
     const int* nmask;
-    std::string name;
 
-    // Calc mean
-    if (std::find(varlist.begin(), varlist.end(), varname) != varlist.end())
+    std::vector<unsigned int> flags(nmasks);
+    std::vector<int> nmasks_all(ns);
+    for (int n=0; n<nmasks; ++n)
     {
-        set_flag(flag, nmask, m.second, fld.loc[2]);
-        calc_mean(m.second.profs.at(varname).data.data(), fld.fld.data(), mfield.data(), flag, nmask,
-                gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend, gd.icells, gd.ijcells);
-        master.sum(m.second.profs.at(varname).data.data(), gd.kcells);
+        set_flag(flag, nmask, *mask_list[n], fld.loc[2]);
+        flags[n] = flag;
+        std::copy(nmask, nmask + gd.kcells, nmasks_all.begin() + n*gd.kcells);
+    }
 
-        // Add the offset.
-        for (auto& value : m.second.profs.at(varname).data)
-            value += offset;
+    std::vector<double> sums(N_moment_sums*ns, 0.);
+    std::vector<double> shift(gd.kcells, 0.);
 
-        set_fillvalue_prof(m.second.profs.at(varname).data.data(), nmask, gd.kstart, gd.kcells);
-    }
+    calc_moment_sums(
+            sums.data(), shift.data(), fld.fld.data(), offset, threshold,
+            mfield.data(), flags.data(), nmasks_all.data(), nmasks,
+            gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
+            gd.icells, gd.ijcells, gd.kcells);
+
+    // The plain sums and the threshold counts are stored first and add up over all processes.
+    master.sum(sums.data(), 2*ns);
 
-    // Calc moments
-    for (int power=2; power<=4; power++)
+    std::vector<double> mean(ns, 0.);
+    for (int n=0; n<nmasks; ++n)
     {
-        name = varname + "_" + std::to_string(power);
-        if (std::find(varlist.begin(), varlist.end(), name) != varlist.end())
+        set_flag(flag, nmask, *mask_list[n], fld.loc[2]);
+        for (int k=gd.kstart; k<gd.kend+1; ++k)
         {
-            set_flag(flag, nmask, m.second, fld.loc[2]);
-            calc_moment(
-                    m.second.profs.at(name).data.data(), fld.fld.data(), m.second.profs.at(varname).data.data(), offset, mfield.data(), flag, nmask,
-                    power, gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
-                    gd.icells, gd.ijcells);
+            if (nmask[k])
+                mean[n*gd.kcells + k] = sums[n*gd.kcells + k + Sum_plain*ns] / nmask[k];
+        }
+    }
 
-            master.sum(m.second.profs.at(name).data.data(), gd.kcells);
-            set_fillvalue_prof(m.second.profs.at(name).data.data(), nmask, gd.kstart, gd.kcells);
+    // The power sums are local to this process, and are combined after a shift to the global mean.
+    std::vector<double> central(3*ns, 0.);
+    if (do_moments)
+    {
+        calc_central_sums(
+                central.data(), sums.data(), shift.data(), mean.data(),
+                nmasks, gd.kstart, gd.kend, gd.kcells);
+        master.sum(central.data(), 3*ns);
+    }
+
+    auto set_prof = [&](Mask<TF>& m, const std::string& name, const double* const data, const TF add)
+    {
+        if (!has_var(name))
+            return;
+
+        std::vector<TF>& prof = m.profs.at(name).data;
+        for (int k=gd.kstart; k<gd.kend+1; ++k)
+        {
+            if (nmask[k])
+                prof[k] = data[k] / nmask[k] + add;
         }
+        set_fillvalue_prof(prof.data(), nmask, gd.kstart, gd.kcells);
+    };
+
+    for (int n=0; n<nmasks; ++n)
+    {
+        Mask<TF>& m = *mask_list[n];
+        set_flag(flag, nmask, m, fld.loc[2]);
+
+        set_prof(m, varname, &sums[n*gd.kcells + Sum_plain*ns], offset);
+        for (int power=2; power<=4; ++power)
+            set_prof(m, varname + "_" + std::to_string(power), &central[n*gd.kcells + (power-2)*ns], 0.);
+        set_prof(m, varname + "_frac", &sums[n*gd.kcells + Sum_frac*ns], 0.);
     }
+}
+
+template<typename TF>
+void Stats<TF>::calc_mask_stats(
+        std::pair<const std::string, Mask<TF>>& m,
+        const std::string& varname, const Field3d<TF>& fld, const TF offset, const TF threshold)
+{
+    auto& gd = grid.get_grid_data();
+
+    unsigned int flag;
+    const int* nmask;
+    std::string name;
+
+    // Calc mean, moments and fraction
+    std::vector<Mask<TF>*> mask_list(1, &m.second);
+    calc_moment_stats(mask_list, varname, fld, offset, threshold);
 
     // Calc Resolved Flux
     name = varname + "_w";
@@ -1376,22 +1518,6 @@ void Stats<TF>::calc_mask_stats(
         // Only assign if number of points in mask is positive.
         m.second.tseries.at(name).data = (cover.second > 0) ? TF(cover.first)/TF(cover.second) : 0.;
     }
-
-    // Calc Fraction
-    name = varname + "_frac";
-    auto it1 = std::find(varlist.begin(), varlist.end(), name);
-    if (it1 != varlist.end())
-    {
-        set_flag(flag, nmask, m.second, fld.loc[2]);
-
-        calc_frac(
-                m.second.profs.at(name).data.data(), fld.fld.data(), offset, threshold, mfield.data(), flag, nmask,
-                gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
-                gd.icells, gd.ijcells);
-
-        master.sum(m.second.profs.at(name).data.data(), gd.kcells);
-        set_fillvalue_prof(m.second.profs.at(name).data.data(), nmask, gd.kstart, gd.kcells);
-    }
 }
 
 template<typename TF>
@@ -1404,43 +1530,11 @@ void Stats<TF>::calc_stats(
     const int* nmask;
     std::string name;
 
-    // Calc mean
-    if (std::find(varlist.begin(), varlist.end(), varname) != varlist.end())
-    {
-        for (auto& m : masks)
-        {
-            set_flag(flag, nmask, m.second, fld.loc[2]);
-            calc_mean(m.second.profs.at(varname).data.data(), fld.fld.data(), mfield.data(), flag, nmask,
-                    gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend, gd.icells, gd.ijcells);
-            master.sum(m.second.profs.at(varname).data.data(), gd.kcells);
-
-            // Add the offset.
-            for (auto& value : m.second.profs.at(varname).data)
-                value += offset;
-
-            set_fillvalue_prof(m.second.profs.at(varname).data.data(), nmask, gd.kstart, gd.kcells);
-        }
-    }
-
-    // Calc moments
-    for (int power=2; power<=4; power++)
-    {
-        name = varname + "_" + std::to_string(power);
-        if (std::find(varlist.begin(), varlist.end(), name) != varlist.end())
-        {
-            for (auto& m : masks)
-            {
-                set_flag(flag, nmask, m.second, fld.loc[2]);
-                calc_moment(
-                        m.second.profs.at(name).data.data(), fld.fld.data(), m.second.profs.at(varname).data.data(), offset, mfield.data(), flag, nmask,
-                        power, gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
-                        gd.icells, gd.ijcells);
-
-                master.sum(m.second.profs.at(name).data.data(), gd.kcells);
-                set_fillvalue_prof(m.second.profs.at(name).data.data(), nmask, gd.kstart, gd.kcells);
-            }
-        }
-    }
+    // Calc mean, moments and fraction
+    std::vector<Mask<TF>*> mask_list;
+    for (auto& m : masks)
+        mask_list.push_back(&m.second);
+    calc_moment_stats(mask_list, varname, fld, offset, threshold);
 
     // Calc Resolved Flux
     name = varname + "_w";
@@ -1570,25 +1664,6 @@ void Stats<TF>::calc_stats(
             m.second.tseries.at(name).data = (cover.second > 0) ? TF(cover.first)/TF(cover.second) : 0.;
         }
     }
-
-    // Calc Fraction
-    name = varname + "_frac";
-    auto it1 = std::find(varlist.begin(), varlist.end(), name);
-    if (it1 != varlist.end())
-    {
-        for (auto& m : masks)
-        {
-            set_flag(flag, nmask, m.second, fld.loc[2]);
-
-            calc_frac(
-                    m.second.profs.at(name).data.data(), fld.fld.data(), offset, threshold, mfield.data(), flag, nmask,
-                    gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
-                    gd.icells, gd.ijcells);
-
-            master.sum(m.second.profs.at(name).data.data(), gd.kcells);
-            set_fillvalue_prof(m.second.profs.at(name).data.data(), nmask, gd.kstart, gd.kcells);
-        }
-    }
 }
 
 template<typename TF>
@@ -163,19 +163,21 @@ namespace
 
     template<typename TF>
     void calc_buoyancy_tend_2nd(TF* const restrict wt, const TF* const restrict th, const TF* const restrict threfh,
-                                const int istart, const int iend, const int jstart, const int jend, const int kstart, const int kend,
-                                const int icells, const int ijcells)
+                                const int jstart, const int jend, const int kstart, const int kend,
+                                const int icells, const int ijcells,
+                                const Row_spans& row_spans)
     {
         using Finite_difference::O2::interp2;
 
         for (int k=kstart+1; k<kend; ++k)
             for (int j=jstart; j<jend; ++j)
-                #pragma ivdep
-                for (int i=istart; i<iend; ++i)
-                {
-                    const int ijk = i + j*icells + k*ijcells;
-                    wt[ijk] += grav<TF>/threfh[k] * (interp2(th[ijk-ijcells], th[ijk]) - threfh[k]);
-                }
+                for (int n=row_spans.begin(j, k); n<row_spans.end(j, k); ++n)
+                    #pragma ivdep
+                    for (int i=row_spans.i0[n]; i<row_spans.i1[n]; ++i)
+                    {
+                        const int ijk = i + j*icells + k*ijcells;
+                        wt[ijk] += grav<TF>/threfh[k] * (interp2(th[ijk-ijcells], th[ijk]) - threfh[k]);
+                    }
     }
 
     template<typename TF>
@@ -422,8 +424,8 @@ void Thermo_dry<TF>::exec( const double dt, Stats<TF>& stats)
     if (grid.get_spatial_order() == Grid_order::Second)
     {
         calc_buoyancy_tend_2nd(fields.mt.at("w")->fld.data(), fields.sp.at("th")->fld.data(), bs.threfh.data(),
-                               gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
-                               gd.icells, gd.ijcells);
+                               gd.jstart, gd.jend, gd.kstart, gd.kend,
+                               gd.icells, gd.ijcells, gd.row_spans);
 
         if (swbaroclinic)
             calc_baroclinic_2nd(
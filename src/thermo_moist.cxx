@@ -75,43 +75,46 @@ namespace
             TF* restrict wt, TF* restrict thl, TF* restrict qt,
             TF* restrict ph, TF* restrict thlh, TF* restrict qth,
             TF* restrict ql, TF* restrict qi, TF* restrict thvrefh,
-            const int istart, const int iend,
             const int jstart, const int jend,
             const int kstart, const int kend,
-            const int jj, const int kk)
+            const int jj, const int kk,
+            const Row_spans& row_spans)
     {
         #pragma omp parallel for
         for (int k=kstart+1; k<kend; k++)
         {
             const TF exnh = exner(ph[k]);
             for (int j=jstart; j<jend; j++)
-                #pragma ivdep
-                for (int i=istart; i<iend; i++)
-                {
-                    const int ijk = i + j*jj + k*kk;
-                    const int ij  = i + j*jj;
-                    thlh[ij] = interp2(thl[ijk-kk], thl[ijk]);
-                    qth[ij]  = interp2(qt[ijk-kk], qt[ijk]);
-                }
+                for (int n=row_spans.begin(j, k); n<row_spans.end(j, k); ++n)
+                    #pragma ivdep
+                    for (int i=row_spans.i0[n]; i<row_spans.i1[n]; ++i)
+                    {
+                        const int ijk = i + j*jj + k*kk;
+                        const int ij  = i + j*jj;
+                        thlh[ij] = interp2(thl[ijk-kk], thl[ijk]);
+                        qth[ij]  = interp2(qt[ijk-kk], qt[ijk]);
+                    }
 
             for (int j=jstart; j<jend; j++)
-                #pragma ivdep
-                for (int i=istart; i<iend; i++)
-                {
-                    const int ij  = i + j*jj;
-                    Struct_sat_adjust<TF> ssa = sat_adjust(thlh[ij], qth[ij], ph[k], exnh);
-                    ql[ij] = ssa.ql;
-                    qi[ij] = ssa.qi;
-                }
+                for (int n=row_spans.begin(j, k); n<row_spans.end(j, k); ++n)
+                    #pragma ivdep
+                    for (int i=row_spans.i0[n]; i<row_spans.i1[n]; ++i)
+                    {
+                        const int ij  = i + j*jj;
+                        Struct_sat_adjust<TF> ssa = sat_adjust(thlh[ij], qth[ij], ph[k], exnh);
+                        ql[ij] = ssa.ql;
+                        qi[ij] = ssa.qi;
+                    }
 
             for (int j=jstart; j<jend; j++)
-                #pragma ivdep
-                for (int i=istart; i<iend; i++)
-                {
-                    const int ijk = i + j*jj + k*kk;
-                    const int ij  = i + j*jj;
-                    wt[ijk] += buoyancy(exnh, thlh[ij], qth[ij], ql[ij], qi[ij], thvrefh[k]);
-                }
+                for (int n=row_spans.begin(j, k); n<row_spans.end(j, k); ++n)
+                    #pragma ivdep
+                    for (int i=row_spans.i0[n]; i<row_spans.i1[n]; ++i)
+                    {
+                        const int ijk = i + j*jj + k*kk;
+                        const int ij  = i + j*jj;
+                        wt[ijk] += buoyancy(exnh, thlh[ij], qth[ij], ql[ij], qi[ij], thvrefh[k]);
+                    }
         }
     }
 
@@ -925,8 +928,8 @@ void Thermo_moist<TF>::exec(const double dt, Stats<TF>& stats)
             fields.mt.at("w")->fld.data(), fields.sp.at("thl")->fld.data(), fields.sp.at("qt")->fld.data(), bs.prefh.data(),
             &tmp->fld[0*gd.ijcells], &tmp->fld[1*gd.ijcells],
             &tmp->fld[2*gd.ijcells], &tmp->fld[3*gd.ijcells], bs.thvrefh.data(),
-            gd.istart, gd.iend, gd.jstart, gd.jend, gd.kstart, gd.kend,
-            gd.icells, gd.ijcells);
+            gd.jstart, gd.jend, gd.kstart, gd.kend,
+            gd.icells, gd.ijcells, gd.row_spans);
 
     fields.release_tmp(tmp);
 
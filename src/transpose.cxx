@@ -20,6 +20,8 @@
  * along with MicroHH.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
+#include <string>
 #include "master.h"
 #include "grid.h"
 #include "transpose.h"
@@ -30,6 +32,10 @@ Transpose<TF>::Transpose(Master& masterin, Grid<TF>& gridin) :
     grid(gridin),
     mpi_types_allocated(false)
 {
+    #ifdef USEMPI
+    shared_x = false;
+    shared_y = false;
+    #endif
 }
 
 template<typename TF>
@@ -50,12 +56,61 @@ namespace
     template<typename TF> MPI_Datatype mpi_fp_type();
     template<> MPI_Datatype mpi_fp_type<double>() { return MPI_DOUBLE; }
     template<> MPI_Datatype mpi_fp_type<float>() { return MPI_FLOAT; }
+
+    // Copy the strided block starting at data into a contiguous buffer.
+    template<typename TF>
+    void pack_block(
+            TF* const restrict buf, const TF* const restrict data,
+            const int count, const int length, const int stride)
+    {
+        for (int n=0; n<count; ++n)
+        {
+            const TF* const restrict src = &data[n*stride];
+            TF* const restrict dst = &buf[n*length];
+
+            #pragma ivdep
+            for (int i=0; i<length; ++i)
+                dst[i] = src[i];
+        }
+    }
+
+    // Copy a contiguous buffer into the strided block starting at data.
+    template<typename TF>
+    void unpack_block(
+            TF* const restrict data, const TF* const restrict buf,
+            const int count, const int length, const int stride)
+    {
+        for (int n=0; n<count; ++n)
+        {
+            const TF* const restrict src = &buf[n*length];
+            TF* const restrict dst = &data[n*stride];
+
+            #pragma ivdep
+            for (int i=0; i<length; ++i)
+                dst[i] = src[i];
+        }
+    }
+
+    std::string get_transpose_name(const Transpose_type type)
+    {
+        if (type == Transpose_type::Datatype)
+            return "datatype";
+        else if (type == Transpose_type::Alltoall)
+            return "alltoall";
+        else if (type == Transpose_type::Pairwise)
+            return "pairwise";
+        else if (type == Transpose_type::Persistent)
+            return "persistent";
+        else
+            return "auto";
+    }
 }
 
 template<typename TF>
 void Transpose<TF>::init_mpi()
 {
     auto& gd = grid.get_grid_data();
+    auto& md = master.get_MPI_data();
 
     int datacount, datablock, datastride;
 
@@ -98,6 +153,143 @@ void Transpose<TF>::init_mpi()
     MPI_Type_commit(&transposey2);
 
     mpi_types_allocated = true;
+
+    // Describe the same blocks as {type, count, length, stride, step} for the packed transposes.
+    const Transpose_block block_z  = {&transposez , 1, gd.imax*gd.jmax*gd.kblock, 0, gd.imax*gd.jmax*gd.kblock};
+    const Transpose_block block_x  = {&transposex , gd.jmax*gd.kblock, gd.imax, gd.itot, gd.imax};
+    const Transpose_block block_x2 = {&transposex2, gd.jmax*gd.kblock, gd.iblock, gd.itot, gd.iblock};
+    const Transpose_block block_y  = {&transposey , gd.kblock, gd.iblock*gd.jmax, gd.iblock*gd.jtot, gd.iblock*gd.jmax};
+    const Transpose_block block_y2 = {&transposey2, gd.kblock, gd.iblock*gd.jblock, gd.iblock*gd.jtot, gd.iblock*gd.jblock};
+    const Transpose_block block_z2 = {&transposez2, 1, gd.iblock*gd.jblock*gd.kblock, 0, gd.iblock*gd.jblock*gd.kblock};
+
+    // The persistent messages and the shared memory buffers are added below, if used.
+    plan_zx = {md.commx, md.npx, md.mpicoordx, block_z , block_x , nullptr, {}, nullptr};
+    plan_xz = {md.commx, md.npx, md.mpicoordx, block_x , block_z , nullptr, {}, nullptr};
+    plan_xy = {md.commy, md.npy, md.mpicoordy, block_x2, block_y , nullptr, {}, nullptr};
+    plan_yx = {md.commy, md.npy, md.mpicoordy, block_y , block_x2, nullptr, {}, nullptr};
+    plan_yz = {md.commx, md.npx, md.mpicoordx, block_y2, block_z2, nullptr, {}, nullptr};
+    plan_zy = {md.commx, md.npx, md.mpicoordx, block_z2, block_y2, nullptr, {}, nullptr};
+
+    // In node-aware mode, transposes within a node are done with direct copies through shared memory.
+    if (md.node_aware)
+    {
+        std::vector<TF*> shared_ptrs_x;
+        std::vector<TF*> shared_ptrs_y;
+
+        shared_x = init_shared(md.commx, win_x, shared_ptrs_x);
+        shared_y = init_shared(md.commy, win_y, shared_ptrs_y);
+
+        if (shared_x)
+        {
+            for (Transpose_plan* plan : {&plan_zx, &plan_xz, &plan_yz, &plan_zy})
+            {
+                plan->shared = shared_ptrs_x;
+                plan->shared_win = &win_x;
+            }
+        }
+
+        if (shared_y)
+        {
+            for (Transpose_plan* plan : {&plan_xy, &plan_yx})
+            {
+                plan->shared = shared_ptrs_y;
+                plan->shared_win = &win_y;
+            }
+        }
+    }
+
+    transpose_type = grid.get_transpose_type();
+
+    // The packed buffers are allocated once, as the persistent messages point into them.
+    sendbuf.resize(gd.nmax);
+    recvbuf.resize(gd.nmax);
+
+    if (transpose_type == Transpose_type::Persistent || transpose_type == Transpose_type::Auto)
+    {
+        init_persistent(plan_zx);
+        init_persistent(plan_xz);
+        init_persistent(plan_xy);
+        init_persistent(plan_yx);
+        init_persistent(plan_yz);
+        init_persistent(plan_zy);
+    }
+
+    if (transpose_type == Transpose_type::Auto)
+    {
+        autotune();
+
+        // Store the choice, such that the other transposes on this grid do not retune.
+        grid.set_transpose_type(transpose_type);
+    }
+
+    if (transpose_type != Transpose_type::Persistent)
+    {
+        plan_zx.comm_plan.reset();
+        plan_xz.comm_plan.reset();
+        plan_xy.comm_plan.reset();
+        plan_yx.comm_plan.reset();
+        plan_yz.comm_plan.reset();
+        plan_zy.comm_plan.reset();
+    }
+
+    if (transpose_type == Transpose_type::Datatype)
+    {
+        sendbuf.clear();
+        recvbuf.clear();
+        sendbuf.shrink_to_fit();
+        recvbuf.shrink_to_fit();
+    }
+}
+
+template<typename TF>
+bool Transpose<TF>::init_shared(MPI_Comm comm, MPI_Win& win, std::vector<TF*>& shared_ptrs)
+{
+    auto& gd = grid.get_grid_data();
+
+    int np, np_node;
+    MPI_Comm commnode;
+    MPI_Comm_size(comm, &np);
+    MPI_Comm_split_type(comm, MPI_COMM_TYPE_SHARED, 0, MPI_INFO_NULL, &commnode);
+    MPI_Comm_size(commnode, &np_node);
+    MPI_Comm_free(&commnode);
+
+    // All processes of the communicator have to agree on whether they share a node.
+    int is_shared = (np == np_node && np > 1);
+    MPI_Allreduce(MPI_IN_PLACE, &is_shared, 1, MPI_INT, MPI_MIN, comm);
+
+    if (!is_shared)
+        return false;
+
+    TF* base_ptr;
+    MPI_Win_allocate_shared(gd.nmax*sizeof(TF), sizeof(TF), MPI_INFO_NULL, comm, &base_ptr, &win);
+
+    shared_ptrs.resize(np);
+    for (int n=0; n<np; ++n)
+    {
+        MPI_Aint size;
+        int disp_unit;
+        MPI_Win_shared_query(win, n, &size, &disp_unit, &shared_ptrs[n]);
+    }
+
+    // The window stays in a passive access epoch, synchronization is done with barriers.
+    MPI_Win_lock_all(MPI_MODE_NOCHECK, win);
+
+    return true;
+}
+
+template<typename TF>
+void Transpose<TF>::init_persistent(Transpose_plan& plan)
+{
+    const int blocksize = plan.send.count*plan.send.length;
+    const int tag = 1;
+
+    plan.comm_plan = std::make_unique<Comm_plan>();
+
+    for (int n=0; n<plan.np; ++n)
+    {
+        plan.comm_plan->add_send(&sendbuf[n*blocksize], blocksize, mpi_fp_type<TF>(), n, tag, plan.comm);
+        plan.comm_plan->add_recv(&recvbuf[n*blocksize], blocksize, mpi_fp_type<TF>(), n, tag, plan.comm);
+    }
 }
 
 template<typename TF>
@@ -112,162 +304,265 @@ void Transpose<TF>::exit_mpi()
         MPI_Type_free(&transposey);
         MPI_Type_free(&transposey2);
     }
+
+    if (shared_x)
+    {
+        MPI_Win_unlock_all(win_x);
+        MPI_Win_free(&win_x);
+    }
+
+    if (shared_y)
+    {
+        MPI_Win_unlock_all(win_y);
+        MPI_Win_free(&win_y);
+    }
 }
 
 template<typename TF>
-void Transpose<TF>::exec_zx(TF* const restrict ar, TF* const restrict as)
+void Transpose<TF>::autotune()
 {
     auto& gd = grid.get_grid_data();
     auto& md = master.get_MPI_data();
 
-    const int ncount = 1;
-    const int tag = 1;
+    // In a serial run there is nothing to tune.
+    if (md.nprocs == 1)
+    {
+        transpose_type = Transpose_type::Datatype;
+        return;
+    }
 
-    const int jj = gd.imax;
-    const int kk = gd.imax*gd.jmax;
+    // The plans that go through shared memory do not depend on the transpose type, only the
+    // remaining ones of the full cycle are timed.
+    std::vector<const Transpose_plan*> plans;
+    for (const Transpose_plan* plan : {&plan_zx, &plan_xy, &plan_yz, &plan_zy, &plan_yx, &plan_xz})
+        if (plan->shared.empty())
+            plans.push_back(plan);
 
-    for (int n=0; n<md.npx; ++n)
+    if (plans.empty())
     {
-        // Determine where to fetch the data and where to store it.
-        const int ijks = n*gd.kblock*kk;
-        const int ijkr = n*jj;
+        transpose_type = Transpose_type::Datatype;
+        master.print_message("All transposes go through shared memory, no transpose type selected\n");
+        return;
+    }
 
-        // Send and receive the data.
-        MPI_Isend(&as[ijks], ncount, transposez, n, tag, md.commx, master.get_request_ptr());
-        MPI_Irecv(&ar[ijkr], ncount, transposex, n, tag, md.commx, master.get_request_ptr());
+    const std::vector<Transpose_type> types = {
+        Transpose_type::Datatype, Transpose_type::Alltoall,
+        Transpose_type::Pairwise, Transpose_type::Persistent};
+
+    const int n_repeat = 3;
+
+    std::vector<TF> a(gd.nmax, TF(0.));
+    std::vector<TF> b(gd.nmax, TF(0.));
+
+    std::vector<double> timings(types.size());
+
+    for (size_t n=0; n<types.size(); ++n)
+    {
+        transpose_type = types[n];
+
+        // Do one full cycle as warm up before timing it.
+        for (int i=0; i<n_repeat+1; ++i)
+        {
+            if (i == 1)
+            {
+                MPI_Barrier(md.commxy);
+                timings[n] = master.get_wall_clock_time();
+            }
+
+            for (const Transpose_plan* plan : plans)
+            {
+                exec(*plan, b.data(), a.data());
+                std::swap(a, b);
+            }
+        }
+
+        timings[n] = master.get_wall_clock_time() - timings[n];
     }
 
-    master.wait_all();
+    // The slowest process determines the cost of a transpose.
+    master.max(timings.data(), timings.size());
+
+    const size_t n_best = std::min_element(timings.begin(), timings.end()) - timings.begin();
+    transpose_type = types[n_best];
+
+    std::string msg = "Transpose timings:";
+    for (size_t n=0; n<types.size(); ++n)
+        msg += " " + get_transpose_name(types[n]) + " = " + std::to_string(timings[n]/n_repeat) + " s";
+    master.print_message(msg);
+    master.print_message("Selected transpose type: " + get_transpose_name(transpose_type));
 }
 
 template<typename TF>
-void Transpose<TF>::exec_xz(TF* const restrict ar, TF* const restrict as)
+void Transpose<TF>::exec(const Transpose_plan& plan, TF* const restrict ar, TF* const restrict as)
 {
-    auto& gd = grid.get_grid_data();
-    auto& md = master.get_MPI_data();
+    if (!plan.shared.empty())
+        exec_shared(plan, ar, as);
+    else if (transpose_type == Transpose_type::Alltoall)
+        exec_alltoall(plan, ar, as);
+    else if (transpose_type == Transpose_type::Pairwise)
+        exec_pairwise(plan, ar, as);
+    else if (transpose_type == Transpose_type::Persistent)
+        exec_persistent(plan, ar, as);
+    else
+        exec_datatype(plan, ar, as);
+}
 
+template<typename TF>
+void Transpose<TF>::exec_datatype(const Transpose_plan& plan, TF* const restrict ar, TF* const restrict as)
+{
     const int ncount = 1;
     const int tag = 1;
 
-    const int jj = gd.imax;
-    const int kk = gd.imax*gd.jmax;
-
-    for (int n=0; n<md.npx; ++n)
+    for (int n=0; n<plan.np; ++n)
     {
         // Determine where to fetch the data and where to store it.
-        const int ijks = n*jj;
-        const int ijkr = n*gd.kblock*kk;
+        const int ijks = n*plan.send.step;
+        const int ijkr = n*plan.recv.step;
 
         // Send and receive the data.
-        MPI_Isend(&as[ijks], ncount, transposex, n, tag, md.commx, master.get_request_ptr());
-        MPI_Irecv(&ar[ijkr], ncount, transposez, n, tag, md.commx, master.get_request_ptr());
+        MPI_Isend(&as[ijks], ncount, *plan.send.type, n, tag, plan.comm, master.get_request_ptr());
+        MPI_Irecv(&ar[ijkr], ncount, *plan.recv.type, n, tag, plan.comm, master.get_request_ptr());
     }
 
     master.wait_all();
 }
 
 template<typename TF>
-void Transpose<TF>::exec_xy(TF* const restrict ar, TF* const restrict as)
+void Transpose<TF>::exec_alltoall(const Transpose_plan& plan, TF* const restrict ar, TF* const restrict as)
 {
-    auto& gd = grid.get_grid_data();
-    auto& md = master.get_MPI_data();
+    const Transpose_block& sb = plan.send;
+    const Transpose_block& rb = plan.recv;
 
-    const int ncount = 1;
-    const int tag = 1;
+    const int blocksize = sb.count*sb.length;
 
-    const int jj = gd.iblock;
-    const int kk = gd.iblock*gd.jmax;
+    // Blocks that are already laid out contiguously per process can be communicated in place.
+    const bool send_in_place = (sb.count == 1 && sb.step == blocksize);
+    const bool recv_in_place = (rb.count == 1 && rb.step == blocksize);
 
-    for (int n=0; n<md.npy; ++n)
-    {
-        // determine where to fetch the data and where to store it
-        const int ijks = n*jj;
-        const int ijkr = n*kk;
+    TF* const send_ptr = send_in_place ? as : sendbuf.data();
+    TF* const recv_ptr = recv_in_place ? ar : recvbuf.data();
 
-        // send and receive the data
-        MPI_Isend(&as[ijks], ncount, transposex2, n, tag, md.commy, master.get_request_ptr());
-        MPI_Irecv(&ar[ijkr], ncount, transposey , n, tag, md.commy, master.get_request_ptr());
-    }
+    if (!send_in_place)
+        for (int n=0; n<plan.np; ++n)
+            pack_block(&sendbuf[n*blocksize], &as[n*sb.step], sb.count, sb.length, sb.stride);
 
-    master.wait_all();
+    MPI_Alltoall(
+            send_ptr, blocksize, mpi_fp_type<TF>(),
+            recv_ptr, blocksize, mpi_fp_type<TF>(), plan.comm);
+
+    if (!recv_in_place)
+        for (int n=0; n<plan.np; ++n)
+            unpack_block(&ar[n*rb.step], &recvbuf[n*blocksize], rb.count, rb.length, rb.stride);
 }
 
 template<typename TF>
-void Transpose<TF>::exec_yx(TF* const restrict ar, TF* const restrict as)
+void Transpose<TF>::exec_pairwise(const Transpose_plan& plan, TF* const restrict ar, TF* const restrict as)
 {
-    auto& gd = grid.get_grid_data();
-    auto& md = master.get_MPI_data();
+    const Transpose_block& sb = plan.send;
+    const Transpose_block& rb = plan.recv;
 
-    const int ncount = 1;
+    const int blocksize = sb.count*sb.length;
     const int tag = 1;
 
-    const int jj = gd.iblock;
-    const int kk = gd.iblock*gd.jmax;
-
-    for (int n=0; n<md.npy; ++n)
+    // In step p every process sends to rank+p and receives from rank-p,
+    // such that every process has exactly one partner per step.
+    for (int p=0; p<plan.np; ++p)
     {
-        // determine where to fetch the data and where to store it
-        const int ijks = n*kk;
-        const int ijkr = n*jj;
-
-        // send and receive the data
-        MPI_Isend(&as[ijks], ncount, transposey , n, tag, md.commy, master.get_request_ptr());
-        MPI_Irecv(&ar[ijkr], ncount, transposex2, n, tag, md.commy, master.get_request_ptr());
+        const int n_send = (plan.rank + p) % plan.np;
+        const int n_recv = (plan.rank - p + plan.np) % plan.np;
+
+        pack_block(sendbuf.data(), &as[n_send*sb.step], sb.count, sb.length, sb.stride);
+
+        if (p == 0)
+            unpack_block(&ar[n_recv*rb.step], sendbuf.data(), rb.count, rb.length, rb.stride);
+        else
+        {
+            MPI_Sendrecv(
+                    sendbuf.data(), blocksize, mpi_fp_type<TF>(), n_send, tag,
+                    recvbuf.data(), blocksize, mpi_fp_type<TF>(), n_recv, tag,
+                    plan.comm, MPI_STATUS_IGNORE);
+
+            unpack_block(&ar[n_recv*rb.step], recvbuf.data(), rb.count, rb.length, rb.stride);
+        }
     }
+}
 
-    master.wait_all();
+template<typename TF>
+void Transpose<TF>::exec_persistent(const Transpose_plan& plan, TF* const restrict ar, TF* const restrict as)
+{
+    const Transpose_block& sb = plan.send;
+    const Transpose_block& rb = plan.recv;
+
+    const int blocksize = sb.count*sb.length;
+
+    for (int n=0; n<plan.np; ++n)
+        pack_block(&sendbuf[n*blocksize], &as[n*sb.step], sb.count, sb.length, sb.stride);
+
+    plan.comm_plan->exec();
+
+    for (int n=0; n<plan.np; ++n)
+        unpack_block(&ar[n*rb.step], &recvbuf[n*blocksize], rb.count, rb.length, rb.stride);
 }
 
 template<typename TF>
-void Transpose<TF>::exec_yz(TF* const restrict ar, TF* const restrict as)
+void Transpose<TF>::exec_shared(const Transpose_plan& plan, TF* const restrict ar, TF* const restrict as)
 {
-    auto& gd = grid.get_grid_data();
-    auto& md = master.get_MPI_data();
+    const Transpose_block& sb = plan.send;
+    const Transpose_block& rb = plan.recv;
 
-    const int ncount = 1;
-    const int tag = 1;
+    const int blocksize = sb.count*sb.length;
 
-    const int jj = gd.iblock;
-    const int kk = gd.iblock*gd.jblock;
+    // Every process packs its outgoing blocks into its own part of the shared window.
+    TF* const restrict own = plan.shared[plan.rank];
+    for (int n=0; n<plan.np; ++n)
+        pack_block(&own[n*blocksize], &as[n*sb.step], sb.count, sb.length, sb.stride);
 
-    for (int n=0; n<md.npx; ++n)
-    {
-        // determine where to fetch the data and where to store it
-        const int ijks = n*gd.jblock*jj;
-        const int ijkr = n*gd.kblock*kk;
+    MPI_Win_sync(*plan.shared_win);
+    MPI_Barrier(plan.comm);
+    MPI_Win_sync(*plan.shared_win);
 
-        // send and receive the data
-        MPI_Isend(&as[ijks], ncount, transposey2, n, tag, md.commx, master.get_request_ptr());
-        MPI_Irecv(&ar[ijkr], ncount, transposez2, n, tag, md.commx, master.get_request_ptr());
-    }
+    // Copy the blocks destined for this process directly out of the windows of the others.
+    for (int n=0; n<plan.np; ++n)
+        unpack_block(&ar[n*rb.step], &plan.shared[n][plan.rank*blocksize], rb.count, rb.length, rb.stride);
 
-    master.wait_all();
+    // Make sure that nobody overwrites its window before all processes have read it.
+    MPI_Barrier(plan.comm);
 }
 
 template<typename TF>
-void Transpose<TF>::exec_zy(TF* const restrict ar, TF* const restrict as)
+void Transpose<TF>::exec_zx(TF* const restrict ar, TF* const restrict as)
 {
-    auto& gd = grid.get_grid_data();
-    auto& md = master.get_MPI_data();
+    exec(plan_zx, ar, as);
+}
 
-    const int ncount = 1;
-    const int tag = 1;
+template<typename TF>
+void Transpose<TF>::exec_xz(TF* const restrict ar, TF* const restrict as)
+{
+    exec(plan_xz, ar, as);
+}
 
-    const int jj = gd.iblock;
-    const int kk = gd.iblock*gd.jblock;
+template<typename TF>
+void Transpose<TF>::exec_xy(TF* const restrict ar, TF* const restrict as)
+{
+    exec(plan_xy, ar, as);
+}
 
-    for (int n=0; n<md.npx; ++n)
-    {
-        // determine where to fetch the data and where to store it
-        const int ijks = n*gd.kblock*kk;
-        const int ijkr = n*gd.jblock*jj;
+template<typename TF>
+void Transpose<TF>::exec_yx(TF* const restrict ar, TF* const restrict as)
+{
+    exec(plan_yx, ar, as);
+}
 
-        // send and receive the data
-        MPI_Isend(&as[ijks], ncount, transposez2, n, tag, md.commx, master.get_request_ptr());
-        MPI_Irecv(&ar[ijkr], ncount, transposey2, n, tag, md.commx, master.get_request_ptr());
-    }
+template<typename TF>
+void Transpose<TF>::exec_yz(TF* const restrict ar, TF* const restrict as)
+{
+    exec(plan_yz, ar, as);
+}
 
-    master.wait_all();
+template<typename TF>
+void Transpose<TF>::exec_zy(TF* const restrict ar, TF* const restrict as)
+{
+    exec(plan_zy, ar, as);
 }
 #else
 
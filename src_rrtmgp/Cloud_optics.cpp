@@ -22,8 +22,13 @@
  *
  */
 
+#include <vector>
+#include <algorithm>
+
 #include "Cloud_optics.h"
 
+#define restrict RESTRICTKEYWORD
+
 template<typename TF>
 Cloud_optics<TF>::Cloud_optics(
         const Array<TF,2>& band_lims_wvn,
@@ -67,32 +72,50 @@ Cloud_optics<TF>::Cloud_optics(
         }
 }
 
+// Compute the lookup index and interpolation factor of each cell once, as they are shared
+// by the extinction, single scattering albedo and asymmetry tables.
+template<typename TF>
+void compute_table_index(
+        const int ncells, const Array<TF,2>& size, const int nsteps,
+        const TF step_size, const TF offset,
+        std::vector<int>& index, std::vector<TF>& fint)
+{
+    index.resize(ncells);
+    fint.resize(ncells);
+
+    const TF* restrict size_ptr = size.ptr();
+
+    #pragma ivdep
+    for (int n=0; n<ncells; ++n)
+    {
+        const TF size_scaled = (size_ptr[n] - offset) / step_size;
+        index[n] = std::max(std::min(static_cast<int>(size_scaled) + 1, nsteps-1), 1);
+        fint[n] = size_scaled - (index[n]-1);
+    }
+}
+
+// Interpolate a table per band, with the contiguous cells in the inner loop.
 template<typename TF>
 void compute_from_table(
-        const int ncol, const int nlay, const int nbnd,
-        const Array<int,2>& mask, const Array<TF,2>& size, const int nsteps,
-        const TF step_size, const TF offset, const Array<TF,2>& table,
-        Array<TF,3>& out)
+        const int ncells, const int nbnd, const Array<int,2>& mask,
+        const std::vector<int>& index, const std::vector<TF>& fint,
+        const Array<TF,2>& table, Array<TF,3>& out)
 {
-    for (int ilay=1; ilay<=nlay; ++ilay)
-        for (int icol=1; icol<=ncol; ++icol)
-        {
-            if (mask({icol, ilay}))
-            {
-                const int index = std::min(
-                        static_cast<int>((size({icol, ilay}) - offset) / step_size) + 1, nsteps-1);
-                const TF fint = (size({icol, ilay}) - offset) / step_size - (index-1);
+    const int nsize = table.dim(1);
+    const int* restrict mask_ptr = mask.ptr();
 
-                for (int ibnd=1; ibnd<=nbnd; ++ibnd)
-                    out({icol, ilay, ibnd}) =
-                            table({index, ibnd}) + fint * (table({index+1, ibnd}) - table({index, ibnd}));
-            }
-            else
-            {
-                for (int ibnd=1; ibnd<=nbnd; ++ibnd)
-                    out({icol, ilay, ibnd}) = TF(0.);
-            }
+    for (int ibnd=1; ibnd<=nbnd; ++ibnd)
+    {
+        const TF* restrict table_bnd = table.ptr() + (ibnd-1)*nsize;
+        TF* restrict out_bnd = out.ptr() + (ibnd-1)*ncells;
+
+        #pragma ivdep
+        for (int n=0; n<ncells; ++n)
+        {
+            const TF value = table_bnd[index[n]-1] + fint[n] * (table_bnd[index[n]] - table_bnd[index[n]-1]);
+            out_bnd[n] = mask_ptr[n] ? value : TF(0.);
         }
+    }
 }
 
 // Two-stream variant of cloud optics.
@@ -101,7 +124,8 @@ void Cloud_optics<TF>::cloud_optics(
         const Array<int,2>& liqmsk, const Array<int,2>& icemsk,
         const Array<TF,2>& clwp, const Array<TF,2>& ciwp,
         const Array<TF,2>& reliq, const Array<TF,2>& reice,
-        Optical_props_2str<TF>& optical_props)
+        Optical_props_2str<TF>& optical_props,
+        std::vector<int>& index, std::vector<TF>& fint)
 {
     const int ncol = clwp.dim(1);
     const int nlay = clwp.dim(2);
@@ -111,23 +135,12 @@ void Cloud_optics<TF>::cloud_optics(
     Optical_props_2str<TF> clouds_ice(ncol, nlay, optical_props);
 
     // Liquid water.
-    compute_from_table(
-            ncol, nlay, nbnd, liqmsk, reliq,
-            this->liq_nsteps, this->liq_step_size,
-            this->radliq_lwr, this->lut_extliq,
-            clouds_liq.get_tau());
-
-    compute_from_table(
-            ncol, nlay, nbnd, liqmsk, reliq,
-            this->liq_nsteps, this->liq_step_size,
-            this->radliq_lwr, this->lut_ssaliq,
-            clouds_liq.get_ssa());
-
-    compute_from_table(
-            ncol, nlay, nbnd, liqmsk, reliq,
-            this->liq_nsteps, this->liq_step_size,
-            this->radliq_lwr, this->lut_asyliq,
-            clouds_liq.get_g());
+    compute_table_index(
+            ncol*nlay, reliq, this->liq_nsteps, this->liq_step_size,
+            this->radliq_lwr, index, fint);
+    compute_from_table(ncol*nlay, nbnd, liqmsk, index, fint, this->lut_extliq, clouds_liq.get_tau());
+    compute_from_table(ncol*nlay, nbnd, liqmsk, index, fint, this->lut_ssaliq, clouds_liq.get_ssa());
+    compute_from_table(ncol*nlay, nbnd, liqmsk, index, fint, this->lut_asyliq, clouds_liq.get_g());
 
     for (int ibnd=1; ibnd<=nbnd; ++ibnd)
         for (int ilay=1; ilay<=nlay; ++ilay)
@@ -136,23 +149,12 @@ void Cloud_optics<TF>::cloud_optics(
                 clouds_liq.get_tau()({icol, ilay, ibnd}) *= clwp({icol, ilay});
 
     // Ice.
-    compute_from_table(
-            ncol, nlay, nbnd, icemsk, reice,
-            this->ice_nsteps, this->ice_step_size,
-            this->radice_lwr, this->lut_extice,
-            clouds_ice.get_tau());
-
-    compute_from_table(
-            ncol, nlay, nbnd, icemsk, reice,
-            this->ice_nsteps, this->ice_step_size,
-            this->radice_lwr, this->lut_ssaice,
-            clouds_ice.get_ssa());
-
-    compute_from_table(
-            ncol, nlay, nbnd, icemsk, reice,
-            this->ice_nsteps, this->ice_step_size,
-            this->radice_lwr, this->lut_asyice,
-            clouds_ice.get_g());
+    compute_table_index(
+            ncol*nlay, reice, this->ice_nsteps, this->ice_step_size,
+            this->radice_lwr, index, fint);
+    compute_from_table(ncol*nlay, nbnd, icemsk, index, fint, this->lut_extice, clouds_ice.get_tau());
+    compute_from_table(ncol*nlay, nbnd, icemsk, index, fint, this->lut_ssaice, clouds_ice.get_ssa());
+    compute_from_table(ncol*nlay, nbnd, icemsk, index, fint, this->lut_asyice, clouds_ice.get_g());
 
     for (int ibnd=1; ibnd<=nbnd; ++ibnd)
         for (int ilay=1; ilay<=nlay; ++ilay)
@@ -183,7 +185,8 @@ void Cloud_optics<TF>::cloud_optics(
         const Array<int,2>& liqmsk, const Array<int,2>& icemsk,
         const Array<TF,2>& clwp, const Array<TF,2>& ciwp,
         const Array<TF,2>& reliq, const Array<TF,2>& reice,
-        Optical_props_1scl<TF>& optical_props)
+        Optical_props_1scl<TF>& optical_props,
+        std::vector<int>& index, std::vector<TF>& fint)
 {
     const int ncol = clwp.dim(1);
     const int nlay = clwp.dim(2);
@@ -193,11 +196,10 @@ void Cloud_optics<TF>::cloud_optics(
     Optical_props_1scl<TF> clouds_ice(ncol, nlay, optical_props);
 
     // Liquid water.
-    compute_from_table(
-            ncol, nlay, nbnd, liqmsk, reliq,
-            this->liq_nsteps, this->liq_step_size,
-            this->radliq_lwr, this->lut_extliq,
-            clouds_liq.get_tau());
+    compute_table_index(
+            ncol*nlay, reliq, this->liq_nsteps, this->liq_step_size,
+            this->radliq_lwr, index, fint);
+    compute_from_table(ncol*nlay, nbnd, liqmsk, index, fint, this->lut_extliq, clouds_liq.get_tau());
 
     for (int ibnd=1; ibnd<=nbnd; ++ibnd)
         for (int ilay=1; ilay<=nlay; ++ilay)
@@ -206,11 +208,10 @@ void Cloud_optics<TF>::cloud_optics(
                 clouds_liq.get_tau()({icol, ilay, ibnd}) *= clwp({icol, ilay});
 
     // Ice.
-    compute_from_table(
-            ncol, nlay, nbnd, icemsk, reice,
-            this->ice_nsteps, this->ice_step_size,
-            this->radice_lwr, this->lut_extice,
-            clouds_ice.get_tau());
+    compute_table_index(
+            ncol*nlay, reice, this->ice_nsteps, this->ice_step_size,
+            this->radice_lwr, index, fint);
+    compute_from_table(ncol*nlay, nbnd, icemsk, index, fint, this->lut_extice, clouds_ice.get_tau());
 
     for (int ibnd=1; ibnd<=nbnd; ++ibnd)
         for (int ilay=1; ilay<=nlay; ++ilay)
@@ -27,17 +27,22 @@
 
 template<typename TF>
 Gas_concs<TF>::Gas_concs(const Gas_concs& gas_concs_ref, const int start, const int size)
+{
+    set_subset(gas_concs_ref, start, size);
+}
+
+template<typename TF>
+void Gas_concs<TF>::set_subset(const Gas_concs& gas_concs_ref, const int start, const int size)
 {
     const int end = start + size - 1;
     for (auto& g : gas_concs_ref.gas_concs_map)
     {
+        Array<TF,2>& gas_conc_subset = this->gas_concs_map[g.first];
+
         if (g.second.dim(1) == 1)
-            this->gas_concs_map.emplace(g.first, g.second);
+            gas_conc_subset = g.second;
         else
-        {
-            Array<TF,2> gas_conc_subset = g.second.subset({{ {start, end}, {1, g.second.dim(2)} }});
-            this->gas_concs_map.emplace(g.first, gas_conc_subset);
-        }
+            g.second.subset_to({{ {start, end}, {1, g.second.dim(2)} }}, gas_conc_subset);
     }
 }
 
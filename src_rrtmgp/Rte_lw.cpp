@@ -79,6 +79,36 @@ namespace rrtmgp_kernel_launcher
     }
 }
 
+namespace
+{
+    // Gather the selected g-points of each column into a compact g-point dimension.
+    template<typename TF>
+    void gather_gpt(const Array<TF,3>& arr_in, const Array<int,2>& gpt_sel, Array<TF,3>& arr_out)
+    {
+        const int ncol = gpt_sel.dim(1);
+        const int nsel = gpt_sel.dim(2);
+        const int nz = arr_in.dim(2);
+
+        arr_out.set_dims({ncol, nz, nsel});
+        for (int isel=1; isel<=nsel; ++isel)
+            for (int iz=1; iz<=nz; ++iz)
+                for (int icol=1; icol<=ncol; ++icol)
+                    arr_out({icol, iz, isel}) = arr_in({icol, iz, gpt_sel({icol, isel})});
+    }
+
+    template<typename TF>
+    void gather_gpt(const Array<TF,2>& arr_in, const Array<int,2>& gpt_sel, Array<TF,2>& arr_out)
+    {
+        const int ncol = gpt_sel.dim(1);
+        const int nsel = gpt_sel.dim(2);
+
+        arr_out.set_dims({ncol, nsel});
+        for (int isel=1; isel<=nsel; ++isel)
+            for (int icol=1; icol<=ncol; ++icol)
+                arr_out({icol, isel}) = arr_in({icol, gpt_sel({icol, isel})});
+    }
+}
+
 template<typename TF>
 void Rte_lw<TF>::rte_lw(
         const std::unique_ptr<Optical_props_arry<TF>>& optical_props,
@@ -140,6 +170,79 @@ void Rte_lw<TF>::rte_lw(
     // fluxes->reduce(gpt_flux_up, gpt_flux_dn, optical_props, top_at_1);
 }
 
+template<typename TF>
+void Rte_lw<TF>::rte_lw_gpt_subset(
+        const std::unique_ptr<Optical_props_arry<TF>>& optical_props,
+        const int top_at_1,
+        const Source_func_lw<TF>& sources,
+        const Array<TF,2>& sfc_emis,
+        const Array<TF,2>& inc_flux,
+        const Array<int,2>& gpt_sel,
+        Array<TF,3>& gpt_flux_up,
+        Array<TF,3>& gpt_flux_dn,
+        const int n_gauss_angles)
+{
+    const int ncol = optical_props->get_ncol();
+    const int nlay = optical_props->get_nlay();
+    const int ngpt = optical_props->get_ngpt();
+    const int nsel = gpt_sel.dim(2);
+
+    Array<TF,2> sfc_emis_gpt({ncol, ngpt});
+    expand_and_transpose(optical_props, sfc_emis, sfc_emis_gpt);
+
+    // The solver treats each column and g-point independently, so only the selected ones are solved.
+    Array<TF,3> tau, lay_source, lev_source_inc, lev_source_dec;
+    Array<TF,2> sfc_emis_sel, sfc_source_sel;
+
+    gather_gpt(optical_props->get_tau(), gpt_sel, tau);
+    gather_gpt(sources.get_lay_source(), gpt_sel, lay_source);
+    gather_gpt(sources.get_lev_source_inc(), gpt_sel, lev_source_inc);
+    gather_gpt(sources.get_lev_source_dec(), gpt_sel, lev_source_dec);
+    gather_gpt(sfc_emis_gpt, gpt_sel, sfc_emis_sel);
+    gather_gpt(sources.get_sfc_source(), gpt_sel, sfc_source_sel);
+
+    // Upper boundary condition.
+    if (inc_flux.size() == 0)
+        rrtmgp_kernel_launcher::apply_BC(ncol, nlay, nsel, top_at_1, gpt_flux_dn);
+    else
+    {
+        Array<TF,2> inc_flux_sel;
+        gather_gpt(inc_flux, gpt_sel, inc_flux_sel);
+        rrtmgp_kernel_launcher::apply_BC(ncol, nlay, nsel, top_at_1, inc_flux_sel, gpt_flux_dn);
+    }
+
+    const int max_gauss_pts = 4;
+    const Array<TF,2> gauss_Ds(
+            {      1.66,         0.,         0.,         0.,
+             1.18350343, 2.81649655,         0.,         0.,
+             1.09719858, 1.69338507, 4.70941630,         0.,
+             1.06056257, 1.38282560, 2.40148179, 7.15513024},
+            { max_gauss_pts, max_gauss_pts });
+
+    const Array<TF,2> gauss_wts(
+            {         0.5,           0.,           0.,           0.,
+             0.3180413817, 0.1819586183,           0.,           0.,
+             0.2009319137, 0.2292411064, 0.0698269799,           0.,
+             0.1355069134, 0.2034645680, 0.1298475476, 0.0311809710},
+            { max_gauss_pts, max_gauss_pts });
+
+    const int n_quad_angs = n_gauss_angles;
+
+    Array<TF,2> gauss_Ds_subset = gauss_Ds.subset(
+            {{ {1, n_quad_angs}, {n_quad_angs, n_quad_angs} }});
+    Array<TF,2> gauss_wts_subset = gauss_wts.subset(
+            {{ {1, n_quad_angs}, {n_quad_angs, n_quad_angs} }});
+
+    rrtmgp_kernel_launcher::lw_solver_noscat_GaussQuad(
+            ncol, nlay, nsel, top_at_1, n_quad_angs,
+            gauss_Ds_subset, gauss_wts_subset,
+            tau,
+            lay_source,
+            lev_source_inc, lev_source_dec,
+            sfc_emis_sel, sfc_source_sel,
+            gpt_flux_up, gpt_flux_dn);
+}
+
 template<typename TF>
 void Rte_lw<TF>::expand_and_transpose(
         const std::unique_ptr<Optical_props_arry<TF>>& ops,
@@ -88,6 +88,36 @@ namespace rrtmgp_kernel_launcher
     }
 }
 
+namespace
+{
+    // Gather the selected g-points of each column into a compact g-point dimension.
+    template<typename TF>
+    void gather_gpt(const Array<TF,3>& arr_in, const Array<int,2>& gpt_sel, Array<TF,3>& arr_out)
+    {
+        const int ncol = gpt_sel.dim(1);
+        const int nsel = gpt_sel.dim(2);
+        const int nz = arr_in.dim(2);
+
+        arr_out.set_dims({ncol, nz, nsel});
+        for (int isel=1; isel<=nsel; ++isel)
+            for (int iz=1; iz<=nz; ++iz)
+                for (int icol=1; icol<=ncol; ++icol)
+                    arr_out({icol, iz, isel}) = arr_in({icol, iz, gpt_sel({icol, isel})});
+    }
+
+    template<typename TF>
+    void gather_gpt(const Array<TF,2>& arr_in, const Array<int,2>& gpt_sel, Array<TF,2>& arr_out)
+    {
+        const int ncol = gpt_sel.dim(1);
+        const int nsel = gpt_sel.dim(2);
+
+        arr_out.set_dims({ncol, nsel});
+        for (int isel=1; isel<=nsel; ++isel)
+            for (int icol=1; icol<=ncol; ++icol)
+                arr_out({icol, isel}) = arr_in({icol, gpt_sel({icol, isel})});
+    }
+}
+
 template<typename TF>
 void Rte_sw<TF>::rte_sw(
         const std::unique_ptr<Optical_props_arry<TF>>& optical_props,
@@ -133,6 +163,61 @@ void Rte_sw<TF>::rte_sw(
     // fluxes->reduce(gpt_flux_up, gpt_flux_dn, gpt_flux_dir, optical_props, top_at_1);
 }
 
+template<typename TF>
+void Rte_sw<TF>::rte_sw_gpt_subset(
+        const std::unique_ptr<Optical_props_arry<TF>>& optical_props,
+        const int top_at_1,
+        const Array<TF,1>& mu0,
+        const Array<TF,2>& inc_flux_dir,
+        const Array<TF,2>& sfc_alb_dir,
+        const Array<TF,2>& sfc_alb_dif,
+        const Array<TF,2>& inc_flux_dif,
+        const Array<int,2>& gpt_sel,
+        Array<TF,3>& gpt_flux_up,
+        Array<TF,3>& gpt_flux_dn,
+        Array<TF,3>& gpt_flux_dir)
+{
+    const int ncol = optical_props->get_ncol();
+    const int nlay = optical_props->get_nlay();
+    const int ngpt = optical_props->get_ngpt();
+    const int nsel = gpt_sel.dim(2);
+
+    Array<TF,2> sfc_alb_dir_gpt({ncol, ngpt});
+    Array<TF,2> sfc_alb_dif_gpt({ncol, ngpt});
+
+    expand_and_transpose(optical_props, sfc_alb_dir, sfc_alb_dir_gpt);
+    expand_and_transpose(optical_props, sfc_alb_dif, sfc_alb_dif_gpt);
+
+    // The solver treats each column and g-point independently, so only the selected ones are solved.
+    Array<TF,3> tau, ssa, g;
+    Array<TF,2> sfc_alb_dir_sel, sfc_alb_dif_sel, inc_flux_dir_sel;
+
+    gather_gpt(optical_props->get_tau(), gpt_sel, tau);
+    gather_gpt(optical_props->get_ssa(), gpt_sel, ssa);
+    gather_gpt(optical_props->get_g  (), gpt_sel, g  );
+    gather_gpt(sfc_alb_dir_gpt, gpt_sel, sfc_alb_dir_sel);
+    gather_gpt(sfc_alb_dif_gpt, gpt_sel, sfc_alb_dif_sel);
+    gather_gpt(inc_flux_dir, gpt_sel, inc_flux_dir_sel);
+
+    // Upper boundary condition. At this stage, flux_dn contains the diffuse radiation only.
+    rrtmgp_kernel_launcher::apply_BC(ncol, nlay, nsel, top_at_1, inc_flux_dir_sel, mu0, gpt_flux_dir);
+    if (inc_flux_dif.size() == 0)
+        rrtmgp_kernel_launcher::apply_BC(ncol, nlay, nsel, top_at_1, gpt_flux_dn);
+    else
+    {
+        Array<TF,2> inc_flux_dif_sel;
+        gather_gpt(inc_flux_dif, gpt_sel, inc_flux_dif_sel);
+        rrtmgp_kernel_launcher::apply_BC(ncol, nlay, nsel, top_at_1, inc_flux_dif_sel, gpt_flux_dn);
+    }
+
+    rrtmgp_kernel_launcher::sw_solver_2stream(
+            ncol, nlay, nsel, top_at_1,
+            tau, ssa, g,
+            mu0,
+            sfc_alb_dir_sel, sfc_alb_dif_sel,
+            gpt_flux_up, gpt_flux_dn, gpt_flux_dir);
+}
+
 template<typename TF>
 void Rte_sw<TF>::expand_and_transpose(
         const std::unique_ptr<Optical_props_arry<TF>>& ops,